@@ -0,0 +1,443 @@
+// Host load harness for the command path: the real CommandReceiver behind a fake UART.
+//
+// Builds src/CommandReceiver.cpp and the modules it drives against the
+// stand-ins in host/. Commands are drawn by weight (--mix) from a template
+// file in the format of lib/comandFormat.json, --corrupt percent of them
+// damaged the way the on-device LOADTEST does (bit flip, deleted byte,
+// inserted byte, truncation), and written to the Serial stand-in as lines.
+// Each wake-up of the command task is replayed by calling checkCommand():
+// line assembly, command slots, echo, receiveCommand() and credit grants
+// all run as on the board. The harness is the host end of the credit
+// protocol: it sends at most --burst lines per wake-up and, unless
+// --ignore-credits, never more than the credits the firmware granted.
+//
+// Reported, per run and per template:
+//
+//   - latency of a wake-up (checkCommand()), p50 / p99 / max; with
+//     --burst 1 that is the latency of one command;
+//   - heap: the most a wake-up allocated at once, and what all wake-ups
+//     left allocated (host malloc, see host/HostRuntime.cpp);
+//   - lines dropped by the receiver (getOverflowedLines()) and lines that
+//     were neither executed nor reported as dropped;
+//   - misparsed: valid template lines the receiver rejected, and for the
+//     corrupted ones how many were rejected or still accepted.
+//
+// Commands are parsed and dispatched only (dry run, as LOADTEST) unless
+// --execute; then they act on the motors, NVS model and a host SD card.
+// --corpus DIR writes each template as one file, the seed corpus of
+// FuzzReceiveCommand.cpp.
+//
+// Build:  g++ -O2 -std=c++17 -pthread -Ihost -I../src -I../.pio/libdeps/esp32-s3-devkitc-1/ArduinoJson/src
+//             -o CommandHarness CommandHarness.cpp host/HostRuntime.cpp host/Preferences.cpp host/SD.cpp
+//             ../src/CommandReceiver.cpp ../src/CommandLoadTest.cpp ../src/StatusEncoder.cpp
+//             ../src/TelemetryStreamer.cpp ../src/A4988Manager.cpp ../src/StepJitter.cpp ../src/Sensor.cpp
+//             ../src/ConfigManager.cpp ../src/RecipeManager.cpp ../src/CrashReport.cpp ../src/SDCardManager.cpp
+//             ../src/NextionHMI.cpp ../src/NextionDisplay.cpp ../src/NextionProtocol.cpp ../src/NextionTrend.cpp
+//             ../src/BootSequence.cpp ../src/WarmRestart.cpp ../src/EventLogger.cpp ../src/DeferredLog.cpp
+//             ../src/Metrics.cpp ../src/TaskHealth.cpp ../src/Trace.cpp
+// Usage:  CommandHarness [--templates FILE] [--mix NAME=WEIGHT[,NAME=WEIGHT]...] [--count N] [--corrupt PCT]
+//                        [--seed N] [--burst N] [--ignore-credits] [--execute] [--quiet]
+//         CommandHarness [--templates FILE] --list | --corpus DIR
+// Exit status is 1 when a check fails.
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CommandReceiver.h"
+#include "ConfigManager.h"
+#include "CrashReport.h"
+#include "DeferredLog.h"
+#include "EventLogger.h"
+#include "HostRuntime.h"
+#include "Metrics.h"
+#include "RecipeManager.h"
+#include "SDCardManager.h"
+
+using HostRuntime::fail;
+
+/** One command of the template file, as the single line the host sends. */
+struct Template {
+    std::string name;       // "command", or "motorType" for motor commands
+    std::string line;
+    uint32_t weight = 1;
+    std::vector<uint32_t> latency;  // Wake-ups of this template alone (--burst 1, not corrupted)
+};
+
+/** A line as sent and the frames the receiver cuts it into. */
+struct Sent {
+    int templateIndex;
+    bool corrupted;
+    std::vector<std::string> frames;
+};
+
+static std::vector<Template> templates;
+static const char* templatesPath = "../lib/comandFormat.json";
+static uint32_t count = 10000;
+static int corruptPercent = 0;
+static uint32_t seed = 1;
+static uint32_t burst = 1;
+static bool ignoreCredits = false;
+static bool execute = false;
+static bool quiet = false;
+static std::mt19937 rng;
+
+static uint32_t pick(uint32_t range) {
+    return std::uniform_int_distribution<uint32_t>(0, range - 1)(rng);
+}
+
+/**
+ * Reads the template array. Each entry becomes one minified line; motor
+ * entries are named after their "motorType" so case and disc can be
+ * weighted separately, repeated names get "#2", "#3"...
+ */
+static bool loadTemplates(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return false;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    std::string content = text.str();
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, content.c_str(), content.size());
+    if (error || doc.size() == 0) {
+        fprintf(stderr, "%s: not a JSON array of commands (%s)\n", path, error.c_str());
+        return false;
+    }
+    std::map<std::string, int> seen;
+    for (JsonVariantConst entry : doc.as<JsonArrayConst>()) {
+        Template t;
+        const char* name = entry["motorType"].is<const char*>() ? entry["motorType"] : entry["command"];
+        t.name = name ? name : "?";
+        if (++seen[t.name] > 1) t.name += "#" + std::to_string(seen[t.name]);
+        String line;
+        serializeJson(entry, line);
+        t.line = line.c_str();
+        templates.push_back(t);
+    }
+    return true;
+}
+
+static bool parseMix(const char* mix) {
+    for (Template& t : templates) t.weight = 0;
+    std::stringstream items(mix);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        size_t equals = item.find('=');
+        std::string name = item.substr(0, equals);
+        long weight = equals == std::string::npos ? 1 : atol(item.c_str() + equals + 1);
+        auto it = std::find_if(templates.begin(), templates.end(), [&](const Template& t) { return t.name == name; });
+        if (it == templates.end() || weight < 0) {
+            fprintf(stderr, "--mix: no template \"%s\" (see --list)\n", name.c_str());
+            return false;
+        }
+        it->weight = weight;
+    }
+    return true;
+}
+
+// Same damage as CommandLoadTest::corrupt(), on a host string
+static void corrupt(std::string& line) {
+    if (line.empty()) return;
+    size_t pos = pick(line.size());
+    switch (pick(4)) {
+        case 0:  line[pos] ^= (char)(1 << pick(8)); break;
+        case 1:  line.erase(pos, 1); break;
+        case 2:  line.insert(pos, 1, (char)pick(256)); break;
+        default: line.resize(pos); break;
+    }
+}
+
+// What pumpRx() makes of the bytes of one line: '\r' is skipped, every '\n' ends a frame
+static std::vector<std::string> framesOf(const std::string& line) {
+    std::vector<std::string> frames(1);
+    for (char c : line) {
+        if (c == '\r') continue;
+        if (c == '\n') frames.emplace_back();
+        else frames.back() += c;
+    }
+    return frames;
+}
+
+static uint32_t counter(JsonDocument& metrics, const char* name) {
+    return metrics["counters"][name]["value"] | 0u;
+}
+
+static uint32_t percentileOf(std::vector<uint32_t>& samples, double fraction) {
+    if (samples.empty()) return 0;
+    size_t index = std::min(samples.size() - 1, (size_t)(fraction * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+static void printLatency(const char* label, std::vector<uint32_t>& samples) {
+    if (samples.empty()) return;
+    uint32_t max = *std::max_element(samples.begin(), samples.end());
+    uint32_t p99 = percentileOf(samples, 0.99);
+    uint32_t p50 = percentileOf(samples, 0.50);
+    printf("  %-16s %7zu  %8.1f  %8.1f  %8.1f\n", label, samples.size(), p50 / 1000.0, p99 / 1000.0, max / 1000.0);
+}
+
+static int usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--templates FILE] [--mix NAME=WEIGHT[,NAME=WEIGHT]...] [--count N] [--corrupt PCT]\n"
+                    "       %*s [--seed N] [--burst N] [--ignore-credits] [--execute] [--quiet]\n"
+                    "       %s [--templates FILE] --list | --corpus DIR\n",
+            program, (int)strlen(program), "", program);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    const char* mix = nullptr;
+    const char* corpusDir = nullptr;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        bool value = i + 1 < argc;
+        if (strcmp(argv[i], "--templates") == 0 && value) templatesPath = argv[++i];
+        else if (strcmp(argv[i], "--mix") == 0 && value) mix = argv[++i];
+        else if (strcmp(argv[i], "--count") == 0 && value) count = atol(argv[++i]);
+        else if (strcmp(argv[i], "--corrupt") == 0 && value) corruptPercent = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && value) seed = atol(argv[++i]);
+        else if (strcmp(argv[i], "--burst") == 0 && value) burst = atol(argv[++i]);
+        else if (strcmp(argv[i], "--corpus") == 0 && value) corpusDir = argv[++i];
+        else if (strcmp(argv[i], "--ignore-credits") == 0) ignoreCredits = true;
+        else if (strcmp(argv[i], "--execute") == 0) execute = true;
+        else if (strcmp(argv[i], "--list") == 0) list = true;
+        else if (strcmp(argv[i], "--quiet") == 0) quiet = true;
+        else return usage(argv[0]);
+    }
+    if (corruptPercent < 0 || corruptPercent > 100 || burst == 0 || count == 0) {
+        fprintf(stderr, "--corrupt must be 0-100, --burst and --count positive\n");
+        return 2;
+    }
+    if (!loadTemplates(templatesPath)) return 2;
+    if (mix && !parseMix(mix)) return 2;
+
+    if (list) {
+        for (const Template& t : templates) printf("%-14s %s\n", t.name.c_str(), t.line.c_str());
+        return 0;
+    }
+    if (corpusDir) {
+        for (const Template& t : templates) {
+            std::string path = std::string(corpusDir) + "/" + t.name;
+            std::ofstream out(path, std::ios::binary);
+            out << t.line;
+            if (!out) {
+                fprintf(stderr, "Cannot write %s\n", path.c_str());
+                return 2;
+            }
+        }
+        printf("%zu templates written to %s\n", templates.size(), corpusDir);
+        return 0;
+    }
+
+    uint32_t totalWeight = 0;
+    for (const Template& t : templates) totalWeight += t.weight;
+    if (totalWeight == 0) {
+        fprintf(stderr, "--mix leaves no template\n");
+        return 2;
+    }
+
+    // The firmware side, wired as main.cpp does
+    A4988Manager discMotor(STEP_PIN_DISC, DIR_PIN_DISC, ENABLE_PIN_DISC, MS01_PIN_DISC, MS02_PIN_DISC,
+                           MS03_PIN_DISC, SLP_PIN_DISC, RESET_PIN_DISC, true);
+    A4988Manager caseMotor(STEP_PIN_CASE, DIR_PIN_CASE, ENABLE_PIN_CASE, MS01_PIN_CASE, MS02_PIN_CASE,
+                           MS03_PIN_CASE, SLP_PIN_CASE, RESET_PIN_CASE, false);
+    Sensor sensor(SENSOR_PIN);
+    Preferences prefs;
+    SDCardManager sdCard;
+    if (execute) {
+        DeferredLog::begin();
+        if (sdCard.begin()) EventLogger::begin();
+    }
+    sensor.begin();
+    CommandReceiver receiver(&sensor, caseMotor, discMotor);
+    receiver.begin();
+    prefs.begin(CONFIG_PARTITION, false);
+    prefs.putBool(RESET_FLAG, false);       // Not a first boot: no factory reset and restart
+    ConfigManager config(&prefs);
+    config.begin();
+    receiver.setConfigManager(&config);
+    RecipeManager recipes(&config, &receiver, &sdCard, caseMotor, discMotor);
+    receiver.setRecipes(&recipes);
+    CrashReport crashReport;
+    crashReport.begin();
+    receiver.setCrashReport(&crashReport);
+    discMotor.begin();
+    caseMotor.begin();
+    receiver.setDryRun(!execute);
+
+    rng.seed(seed);
+    std::vector<uint32_t> latency;
+    latency.reserve(count);
+    for (Template& t : templates) t.latency.reserve(count * t.weight / totalWeight + 16);
+    std::vector<Sent> batch;
+    batch.reserve(burst);
+
+    int32_t credits = 0;            // Host view of the free slots
+    uint64_t framesSent = 0, creditsGranted = 0;
+    uint32_t corrupted = 0, misparsed = 0, rejectedCorrupt = 0, acceptedCorrupt = 0;
+    uint32_t missing = 0, unexpected = 0, heapWakeMax = 0;
+    int32_t leaked = 0;             // Net allocation of all wake-ups
+    uint32_t overflowBefore = receiver.getOverflowedLines();
+
+    // Reads what the firmware wrote: credit replies, echoes of the batch, anything else
+    auto drain = [&](std::vector<Sent>* sentBatch, uint32_t* validEchoes, uint32_t* corruptEchoes) {
+        std::string output = Serial.hostTake();
+        uint32_t echoed = 0;
+        size_t frameOf = 0, frame = 0;  // Next expected echo: batch[frameOf].frames[frame]
+        std::stringstream lines(output);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            unsigned value, window;
+            if (sscanf(line.c_str(), "{\"window\":%u,\"credits\":%u", &window, &value) == 2) {
+                credits = value;
+                continue;
+            }
+            if (sscanf(line.c_str(), "{\"credits\":%u}", &value) == 1 && line.back() == '}') {
+                credits += value;
+                creditsGranted += value;
+                continue;
+            }
+            bool matched = false;
+            if (sentBatch) {
+                // Frames skipped over before a match were dropped or lost
+                for (size_t b = frameOf, f = frame; b < sentBatch->size() && !matched; b++, f = 0) {
+                    const Sent& sent = (*sentBatch)[b];
+                    for (; f < sent.frames.size(); f++) {
+                        if (sent.frames[f] != line) continue;
+                        matched = true;
+                        (sent.corrupted ? *corruptEchoes : *validEchoes) += 1;
+                        frameOf = b;
+                        frame = f + 1;
+                        echoed++;
+                        break;
+                    }
+                }
+            }
+            if (!matched && sentBatch && !execute) {  // A dry run writes nothing but echoes and credits
+                if (unexpected++ < 3) printf("unexpected output: %s\n", line.c_str());
+            }
+        }
+        return echoed;
+    };
+
+    drain(nullptr, nullptr, nullptr);  // Window advertised by begin()
+    if (credits <= 0) fail("no credit window advertised at begin()");
+
+    // A first wake-up with an empty line, so what is set up lazily is not counted as kept
+    Serial.hostFeed("\n");
+    credits--;
+    receiver.checkCommand();
+    drain(nullptr, nullptr, nullptr);
+    creditsGranted = 0;
+
+    JsonDocument metrics;
+    Metrics::report(metrics);
+    uint32_t executedBefore = counter(metrics, "command.executed");
+    uint32_t rejectedBefore = counter(metrics, "command.rejected");
+
+    uint32_t sentLines = 0;
+    Sent next;                      // Drawn but not sent yet: did not fit the credits
+    std::string nextLine;
+    bool haveNext = false;
+    while (sentLines < count) {
+        batch.clear();
+        std::string bytes;
+        uint32_t frames = 0;
+        while (batch.size() < burst && sentLines < count) {
+            if (!haveNext) {
+                uint32_t choice = pick(totalWeight);
+                next.templateIndex = 0;
+                while (choice >= templates[next.templateIndex].weight) choice -= templates[next.templateIndex++].weight;
+                nextLine = templates[next.templateIndex].line;
+                next.corrupted = corruptPercent && (int)pick(100) < corruptPercent;
+                if (next.corrupted) {
+                    corrupt(nextLine);
+                    corrupted++;
+                }
+                next.frames = framesOf(nextLine);
+                haveNext = true;
+            }
+            if (!ignoreCredits && (int32_t)(frames + next.frames.size()) > credits) break;
+            frames += next.frames.size();
+            bytes += nextLine + "\n";
+            batch.push_back(next);
+            haveNext = false;
+            sentLines++;
+        }
+        if (batch.empty()) {
+            fail("%d credits left, not enough for the next line: the host would stall", (int)credits);
+            break;
+        }
+        if (!ignoreCredits) credits -= frames;
+        framesSent += frames;
+
+        // Heap figures cover the firmware only: from the bytes arriving to the end of the wake-up
+        HostRuntime::resetHeapPeak();
+        uint32_t heapBefore = HostRuntime::heapInUse();
+        Serial.hostFeed(bytes.c_str(), bytes.size());
+        uint32_t start = ESP.getCycleCount();
+        receiver.checkCommand();
+        uint32_t elapsed = ESP.getCycleCount() - start;
+        heapWakeMax = std::max(heapWakeMax, HostRuntime::heapPeak() - heapBefore);
+        leaked += (int32_t)(HostRuntime::heapInUse() - heapBefore);
+        latency.push_back(elapsed);
+        if (batch.size() == 1 && !batch[0].corrupted) templates[batch[0].templateIndex].latency.push_back(elapsed);
+
+        uint32_t validEchoes = 0, corruptEchoes = 0;
+        uint32_t echoed = drain(&batch, &validEchoes, &corruptEchoes);
+        Metrics::report(metrics);
+        uint32_t executed = counter(metrics, "command.executed") - executedBefore;
+        uint32_t rejected = counter(metrics, "command.rejected") - rejectedBefore;
+        executedBefore += executed;
+        rejectedBefore += rejected;
+        if (executed + rejected != echoed) {
+            fail("%u lines echoed but %u processed", (unsigned)echoed, (unsigned)(executed + rejected));
+        }
+        // Rejections beyond the corrupted frames were valid lines; exact with --burst 1
+        uint32_t rejectedOfCorrupt = std::min(rejected, corruptEchoes);
+        misparsed += rejected - rejectedOfCorrupt;
+        rejectedCorrupt += rejectedOfCorrupt;
+        acceptedCorrupt += corruptEchoes - rejectedOfCorrupt;
+        missing += frames - echoed;
+    }
+    drain(nullptr, nullptr, nullptr);  // Replies still queued (--execute)
+    uint32_t dropped = receiver.getOverflowedLines() - overflowBefore;
+
+    if (!quiet) {
+        printf("%u commands from %s (%zu templates), %u corrupted, seed %u, %s\n", (unsigned)sentLines,
+               templatesPath, templates.size(), (unsigned)corrupted, (unsigned)seed,
+               execute ? "executed" : "dry run");
+        printf("%u line(s) per wake-up, credits %s\n\n", (unsigned)burst, ignoreCredits ? "ignored" : "honoured");
+        printf("  latency (us)     samples       p50       p99       max\n");
+        printLatency(burst == 1 ? "all commands" : "per wake-up", latency);
+        for (Template& t : templates) printLatency(t.name.c_str(), t.latency);
+        printf("\n  heap: %u bytes at most allocated during a wake-up, %d kept after all wake-ups\n",
+               (unsigned)heapWakeMax, (int)leaked);
+        printf("  lines: %llu frames sent, %u dropped by the receiver, %u unaccounted for\n",
+               (unsigned long long)framesSent, (unsigned)dropped, (unsigned)(missing - std::min(missing, dropped)));
+        printf("  misparsed: %u valid lines rejected; corrupted lines: %u rejected, %u still accepted\n",
+               (unsigned)misparsed, (unsigned)rejectedCorrupt, (unsigned)acceptedCorrupt);
+        printf("  credits: %llu granted for %llu frames\n", (unsigned long long)creditsGranted,
+               (unsigned long long)framesSent);
+    }
+
+    if (misparsed) fail("%u valid template lines were rejected", (unsigned)misparsed);
+    if (missing != dropped) fail("%u lines were not echoed, %u reported dropped", (unsigned)missing, (unsigned)dropped);
+    if (!ignoreCredits && dropped) fail("%u lines dropped although the host kept to its credits", (unsigned)dropped);
+    if (!execute && creditsGranted != framesSent) {  // FLOWCONTROL (--execute) re-advertises instead
+        fail("%llu credits granted for %llu frames", (unsigned long long)creditsGranted, (unsigned long long)framesSent);
+    }
+    if (unexpected) fail("%u unexpected output lines in a dry run", (unsigned)unexpected);
+    if (!execute && leaked > 0) fail("the wake-ups kept %d bytes allocated", (int)leaked);
+    if (HostRuntime::failures() == 0) printf("OK: every command line was parsed, echoed and credited\n");
+    HostRuntime::exit(HostRuntime::failures() == 0 ? 0 : 1);
+}
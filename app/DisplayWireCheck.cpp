@@ -0,0 +1,227 @@
+// Host check of the wire traffic NextionDisplay sends per key press.
+//
+// Builds the real src/NextionDisplay.cpp against the stand-ins in host/
+// and a fake Nextion that counts bytes and UART writes and decodes every
+// `nX.val=` it receives. It plays key presses the way NextionHMI does
+// (beginPress(), the four status fields, endPress()) and checks that:
+//
+//   - the first status goes out as one write of all four fields;
+//   - a press that changes one field sends only that field;
+//   - a press that changes nothing sends nothing and counts as suppressed;
+//   - getLastPressBytes() matches the bytes the fake received, without
+//     background (graph) data queued during the press;
+//   - a burst of updates to one field within NEXTION_MIN_REFRESH_MS is
+//     rate limited and ends with the last value on the display.
+//
+// Each press is compared with the four separate commands the display got
+// before the model existed; wire time is given at --baud.
+//
+// Build:  g++ -O2 -std=c++17 -pthread -Ihost -I../src -I../.pio/libdeps/esp32-s3-devkitc-1/ArduinoJson/src
+//             -o DisplayWireCheck DisplayWireCheck.cpp host/HostRuntime.cpp
+//             ../src/NextionDisplay.cpp ../src/TaskHealth.cpp ../src/Trace.cpp
+// Usage:  DisplayWireCheck [--baud BAUD] [--quiet]
+// Exit status is 1 when a check fails.
+
+#include <map>
+
+#include "HostRuntime.h"
+#include "NextionDisplay.h"
+
+using HostRuntime::fail;
+
+/**
+ * Display end of the UART: counts what arrives and keeps the value of
+ * every component as the panel would show it.
+ */
+class FakeNextion : public Print {
+public:
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    size_t write(const uint8_t* data, size_t length) override {
+        std::lock_guard<std::mutex> guard(_lock);
+        _bytes += length;
+        _writes++;
+        for (size_t i = 0; i < length; i++) {
+            if (data[i] != 0xFF) {
+                _line += (char)data[i];
+                _terminators = 0;
+            } else if (++_terminators == 3) {
+                decode(_line);
+                _line.clear();
+                _terminators = 0;
+            }
+        }
+        return length;
+    }
+
+    int availableForWrite() override { return 128; }  // TX FIFO always drained
+
+    uint32_t bytes() { std::lock_guard<std::mutex> guard(_lock); return _bytes; }
+    uint32_t writes() { std::lock_guard<std::mutex> guard(_lock); return _writes; }
+    uint32_t updates(const std::string& name) { std::lock_guard<std::mutex> guard(_lock); return _updates[name]; }
+    bool shows(const std::string& name, int32_t value) {
+        std::lock_guard<std::mutex> guard(_lock);
+        auto it = _shown.find(name);
+        return it != _shown.end() && it->second == value;
+    }
+
+private:
+    void decode(const std::string& command) {
+        size_t dot = command.find(".val=");
+        if (dot == std::string::npos) return;  // Raw or background command
+        std::string name = command.substr(0, dot);
+        _shown[name] = atol(command.c_str() + dot + 5);
+        _updates[name]++;
+    }
+
+    std::mutex _lock;
+    std::string _line;
+    int _terminators = 0;
+    uint32_t _bytes = 0;
+    uint32_t _writes = 0;
+    std::map<std::string, int32_t> _shown;
+    std::map<std::string, uint32_t> _updates;
+};
+
+static const char* const FIELDS[] = { "n1", "n2", "n0", "n3" };  // Order of NextionHMI::sendSystemStatus
+
+static NextionDisplay display;
+static FakeNextion nextion;
+static int8_t ids[4];
+static long baud = 9600;
+static bool quiet = false;
+
+// Bytes the status took as four separate commands
+static uint32_t legacyBytes(const int32_t values[4]) {
+    uint32_t bytes = 0;
+    char line[32];
+    for (int i = 0; i < 4; i++) bytes += snprintf(line, sizeof(line), "%s.val=%ld", FIELDS[i], (long)values[i]) + 3;
+    return bytes;
+}
+
+// Waits until the writer has sent everything and the press is settled
+static void settle() {
+    uint32_t start = millis();
+    uint32_t bytes = nextion.bytes();
+    uint32_t quietSince = millis();
+    while (millis() - start < 2000) {
+        delay(5);
+        if (nextion.bytes() != bytes || display.hasPending()) {
+            bytes = nextion.bytes();
+            quietSince = millis();
+        } else if (millis() - quietSince >= 3 * NEXTION_MIN_REFRESH_MS) {
+            return;
+        }
+    }
+    fail("display output did not settle within 2 s");
+}
+
+struct PressResult {
+    uint32_t bytes;       // Received by the fake
+    uint32_t writes;      // UART writes
+    uint32_t reported;    // getLastPressBytes()
+};
+
+/**
+ * One key press followed by the status update of NextionHMI, with
+ * optional background data queued while it runs.
+ */
+static PressResult press(const char* label, const int32_t values[4], int backgroundCommands = 0) {
+    uint32_t bytes = nextion.bytes();
+    uint32_t writes = nextion.writes();
+    uint32_t background = display.getBackgroundBytes();
+
+    display.beginPress();
+    for (int i = 0; i < backgroundCommands; i++) display.sendBackground("add 1,0,128");
+    for (int i = 0; i < 4; i++) display.setNumber(ids[i], values[i]);
+    display.endPress();
+    display.flush();
+    settle();
+
+    PressResult result;
+    result.bytes = nextion.bytes() - bytes - (display.getBackgroundBytes() - background);
+    result.writes = nextion.writes() - writes;
+    result.reported = display.getLastPressBytes();
+    if (!quiet) {
+        uint32_t legacy = legacyBytes(values);
+        printf("%-22s %3u bytes in %u write(s), %6.1f ms at %ld baud (was %u bytes, %.1f ms)\n", label,
+               (unsigned)result.bytes, (unsigned)result.writes, result.bytes * 10000.0 / baud, baud,
+               (unsigned)legacy, legacy * 10000.0 / baud);
+    }
+    if (result.reported != result.bytes) {
+        fail("%s: getLastPressBytes() is %u, the display received %u", label, (unsigned)result.reported,
+             (unsigned)result.bytes);
+    }
+    for (int i = 0; i < 4; i++) {
+        if (!nextion.shows(FIELDS[i], values[i])) fail("%s: %s does not show %ld", label, FIELDS[i], (long)values[i]);
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc) {
+            baud = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--baud BAUD] [--quiet]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (baud <= 0) {
+        fprintf(stderr, "--baud must be positive\n");
+        return 2;
+    }
+
+    for (int i = 0; i < 4; i++) ids[i] = display.addNumber(FIELDS[i]);
+    display.begin(&nextion);
+
+    int32_t status[4] = { 120, 45, 300, 1600 };
+    PressResult first = press("first status", status);
+    if (first.writes != 1) fail("first status took %u writes, expected one", (unsigned)first.writes);
+
+    delay(NEXTION_MIN_REFRESH_MS);
+    status[0] = 125;
+    PressResult one = press("one field changed", status);
+    char expected[32];
+    uint32_t expectedBytes = snprintf(expected, sizeof(expected), "n1.val=%ld", (long)status[0]) + 3;
+    if (one.bytes != expectedBytes) fail("one changed field sent %u bytes, expected %u", (unsigned)one.bytes, (unsigned)expectedBytes);
+    if (one.writes != 1) fail("one changed field took %u writes", (unsigned)one.writes);
+
+    uint32_t suppressed = display.getSuppressed();
+    PressResult none = press("nothing changed", status);
+    if (none.bytes != 0) fail("an unchanged status sent %u bytes", (unsigned)none.bytes);
+    if (display.getSuppressed() - suppressed != 4) fail("unchanged fields were not counted as suppressed");
+
+    delay(NEXTION_MIN_REFRESH_MS);
+    status[1] = 50;
+    status[3] = 1650;
+    PressResult two = press("two fields + graph", status, 3);
+    expectedBytes = snprintf(expected, sizeof(expected), "n2.val=%ld", (long)status[1]) + 3
+                  + snprintf(expected, sizeof(expected), "n3.val=%ld", (long)status[3]) + 3;
+    if (two.bytes != expectedBytes) fail("two changed fields sent %u bytes, expected %u", (unsigned)two.bytes, (unsigned)expectedBytes);
+
+    // Holding an adjust key: many updates of one field inside its refresh interval
+    delay(NEXTION_MIN_REFRESH_MS);
+    uint32_t before = nextion.updates("n1");
+    const int burst = 50;
+    uint32_t start = millis();
+    for (int i = 1; i <= burst; i++) {
+        status[0] = 125 + i;
+        display.setNumber(ids[0], status[0]);
+        display.flush();
+        delay(1);
+    }
+    uint32_t elapsed = millis() - start;
+    settle();
+    uint32_t sent = nextion.updates("n1") - before;
+    uint32_t allowed = elapsed / NEXTION_MIN_REFRESH_MS + 2;
+    if (!quiet) printf("%-22s %d updates in %u ms sent %u times (limit %u)\n", "held key", burst, (unsigned)elapsed, (unsigned)sent, (unsigned)allowed);
+    if (sent > allowed) fail("n1 was written %u times in %u ms", (unsigned)sent, (unsigned)elapsed);
+    if (!nextion.shows("n1", status[0])) fail("n1 does not show the last value %ld", (long)status[0]);
+
+    if (display.getDroppedCommands() != 0) fail("%u commands dropped", (unsigned)display.getDroppedCommands());
+    if (HostRuntime::failures() == 0) printf("OK: NextionDisplay sends only changed fields, coalesced\n");
+    HostRuntime::exit(HostRuntime::failures() == 0 ? 0 : 1);
+}
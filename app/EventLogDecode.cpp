@@ -0,0 +1,332 @@
+// Decoder for the binary event log written by EventLogger (src/EventLogger.h).
+//
+// Reads one or more evNNNNNN.bin files and writes CSV and/or one raw
+// little-endian column file per field (time_us.i64, file.u32, type.u8,
+// source.u8, value0.i32, value1.i32) plus columns.txt describing them,
+// which numpy.fromfile / pandas / Arrow load without parsing.
+//
+// The record layout and the event, source and fault names come from the
+// schema text in each file header, so older files decode with the names
+// they were written with.
+//
+// Build:  g++ -O2 -std=c++17 -o EventLogDecode EventLogDecode.cpp
+// Usage:  EventLogDecode [--csv out.csv|-] [--columns DIR] [--quiet] ev*.bin
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char FILE_MAGIC[8] = { 'E', 'V', 'T', 'L', 'O', 'G', '\r', '\n' };
+const uint32_t BLOCK_MAGIC = 0x4B4C5645;
+const size_t FILE_HEADER_SIZE = 48;
+const size_t BLOCK_HEADER_SIZE = 32;
+const size_t READ_BLOCKS = 64;          // Blocks per fread
+const size_t OUTPUT_BUFFER = 1 << 20;   // Bytes buffered per output file
+
+uint16_t readU16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+uint32_t readU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+// Record schema parsed from a file header
+struct Field {
+    std::string type;    // u8, u16, u32, i32
+    size_t offset = 0;
+};
+
+struct Schema {
+    size_t recordSize = 0;
+    std::map<std::string, Field> fields;
+    std::map<unsigned, std::string> types;
+    std::map<unsigned, std::string> sources;
+    std::string text;
+
+    bool parse(const std::string& schemaText) {
+        text = schemaText;
+        std::istringstream lines(schemaText);
+        std::string line;
+        while (std::getline(lines, line)) {
+            std::istringstream in(line);
+            std::string kind;
+            in >> kind;
+            if (kind == "record") {
+                in >> recordSize;
+            } else if (kind == "field") {
+                std::string name;
+                Field field;
+                in >> name >> field.type >> field.offset;
+                fields[name] = field;
+            } else if (kind == "type") {
+                unsigned id;
+                std::string name;
+                in >> id >> name;
+                types[id] = name;
+            } else if (kind == "source") {
+                unsigned id;
+                std::string name;
+                in >> id >> name;
+                sources[id] = name;
+            }
+        }
+        for (const char* name : { "timestamp", "type", "source", "value0", "value1" }) {
+            auto it = fields.find(name);
+            if (it == fields.end() || it->second.offset >= recordSize) return false;
+        }
+        return recordSize > 0;
+    }
+
+    int64_t get(const uint8_t* record, const std::string& name) const {
+        const Field& field = fields.at(name);
+        const uint8_t* p = record + field.offset;
+        if (field.type == "u8") return p[0];
+        if (field.type == "u16") return readU16(p);
+        if (field.type == "i32") return (int32_t)readU32(p);
+        return readU32(p);
+    }
+};
+
+// Buffered binary or text output
+class Output {
+public:
+    bool open(const std::string& path) {
+        file = path == "-" ? stdout : fopen(path.c_str(), "wb");
+        buffer.reserve(OUTPUT_BUFFER);
+        return file != nullptr;
+    }
+    void write(const void* data, size_t length) {
+        if (buffer.size() + length > OUTPUT_BUFFER) flush();
+        buffer.insert(buffer.end(), (const char*)data, (const char*)data + length);
+    }
+    void text(const char* s) { write(s, strlen(s)); }
+    void text(const std::string& s) { write(s.data(), s.size()); }
+    template <typename T> void number(T value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        write(digits, result.ptr - digits);
+    }
+    void flush() {
+        if (file && !buffer.empty()) fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+    void close() {
+        flush();
+        if (file && file != stdout) fclose(file);
+        file = nullptr;
+    }
+    bool isOpen() const { return file != nullptr; }
+
+private:
+    FILE* file = nullptr;
+    std::vector<char> buffer;
+};
+
+struct LogFile {
+    std::string path;
+    uint32_t number = 0;
+    uint32_t blockSize = 0;
+    uint32_t firstSequence = 0;
+    bool contiguous = false;
+    Schema schema;
+};
+
+struct Totals {
+    uint64_t files = 0;
+    uint64_t blocks = 0;
+    uint64_t records = 0;
+    uint64_t dropped = 0;
+    std::map<std::string, uint64_t> perType;
+};
+
+bool readHeader(const std::string& path, LogFile& log) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    uint8_t header[FILE_HEADER_SIZE];
+    bool ok = fread(header, 1, sizeof(header), file) == sizeof(header) && memcmp(header, FILE_MAGIC, 8) == 0;
+    if (ok) {
+        uint16_t schemaLength = readU16(header + 10);
+        log.path = path;
+        log.blockSize = readU32(header + 12);
+        log.number = readU32(header + 20);
+        log.firstSequence = readU32(header + 24);
+        log.contiguous = header[32] != 0;
+        std::string text(schemaLength, '\0');
+        ok = fread(&text[0], 1, schemaLength, file) == schemaLength && log.schema.parse(text)
+             && log.blockSize > BLOCK_HEADER_SIZE;
+    }
+    fclose(file);
+    return ok;
+}
+
+// Decoder state shared by all files
+struct Decoder {
+    Output csv;
+    bool columns = false;
+    std::string columnDir;
+    Output timeColumn, fileColumn, typeColumn, sourceColumn, value0Column, value1Column;
+    Totals totals;
+
+    bool openColumns(const std::string& dir) {
+        columns = true;
+        columnDir = dir;
+        return timeColumn.open(dir + "/time_us.i64") && fileColumn.open(dir + "/file.u32")
+            && typeColumn.open(dir + "/type.u8") && sourceColumn.open(dir + "/source.u8")
+            && value0Column.open(dir + "/value0.i32") && value1Column.open(dir + "/value1.i32");
+    }
+
+    void decodeFile(const LogFile& log) {
+        FILE* file = fopen(log.path.c_str(), "rb");
+        if (!file) return;
+        totals.files++;
+
+        const Schema& schema = log.schema;
+        std::vector<uint8_t> chunk(log.blockSize * READ_BLOCKS);
+        uint32_t expected = log.firstSequence;
+        fseek(file, log.blockSize, SEEK_SET);  // First data block
+
+        bool end = false;
+        while (!end) {
+            size_t got = fread(chunk.data(), log.blockSize, READ_BLOCKS, file);
+            if (got == 0) break;
+            for (size_t b = 0; b < got && !end; b++) {
+                const uint8_t* block = chunk.data() + b * log.blockSize;
+                uint16_t count = readU16(block + 8);
+                uint16_t recordSize = readU16(block + 10);
+                if (readU32(block) != BLOCK_MAGIC || readU32(block + 4) != expected
+                    || readU32(block + 20) != log.number || recordSize != schema.recordSize
+                    || BLOCK_HEADER_SIZE + (size_t)count * recordSize > log.blockSize) {
+                    end = true;
+                    break;
+                }
+                totals.blocks++;
+                totals.dropped = readU32(block + 12);
+                decodeBlock(log, block, count, readU32(block + 16));
+                expected++;
+            }
+        }
+        fclose(file);
+    }
+
+    // Timestamps are the low 32 bits of micros(); the block's uptime (ms,
+    // taken when the block was written) resolves the wrap-around.
+    void decodeBlock(const LogFile& log, const uint8_t* block, uint16_t count, uint32_t uptimeMs) {
+        const Schema& schema = log.schema;
+        int64_t referenceUs = (int64_t)uptimeMs * 1000;
+        const uint8_t* record = block + BLOCK_HEADER_SIZE;
+        for (uint16_t i = 0; i < count; i++, record += schema.recordSize) {
+            uint32_t timestamp = (uint32_t)schema.get(record, "timestamp");
+            int64_t timeUs = referenceUs - (uint32_t)((uint32_t)referenceUs - timestamp);
+            uint8_t type = (uint8_t)schema.get(record, "type");
+            uint8_t source = (uint8_t)schema.get(record, "source");
+            int32_t value0 = (int32_t)schema.get(record, "value0");
+            int32_t value1 = (int32_t)schema.get(record, "value1");
+
+            totals.records++;
+            auto typeName = schema.types.find(type);
+            const std::string& name = typeName != schema.types.end() ? typeName->second : unknown;
+            totals.perType[name]++;
+
+            if (csv.isOpen()) {
+                csv.number(log.number);
+                csv.text(",");
+                csv.number(timeUs);
+                csv.text(",");
+                csv.text(name);
+                csv.text(",");
+                auto sourceName = schema.sources.find(source);
+                if (sourceName != schema.sources.end()) csv.text(sourceName->second); else csv.number(source);
+                csv.text(",");
+                csv.number(value0);
+                csv.text(",");
+                csv.number(value1);
+                csv.text("\n");
+            }
+            if (columns) {
+                timeColumn.write(&timeUs, sizeof(timeUs));
+                fileColumn.write(&log.number, sizeof(log.number));
+                typeColumn.write(&type, 1);
+                sourceColumn.write(&source, 1);
+                value0Column.write(&value0, sizeof(value0));
+                value1Column.write(&value1, sizeof(value1));
+            }
+        }
+    }
+
+    void writeColumnInfo(const Schema& schema) {
+        Output info;
+        if (!info.open(columnDir + "/columns.txt")) return;
+        info.text("rows ");
+        info.number(totals.records);
+        info.text("\ncolumn time_us i64 microseconds since boot\n"
+                  "column file u32 log file number\n"
+                  "column type u8\ncolumn source u8\ncolumn value0 i32\ncolumn value1 i32\n");
+        info.text(schema.text);
+        info.close();
+    }
+
+    void close() {
+        csv.close();
+        for (Output* column : { &timeColumn, &fileColumn, &typeColumn, &sourceColumn, &value0Column, &value1Column }) {
+            column->close();
+        }
+    }
+
+    const std::string unknown = "UNKNOWN";
+};
+
+void usage() {
+    fprintf(stderr, "Usage: EventLogDecode [--csv out.csv|-] [--columns DIR] [--quiet] ev*.bin\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string csvPath, columnDir;
+    bool quiet = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv" && i + 1 < argc) csvPath = argv[++i];
+        else if (arg == "--columns" && i + 1 < argc) columnDir = argv[++i];
+        else if (arg == "--quiet") quiet = true;
+        else if (arg.size() > 1 && arg[0] == '-') { usage(); return 2; }
+        else paths.push_back(arg);
+    }
+    if (paths.empty()) { usage(); return 2; }
+
+    std::vector<LogFile> logs;
+    for (const std::string& path : paths) {
+        LogFile log;
+        if (readHeader(path, log)) logs.push_back(log);
+        else fprintf(stderr, "%s: not an event log, skipped\n", path.c_str());
+    }
+    std::sort(logs.begin(), logs.end(), [](const LogFile& a, const LogFile& b) { return a.number < b.number; });
+    if (logs.empty()) return 1;
+
+    Decoder decoder;
+    if (!csvPath.empty()) {
+        if (!decoder.csv.open(csvPath)) { perror(csvPath.c_str()); return 1; }
+        decoder.csv.text("file,time_us,type,source,value0,value1\n");
+    }
+    if (!columnDir.empty() && !decoder.openColumns(columnDir)) { perror(columnDir.c_str()); return 1; }
+
+    for (const LogFile& log : logs) decoder.decodeFile(log);
+    if (decoder.columns) decoder.writeColumnInfo(logs.back().schema);
+    decoder.close();
+
+    if (!quiet) {
+        const Totals& totals = decoder.totals;
+        fprintf(stderr, "%llu files, %llu blocks, %llu records, %llu dropped on the device\n",
+                (unsigned long long)totals.files, (unsigned long long)totals.blocks,
+                (unsigned long long)totals.records, (unsigned long long)totals.dropped);
+        for (const auto& type : totals.perType) {
+            fprintf(stderr, "  %-16s %llu\n", type.first.c_str(), (unsigned long long)type.second);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Coverage-guided fuzz target for CommandReceiver::receiveCommand() (libFuzzer).
+//
+// Builds src/CommandReceiver.cpp and the modules it drives against the
+// stand-ins in host/, wired as in CommandHarness.cpp. Each input is one
+// command line handed to receiveCommand() in a dry run, as LOADTEST does:
+// the JSON parse and the dispatch on "command", "motorType" and the
+// fields are fuzzed, the motors, NVS and SD card are not touched. The
+// heap is read under ASan as full (host/HostRuntime.cpp), so a leak or an
+// overrun is reported by the sanitizer rather than by a count.
+//
+// Seed corpus: CommandHarness --corpus DIR (one file per template of
+// lib/comandFormat.json).
+//
+// Build:  clang++ -g -O1 -std=c++17 -pthread -fsanitize=fuzzer,address,undefined -Ihost -I../src
+//             -I../.pio/libdeps/esp32-s3-devkitc-1/ArduinoJson/src
+//             -o FuzzReceiveCommand FuzzReceiveCommand.cpp host/HostRuntime.cpp host/Preferences.cpp host/SD.cpp
+//             (the ../src files of the CommandHarness build line)
+// Usage:  mkdir corpus && CommandHarness --corpus corpus && FuzzReceiveCommand corpus
+
+#include <cstddef>
+#include <cstdint>
+
+#include "CommandReceiver.h"
+#include "ConfigManager.h"
+#include "CrashReport.h"
+#include "RecipeManager.h"
+#include "SDCardManager.h"
+
+/** The firmware side, set up once for all inputs. */
+struct Firmware {
+    A4988Manager discMotor{STEP_PIN_DISC, DIR_PIN_DISC, ENABLE_PIN_DISC, MS01_PIN_DISC, MS02_PIN_DISC,
+                           MS03_PIN_DISC, SLP_PIN_DISC, RESET_PIN_DISC, true};
+    A4988Manager caseMotor{STEP_PIN_CASE, DIR_PIN_CASE, ENABLE_PIN_CASE, MS01_PIN_CASE, MS02_PIN_CASE,
+                           MS03_PIN_CASE, SLP_PIN_CASE, RESET_PIN_CASE, false};
+    Sensor sensor{SENSOR_PIN};
+    Preferences prefs;
+    SDCardManager sdCard;
+    CommandReceiver receiver{&sensor, caseMotor, discMotor};
+    ConfigManager config{&prefs};
+    RecipeManager recipes{&config, &receiver, &sdCard, caseMotor, discMotor};
+    CrashReport crashReport;
+
+    Firmware() {
+        sensor.begin();
+        receiver.begin();
+        prefs.begin(CONFIG_PARTITION, false);
+        prefs.putBool(RESET_FLAG, false);   // Not a first boot: no factory reset and restart
+        config.begin();
+        receiver.setConfigManager(&config);
+        receiver.setRecipes(&recipes);
+        crashReport.begin();
+        receiver.setCrashReport(&crashReport);
+        discMotor.begin();
+        caseMotor.begin();
+        receiver.setDryRun(true);
+    }
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static Firmware* firmware = new Firmware();  // Never destroyed: the tasks it started keep running
+    firmware->receiver.receiveCommand((const char*)data, size);
+    Serial.hostTake();                           // Nothing should be written; do not let it pile up
+    return 0;
+}
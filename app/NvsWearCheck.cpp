@@ -0,0 +1,292 @@
+// Host check of the flash writes ConfigManager makes for a burst of key presses.
+//
+// Builds the real src/ConfigManager.cpp against the stand-ins in host/,
+// whose Preferences counts every put that reaches "flash". It replays
+// what an adjust key does on the HMI (one setSetting() per press, at
+// --interval ms) and checks that:
+//
+//   - nothing is written while the presses keep coming;
+//   - the burst is written once CONFIG_COMMIT_QUIET_MS after the last
+//     press, as one settings blob;
+//   - commit() (SAVE) writes the burst at once and the quiet period then
+//     has nothing left to write;
+//   - presses on a cached key cost that key alone: the lifetime entry
+//     counter stays in RAM until the next blob write, which saves it;
+//   - a ConfigManager opened afterwards reads the last values back;
+//   - a put that fails on a full partition stays pending, is not counted
+//     as written, and is written by the next commit once there is room.
+//
+// With --bench it instead runs workloads on a freshly erased partition
+// of --pages pages and reports, from the NVS page model of the
+// Preferences stand-in, the entries written (garbage collection moves
+// included), the page erases and the write amplification: flash bytes
+// per byte handed to NVS and per byte the workload changed. The erases
+// are also given as NVSDIAG estimates them (one per NVS_ENTRIES_PER_PAGE
+// entries), to see how far that estimate is off. Workloads, --ops times:
+//
+//   hmi       speed key, committed after every --burst presses (quiet period)
+//   perpress  speed key, committed after every press (write-through)
+//   cached    PutInt() of a cached key, committed after every --burst
+//   recipes   saveRecipe() over all slots, each committed
+//
+// Build:  g++ -O2 -std=c++17 -pthread -Ihost -I../src -I../.pio/libdeps/esp32-s3-devkitc-1/ArduinoJson/src
+//             -o NvsWearCheck NvsWearCheck.cpp host/HostRuntime.cpp host/Preferences.cpp
+//             ../src/ConfigManager.cpp ../src/TaskHealth.cpp ../src/Trace.cpp
+// Usage:  NvsWearCheck [--presses N] [--interval MS] [--quiet]
+//         NvsWearCheck --bench [WORKLOAD]... [--ops N] [--burst N] [--pages N]
+// Exit status is 1 when a check fails.
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ConfigManager.h"
+#include "HostRuntime.h"
+
+using HostRuntime::fail;
+
+static int presses = 100;
+static uint32_t intervalMs = 10;
+static bool quiet = false;
+
+// Waits for the commit task to write everything pending; false on timeout
+static bool waitCommitted(ConfigManager& config, uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (config.getPendingCount() > 0) {
+        if (millis() - start > timeoutMs) return false;
+        delay(10);
+    }
+    return true;
+}
+
+/**
+ * Runs @p press once per key press and returns the flash writes made
+ * during the burst and until it was committed (by @p save or the quiet
+ * period).
+ */
+template <class Press>
+static uint32_t burst(const char* label, ConfigManager& config, bool save, Press press) {
+    uint32_t before = Preferences::hostWrites();
+    uint32_t counted = config.getNvsWrites();
+
+    for (int i = 0; i < presses; i++) {
+        press(i);
+        delay(intervalMs);
+    }
+    uint32_t during = Preferences::hostWrites() - before;
+    if (during != 0) fail("%s: %u flash writes while the presses kept coming", label, (unsigned)during);
+    if (config.getPendingCount() == 0) fail("%s: nothing pending after the burst", label);
+
+    uint32_t start = millis();
+    if (save) config.commit();
+    if (!waitCommitted(config, CONFIG_COMMIT_QUIET_MS + 1000)) fail("%s: still pending after the quiet period", label);
+    uint32_t committedMs = millis() - start;
+    if (save) delay(CONFIG_COMMIT_QUIET_MS + 500);  // The commit task must not write it again
+
+    uint32_t writes = Preferences::hostWrites() - before;
+    if (config.getNvsWrites() - counted != writes) {
+        fail("%s: getNvsWrites() counted %u, flash saw %u", label, (unsigned)(config.getNvsWrites() - counted),
+             (unsigned)writes);
+    }
+    if (!quiet) {
+        printf("%-16s %d presses -> %u flash write(s), committed %u ms after the last (write-through: %d)\n", label,
+               presses, (unsigned)writes, (unsigned)committedMs, presses);
+    }
+    return writes;
+}
+
+struct Workload {
+    const char* name;
+    std::function<uint32_t(ConfigManager&, int)> op;  // Runs operation i, returns the bytes it changed
+    bool commitEach;                                  // Commit after every op, else every --burst
+};
+
+static int benchOps = 10000;
+static int benchBurst = 10;
+static uint16_t benchPages = HOST_NVS_PAGES;
+
+static int32_t zigzag(int i) {
+    return HMI_SPEED_MIN + 10 * (i % 50 < 25 ? i % 50 : 50 - i % 50);
+}
+
+static const Workload WORKLOADS[] = {
+    { "hmi", [](ConfigManager& config, int i) {
+          return config.setSetting(SETTING_CASE_RPM, zigzag(i)) ? (uint32_t)sizeof(int32_t) : 0;
+      }, false },
+    { "perpress", [](ConfigManager& config, int i) {
+          return config.setSetting(SETTING_CASE_RPM, zigzag(i)) ? (uint32_t)sizeof(int32_t) : 0;
+      }, true },
+    { "cached", [](ConfigManager& config, int i) {
+          config.PutInt("hmiPresses", i);
+          return (uint32_t)sizeof(int32_t);
+      }, false },
+    { "recipes", [](ConfigManager& config, int i) {
+          Recipe recipe;
+          snprintf(recipe.name, sizeof(recipe.name), "R%d", i);
+          for (uint8_t id = 0; id < RECIPE_SETTINGS; id++) recipe.values[id] = config.getSetting((SettingId)id);
+          return config.saveRecipe(i % RECIPE_MAX_COUNT, recipe) ? (uint32_t)sizeof(Recipe) : 0;
+      }, true },
+};
+
+static void bench(const Workload& workload) {
+    Preferences::hostFormat(benchPages);
+    Preferences* prefs = new Preferences;  // Never freed: the commit task keeps using it
+    prefs->begin(CONFIG_PARTITION, false);
+    prefs->putBool(RESET_FLAG, false);
+    ConfigManager* config = new ConfigManager(prefs);
+    config->begin();
+
+    NvsCounters start = Preferences::hostCounters();
+    uint64_t changed = 0;
+    for (int i = 0; i < benchOps; i++) {
+        changed += workload.op(*config, i);
+        if (workload.commitEach || (i + 1) % benchBurst == 0) config->commit();
+    }
+    config->commit();
+    NvsCounters end = Preferences::hostCounters();
+
+    uint64_t entries = end.entriesWritten - start.entriesWritten;
+    uint64_t bytes = end.requestedBytes - start.requestedBytes;
+    uint32_t erases = end.pageErases - start.pageErases;
+    nvs_stats_t stats;
+    nvs_get_stats(CONFIG_NVS_PARTITION, &stats);
+    printf("%-9s %7u %7u %9llu %8llu %7u %7.1f %7.1f %8.1f %8.2f %8.2f %5u/%u\n", workload.name,
+           (unsigned)(end.writes - start.writes), (unsigned)(end.unchangedPuts - start.unchangedPuts),
+           (unsigned long long)entries, (unsigned long long)(end.entriesMoved - start.entriesMoved), (unsigned)erases,
+           (double)erases / benchPages, (double)entries / NVS_ENTRIES_PER_PAGE / benchPages,
+           (double)end.maxPageErases, bytes ? entries * NVS_ENTRY_SIZE / (double)bytes : 0.0,
+           changed ? entries * NVS_ENTRY_SIZE / (double)changed : 0.0, (unsigned)stats.used_entries,
+           (unsigned)stats.total_entries);
+    if (end.failedPuts != start.failedPuts) fail("%s: %u puts failed, partition full", workload.name, (unsigned)(end.failedPuts - start.failedPuts));
+}
+
+static int runBench(const std::vector<const Workload*>& selected) {
+    printf("%d ops, commit every %d, %u pages of %d entries\n", benchOps, benchBurst, (unsigned)benchPages,
+           NVS_ENTRIES_PER_PAGE);
+    printf("%-9s %7s %7s %9s %8s %7s %7s %7s %8s %8s %8s %9s\n", "workload", "writes", "same", "entries", "moved",
+           "erases", "/page", "est.", "maxpage", "WA(nvs)", "WA(chg)", "used");
+    for (const Workload* workload : selected) bench(*workload);
+    if (HostRuntime::failures() == 0) printf("OK\n");
+    return HostRuntime::failures() == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    bool benchmark = false;
+    std::vector<const Workload*> selected;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            benchmark = true;
+        } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            benchOps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--burst") == 0 && i + 1 < argc) {
+            benchBurst = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pages") == 0 && i + 1 < argc) {
+            benchPages = (uint16_t)atoi(argv[++i]);
+        } else if (benchmark && argv[i][0] != '-') {
+            const Workload* found = nullptr;
+            for (const Workload& workload : WORKLOADS) {
+                if (strcmp(workload.name, argv[i]) == 0) found = &workload;
+            }
+            if (found == nullptr) {
+                fprintf(stderr, "Unknown workload %s\n", argv[i]);
+                return 2;
+            }
+            selected.push_back(found);
+        } else if (strcmp(argv[i], "--presses") == 0 && i + 1 < argc) {
+            presses = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            intervalMs = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--presses N] [--interval MS] [--quiet]\n"
+                            "       %s --bench [WORKLOAD]... [--ops N] [--burst N] [--pages N]\n", argv[0], argv[0]);
+            return 2;
+        }
+    }
+    if (benchmark) {
+        if (benchOps <= 0 || benchBurst <= 0 || benchPages < 2) {
+            fprintf(stderr, "--ops and --burst must be positive, --pages at least 2\n");
+            return 2;
+        }
+        if (selected.empty()) {
+            for (const Workload& workload : WORKLOADS) selected.push_back(&workload);
+        }
+        HostRuntime::exit(runBench(selected));
+    }
+    if (presses <= 0 || intervalMs >= CONFIG_COMMIT_QUIET_MS) {
+        fprintf(stderr, "--presses must be positive and --interval below CONFIG_COMMIT_QUIET_MS (%d)\n",
+                CONFIG_COMMIT_QUIET_MS);
+        return 2;
+    }
+
+    // A configured device: no first-boot defaults and restart
+    Preferences prefs;
+    prefs.begin(CONFIG_PARTITION, false);
+    prefs.putBool(RESET_FLAG, false);
+    ConfigManager config(&prefs);
+    config.begin();
+
+    const int32_t step = 10;
+    int32_t caseSpeed = config.getSetting(SETTING_CASE_RPM);
+    auto speedKey = [&](int i) {
+        caseSpeed = constrain(caseSpeed + ((i / 20) % 2 ? step : -step), HMI_SPEED_MIN, HMI_SPEED_MAX);  // Down, up, down...
+        if (!config.setSetting(SETTING_CASE_RPM, caseSpeed)) fail("setSetting(%ld) refused", (long)caseSpeed);
+    };
+
+    uint32_t writes = burst("speed key", config, false, speedKey);
+    if (writes != 1) fail("speed key: %u flash writes, expected one settings blob", (unsigned)writes);
+
+    writes = burst("speed key, SAVE", config, true, speedKey);
+    if (writes != 1) fail("speed key, SAVE: %u flash writes, expected one", (unsigned)writes);
+
+    int32_t counter = 0;
+    writes = burst("cached key", config, false, [&](int i) { config.PutInt("hmiPresses", ++counter); });
+    if (writes != 1) fail("cached key: %u flash writes, expected the key alone", (unsigned)writes);
+
+    // The counter rides along with the next blob, counting the key's entries too
+    writes = burst("speed key", config, false, speedKey);
+    if (writes != 1) fail("speed key after cached key: %u flash writes, expected one settings blob", (unsigned)writes);
+    int32_t lifetime = config.getSetting(SETTING_NVS_ENTRIES);
+
+    Preferences reopened;
+    reopened.begin(CONFIG_PARTITION, false);
+    ConfigManager after(&reopened);
+    after.begin();
+    if (after.getSetting(SETTING_CASE_RPM) != caseSpeed) {
+        fail("reopened: case speed %ld, expected %ld", (long)after.getSetting(SETTING_CASE_RPM), (long)caseSpeed);
+    }
+    if (after.GetInt("hmiPresses", -1) != counter) {
+        fail("reopened: hmiPresses %d, expected %ld", after.GetInt("hmiPresses", -1), (long)counter);
+    }
+    if (after.getSetting(SETTING_NVS_ENTRIES) != lifetime) {
+        fail("reopened: %ld lifetime NVS entries, expected %ld", (long)after.getSetting(SETTING_NVS_ENTRIES),
+             (long)lifetime);
+    }
+
+    // A full partition: the failed put stays pending and is not counted
+    std::vector<std::string> fillers;
+    while (fillers.size() < 1000) {  // One entry each, down to the last free one
+        std::string key = "fill" + std::to_string(fillers.size());
+        if (prefs.putInt(key.c_str(), 0) == 0) break;
+        fillers.push_back(key);
+    }
+    uint32_t counted = after.getNvsWrites();
+    uint32_t commits = after.getCommitCount();
+    after.PutInt("hmiPresses", ++counter);
+    after.commit();
+    if (after.getPendingCount() == 0) fail("partition full: the failed put was dropped, not kept pending");
+    if (after.getNvsWrites() != counted || after.getCommitCount() != commits) {
+        fail("partition full: %u NVS write(s) and %u commit(s) counted for a failed put",
+             (unsigned)(after.getNvsWrites() - counted), (unsigned)(after.getCommitCount() - commits));
+    }
+    for (const std::string& key : fillers) prefs.remove(key.c_str());
+    after.commit();
+    if (after.getPendingCount() != 0 || prefs.getInt("hmiPresses", -1) != counter) {
+        fail("partition freed: hmiPresses %d in flash, expected %ld", prefs.getInt("hmiPresses", -1), (long)counter);
+    }
+    if (!quiet) printf("partition full     a failed put stayed pending and was written once there was room\n");
+
+    if (HostRuntime::failures() == 0) printf("OK: ConfigManager coalesces a burst of %d presses into one commit\n", presses);
+    HostRuntime::exit(HostRuntime::failures() == 0 ? 0 : 1);
+}
@@ -0,0 +1,95 @@
+// Host check that the disc step task keeps every setpoint it is given.
+//
+// Builds the real src/A4988Manager.cpp against the stand-ins in host/,
+// drives the sensor pin with HostRuntime::setPin() and counts the step
+// pulses on the disc step pin. setFrequency() is the only writer of the
+// step interval; the task used to park the stop time in it during a dwell
+// and put back a copy taken earlier, so a setpoint that arrived in the
+// meantime was lost. Checks that:
+//
+//   - a setpoint given while the task waits for a sensor edge is stepped;
+//   - a setpoint given during a dwell is stepped once the dwell ends;
+//   - the dwell itself lasts the stop time, not a step interval;
+//   - getStepInterval() matches the last setpoint after both.
+//
+// Rates are compared with a wide margin: host sleeps run long.
+//
+// Build:  g++ -O2 -std=c++17 -pthread -Ihost -I../src -I../.pio/libdeps/esp32-s3-devkitc-1/ArduinoJson/src
+//             -o StepTaskCheck StepTaskCheck.cpp host/HostRuntime.cpp host/SD.cpp
+//             ../src/A4988Manager.cpp ../src/StepJitter.cpp ../src/EventLogger.cpp ../src/DeferredLog.cpp
+//             ../src/TaskHealth.cpp ../src/Trace.cpp ../src/Metrics.cpp
+// Usage:  StepTaskCheck [--quiet]
+// Exit status is 1 when a check fails.
+
+#include "A4988Manager.h"
+#include "HostRuntime.h"
+
+#define CHECK_STOP_MS      300   // Dwell after each sensor edge
+#define CHECK_WINDOW_MS    400   // Step pulses are counted over this long
+
+using HostRuntime::fail;
+
+static bool quiet = false;
+
+/**
+ * Counts disc step pulses over CHECK_WINDOW_MS and checks them against
+ * the rate of @p frequency, as the task steps it: two waits of whole ms.
+ */
+static void checkRate(const char* label, A4988Manager& disc, float frequency) {
+    unsigned long interval = (unsigned long)(1000.0 / frequency);
+    uint32_t expected = CHECK_WINDOW_MS / (2 * interval);
+    uint32_t before = HostRuntime::pinRises(STEP_PIN_DISC);
+    delay(CHECK_WINDOW_MS);
+    uint32_t steps = HostRuntime::pinRises(STEP_PIN_DISC) - before;
+    if (!quiet) {
+        printf("%-28s %4u steps in %u ms, %u expected at %.0f Hz\n", label, (unsigned)steps,
+               (unsigned)CHECK_WINDOW_MS, (unsigned)expected, frequency);
+    }
+    if (disc.getStepInterval() != interval) {
+        fail("%s: step interval %lu ms, %lu ms for %.0f Hz", label, disc.getStepInterval(), interval, frequency);
+    }
+    if (steps < expected / 2 || steps > expected * 3 / 2) {
+        fail("%s: %u steps, %u expected at %.0f Hz", label, (unsigned)steps, (unsigned)expected, frequency);
+    }
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quiet") == 0) quiet = true;
+        else {
+            fprintf(stderr, "Usage: %s [--quiet]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    A4988Manager disc(STEP_PIN_DISC, DIR_PIN_DISC, ENABLE_PIN_DISC, MS01_PIN_DISC, MS02_PIN_DISC,
+                      MS03_PIN_DISC, SLP_PIN_DISC, RESET_PIN_DISC, true);
+    disc.begin();
+    disc.SetStopTime(CHECK_STOP_MS);
+    disc.SetStepsToTake(2);
+    HostRuntime::setPin(SENSOR_PIN, LOW);
+
+    disc.setFrequency(HMI_SPEED_MIN);
+    delay(100);
+    disc.setFrequency(250);  // While the task waits for an edge
+    checkRate("setpoint before an edge", disc, 250);
+
+    // A product passes: the task steps out of the switching zone, then stops
+    uint32_t edgeAt = millis();
+    HostRuntime::setPin(SENSOR_PIN, HIGH);
+    delay(50);
+    HostRuntime::setPin(SENSOR_PIN, LOW);
+    delay(100);
+    disc.setFrequency(125);  // During the dwell
+    delay(CHECK_STOP_MS + 50 - (millis() - edgeAt));
+    uint32_t dwellUs = disc.getLastDwellUs();
+    if (!quiet) printf("dwell                        %4u ms, stop time %u ms\n", (unsigned)(dwellUs / 1000), CHECK_STOP_MS);
+    if (dwellUs < (CHECK_STOP_MS - 10) * 1000UL || dwellUs > (CHECK_STOP_MS + 100) * 1000UL) {
+        fail("the dwell lasted %u us, the stop time is %u ms", (unsigned)dwellUs, CHECK_STOP_MS);
+    }
+    checkRate("setpoint during a dwell", disc, 125);
+
+    disc.setFrequency(0);
+    if (HostRuntime::failures() == 0) printf("OK: setpoints given before an edge and during a dwell are stepped\n");
+    HostRuntime::exit(HostRuntime::failures() == 0 ? 0 : 1);
+}
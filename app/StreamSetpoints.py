@@ -0,0 +1,99 @@
+import argparse
+import json
+import time
+import serial
+
+# Host side of the command link credit protocol.
+#
+# The device advertises {"window":W,"credits":C,"lineSize":L} at boot and on
+# FLOWCONTROL, then replenishes with {"credits":N} as it frees command slots.
+# A line may only be sent while at least one credit is available, which
+# keeps the device RX buffer from ever overflowing.
+
+
+class CreditLink:
+    def __init__(self, port, baudrate=115200, timeout=0.05):
+        self.ser = serial.Serial(port, baudrate, timeout=timeout)
+        self.credits = 0
+        self.line_size = 256
+        self.lines = []          # Non-credit lines received from the device
+        self._rx = b""
+
+    # Ask the device to (re)advertise its window and wait for it
+    def sync(self, wait=2.0):
+        self.ser.write(b'{"command":"FLOWCONTROL","enable":true}\n')
+        deadline = time.time() + wait
+        while time.time() < deadline:
+            for msg in self.poll():
+                if "window" in msg:
+                    return msg["window"]
+        raise TimeoutError("device did not advertise a credit window")
+
+    # Read whatever is pending and apply credit updates
+    def poll(self):
+        self._rx += self.ser.read(self.ser.in_waiting or 1)
+        messages = []
+        while b"\n" in self._rx:
+            raw, self._rx = self._rx.split(b"\n", 1)
+            text = raw.decode("utf-8", "replace").strip()
+            msg = None
+            if text.startswith("{"):
+                try:
+                    msg = json.loads(text)
+                except json.JSONDecodeError:
+                    msg = None
+            if isinstance(msg, dict) and "window" in msg:
+                self.credits = msg.get("credits", msg["window"])
+                self.line_size = msg.get("lineSize", self.line_size)
+                messages.append(msg)
+            elif isinstance(msg, dict) and set(msg.keys()) == {"credits"}:
+                self.credits += msg["credits"]
+                messages.append(msg)
+            else:
+                self.lines.append(text)
+        return messages
+
+    # Send one command, blocking only on the host side until a credit is free
+    def send(self, command):
+        line = json.dumps(command, separators=(",", ":")).encode("utf-8") + b"\n"
+        if len(line) > self.line_size:
+            raise ValueError("command longer than device line size")
+        while self.credits <= 0:
+            self.poll()
+        self.ser.write(line)
+        self.credits -= 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stream motor setpoints using credit-based flow control")
+    parser.add_argument("port")
+    parser.add_argument("--count", type=int, default=1000)
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    link = CreditLink(args.port, args.baud)
+    window = link.sync()
+    print(f"Credit window: {window}")
+
+    start = time.time()
+    for i in range(args.count):
+        link.send({
+            "command": "motor",
+            "motorType": "motorCase",
+            "speed": 100.0 + (i % 200),
+            "microsteps": 4,
+            "direction": 1,
+        })
+    # Wait until every credit has come back, i.e. all commands were processed
+    deadline = time.time() + 5.0
+    while link.credits < window and time.time() < deadline:
+        link.poll()
+    elapsed = time.time() - start
+
+    echoed = sum(1 for line in link.lines if line.startswith('{"command":"motor"'))
+    print(f"Sent {args.count} commands in {elapsed:.2f} s ({args.count / elapsed:.0f} cmd/s)")
+    print(f"Echoed by device: {echoed}, missing: {args.count - echoed}")
+
+
+if __name__ == "__main__":
+    main()
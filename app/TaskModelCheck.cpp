@@ -0,0 +1,266 @@
+// Host check of the firmware task model declared in src/Config.h.
+//
+// Builds the task table from the Config.h macros (core, priority, period)
+// with worst-case execution time estimates, adds the ESP-IDF system tasks
+// that share the cores, and checks:
+//
+//   - the motor step tasks are alone on STEP_CORE and above every
+//     application task;
+//   - the priority tiers are ordered: step > input > output > idle;
+//   - every task meets its deadline under fixed-priority preemptive
+//     scheduling, by response-time analysis per core
+//     (R = C + sum over higher or equal priority tasks of ceil(R / Tj) * Cj,
+//     equal priorities counted as interference since FreeRTOS time-slices
+//     them). Step and input tasks must finish within their period (or an
+//     explicit deadline); output and idle tasks only have to check in
+//     before TaskHealth reports them late (TASK_HEALTH_LATE_MS);
+//   - no supervised task blocks longer than TASK_IDLE_WAKE_MS between
+//     check-ins, and that wait plus its response time stays within
+//     TASK_HEALTH_LATE_MS;
+//   - the watchdog timings are consistent: TASK_FEED_MS < TASK_IDLE_WAKE_MS
+//     < TASK_HEALTH_LATE_MS < TASK_WDT_TIMEOUT_S, and the supervised tasks
+//     fit TASK_HEALTH_MAX_TASKS.
+//
+// The WCET defaults are unmeasured estimates. The check only means
+// something once they are replaced with figures taken from TRACEDUMP
+// spans on the target, passed with --wcet. Sporadic tasks use their
+// minimum inter-arrival time as period (a command back to back on the
+// console UART, a display event back to back on the Nextion UART); the
+// boot stages run once, so their period is a whole boot and their
+// deadline the stage timeout (BOOT_HMI_TIMEOUT_MS when they have none).
+//
+// Build:  g++ -O2 -std=c++17 -o TaskModelCheck TaskModelCheck.cpp
+// Usage:  TaskModelCheck [--wcet NAME=US]... [--step-hz HZ] [--quiet]
+// Exit status is 1 when a check fails.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../src/Config.h"
+
+enum Tier { SYSTEM, STEP, INPUT, OUTPUT, IDLE };
+
+static const char* const TIER_NAMES[] = { "system", "step", "input", "output", "idle" };
+
+struct TaskSpec {
+    std::string name;
+    Tier tier;
+    int core;
+    int priority;
+    double periodUs;      // Period or minimum inter-arrival time
+    double wcetUs;
+    double deadlineUs;    // 0: the tier default, see deadlineOf()
+    bool supervised;      // Registered with TaskHealth
+    double blockUs = 0;   // Longest wait between two check-ins, 0: the period
+};
+
+// Microseconds to move @p bytes over a UART at @p baud (8N1)
+static double uartUs(int bytes, long baud) {
+    return bytes * 10.0 * 1e6 / baud;
+}
+
+static std::vector<TaskSpec> buildModel(double stepHz) {
+    const double stepPeriodUs = std::max(1e6 / stepHz, 1000.0);  // vTaskDelay() granularity is one tick
+    const double bootPeriodUs = 60e6;                              // Once per boot
+    const double bootDeadlineUs = BOOT_HMI_TIMEOUT_MS * 1000.0;
+    return {
+        // ESP-IDF system tasks: tick interrupt and IPC on both cores, esp_timer on core 0
+        { "tick.0",        SYSTEM, 0, 25, 1000, 5, 0, false },
+        { "tick.1",        SYSTEM, 1, 25, 1000, 5, 0, false },
+        { "ipc.0",         SYSTEM, 0, 24, 10000, 20, 0, false },
+        { "ipc.1",         SYSTEM, 1, 24, 10000, 20, 0, false },
+        { "esp_timer",     SYSTEM, 0, 22, 1000, 10, 0, false },
+
+        { "motor.case",    STEP,   STEP_CORE, STEP_TASK_PRIORITY, stepPeriodUs, 40, 0, true },
+        { "motor.disc",    STEP,   STEP_CORE, STEP_TASK_PRIORITY, stepPeriodUs, 60, 0, true },
+
+        { "command",       INPUT,  COMMAND_TASK_CORE, COMMAND_TASK_PRIORITY,
+          uartUs(64, BAUDE_RATE), 1500, 20000, true, TASK_IDLE_WAKE_MS * 1000.0 },
+        { "hmi.rx",        INPUT,  NEXTION_TASK_CORE, NEXTION_TASK_PRIORITY,
+          uartUs(7, NEXTION_BAUDRATE), 300, NEXTION_IDLE_FLUSH_MS * 1000.0 + uartUs(7, NEXTION_BAUDRATE), true,
+          TASK_IDLE_WAKE_MS * 1000.0 },
+
+        { "hmi.tx",        OUTPUT, NEXTION_WRITER_TASK_CORE, NEXTION_WRITER_TASK_PRIORITY, 20000, 600, 0, true },
+        { "hmi.hold",      OUTPUT, NEXTION_TASK_CORE, NEXTION_HOLD_TASK_PRIORITY,
+          NEXTION_REPEAT_PERIOD_MS * 1000.0, 200, 0, true, TASK_IDLE_WAKE_MS * 1000.0 },
+        { "telemetry",     OUTPUT, TELEMETRY_TASK_CORE, TELEMETRY_TASK_PRIORITY,
+          1e6 / TELEMETRY_MAX_RATE_HZ, 800, 0, true, 1e6 },  // 1 Hz at the lowest rate
+        { "event.drain",   OUTPUT, EVENT_LOG_TASK_CORE, EVENT_LOG_TASK_PRIORITY,
+          EVENT_LOG_DRAIN_PERIOD_MS * 1000.0, 200, 0, true },
+        { "event.write",   OUTPUT, EVENT_LOG_TASK_CORE, EVENT_LOG_TASK_PRIORITY,
+          EVENT_LOG_FLUSH_MS * 1000.0, 8000, 0, true },
+        { "config.commit", OUTPUT, CONFIG_COMMIT_TASK_CORE, CONFIG_COMMIT_TASK_PRIORITY,
+          std::min(CONFIG_COMMIT_QUIET_MS, TASK_IDLE_WAKE_MS) * 1000.0, 30000, 0, true },
+        { "warm.sync",     OUTPUT, WARM_TASK_CORE, WARM_TASK_PRIORITY,
+          WARM_SYNC_PERIOD_MS * 1000.0, 100, 0, true },
+
+        // Boot stages of main.cpp, not supervised
+        { "boot.console",  OUTPUT, BOOT_TASK_CORE, BOOT_TASK_PRIORITY, bootPeriodUs, 5000, bootDeadlineUs, false },
+        { "boot.motors",   OUTPUT, BOOT_TASK_CORE, BOOT_TASK_PRIORITY, bootPeriodUs, 2000, bootDeadlineUs, false },
+        { "boot.sd",       OUTPUT, BOOT_TASK_CORE, BOOT_TASK_PRIORITY, bootPeriodUs, 30000,
+          BOOT_SD_TIMEOUT_MS * 1000.0, false },
+        { "boot.resume",   OUTPUT, BOOT_TASK_CORE, BOOT_TASK_PRIORITY, bootPeriodUs, 5000, bootDeadlineUs, false },
+        { "boot.config",   OUTPUT, BOOT_TASK_CORE, BOOT_TASK_PRIORITY, bootPeriodUs, 20000, bootDeadlineUs, false },
+        { "boot.recipes",  OUTPUT, BOOT_TASK_CORE, BOOT_TASK_PRIORITY, bootPeriodUs, 10000, bootDeadlineUs, false },
+        { "boot.display",  OUTPUT, BOOT_TASK_CORE, BOOT_TASK_PRIORITY, bootPeriodUs, 50000, bootDeadlineUs, false },
+
+        { "hmi.trend",     IDLE,   NEXTION_TREND_TASK_CORE, NEXTION_TREND_TASK_PRIORITY,
+          NEXTION_TREND_SAMPLE_MS * 1000.0, 300, 0, true },
+        { "log.drain",     IDLE,   DEFERRED_LOG_TASK_CORE, DEFERRED_LOG_TASK_PRIORITY,
+          DEFERRED_LOG_DRAIN_PERIOD_MS * 1000.0, 1000, 0, true },
+    };
+}
+
+static int failures = 0;
+
+static double deadlineOf(const TaskSpec& task) {
+    if (task.deadlineUs > 0) return task.deadlineUs;
+    return task.tier >= OUTPUT ? TASK_HEALTH_LATE_MS * 1000.0 : task.periodUs;
+}
+
+__attribute__((format(printf, 1, 2)))
+static void fail(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    printf("FAIL: ");
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+    failures++;
+}
+
+/**
+ * Worst-case response time of @p task on its core, or a value above the
+ * deadline when the iteration passes it.
+ */
+static double responseTime(const TaskSpec& task, const std::vector<TaskSpec>& model) {
+    double deadline = deadlineOf(task);
+    double r = task.wcetUs;
+    while (true) {
+        double next = task.wcetUs;
+        for (const TaskSpec& other : model) {
+            if (&other == &task || other.core != task.core || other.priority < task.priority) continue;
+            next += std::ceil(r / other.periodUs) * other.wcetUs;
+        }
+        if (next == r || next > deadline) return next;
+        r = next;
+    }
+}
+
+static void checkPlacement(const std::vector<TaskSpec>& model) {
+    int stepMin = 1000;
+    int appMax = -1;
+    for (const TaskSpec& task : model) {
+        if (task.tier == STEP) {
+            stepMin = std::min(stepMin, task.priority);
+            if (task.core != STEP_CORE) fail("%s is not on STEP_CORE", task.name.c_str());
+        } else if (task.tier != SYSTEM) {
+            appMax = std::max(appMax, task.priority);
+            if (task.core == STEP_CORE) fail("%s shares STEP_CORE with the step tasks", task.name.c_str());
+        }
+    }
+    if (stepMin <= appMax) fail("step tasks are not above every application task");
+
+    // Each tier strictly above the next one
+    for (int tier = STEP; tier < IDLE; tier++) {
+        int low = 1000;
+        int high = -1;
+        for (const TaskSpec& task : model) {
+            if (task.tier == tier) low = std::min(low, task.priority);
+            if (task.tier == tier + 1) high = std::max(high, task.priority);
+        }
+        if (high >= 0 && low <= high) fail("%s tier is not above the %s tier", TIER_NAMES[tier], TIER_NAMES[tier + 1]);
+    }
+}
+
+static void checkWatchdog(const std::vector<TaskSpec>& model) {
+    if (TASK_FEED_MS >= TASK_IDLE_WAKE_MS) fail("TASK_FEED_MS must be below TASK_IDLE_WAKE_MS");
+    if (TASK_IDLE_WAKE_MS >= TASK_HEALTH_LATE_MS) fail("TASK_IDLE_WAKE_MS must be below TASK_HEALTH_LATE_MS");
+    if (TASK_HEALTH_LATE_MS >= TASK_WDT_TIMEOUT_S * 1000) fail("TASK_HEALTH_LATE_MS must be below TASK_WDT_TIMEOUT_S");
+    long supervised = std::count_if(model.begin(), model.end(), [](const TaskSpec& t) { return t.supervised; });
+    if (supervised > TASK_HEALTH_MAX_TASKS) fail("more supervised tasks than TASK_HEALTH_MAX_TASKS");
+}
+
+static void checkSchedule(const std::vector<TaskSpec>& model, bool quiet) {
+    if (!quiet) {
+        printf("%-14s %-7s %4s %4s %10s %8s %10s %10s\n",
+               "task", "tier", "core", "prio", "period_us", "wcet_us", "resp_us", "deadl_us");
+    }
+    for (int core = 0; core < 2; core++) {
+        double utilization = 0;
+        for (const TaskSpec& task : model) {
+            if (task.core != core) continue;
+            utilization += task.wcetUs / task.periodUs;
+            double deadline = deadlineOf(task);
+            double r = responseTime(task, model);
+            if (!quiet) {
+                printf("%-14s %-7s %4d %4d %10.0f %8.0f %10.0f %10.0f%s\n",
+                       task.name.c_str(), TIER_NAMES[task.tier], task.core, task.priority,
+                       task.periodUs, task.wcetUs, r, deadline, r > deadline ? "  MISSED" : "");
+            }
+            if (r > deadline) fail("%s misses its deadline (%.0f > %.0f us)", task.name.c_str(), r, deadline);
+            if (!task.supervised) continue;
+            double block = task.blockUs > 0 ? task.blockUs : task.periodUs;
+            if (block > TASK_IDLE_WAKE_MS * 1000.0) {
+                fail("%s blocks %.0f us between check-ins, above TASK_IDLE_WAKE_MS", task.name.c_str(), block);
+            }
+            if (block + r > TASK_HEALTH_LATE_MS * 1000.0) {
+                fail("%s checks in %.0f us apart, reported late", task.name.c_str(), block + r);
+            }
+        }
+        if (!quiet) printf("core %d utilization %.1f %%\n", core, utilization * 100);
+        if (utilization > 1) fail("core %d utilization above 100 %%", core);
+    }
+}
+
+int main(int argc, char** argv) {
+    double stepHz = 1000;
+    bool quiet = false;
+    std::vector<std::pair<std::string, double>> wcets;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step-hz") == 0 && i + 1 < argc) {
+            stepHz = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--wcet") == 0 && i + 1 < argc) {
+            const char* arg = argv[++i];
+            const char* eq = strchr(arg, '=');
+            if (eq == nullptr) {
+                fprintf(stderr, "--wcet expects NAME=US\n");
+                return 2;
+            }
+            wcets.emplace_back(std::string(arg, eq), atof(eq + 1));
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--wcet NAME=US]... [--step-hz HZ] [--quiet]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (stepHz <= 0) {
+        fprintf(stderr, "--step-hz must be positive\n");
+        return 2;
+    }
+
+    std::vector<TaskSpec> model = buildModel(stepHz);
+    for (const auto& [name, us] : wcets) {
+        auto task = std::find_if(model.begin(), model.end(), [&](const TaskSpec& t) { return t.name == name; });
+        if (task == model.end()) {
+            fprintf(stderr, "Unknown task %s\n", name.c_str());
+            return 2;
+        }
+        task->wcetUs = us;
+    }
+
+    checkPlacement(model);
+    checkWatchdog(model);
+    checkSchedule(model, quiet);
+
+    if (failures == 0) printf("OK: task model of Config.h holds\n");
+    return failures == 0 ? 0 : 1;
+}
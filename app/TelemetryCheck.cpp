@@ -0,0 +1,110 @@
+// Host check that SUBSCRIBE actually puts telemetry frames on the wire.
+//
+// Builds the real src/CommandReceiver.cpp and TelemetryStreamer.cpp
+// against the stand-ins in host/, whose Serial reports the 128-byte
+// hardware FIFO from availableForWrite() unless a TX ring was set. It
+// subscribes at --rate Hz for --ms ms and checks that:
+//
+//   - CommandReceiver::begin() gave the console UART a TX ring that holds
+//     a whole frame, so the streamer's backpressure check can pass;
+//   - a keyframe is longer than the FIFO alone (the reason for the ring);
+//   - the first frame out is a keyframe and later ones are deltas, with
+//     consecutive sequence numbers (nothing dropped on an idle link);
+//   - UNSUBSCRIBE stops the stream.
+//
+// Build:  g++ -O2 -std=c++17 -pthread -Ihost -I../src -I../.pio/libdeps/esp32-s3-devkitc-1/ArduinoJson/src
+//             -o TelemetryCheck TelemetryCheck.cpp host/HostRuntime.cpp host/Preferences.cpp host/SD.cpp
+//             (the ../src files of the CommandHarness build line)
+// Usage:  TelemetryCheck [--rate HZ] [--ms MS] [--quiet]
+// Exit status is 1 when a check fails.
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "CommandReceiver.h"
+#include "HostRuntime.h"
+
+using HostRuntime::fail;
+
+int main(int argc, char** argv) {
+    uint32_t rate = 50;
+    uint32_t ms = 300;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        bool value = i + 1 < argc;
+        if (strcmp(argv[i], "--rate") == 0 && value) rate = atol(argv[++i]);
+        else if (strcmp(argv[i], "--ms") == 0 && value) ms = atol(argv[++i]);
+        else if (strcmp(argv[i], "--quiet") == 0) quiet = true;
+        else {
+            fprintf(stderr, "Usage: %s [--rate HZ] [--ms MS] [--quiet]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (rate == 0 || rate > TELEMETRY_MAX_RATE_HZ || ms == 0) {
+        fprintf(stderr, "--rate must be 1-%d, --ms positive\n", TELEMETRY_MAX_RATE_HZ);
+        return 2;
+    }
+
+    A4988Manager discMotor(STEP_PIN_DISC, DIR_PIN_DISC, ENABLE_PIN_DISC, MS01_PIN_DISC, MS02_PIN_DISC,
+                           MS03_PIN_DISC, SLP_PIN_DISC, RESET_PIN_DISC, true);
+    A4988Manager caseMotor(STEP_PIN_CASE, DIR_PIN_CASE, ENABLE_PIN_CASE, MS01_PIN_CASE, MS02_PIN_CASE,
+                           MS03_PIN_CASE, SLP_PIN_CASE, RESET_PIN_CASE, false);
+    Sensor sensor(SENSOR_PIN);
+    sensor.begin();
+    CommandReceiver receiver(&sensor, caseMotor, discMotor);
+
+    if (Serial.availableForWrite() != HOST_UART_FIFO_SIZE) {
+        fail("the UART reports %d bytes free before begin(), not the FIFO", Serial.availableForWrite());
+    }
+    receiver.begin();
+    Serial.hostTake();  // Credit window
+    if (Serial.availableForWrite() < TELEMETRY_FRAME_SIZE) {
+        fail("availableForWrite() is %d after begin(), a %d-byte frame never fits",
+             Serial.availableForWrite(), TELEMETRY_FRAME_SIZE);
+    }
+
+    char command[64];
+    snprintf(command, sizeof(command), "{\"command\":\"SUBSCRIBE\",\"rate\":%u}", (unsigned)rate);
+    if (!receiver.receiveCommand(command, strlen(command))) fail("SUBSCRIBE not recognized");
+    delay(ms);
+    const char* stop = "{\"command\":\"UNSUBSCRIBE\"}";
+    receiver.receiveCommand(stop, strlen(stop));
+    std::string output = Serial.hostTake();
+    delay(1000 / rate * 3);
+    std::string after = Serial.hostTake();
+
+    uint32_t frames = 0, keyframes = 0, gaps = 0;
+    size_t keyframeBytes = 0;
+    long previous = -1;
+    std::stringstream lines(output);
+    std::string line;
+    while (std::getline(lines, line)) {
+        long sequence;
+        int key;
+        if (sscanf(line.c_str(), "{\"tlm\":%ld,\"ts\":%*llu,\"key\":%d", &sequence, &key) != 2) continue;
+        if (frames == 0 && key != 1) fail("the first frame (%ld) is not a keyframe", sequence);
+        if (previous >= 0 && sequence != previous + 1) gaps++;
+        if (key == 1) {
+            keyframes++;
+            keyframeBytes = std::max(keyframeBytes, line.size() + 1);
+        }
+        previous = sequence;
+        frames++;
+    }
+
+    if (!quiet) {
+        printf("%u frames in %u ms at %u Hz: %u keyframe(s) of up to %zu bytes, %u gap(s)\n", (unsigned)frames,
+               (unsigned)ms, (unsigned)rate, (unsigned)keyframes, keyframeBytes, (unsigned)gaps);
+        printf("UART TX space after begin(): %d bytes (FIFO %d)\n", Serial.availableForWrite(), HOST_UART_FIFO_SIZE);
+    }
+    if (keyframes == 0) fail("no keyframe went out");
+    if (keyframes && keyframeBytes <= HOST_UART_FIFO_SIZE) {
+        fail("a keyframe is %zu bytes, it would fit the FIFO alone", keyframeBytes);
+    }
+    if (frames < 2) fail("%u frame(s) in %u ms at %u Hz", (unsigned)frames, (unsigned)ms, (unsigned)rate);
+    if (gaps) fail("%u gap(s) in the sequence numbers on an idle link", (unsigned)gaps);
+    if (after.find("\"tlm\"") != std::string::npos) fail("frames still sent after UNSUBSCRIBE");
+    if (HostRuntime::failures() == 0) printf("OK: telemetry frames fit the TX ring and the stream starts with a keyframe\n");
+    HostRuntime::exit(HostRuntime::failures() == 0 ? 0 : 1);
+}
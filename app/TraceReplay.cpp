@@ -0,0 +1,413 @@
+// Offline replay of sensor traces recorded with the CAPTURE command.
+//
+// A capture logs every raw sensor transition (with the disc step count at
+// that moment) and every step pulse. Since the products sit at fixed disc
+// positions, the transitions give the product layout in step coordinates,
+// independent of how the firmware moved the disc. This tool runs the disc
+// stop logic of A4988Manager::motorStepTask over that layout with other
+// stop offsets and stop times and reports the stop position of every cycle,
+// the products that pass without a stop, and the cycle time.
+//
+// Input is the column directory written by EventLogDecode --columns.
+//
+// Build:  g++ -O2 -std=c++17 -o TraceReplay TraceReplay.cpp
+// Usage:  TraceReplay [options] COLUMN_DIR
+//   --steps A[:B[:INC]]   stop offsets (steps after the edge) to try, default: captured
+//   --stop A[:B[:INC]]    stop times (ms) to try, default: captured
+//   --speed HZ            disc step frequency, default: measured step period
+//   --ref lead|center|trail  product point the stop is measured from (center)
+//   --target STEPS        wanted distance from that point, errors are relative to it (0)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Product seen by the sensor: disc steps [start, end) with the sensor high
+struct Product {
+    int64_t start;
+    int64_t end;
+};
+
+struct Session {
+    int64_t startStep = -1;
+    int64_t endStep = -1;
+    std::vector<std::pair<int64_t, int>> edges;   // (step, level) from the sensor ISR
+    std::vector<Product> products;
+    std::vector<int64_t> capturedStops;           // DWELL_START positions
+    std::vector<int64_t> capturedStopUs;
+    std::vector<double> stepPeriods;              // Between consecutive disc steps (us)
+    std::vector<double> dwellOverheads;           // Measured dwell - stop time (us)
+    int64_t stopTimeMs = -1;
+    int64_t stepsToTake = -1;
+    double speedHz = 0;
+    int64_t lastStepUs = -1;
+};
+
+struct Params {
+    int64_t steps;
+    int64_t stopMs;
+};
+
+struct Result {
+    std::vector<int64_t> stops;
+    std::vector<double> errors;
+    std::vector<double> cycleUs;
+    uint64_t products = 0;
+    uint64_t missed = 0;
+};
+
+template <typename T> bool readColumn(const std::string& path, std::vector<T>& column) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    column.resize(size / sizeof(T));
+    bool ok = fread(column.data(), sizeof(T), column.size(), file) == column.size();
+    fclose(file);
+    return ok;
+}
+
+double median(std::vector<double> values) {
+    if (values.empty()) return 0;
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Parses A, A:B or A:B:INC; B and INC default to A and 1
+bool parseRange(const char* text, std::vector<int64_t>& values) {
+    long long first, last, inc = 1;
+    int n = sscanf(text, "%lld:%lld:%lld", &first, &last, &inc);
+    if (n < 1 || inc <= 0) return false;
+    if (n == 1) last = first;
+    for (long long v = first; v <= last; v += inc) values.push_back(v);
+    return !values.empty();
+}
+
+// Turns the raw transitions into products. The motor task polls once per
+// step, so the level at step p is the level after the last transition
+// logged at a step <= p; pulses that start and end on the same step are
+// invisible to it and adjacent products merge.
+void buildProducts(Session& session) {
+    std::vector<std::pair<int64_t, int>> levels;  // Level from each step on
+    for (const auto& edge : session.edges) {
+        if (!levels.empty() && levels.back().first == edge.first) levels.back().second = edge.second;
+        else levels.push_back(edge);
+    }
+    bool high = false;
+    int64_t start = 0;
+    for (const auto& level : levels) {
+        if (level.second && !high) {
+            start = level.first;
+            high = true;
+        } else if (!level.second && high) {
+            session.products.push_back({ start, level.first });
+            high = false;
+        }
+    }
+    if (high) session.products.push_back({ start, session.endStep + 1 });
+}
+
+class Replay {
+public:
+    Replay(const Session& session, double stepUs, double dwellOverheadUs, const std::string& ref, double target)
+        : session(session), stepUs(stepUs), dwellOverheadUs(dwellOverheadUs), ref(ref), target(target) {}
+
+    // Mirrors the disc branch of A4988Manager::motorStepTask, one step per
+    // loop iteration (low phase, step, high phase = stepUs).
+    void run(const Params& params, Result& result) {
+        const std::vector<Product>& products = session.products;
+        std::vector<bool> served(products.size(), false);
+        size_t cursor = 0;
+        auto highAt = [&](int64_t pos) {
+            while (cursor < products.size() && products[cursor].end <= pos) cursor++;
+            return cursor < products.size() && products[cursor].start <= pos;
+        };
+
+        int64_t pos = session.startStep;
+        double timeUs = 0;
+        double lastStopUs = -1;
+        bool clearing = highAt(pos);  // Started on a product: step off it first
+        while (pos <= session.endStep) {
+            if (!clearing) {
+                // Wait for a rising edge, polled before every step
+                if (!highAt(pos)) {
+                    if (cursor >= products.size()) break;
+                    timeUs += (products[cursor].start - pos) * stepUs;
+                    pos = products[cursor].start;
+                    if (pos > session.endStep) break;
+                }
+                size_t product = cursor;
+                served[product] = true;
+                pos += params.steps;
+                timeUs += params.steps * stepUs;
+                if (pos > session.endStep) break;
+
+                result.stops.push_back(pos);
+                result.errors.push_back(pos - reference(products[product]) - target);
+                if (lastStopUs >= 0) result.cycleUs.push_back(timeUs - lastStopUs);
+                lastStopUs = timeUs;
+
+                // Stop, then the step that ends the dwell
+                timeUs += params.stopMs * 1000.0 + dwellOverheadUs + stepUs / 2;
+                pos++;
+            }
+            // Step while the sensor is high, at least once
+            pos++;
+            timeUs += stepUs;
+            if (highAt(pos)) {
+                timeUs += (products[cursor].end - pos) * stepUs;
+                pos = products[cursor].end;
+            }
+            clearing = false;
+        }
+
+        for (size_t i = 0; i < products.size(); i++) {
+            if (products[i].start <= session.startStep || products[i].start > session.endStep) continue;
+            result.products++;
+            if (!served[i]) result.missed++;
+        }
+    }
+
+private:
+    double reference(const Product& product) const {
+        if (ref == "lead") return product.start;
+        if (ref == "trail") return product.end;
+        return (product.start + product.end) / 2.0;
+    }
+
+    const Session& session;
+    double stepUs;
+    double dwellOverheadUs;
+    std::string ref;
+    double target;
+};
+
+void usage() {
+    fprintf(stderr, "Usage: TraceReplay [--steps A[:B[:INC]]] [--stop A[:B[:INC]]] [--speed HZ]\n"
+                    "                   [--ref lead|center|trail] [--target STEPS] COLUMN_DIR\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<int64_t> stepsList, stopList;
+    double speedHz = 0;
+    double target = 0;
+    std::string ref = "center";
+    std::string dir;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--steps" && hasValue) { if (!parseRange(argv[++i], stepsList)) { usage(); return 2; } }
+        else if (arg == "--stop" && hasValue) { if (!parseRange(argv[++i], stopList)) { usage(); return 2; } }
+        else if (arg == "--speed" && hasValue) speedHz = atof(argv[++i]);
+        else if (arg == "--target" && hasValue) target = atof(argv[++i]);
+        else if (arg == "--ref" && hasValue) ref = argv[++i];
+        else if (arg[0] == '-' || !dir.empty()) { usage(); return 2; }
+        else dir = arg;
+    }
+    if (dir.empty() || (ref != "lead" && ref != "center" && ref != "trail")) { usage(); return 2; }
+
+    // Event type and source ids from the schema
+    std::map<std::string, int> typeIds;
+    int discSource = -1;
+    std::ifstream info(dir + "/columns.txt");
+    std::string line;
+    while (std::getline(info, line)) {
+        std::istringstream in(line);
+        std::string kind, name;
+        int id;
+        in >> kind >> id >> name;
+        if (kind == "type") typeIds[name] = id;
+        else if (kind == "source" && name == "disc") discSource = id;
+    }
+    for (const char* name : { "STEP", "SENSOR_RAW", "CAPTURE", "DWELL_START", "DWELL_END", "SETPOINT", "SENSOR_PARAMS" }) {
+        if (!typeIds.count(name)) {
+            fprintf(stderr, "%s/columns.txt: no %s event, log written before capture support?\n", dir.c_str(), name);
+            return 1;
+        }
+    }
+
+    std::vector<int64_t> times;
+    std::vector<uint8_t> types, sources;
+    std::vector<int32_t> values0, values1;
+    if (!readColumn(dir + "/time_us.i64", times) || !readColumn(dir + "/type.u8", types)
+        || !readColumn(dir + "/source.u8", sources) || !readColumn(dir + "/value0.i32", values0)
+        || !readColumn(dir + "/value1.i32", values1) || types.size() != times.size()
+        || sources.size() != times.size() || values0.size() != times.size() || values1.size() != times.size()) {
+        fprintf(stderr, "%s: missing or inconsistent column files\n", dir.c_str());
+        return 1;
+    }
+
+    // Split into capture sessions; a reboot (time going back) also ends one
+    const int STEP = typeIds["STEP"], RAW = typeIds["SENSOR_RAW"], CAPTURE = typeIds["CAPTURE"];
+    const int DWELL_START = typeIds["DWELL_START"], DWELL_END = typeIds["DWELL_END"];
+    const int SETPOINT = typeIds["SETPOINT"], PARAMS = typeIds["SENSOR_PARAMS"];
+    std::vector<Session> sessions;
+    Session* session = nullptr;
+    int64_t lastUs = INT64_MIN;
+    for (size_t i = 0; i < times.size(); i++) {
+        int type = types[i];
+        if (times[i] < lastUs) session = nullptr;
+        lastUs = times[i];
+        if (type == CAPTURE) {
+            if (values0[i]) {
+                sessions.emplace_back();
+                session = &sessions.back();
+            } else {
+                session = nullptr;
+            }
+            continue;
+        }
+        if (session == nullptr || sources[i] != discSource) continue;
+
+        if (type == RAW) {
+            if (session->startStep < 0) session->startStep = values0[i];
+            session->edges.push_back({ values0[i], values1[i] != 0 });
+            session->endStep = std::max<int64_t>(session->endStep, values0[i]);
+        } else if (type == STEP) {
+            if (session->lastStepUs >= 0) session->stepPeriods.push_back(times[i] - session->lastStepUs);
+            session->lastStepUs = times[i];
+            session->endStep = std::max<int64_t>(session->endStep, values0[i]);
+        } else if (type == DWELL_START && session->startStep >= 0) {
+            session->capturedStops.push_back(values0[i]);
+            session->capturedStopUs.push_back(times[i]);
+            session->lastStepUs = -1;  // The next step ends the dwell, not a step period
+        } else if (type == DWELL_END && session->stopTimeMs >= 0) {
+            session->dwellOverheads.push_back(values1[i] - session->stopTimeMs * 1000.0);
+        } else if (type == PARAMS && session->stopTimeMs < 0) {
+            session->stopTimeMs = values0[i];
+            session->stepsToTake = values1[i];
+        } else if (type == SETPOINT && session->speedHz == 0) {
+            session->speedHz = values0[i] / 1000.0;
+        }
+    }
+    sessions.erase(std::remove_if(sessions.begin(), sessions.end(),
+                                  [](const Session& s) { return s.startStep < 0 || s.stopTimeMs < 0; }),
+                   sessions.end());
+    if (sessions.empty()) {
+        fprintf(stderr, "%s: no capture sessions (send {\"command\":\"CAPTURE\",\"enable\":true})\n", dir.c_str());
+        return 1;
+    }
+
+    // Timing model from the measurements, or from the firmware's integer
+    // millisecond interval when another speed is asked for
+    std::vector<double> periods, overheads;
+    uint64_t productCount = 0, capturedCount = 0;
+    for (Session& s : sessions) {
+        buildProducts(s);
+        productCount += s.products.size();
+        capturedCount += s.capturedStops.size();
+        periods.insert(periods.end(), s.stepPeriods.begin(), s.stepPeriods.end());
+        overheads.insert(overheads.end(), s.dwellOverheads.begin(), s.dwellOverheads.end());
+    }
+    double stepUs = speedHz > 0 ? 2000.0 * std::floor(1000.0 / speedHz) : median(periods);
+    double dwellOverheadUs = median(overheads);
+    if (stepUs <= 0) {
+        fprintf(stderr, "No disc steps in the capture; pass --speed\n");
+        return 1;
+    }
+
+    // Check the model: the captured settings must reproduce the captured stops
+    uint64_t matched = 0;
+    std::vector<double> measuredCycles;
+    for (const Session& s : sessions) {
+        Result result;
+        Replay(s, stepUs, dwellOverheadUs, ref, target).run({ s.stepsToTake, s.stopTimeMs }, result);
+        for (int64_t stop : s.capturedStops) {
+            if (std::binary_search(result.stops.begin(), result.stops.end(), stop)) matched++;
+        }
+        for (size_t i = 1; i < s.capturedStopUs.size(); i++) {
+            measuredCycles.push_back(s.capturedStopUs[i] - s.capturedStopUs[i - 1]);
+        }
+    }
+    const Session& first = sessions.front();
+    printf("%zu capture sessions, %llu products, %llu captured stops\n", sessions.size(),
+           (unsigned long long)productCount, (unsigned long long)capturedCount);
+    printf("captured settings: steps %lld, stop %lld ms, disc %.1f Hz\n", (long long)first.stepsToTake,
+           (long long)first.stopTimeMs, first.speedHz);
+    double measuredCycleMs = 0;
+    for (double c : measuredCycles) measuredCycleMs += c / 1000.0;
+    if (!measuredCycles.empty()) measuredCycleMs /= measuredCycles.size();
+    printf("step period %.0f us, dwell overhead %.0f us, measured cycle %.1f ms\n", stepUs, dwellOverheadUs,
+           measuredCycleMs);
+    printf("replay of the captured settings matches %llu of %llu stops\n\n", (unsigned long long)matched,
+           (unsigned long long)capturedCount);
+
+    if (stepsList.empty()) stepsList.push_back(first.stepsToTake);
+    if (stopList.empty()) stopList.push_back(first.stopTimeMs);
+
+    printf("%6s %8s %8s %7s %9s %8s %9s %10s %10s %8s\n", "steps", "stop_ms", "cycles", "missed", "bias",
+           "sd", "p95|err|", "cycle_ms", "p95_ms", "per_min");
+    Params best = { -1, -1 };
+    uint64_t bestMissed = UINT64_MAX;
+    double bestError = 0, bestCycle = 0;
+    for (int64_t stopMs : stopList) {
+        for (int64_t steps : stepsList) {
+            Result total;
+            for (const Session& s : sessions) {
+                Result result;
+                Replay(s, stepUs, dwellOverheadUs, ref, target).run({ steps, stopMs }, result);
+                total.errors.insert(total.errors.end(), result.errors.begin(), result.errors.end());
+                total.cycleUs.insert(total.cycleUs.end(), result.cycleUs.begin(), result.cycleUs.end());
+                total.products += result.products;
+                total.missed += result.missed;
+            }
+
+            double sum = 0, sumSquares = 0;
+            std::vector<double> absErrors;
+            for (double e : total.errors) {
+                sum += e;
+                sumSquares += e * e;
+                absErrors.push_back(std::fabs(e));
+            }
+            size_t n = total.errors.size();
+            double bias = n ? sum / n : 0;
+            double sd = n > 1 ? std::sqrt(std::max(0.0, (sumSquares - n * bias * bias) / (n - 1))) : 0;
+            double p95Error = percentile(absErrors, 0.95);
+            double cycleMs = 0;
+            for (double c : total.cycleUs) cycleMs += c / 1000.0;
+            if (!total.cycleUs.empty()) cycleMs /= total.cycleUs.size();
+            double p95Cycle = percentile(total.cycleUs, 0.95) / 1000.0;
+
+            printf("%6lld %8lld %8zu %7llu %9.2f %8.2f %9.2f %10.1f %10.1f %8.1f\n", (long long)steps,
+                   (long long)stopMs, n, (unsigned long long)total.missed, bias, sd, p95Error, cycleMs, p95Cycle,
+                   cycleMs > 0 ? 60000.0 / cycleMs : 0);
+
+            // Fewest missed products, then the tightest stops, then the fastest cycle
+            bool better = total.missed < bestMissed
+                || (total.missed == bestMissed && (p95Error < bestError
+                    || (p95Error == bestError && cycleMs < bestCycle)));
+            if (n > 0 && better) {
+                best = { steps, stopMs };
+                bestMissed = total.missed;
+                bestError = p95Error;
+                bestCycle = cycleMs;
+            }
+        }
+    }
+    if (best.steps >= 0 && (stepsList.size() > 1 || stopList.size() > 1)) {
+        printf("\nbest: steps %lld, stop %lld ms (%llu missed, p95 |error| %.2f steps, cycle %.1f ms)\n",
+               (long long)best.steps, (long long)best.stopMs, (unsigned long long)bestMissed, bestError,
+               bestCycle);
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Host check that a warm restart brings the disc back to its saved speed.
+//
+// Builds the real src/WarmRestart.cpp, CommandReceiver.cpp and
+// A4988Manager.cpp against the stand-ins in host/. A first WarmRestart
+// mirrors a running disc into "RTC memory" (a static in the same process);
+// a second one, begun with a watchdog reset reason, reads it back and
+// resume() ramps the disc from HMI_SPEED_MIN with setFrequency(). A sensor
+// edge arrives early in the ramp and its dwell lasts past the end of it,
+// so the last ramp steps land in the dwell, after which the step task
+// used to put back the interval it had at the edge. Checks that:
+//
+//   - the saved state is found and motion is resumed;
+//   - after the ramp getSpeed() is the saved speed and getStepInterval(),
+//     the interval the step task actually waits, matches it;
+//   - the measured step rate is that of the saved speed, not of the
+//     HMI_SPEED_MIN the ramp started from.
+//
+// Build:  g++ -O2 -std=c++17 -pthread -Ihost -I../src -I../.pio/libdeps/esp32-s3-devkitc-1/ArduinoJson/src
+//             -o WarmResumeCheck WarmResumeCheck.cpp host/HostRuntime.cpp host/Preferences.cpp host/SD.cpp
+//             (the ../src files of the CommandHarness build line)
+// Usage:  WarmResumeCheck [--speed HZ] [--quiet]
+// Exit status is 1 when a check fails.
+
+#include <thread>
+
+#include "CommandReceiver.h"
+#include "HostRuntime.h"
+#include "WarmRestart.h"
+
+#define CHECK_EDGE_MS      (WARM_RAMP_MS / 5)  // Sensor edge, from the start of the ramp
+#define CHECK_STOP_MS      (WARM_RAMP_MS - CHECK_EDGE_MS + 50)  // Dwell after it, past the ramp
+#define CHECK_WINDOW_MS    400   // Step pulses are counted over this long
+
+using HostRuntime::fail;
+
+int main(int argc, char** argv) {
+    float speed = 250;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        bool value = i + 1 < argc;
+        if (strcmp(argv[i], "--speed") == 0 && value) speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--quiet") == 0) quiet = true;
+        else {
+            fprintf(stderr, "Usage: %s [--speed HZ] [--quiet]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (speed <= HMI_SPEED_MIN || speed > HMI_SPEED_MAX) {
+        fprintf(stderr, "--speed must be above %d and at most %d Hz, so there is a ramp\n", HMI_SPEED_MIN,
+                HMI_SPEED_MAX);
+        return 2;
+    }
+
+    A4988Manager discMotor(STEP_PIN_DISC, DIR_PIN_DISC, ENABLE_PIN_DISC, MS01_PIN_DISC, MS02_PIN_DISC,
+                           MS03_PIN_DISC, SLP_PIN_DISC, RESET_PIN_DISC, true);
+    A4988Manager caseMotor(STEP_PIN_CASE, DIR_PIN_CASE, ENABLE_PIN_CASE, MS01_PIN_CASE, MS02_PIN_CASE,
+                           MS03_PIN_CASE, SLP_PIN_CASE, RESET_PIN_CASE, false);
+    Sensor sensor(SENSOR_PIN);
+    sensor.begin();
+    CommandReceiver receiver(&sensor, caseMotor, discMotor);
+    discMotor.begin();
+    caseMotor.begin();
+    HostRuntime::setPin(SENSOR_PIN, LOW);
+
+    // Before the reset: the disc runs and the state is mirrored
+    HostRuntime::setResetReason(ESP_RST_POWERON);
+    WarmRestart before(caseMotor, discMotor);
+    before.begin();
+    receiver.setSensorParameters(2, CHECK_STOP_MS, 2);
+    receiver.setMotorParameters(2, speed, 1, 1);
+    before.resume(&receiver);
+    delay(4 * WARM_SYNC_PERIOD_MS);
+
+    // The reset: the new boot reads the state, the disc is stopped until it resumes
+    HostRuntime::setResetReason(ESP_RST_TASK_WDT);
+    WarmRestart after(caseMotor, discMotor);
+    after.begin();
+    discMotor.setFrequency(0);
+
+    // A product reaches the sensor early in the ramp; its dwell covers the last steps
+    std::thread product([] {
+        delay(CHECK_EDGE_MS);
+        HostRuntime::setPin(SENSOR_PIN, HIGH);
+        delay(20);
+        HostRuntime::setPin(SENSOR_PIN, LOW);
+    });
+    if (!after.resume(&receiver)) fail("motion was not resumed after a watchdog reset");
+    product.join();
+    delay(CHECK_STOP_MS);  // Out of the dwell
+
+    unsigned long interval = (unsigned long)(1000.0 / speed);
+    uint32_t expected = CHECK_WINDOW_MS / (2 * interval);
+    uint32_t startSteps = HostRuntime::pinRises(STEP_PIN_DISC);
+    delay(CHECK_WINDOW_MS);
+    uint32_t steps = HostRuntime::pinRises(STEP_PIN_DISC) - startSteps;
+
+    if (!quiet) {
+        printf("resumed at %.0f Hz: interval %lu ms (%lu expected), %u steps in %u ms (%u expected)\n",
+               discMotor.getSpeed(), discMotor.getStepInterval(), interval, (unsigned)steps,
+               (unsigned)CHECK_WINDOW_MS, (unsigned)expected);
+    }
+    if (discMotor.getSpeed() != speed) fail("the disc reports %.1f Hz, %.1f Hz was saved", discMotor.getSpeed(), speed);
+    if (discMotor.getStepInterval() != interval) {
+        fail("the step task waits %lu ms, %lu ms for %.0f Hz", discMotor.getStepInterval(), interval, speed);
+    }
+    if (steps < expected / 2 || steps > expected * 3 / 2) {
+        fail("%u steps, %u expected at %.0f Hz", (unsigned)steps, (unsigned)expected, speed);
+    }
+
+    discMotor.setFrequency(0);
+    if (HostRuntime::failures() == 0) printf("OK: the disc resumed at the saved speed\n");
+    HostRuntime::exit(HostRuntime::failures() == 0 ? 0 : 1);
+}
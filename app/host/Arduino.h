@@ -0,0 +1,216 @@
+// Host stand-in for the Arduino-ESP32 core (app/ host checks only).
+//
+// Enough of String, Print, Stream, HardwareSerial, timing and ESP for the
+// firmware modules the host checks link. Serial and Serial1 are fakes:
+// tests feed their RX side and read back what was written (see
+// HardwareSerial below). The clock is the host steady clock.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Let ArduinoJson use String, Print and Stream as it does on the device
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 1
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT  1
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+#define RISING        0x01
+#define FALLING       0x02
+#define CHANGE        0x03
+#define SERIAL_8N1    0x800001c
+#define DEC           10
+#define HEX           16
+#define F(text)       text
+#define ARDUINO_ISR_ATTR
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+template <class T, class L, class H>
+T constrain(T value, L low, H high) {
+    return value < (T)low ? (T)low : (value > (T)high ? (T)high : value);
+}
+
+// Timing, host steady clock since the first call
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// GPIO: writes set the level reads return (HostRuntime::setPin() drives inputs), interrupts do nothing
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void detachInterrupt(uint8_t pin);
+uint8_t digitalPinToInterrupt(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+class String {
+public:
+    String(const char* text = "") : _s(text ? text : "") {}
+    String(const char* text, size_t length) : _s(text, length) {}
+    String(const String& other) = default;
+    String(String&& other) = default;
+    explicit String(char c) : _s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10) : String((unsigned long)value, base) {}
+    explicit String(int value, unsigned char base = 10) : String((long)value, base) {}
+    explicit String(unsigned int value, unsigned char base = 10) : String((unsigned long)value, base) {}
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10) : String((long)value, base) {}
+    explicit String(unsigned long long value, unsigned char base = 10) : String((unsigned long)value, base) {}
+    explicit String(float value, unsigned int decimals = 2) : String((double)value, decimals) {}
+    explicit String(double value, unsigned int decimals = 2);
+
+    String& operator=(const String& other) = default;
+    String& operator=(String&& other) = default;
+    String& operator=(const char* text) { _s = text ? text : ""; return *this; }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    char charAt(unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return _s[index]; }
+
+    bool concat(const String& other) { _s += other._s; return true; }
+    bool concat(const char* text) { if (text) _s += text; return text != nullptr; }
+    bool concat(const char* text, unsigned int length) { if (text) _s.append(text, length); return text != nullptr; }
+    bool concat(char c) { _s += c; return true; }
+    template <class T> bool concat(T value) { return concat(String(value)); }
+    template <class T> String& operator+=(const T& value) { concat(value); return *this; }
+
+    bool equals(const String& other) const { return _s == other._s; }
+    bool equals(const char* text) const { return _s == (text ? text : ""); }
+    bool operator==(const String& other) const { return equals(other); }
+    bool operator==(const char* text) const { return equals(text); }
+    bool operator!=(const String& other) const { return !equals(other); }
+    bool operator!=(const char* text) const { return !equals(text); }
+    bool operator<(const String& other) const { return _s < other._s; }
+
+    int indexOf(char c, unsigned int from = 0) const { return toIndex(_s.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return toIndex(_s.find(text._s, from)); }
+    int lastIndexOf(char c) const { return toIndex(_s.rfind(c)); }
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return _s.size() >= suffix._s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+    }
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from).c_str()) : String(); }
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+    void toUpperCase();
+    void toLowerCase();
+    void replace(const String& find, const String& with);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1) { if (index < _s.size()) _s.erase(index, count); }
+    long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(_s.c_str(), nullptr); }
+    double toDouble() const { return strtod(_s.c_str(), nullptr); }
+
+private:
+    static int toIndex(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+    std::string _s;
+};
+
+// Result type of String concatenation, as in the Arduino core (ArduinoJson names it)
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& s) : String(s) {}
+};
+
+inline StringSumHelper operator+(const String& a, const String& b) { String r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const String& a, const char* b) { String r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const char* a, const String& b) { String r(a); r.concat(b); return r; }
+template <class T, class = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline StringSumHelper operator+(const String& a, T b) { String r(a); r.concat(b); return r; }
+inline bool operator==(const char* a, const String& b) { return b.equals(a); }
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) {
+        size_t n = 0;
+        while (length--) n += write(*data++);
+        return n;
+    }
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+    size_t write(const char* data, size_t length) { return write((const uint8_t*)data, length); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str(), text.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(long long value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned long long value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(double value, int decimals = 2) { return print(String(value, (unsigned int)decimals)); }
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <class T> size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    void setTimeout(unsigned long ms) { _timeout = ms; }
+
+protected:
+    unsigned long _timeout = 1000;
+};
+
+#include "HardwareSerial.h"
+
+class EspClass {
+public:
+    uint32_t getCycleCount();        // Host nanoseconds, see getCpuFreqMHz()
+    uint32_t getCpuFreqMHz();        // 1000, so cycles / MHz gives microseconds
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();          // getHeapSize() minus the bytes malloc has handed out
+    uint32_t getMinFreeHeap();       // Lowest getFreeHeap() seen
+    uint32_t getMaxAllocHeap();
+    void restart();                  // Exits the host process
+};
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
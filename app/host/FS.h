@@ -0,0 +1,81 @@
+// Host stand-in for the Arduino-ESP32 FS library (app/ host checks only).
+//
+// A File is a host file or directory below the directory SD was mounted
+// on (see SD.h); the firmware keeps using its card paths ("/events/...").
+// Files are shared handles like on the device: copies refer to the same
+// open file and the last one closes it.
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <memory>
+
+#include "Arduino.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+struct FileImpl;
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+public:
+    File() = default;
+    explicit File(std::shared_ptr<FileImpl> impl) : _impl(std::move(impl)) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t length);
+    void flush() override;
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const { return _impl != nullptr; }
+    const char* path() const;
+    const char* name() const;     // Without the directory, as on Arduino-ESP32 2.x
+    bool isDirectory() const;
+    File openNextFile(const char* mode = FILE_READ);
+    void rewindDirectory();
+
+private:
+    std::shared_ptr<FileImpl> _impl;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) { return open(path.c_str(), mode, create); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+
+    // Host side
+    const std::string& hostRoot() const { return _root; }  // Empty while not mounted
+
+protected:
+    std::string hostPath(const char* path) const;
+    std::string _root;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // HOST_FS_H
@@ -0,0 +1,2 @@
+// Host stand-in: the Arduino core lets firmware include FreeRTOS.h directly.
+#include "freertos/FreeRTOS.h"
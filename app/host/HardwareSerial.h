@@ -0,0 +1,79 @@
+// Host stand-in for the Arduino-ESP32 HardwareSerial (app/ host checks only).
+//
+// A fake UART: the check feeds bytes with hostFeed() as if they had been
+// received and collects what the firmware wrote with hostTake(). Written
+// bytes drain at once, so availableForWrite() is what the driver reports
+// on an idle UART: the 128-byte hardware FIFO, or the TX ring when one was
+// set with setTxBufferSize() (more than the FIFO, as on the device). A
+// check can still force it with hostSetTxSpace().
+
+#ifndef HOST_HARDWARESERIAL_H
+#define HOST_HARDWARESERIAL_H
+
+#include "Arduino.h"
+
+typedef enum {
+    UART_HW_FLOWCTRL_DISABLE = 0,
+    UART_HW_FLOWCTRL_RTS,
+    UART_HW_FLOWCTRL_CTS,
+    UART_HW_FLOWCTRL_CTS_RTS
+} uart_hw_flowcontrol_t;
+
+typedef std::function<void(void)> OnReceiveCb;
+
+#define HOST_UART_FIFO_SIZE 128   // SOC_UART_FIFO_LEN of the ESP32-S3
+
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int uart) : _uart(uart) { _tx.reserve(4096); }  // Allocated once, like the TX ring
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1,
+               bool invert = false, unsigned long timeoutMs = 20000, uint8_t rxfifoFull = 112) { _baud = baud; }
+    void end() {}
+    void updateBaudRate(unsigned long baud) { _baud = baud; }
+    uint32_t baudRate() { return _baud; }
+    size_t setRxBufferSize(size_t size) { return size; }
+    size_t setTxBufferSize(size_t size) {         // Like Arduino-ESP32: no ring unless larger than the FIFO
+        if (size <= HOST_UART_FIFO_SIZE) return 0;
+        _txSpace = size;
+        return size;
+    }
+    bool setPins(int8_t rxPin, int8_t txPin, int8_t ctsPin = -1, int8_t rtsPin = -1) { return true; }
+    bool setHwFlowCtrlMode(uart_hw_flowcontrol_t mode, uint8_t threshold = 64) { return true; }
+    bool setRxFIFOFull(uint8_t bytes) { return true; }
+    bool setRxTimeout(uint8_t symbols) { return true; }
+    void onReceive(OnReceiveCb callback, bool onlyOnTimeout = false);
+    operator bool() const { return true; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length) override;
+    int availableForWrite() override;
+    using Print::write;
+
+    // Host side
+    void hostFeed(const char* data, size_t length);      // Bytes "received", runs the onReceive callback
+    void hostFeed(const char* text) { hostFeed(text, strlen(text)); }
+    std::string hostTake();                              // Everything written since the last call
+    size_t hostWritten();                                // Total bytes written
+    void hostSetTxSpace(int bytes) { _txSpace = bytes; } // What availableForWrite() reports
+    void hostEcho(bool on) { _echo = on; }               // Also copy writes to stdout
+
+private:
+    int _uart;
+    unsigned long _baud = 0;
+    std::mutex _lock;
+    std::deque<uint8_t> _rx;
+    std::string _tx;
+    size_t _written = 0;
+    int _txSpace = HOST_UART_FIFO_SIZE;
+    bool _echo = false;
+    OnReceiveCb _onReceive;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif // HOST_HARDWARESERIAL_H
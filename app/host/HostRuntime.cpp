@@ -0,0 +1,807 @@
+// Definitions behind the host stand-ins in app/host (FreeRTOS, Arduino, ESP).
+//
+// Linked into every host check that builds firmware sources. Tasks are
+// detached std::threads, so a check ends with HostRuntime::exit() rather
+// than returning from main() while they still run.
+//
+// On glibc the heap figures are real: malloc and friends are wrapped to
+// count the bytes in use and their peak, and ESP.getFreeHeap() reports
+// HOST_HEAP_SIZE minus the bytes in use. Elsewhere, and under a sanitizer
+// (which brings its own allocator), the heap reads as full.
+
+#include "HostRuntime.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Arduino.h"
+#include "esp_core_dump.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "mbedtls/base64.h"
+#include "esp_sleep.h"
+#include "esp_task_wdt.h"
+#include "freertos/FreeRTOS.h"
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define HOST_COUNT_HEAP 1
+#endif
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#undef HOST_COUNT_HEAP
+#endif
+#endif
+
+#ifdef HOST_COUNT_HEAP
+#include <malloc.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static Clock::time_point startTime() {
+    static const Clock::time_point start = Clock::now();
+    return start;
+}
+static const Clock::time_point startAtLoad = startTime();
+
+// ---------------------------------------------------------------- Heap
+
+static std::atomic<int64_t> heapInUse{0};
+static std::atomic<int64_t> heapPeak{0};
+
+#ifdef HOST_COUNT_HEAP
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+static void* counted(void* ptr) {
+    if (ptr) {
+        int64_t now = heapInUse += (int64_t)malloc_usable_size(ptr);
+        int64_t peak = heapPeak.load();
+        while (now > peak && !heapPeak.compare_exchange_weak(peak, now)) {}
+    }
+    return ptr;
+}
+
+extern "C" void* malloc(size_t size) { return counted(__libc_malloc(size)); }
+extern "C" void* calloc(size_t count, size_t size) { return counted(__libc_calloc(count, size)); }
+extern "C" void* memalign(size_t alignment, size_t size) { return counted(__libc_memalign(alignment, size)); }
+extern "C" void* aligned_alloc(size_t alignment, size_t size) { return memalign(alignment, size); }
+extern "C" void* valloc(size_t size) { return memalign(4096, size); }
+
+extern "C" int posix_memalign(void** ptr, size_t alignment, size_t size) {
+    void* p = memalign(alignment, size);
+    if (!p) return ENOMEM;
+    *ptr = p;
+    return 0;
+}
+
+extern "C" void free(void* ptr) {
+    if (!ptr) return;
+    heapInUse -= (int64_t)malloc_usable_size(ptr);
+    __libc_free(ptr);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    if (!ptr) return malloc(size);
+    if (size == 0) {
+        free(ptr);
+        return nullptr;
+    }
+    size_t before = malloc_usable_size(ptr);
+    void* moved = __libc_realloc(ptr, size);
+    if (moved) {
+        heapInUse -= (int64_t)before;
+        counted(moved);
+    }
+    return moved;
+}
+#endif
+
+uint32_t HostRuntime::heapInUse() {
+    return (uint32_t)::heapInUse.load();
+}
+
+uint32_t HostRuntime::heapPeak() {
+    return (uint32_t)::heapPeak.load();
+}
+
+void HostRuntime::resetHeapPeak() {
+    ::heapPeak = ::heapInUse.load();
+}
+
+// ---------------------------------------------------------------- Tasks
+
+struct HostTaskExit {};
+
+struct tskTaskControlBlock {
+    std::string name;
+    UBaseType_t priority;
+    BaseType_t core;
+    UBaseType_t number;
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+    std::atomic<bool> running{true};
+};
+
+static std::mutex taskLock;
+static std::vector<tskTaskControlBlock*> tasks;
+static thread_local tskTaskControlBlock* currentTask = nullptr;
+
+static tskTaskControlBlock* addTask(const char* name, UBaseType_t priority, BaseType_t core) {
+    tskTaskControlBlock* task = new tskTaskControlBlock;
+    task->name = name;
+    task->priority = priority;
+    task->core = core;
+    std::lock_guard<std::mutex> guard(taskLock);
+    task->number = tasks.size() + 1;
+    tasks.push_back(task);
+    return task;
+}
+
+// Waits on @p wake until @p ready holds or @p ticks run out; true if ready
+template <class Ready>
+static bool waitTicks(std::unique_lock<std::mutex>& lock, std::condition_variable& wake, TickType_t ticks, Ready ready) {
+    if (ticks == portMAX_DELAY) {
+        wake.wait(lock, ready);
+        return true;
+    }
+    return wake.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameters,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    tskTaskControlBlock* task = addTask(name, priority, core);
+    if (handle) *handle = task;
+    std::thread([=]() {
+        currentTask = task;
+        try {
+            function(parameters);
+        } catch (HostTaskExit&) {
+        }
+        task->running = false;
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameters,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(function, name, stackDepth, parameters, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != nullptr && task != currentTask) {
+        fprintf(stderr, "host: vTaskDelete of another task is not supported\n");
+        abort();
+    }
+    throw HostTaskExit();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) std::this_thread::yield();
+    else std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    TickType_t wake = *previousWake + increment;
+    int32_t wait = (int32_t)(wake - xTaskGetTickCount());
+    if (wait > 0) vTaskDelay(wait);
+    *previousWake = wake;
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (currentTask == nullptr) currentTask = addTask("main", 1, tskNO_AFFINITY);
+    return currentTask;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    return (task ? task : xTaskGetCurrentTaskHandle())->priority;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return 1024;  // Host threads have no bounded stack to measure
+}
+
+UBaseType_t uxTaskGetNumberOfTasks() {
+    std::lock_guard<std::mutex> guard(taskLock);
+    UBaseType_t count = 0;
+    for (tskTaskControlBlock* task : tasks) count += task->running;
+    return count;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t size, uint32_t* totalRunTime) {
+    std::lock_guard<std::mutex> guard(taskLock);
+    UBaseType_t count = 0;
+    for (tskTaskControlBlock* task : tasks) {
+        if (!task->running) continue;
+        if (count == size) return 0;  // As FreeRTOS: too small an array fills nothing
+        TaskStatus_t& s = status[count++];
+        s.xHandle = task;
+        s.pcTaskName = task->name.c_str();
+        s.xTaskNumber = task->number;
+        s.eCurrentState = task == currentTask ? eRunning : eBlocked;
+        s.uxCurrentPriority = task->priority;
+        s.uxBasePriority = task->priority;
+        s.ulRunTimeCounter = 0;
+        s.usStackHighWaterMark = 1024;
+        s.xCoreID = task->core;
+    }
+    if (totalRunTime) *totalRunTime = (uint32_t)micros();
+    return count;
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+    return (task ? task : xTaskGetCurrentTaskHandle())->name.c_str();
+}
+
+BaseType_t xPortGetCoreID() {
+    BaseType_t core = xTaskGetCurrentTaskHandle()->core;
+    return core == tskNO_AFFINITY ? 0 : core;
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->notifications++;
+    task->wake.notify_all();
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+    xTaskNotifyGive(task);
+    if (woken) *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    tskTaskControlBlock* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->lock);
+    if (!waitTicks(lock, task->wake, ticks, [task] { return task->notifications > 0; })) return 0;
+    uint32_t count = task->notifications;
+    task->notifications = clearOnExit ? 0 : count - 1;
+    return count;
+}
+
+// ---------------------------------------------------------------- Critical sections
+
+static std::recursive_mutex criticalLock;
+
+void portENTER_CRITICAL(portMUX_TYPE* mux) {
+    criticalLock.lock();
+}
+
+void portEXIT_CRITICAL(portMUX_TYPE* mux) {
+    criticalLock.unlock();
+}
+
+// ---------------------------------------------------------------- Queues and semaphores
+
+struct QueueDefinition {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    QueueDefinition* queue = new QueueDefinition;
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitTicks(lock, queue->changed, ticks, [queue] { return queue->items.size() < queue->length; })) return pdFALSE;
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return xQueueSend(queue, item, 0);
+}
+
+static BaseType_t take(QueueHandle_t queue, void* item, TickType_t ticks, bool remove) {
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitTicks(lock, queue->changed, ticks, [queue] { return !queue->items.empty(); })) return pdFALSE;
+    if (queue->itemSize) memcpy(item, queue->items.front().data(), queue->itemSize);
+    if (remove) {
+        queue->items.pop_front();
+        queue->changed.notify_all();
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return take(queue, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return take(queue, item, ticks, false);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    queue->items.clear();
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return queue->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return queue->length - queue->items.size();
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial) {
+    QueueDefinition* semaphore = xQueueCreate(max, 0);
+    for (UBaseType_t i = 0; i < initial; i++) semaphore->items.emplace_back();
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    return xQueueReceive(semaphore, nullptr, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueSend(semaphore, nullptr, 0);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return xSemaphoreGive(semaphore);
+}
+
+// ---------------------------------------------------------------- Event groups
+
+struct EventGroupDef_t {
+    std::mutex lock;
+    std::condition_variable changed;
+    EventBits_t bits = 0;
+};
+
+EventGroupHandle_t xEventGroupCreate() {
+    return new EventGroupDef_t;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    group->bits |= bits;
+    group->changed.notify_all();
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(group->lock);
+    auto done = [=] { return waitForAll ? (group->bits & bits) == bits : (group->bits & bits) != 0; };
+    waitTicks(lock, group->changed, ticks, done);
+    EventBits_t result = group->bits;
+    if (done() && clearOnExit) group->bits &= ~bits;
+    return result;
+}
+
+// ---------------------------------------------------------------- Arduino
+
+unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime()).count();
+}
+
+unsigned long micros() {
+    return (unsigned long)esp_timer_get_time();
+}
+
+void delay(unsigned long ms) {
+    vTaskDelay(ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+#define HOST_PIN_COUNT 64
+
+static std::atomic<uint8_t> pinLevel[HOST_PIN_COUNT];
+static std::atomic<uint32_t> pinRise[HOST_PIN_COUNT];
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin >= HOST_PIN_COUNT) return;
+    if (pinLevel[pin].exchange(value ? HIGH : LOW) == LOW && value) pinRise[pin]++;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < HOST_PIN_COUNT ? pinLevel[pin].load() : LOW;
+}
+
+void HostRuntime::setPin(uint8_t pin, int level) {
+    if (pin < HOST_PIN_COUNT) pinLevel[pin] = level ? HIGH : LOW;
+}
+
+uint32_t HostRuntime::pinRises(uint8_t pin) {
+    return pin < HOST_PIN_COUNT ? pinRise[pin].load() : 0;
+}
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode) {}
+void detachInterrupt(uint8_t pin) {}
+uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+
+static std::mutex randomLock;
+static std::minstd_rand randomEngine;
+
+long random(long max) {
+    return max > 0 ? random(0, max) : 0;
+}
+
+long random(long min, long max) {
+    if (max <= min) return min;
+    std::lock_guard<std::mutex> guard(randomLock);
+    return min + (long)(randomEngine() % (unsigned long)(max - min));
+}
+
+void randomSeed(unsigned long seed) {
+    std::lock_guard<std::mutex> guard(randomLock);
+    if (seed) randomEngine.seed(seed);
+}
+
+static std::string formatUnsigned(unsigned long value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char digits[8 * sizeof(value) + 1];
+    char* p = digits + sizeof(digits);
+    *--p = '\0';
+    do {
+        unsigned digit = value % base;
+        *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value);
+    return p;
+}
+
+String::String(long value, unsigned char base) {
+    if (value < 0 && base == 10) _s = "-" + formatUnsigned(0UL - (unsigned long)value, base);
+    else _s = formatUnsigned((unsigned long)value, base);
+}
+
+String::String(unsigned long value, unsigned char base) : _s(formatUnsigned(value, base)) {}
+
+String::String(double value, unsigned int decimals) {
+    char text[64];
+    snprintf(text, sizeof(text), "%.*f", (int)decimals, value);
+    _s = text;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, std::min<size_t>(to, _s.size()) - from).c_str());
+}
+
+void String::trim() {
+    size_t first = _s.find_first_not_of(" \t\r\n\f\v");
+    if (first == std::string::npos) {
+        _s.clear();
+        return;
+    }
+    _s = _s.substr(first, _s.find_last_not_of(" \t\r\n\f\v") - first + 1);
+}
+
+void String::toUpperCase() {
+    for (char& c : _s) c = (char)toupper((unsigned char)c);
+}
+
+void String::toLowerCase() {
+    for (char& c : _s) c = (char)tolower((unsigned char)c);
+}
+
+void String::replace(const String& find, const String& with) {
+    if (find._s.empty()) return;
+    for (size_t pos = 0; (pos = _s.find(find._s, pos)) != std::string::npos; pos += with._s.size()) {
+        _s.replace(pos, find._s.size(), with._s);
+    }
+}
+
+size_t Print::printf(const char* format, ...) {
+    char small[128];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (n < 0) return 0;
+    if ((size_t)n < sizeof(small)) return write((const uint8_t*)small, n);
+
+    std::vector<char> large(n + 1);
+    va_start(args, format);
+    vsnprintf(large.data(), large.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)large.data(), n);
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    unsigned long start = millis();
+    while (count < length) {
+        int c = read();
+        if (c >= 0) {
+            buffer[count++] = (char)c;
+            continue;
+        }
+        if (millis() - start >= _timeout) break;
+        delay(1);
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------- Serial
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+
+void HardwareSerial::onReceive(OnReceiveCb callback, bool onlyOnTimeout) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _onReceive = callback;
+}
+
+int HardwareSerial::available() {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _rx.size();
+}
+
+int HardwareSerial::read() {
+    std::lock_guard<std::mutex> guard(_lock);
+    if (_rx.empty()) return -1;
+    uint8_t c = _rx.front();
+    _rx.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek() {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _rx.empty() ? -1 : _rx.front();
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _tx.append((const char*)data, length);
+    _written += length;
+    if (_echo) fwrite(data, 1, length, stdout);
+    return length;
+}
+
+int HardwareSerial::availableForWrite() {
+    return _txSpace;
+}
+
+void HardwareSerial::hostFeed(const char* data, size_t length) {
+    OnReceiveCb callback;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _rx.insert(_rx.end(), data, data + length);
+        callback = _onReceive;
+    }
+    if (callback) callback();
+}
+
+std::string HardwareSerial::hostTake() {
+    std::lock_guard<std::mutex> guard(_lock);
+    std::string out = _tx;
+    _tx.clear();  // Keeps its capacity: later writes do not allocate, like the driver's ring
+    return out;
+}
+
+size_t HardwareSerial::hostWritten() {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _written;
+}
+
+// ---------------------------------------------------------------- ESP
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime()).count();
+}
+
+uint32_t EspClass::getCpuFreqMHz() {
+    return 1000;
+}
+
+uint32_t EspClass::getHeapSize() {
+    return HOST_HEAP_SIZE;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return HOST_HEAP_SIZE - HostRuntime::heapInUse();
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return HOST_HEAP_SIZE - HostRuntime::heapPeak();
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return getFreeHeap();
+}
+
+void EspClass::restart() {
+    esp_restart();
+}
+
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime()).count();
+}
+
+static esp_reset_reason_t resetReason = ESP_RST_POWERON;
+
+void HostRuntime::setResetReason(esp_reset_reason_t reason) {
+    resetReason = reason;
+}
+
+esp_reset_reason_t esp_reset_reason() {
+    return resetReason;
+}
+
+void esp_restart() {
+    fprintf(stderr, "host: restart requested\n");
+    HostRuntime::exit(3);
+}
+
+const char* esp_err_to_name(esp_err_t err) {
+    switch (err) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        default: return "ESP_ERR";
+    }
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen) {
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t needed = (slen + 2) / 3 * 4;
+    if (dlen < needed + 1) {
+        *olen = needed + 1;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    unsigned char* out = dst;
+    for (size_t i = 0; i < slen; i += 3) {
+        uint32_t group = (uint32_t)src[i] << 16;
+        if (i + 1 < slen) group |= (uint32_t)src[i + 1] << 8;
+        if (i + 2 < slen) group |= src[i + 2];
+        *out++ = digits[(group >> 18) & 0x3F];
+        *out++ = digits[(group >> 12) & 0x3F];
+        *out++ = i + 1 < slen ? digits[(group >> 6) & 0x3F] : '=';
+        *out++ = i + 2 < slen ? digits[group & 0x3F] : '=';
+    }
+    *out = '\0';
+    *olen = out - dst;
+    return 0;
+}
+
+esp_err_t esp_core_dump_image_check() { return ESP_ERR_NOT_FOUND; }
+esp_err_t esp_core_dump_image_get(size_t* address, size_t* size) { return ESP_ERR_NOT_FOUND; }
+esp_err_t esp_core_dump_image_erase() { return ESP_ERR_NOT_FOUND; }
+esp_err_t esp_core_dump_get_summary(esp_core_dump_summary_t* summary) { return ESP_ERR_NOT_FOUND; }
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* buffer, size_t size) {
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs) {
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start() {
+    fprintf(stderr, "host: deep sleep requested\n");
+    HostRuntime::exit(3);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return ESP.getFreeHeap();
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return ESP.getMinFreeHeap();
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return ESP.getMaxAllocHeap();
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    return malloc(size);
+}
+
+void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+esp_err_t esp_task_wdt_init(uint32_t timeoutSeconds, bool panic) { return ESP_OK; }
+esp_err_t esp_task_wdt_add(TaskHandle_t task) { return ESP_OK; }
+esp_err_t esp_task_wdt_delete(TaskHandle_t task) { return ESP_OK; }
+esp_err_t esp_task_wdt_reset() { return ESP_OK; }
+esp_err_t esp_task_wdt_status(TaskHandle_t task) { return ESP_OK; }
+
+// ---------------------------------------------------------------- Check results
+
+static std::atomic<int> failureCount{0};
+
+void HostRuntime::fail(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    printf("FAIL: ");
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+    failureCount++;
+}
+
+int HostRuntime::failures() {
+    return failureCount;
+}
+
+// ---------------------------------------------------------------- Exit
+
+void HostRuntime::exit(int code) {
+    fflush(stdout);
+    fflush(stderr);
+    std::_Exit(code);  // Skips static destructors the detached tasks may still be using
+}
@@ -0,0 +1,28 @@
+// Host-only helpers next to the stand-ins in app/host (not part of the firmware API).
+
+#ifndef HOST_RUNTIME_H
+#define HOST_RUNTIME_H
+
+#include <cstdint>
+
+#include "esp_system.h"
+
+// Heap ESP.getFreeHeap() counts down from: a round figure for what the
+// firmware has left after boot
+#define HOST_HEAP_SIZE  (256 * 1024)
+
+namespace HostRuntime {
+    uint32_t heapInUse();      // Bytes malloc has handed out and not got back
+    uint32_t heapPeak();       // Highest heapInUse() so far
+    void resetHeapPeak();      // Starts the peak again from the current use
+    [[noreturn]] void exit(int code);  // Flushes and ends the process without joining the tasks
+    void setPin(uint8_t pin, int level);   // Level digitalRead() returns, as if driven from outside
+    uint32_t pinRises(uint8_t pin);        // LOW to HIGH writes so far (step pulses)
+    void setResetReason(esp_reset_reason_t reason);  // What esp_reset_reason() reports from now on
+
+    // Check results: fail() prints "FAIL: <message>" and counts it
+    __attribute__((format(printf, 1, 2))) void fail(const char* format, ...);
+    int failures();
+}
+
+#endif // HOST_RUNTIME_H
@@ -0,0 +1,369 @@
+// Host Preferences store with an NVS page model, see Preferences.h.
+//
+// The partition is a row of 4 kB pages of NVS_ENTRIES_PER_PAGE 32-byte
+// entries, written the way ESP-IDF NVS writes them:
+//
+//   - entries are only appended to the active page; a changed value is
+//     written anew and its old entries are marked erased;
+//   - a put of the value already stored writes nothing;
+//   - a primitive takes 1 entry, a string a header plus its data (with
+//     the NUL), a blob a header plus data per chunk and one index entry;
+//     a blob that does not fit the active page is split into chunks;
+//   - a new namespace takes one entry;
+//   - one page is kept empty for garbage collection. When only it is
+//     left, the full page with the most erased entries is reclaimed: its
+//     live entries are copied into the empty page and it is erased.
+//
+// Entry states are tracked, not their contents; the values themselves
+// live in a map next to the model.
+
+#include "Preferences.h"
+#include "nvs.h"
+
+#include <map>
+#include <vector>
+
+#include "Config.h"
+
+namespace {
+
+struct Span {
+    uint16_t page;
+    uint8_t first;
+    uint8_t count;
+};
+
+struct StoredItem {
+    uint8_t type;
+    std::vector<uint8_t> data;
+    std::vector<Span> spans;       // Entries the item takes in the model
+};
+
+enum EntryState : uint8_t { ENTRY_EMPTY, ENTRY_WRITTEN, ENTRY_ERASED };
+enum PageState : uint8_t { PAGE_EMPTY, PAGE_ACTIVE, PAGE_FULL };
+
+struct Page {
+    PageState state = PAGE_EMPTY;
+    EntryState entries[NVS_ENTRIES_PER_PAGE] = {};
+    uint8_t next = 0;              // First unwritten entry
+    uint8_t erased = 0;
+    uint32_t eraseCycles = 0;
+};
+
+struct Namespace {
+    Span entry;
+    std::map<std::string, StoredItem> items;
+};
+
+std::mutex storeLock;
+std::map<std::string, Namespace> store;
+std::vector<Page> pages(HOST_NVS_PAGES);
+int active = -1;                   // Page taking new entries
+NvsCounters counters;
+
+uint8_t freeEntries(const Page& page) {
+    return NVS_ENTRIES_PER_PAGE - page.next;
+}
+
+int emptyPages() {
+    int count = 0;
+    for (const Page& page : pages) count += page.state == PAGE_EMPTY;
+    return count;
+}
+
+int takeEmptyPage() {
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (pages[i].state == PAGE_EMPTY) {
+            pages[i].state = PAGE_ACTIVE;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+Span append(int page, uint8_t count) {
+    Page& p = pages[page];
+    Span span = { (uint16_t)page, p.next, count };
+    for (uint8_t i = 0; i < count; i++) p.entries[p.next++] = ENTRY_WRITTEN;
+    counters.entriesWritten += count;
+    return span;
+}
+
+void eraseSpans(const std::vector<Span>& spans) {
+    for (const Span& span : spans) {
+        Page& p = pages[span.page];
+        for (uint8_t i = 0; i < span.count; i++) p.entries[span.first + i] = ENTRY_ERASED;
+        p.erased += span.count;
+    }
+}
+
+// Copies the live entries of @p victim to @p target and erases @p victim
+void reclaim(int victim, int target) {
+    for (auto& ns : store) {
+        std::vector<Span*> spans;
+        spans.push_back(&ns.second.entry);
+        for (auto& item : ns.second.items) {
+            for (Span& span : item.second.spans) spans.push_back(&span);
+        }
+        for (Span* span : spans) {
+            if (span->page != victim || span->count == 0) continue;
+            *span = append(target, span->count);
+            counters.entriesMoved += span->count;
+        }
+    }
+    Page& p = pages[victim];
+    uint32_t cycles = p.eraseCycles + 1;
+    p = Page();
+    p.eraseCycles = cycles;
+    counters.pageErases++;
+    counters.maxPageErases = std::max(counters.maxPageErases, cycles);
+}
+
+/**
+ * Makes the active page hold at least @p count more entries, opening a
+ * new page or reclaiming one as NVS does. False if the partition is full.
+ */
+bool makeRoom(uint8_t count) {
+    if (active >= 0 && freeEntries(pages[active]) >= count) return true;
+    if (active >= 0) pages[active].state = PAGE_FULL;
+    while (true) {
+        if (emptyPages() > 1) {
+            active = takeEmptyPage();
+            return true;
+        }
+        int victim = -1;
+        for (size_t i = 0; i < pages.size(); i++) {
+            if (pages[i].state != PAGE_FULL || pages[i].erased == 0) continue;
+            if (victim < 0 || pages[i].erased > pages[victim].erased) victim = (int)i;
+        }
+        if (victim < 0) {
+            active = -1;
+            return false;
+        }
+        active = takeEmptyPage();  // The page kept for this
+        reclaim(victim, active);
+        if (freeEntries(pages[active]) >= count) return true;
+        pages[active].state = PAGE_FULL;
+    }
+}
+
+uint8_t dataEntries(size_t bytes) {
+    return (uint8_t)((bytes + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE);
+}
+
+/**
+ * Writes the entries of an item of @p type and @p length bytes.
+ * False (nothing kept) if the partition has no room.
+ */
+bool writeEntries(uint8_t type, size_t length, std::vector<Span>& spans) {
+    if (type == Preferences::TYPE_BLOB) {
+        size_t remaining = dataEntries(length);
+        do {
+            if (!makeRoom(2)) return false;  // Header and at least one data entry
+            uint8_t take = (uint8_t)std::min<size_t>(remaining, freeEntries(pages[active]) - 1);
+            spans.push_back(append(active, 1 + take));
+            remaining -= take;
+        } while (remaining > 0);
+        if (!makeRoom(1)) return false;
+        spans.push_back(append(active, 1));  // Blob index
+        return true;
+    }
+    uint8_t count = type == Preferences::TYPE_STR ? 1 + dataEntries(length + 1) : 1;
+    if (count > NVS_ENTRIES_PER_PAGE - 1 || !makeRoom(count)) return false;
+    spans.push_back(append(active, count));
+    return true;
+}
+
+Namespace* findNamespace(const std::string& name, bool create) {
+    auto ns = store.find(name);
+    if (ns != store.end()) return &ns->second;
+    if (!create) return nullptr;
+    std::vector<Span> spans;
+    if (!writeEntries(Preferences::TYPE_U8, 1, spans)) return nullptr;
+    Namespace& created = store[name];
+    created.entry = spans[0];
+    return &created;
+}
+
+const StoredItem* findItem(const std::string& ns, const char* key) {
+    auto n = store.find(ns);
+    if (n == store.end()) return nullptr;
+    auto item = n->second.items.find(key);
+    return item == n->second.items.end() ? nullptr : &item->second;
+}
+
+} // namespace
+
+static const size_t KEY_MAX = 15;  // NVS_KEY_NAME_MAX_SIZE - 1
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    if (_started || name == nullptr || strlen(name) > KEY_MAX) return false;
+    std::lock_guard<std::mutex> guard(storeLock);
+    if (findNamespace(name, !readOnly) == nullptr) return false;  // Read-only needs an existing namespace
+    _namespace = name;
+    _readOnly = readOnly;
+    _started = true;
+    return true;
+}
+
+void Preferences::end() {
+    _started = false;
+}
+
+bool Preferences::clear() {
+    if (!_started || _readOnly) return false;
+    std::lock_guard<std::mutex> guard(storeLock);
+    Namespace* ns = findNamespace(_namespace, false);
+    if (ns == nullptr) return false;
+    for (auto& item : ns->items) eraseSpans(item.second.spans);
+    ns->items.clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_started || _readOnly || key == nullptr) return false;
+    std::lock_guard<std::mutex> guard(storeLock);
+    Namespace* ns = findNamespace(_namespace, false);
+    if (ns == nullptr) return false;
+    auto item = ns->items.find(key);
+    if (item == ns->items.end()) return false;
+    eraseSpans(item->second.spans);
+    ns->items.erase(item);
+    return true;
+}
+
+bool Preferences::isKey(const char* key) {
+    if (!_started || key == nullptr) return false;
+    std::lock_guard<std::mutex> guard(storeLock);
+    return findItem(_namespace, key) != nullptr;
+}
+
+size_t Preferences::freeEntries() {
+    if (!_started) return 0;
+    nvs_stats_t stats;
+    nvs_get_stats(nullptr, &stats);
+    return stats.free_entries;
+}
+
+size_t Preferences::putValue(const char* key, ItemType type, const void* value, size_t length) {
+    if (!_started || _readOnly || key == nullptr || strlen(key) > KEY_MAX) return 0;
+    std::lock_guard<std::mutex> guard(storeLock);
+    counters.puts++;
+    counters.requestedBytes += length;
+
+    Namespace* ns = findNamespace(_namespace, true);
+    if (ns == nullptr) {
+        counters.failedPuts++;
+        return 0;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    auto existing = ns->items.find(key);
+    if (existing != ns->items.end() && existing->second.type == type && existing->second.data.size() == length
+        && memcmp(existing->second.data.data(), bytes, length) == 0) {
+        counters.unchangedPuts++;
+        return length;  // NVS compares first and writes nothing
+    }
+
+    StoredItem item;
+    item.type = type;
+    item.data.assign(bytes, bytes + length);
+    if (!writeEntries(type, length, item.spans)) {
+        eraseSpans(item.spans);  // Half-written chunks are dropped
+        counters.failedPuts++;
+        return 0;
+    }
+    if (existing != ns->items.end()) eraseSpans(existing->second.spans);
+    ns->items[key] = std::move(item);
+    counters.writes++;
+    return length;
+}
+
+bool Preferences::getValue(const char* key, ItemType type, void* value, size_t length) {
+    if (!_started || key == nullptr) return false;
+    std::lock_guard<std::mutex> guard(storeLock);
+    const StoredItem* item = findItem(_namespace, key);
+    if (item == nullptr || item->type != type || item->data.size() != length) return false;
+    memcpy(value, item->data.data(), length);
+    return true;
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    uint8_t value;
+    return getValue(key, TYPE_U8, &value, sizeof(value)) ? value != 0 : defaultValue;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    int32_t value;
+    return getValue(key, TYPE_I32, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t value;
+    return getValue(key, TYPE_U32, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint64_t Preferences::getULong64(const char* key, uint64_t defaultValue) {
+    uint64_t value;
+    return getValue(key, TYPE_U64, &value, sizeof(value)) ? value : defaultValue;
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    float value;
+    return getValue(key, TYPE_BLOB, &value, sizeof(value)) ? value : defaultValue;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    if (!_started || key == nullptr) return defaultValue;
+    std::lock_guard<std::mutex> guard(storeLock);
+    const StoredItem* item = findItem(_namespace, key);
+    if (item == nullptr || item->type != TYPE_STR) return defaultValue;
+    return String((const char*)item->data.data(), item->data.size());
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!_started || key == nullptr) return 0;
+    std::lock_guard<std::mutex> guard(storeLock);
+    const StoredItem* item = findItem(_namespace, key);
+    return item != nullptr && item->type == TYPE_BLOB ? item->data.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    if (!_started || key == nullptr) return 0;
+    std::lock_guard<std::mutex> guard(storeLock);
+    const StoredItem* item = findItem(_namespace, key);
+    if (item == nullptr || item->type != TYPE_BLOB || item->data.size() > maxLength) return 0;
+    memcpy(buffer, item->data.data(), item->data.size());
+    return item->data.size();
+}
+
+uint32_t Preferences::hostWrites() {
+    std::lock_guard<std::mutex> guard(storeLock);
+    return counters.writes;
+}
+
+NvsCounters Preferences::hostCounters() {
+    std::lock_guard<std::mutex> guard(storeLock);
+    return counters;
+}
+
+void Preferences::hostFormat(uint16_t pageCount) {
+    std::lock_guard<std::mutex> guard(storeLock);
+    store.clear();
+    pages.assign(std::max<uint16_t>(pageCount, 2), Page());
+    active = -1;
+    counters = NvsCounters();
+}
+
+esp_err_t nvs_get_stats(const char* partitionName, nvs_stats_t* stats) {
+    if (stats == nullptr) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(storeLock);
+    size_t used = 0;
+    for (const Page& page : pages) {
+        for (EntryState entry : page.entries) used += entry == ENTRY_WRITTEN;
+    }
+    stats->total_entries = pages.size() * NVS_ENTRIES_PER_PAGE;
+    stats->used_entries = used;
+    stats->free_entries = stats->total_entries - used;
+    stats->namespace_count = store.size();
+    return ESP_OK;
+}
@@ -0,0 +1,73 @@
+// Host stand-in for the Arduino-ESP32 Preferences library (app/ host checks only).
+//
+// Keys live in one process-wide store, like NVS on the device, so a
+// second Preferences (or ConfigManager) opened later sees what the first
+// one wrote. Types are checked as NVS does: a get of another type returns
+// the default. Underneath is a model of the NVS pages (see
+// Preferences.cpp) that counts the entries written, the entries moved by
+// garbage collection and the page erases, so the write amplification of
+// a workload can be measured. nvs_get_stats() reports on the same model.
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include "Arduino.h"
+
+// Pages of the modelled partition: the 20 kB "nvs" partition (partitions*.csv)
+#define HOST_NVS_PAGES  5
+
+struct NvsCounters {
+    uint32_t puts = 0;             // put calls
+    uint32_t writes = 0;           // Puts that wrote entries
+    uint32_t unchangedPuts = 0;    // Puts of the stored value, nothing written
+    uint32_t failedPuts = 0;       // Partition full
+    uint64_t requestedBytes = 0;   // Payload of all puts
+    uint64_t entriesWritten = 0;   // Including entriesMoved
+    uint64_t entriesMoved = 0;     // Copied by garbage collection
+    uint32_t pageErases = 0;
+    uint32_t maxPageErases = 0;    // Erase cycles of the most worn page
+};
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+    size_t freeEntries();
+
+    size_t putBool(const char* key, bool value) { uint8_t v = value; return putValue(key, TYPE_U8, &v, 1); }
+    size_t putInt(const char* key, int32_t value) { return putValue(key, TYPE_I32, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return putValue(key, TYPE_U32, &value, sizeof(value)); }
+    size_t putULong64(const char* key, uint64_t value) { return putValue(key, TYPE_U64, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return putValue(key, TYPE_BLOB, &value, sizeof(value)); }
+    size_t putString(const char* key, const String& value) { return putValue(key, TYPE_STR, value.c_str(), value.length()); }
+    size_t putBytes(const char* key, const void* value, size_t length) { return putValue(key, TYPE_BLOB, value, length); }
+
+    bool getBool(const char* key, bool defaultValue = false);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0);
+    float getFloat(const char* key, float defaultValue = 0);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+    size_t getBytesLength(const char* key);
+
+    enum ItemType : uint8_t { TYPE_U8, TYPE_I32, TYPE_U32, TYPE_U64, TYPE_STR, TYPE_BLOB };
+
+    // Host side, across all instances
+    static uint32_t hostWrites();                            // Puts that reached flash
+    static NvsCounters hostCounters();
+    static void hostFormat(uint16_t pages = HOST_NVS_PAGES); // Erase the partition and reset the counters
+
+private:
+    size_t putValue(const char* key, ItemType type, const void* value, size_t length);
+    bool getValue(const char* key, ItemType type, void* value, size_t length);
+
+    std::string _namespace;
+    bool _started = false;
+    bool _readOnly = false;
+};
+
+#endif // HOST_PREFERENCES_H
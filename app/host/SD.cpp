@@ -0,0 +1,202 @@
+// Definitions behind the host FS, SD and SPI stand-ins (app/ host checks only).
+//
+// Link it into a check that builds a firmware source using the card
+// (CommandReceiver, EventLogger, RecipeManager, CrashReport).
+
+#include "SD.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SDFS SD;
+SPIClass SPI;
+
+namespace fs {
+
+struct FileImpl {
+    std::string path;       // On the card
+    std::string hostPath;
+    FILE* file = nullptr;
+    DIR* dir = nullptr;
+
+    ~FileImpl() {
+        if (file) fclose(file);
+        if (dir) closedir(dir);
+    }
+};
+
+size_t File::write(const uint8_t* data, size_t length) {
+    if (!_impl || !_impl->file) return 0;
+    return fwrite(data, 1, length, _impl->file);
+}
+
+int File::available() {
+    if (!_impl || !_impl->file) return 0;
+    size_t left = size() - position();
+    return left > INT32_MAX ? INT32_MAX : (int)left;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    if (!_impl || !_impl->file) return -1;
+    int c = fgetc(_impl->file);
+    if (c != EOF) ungetc(c, _impl->file);
+    return c == EOF ? -1 : c;
+}
+
+size_t File::read(uint8_t* buffer, size_t length) {
+    if (!_impl || !_impl->file) return 0;
+    return fread(buffer, 1, length, _impl->file);
+}
+
+void File::flush() {
+    if (_impl && _impl->file) fflush(_impl->file);
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+    if (!_impl || !_impl->file) return false;
+    static const int whence[] = { SEEK_SET, SEEK_CUR, SEEK_END };
+    return fseek(_impl->file, position, whence[mode]) == 0;
+}
+
+size_t File::position() const {
+    if (!_impl || !_impl->file) return 0;
+    long position = ftell(_impl->file);
+    return position < 0 ? 0 : position;
+}
+
+size_t File::size() const {
+    if (!_impl || !_impl->file) return 0;
+    fflush(_impl->file);
+    struct stat info;
+    return fstat(fileno(_impl->file), &info) == 0 ? info.st_size : 0;
+}
+
+void File::close() {
+    _impl.reset();
+}
+
+const char* File::path() const {
+    return _impl ? _impl->path.c_str() : nullptr;
+}
+
+const char* File::name() const {
+    if (!_impl) return nullptr;
+    size_t slash = _impl->path.rfind('/');
+    return _impl->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+bool File::isDirectory() const {
+    return _impl && _impl->dir;
+}
+
+File File::openNextFile(const char* mode) {
+    if (!_impl || !_impl->dir) return File();
+    while (struct dirent* entry = readdir(_impl->dir)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string path = _impl->path;
+        if (path.empty() || path.back() != '/') path += '/';
+        path += entry->d_name;
+        File next = SD.open(path.c_str(), mode);
+        if (next) return next;
+    }
+    return File();
+}
+
+void File::rewindDirectory() {
+    if (_impl && _impl->dir) rewinddir(_impl->dir);
+}
+
+std::string FS::hostPath(const char* path) const {
+    std::string full = _root;
+    if (path[0] != '/') full += '/';
+    return full + path;
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    if (_root.empty() || path == nullptr) return File();
+    auto impl = std::make_shared<FileImpl>();
+    impl->path = path;
+    impl->hostPath = hostPath(path);
+
+    struct stat info;
+    if (stat(impl->hostPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+        impl->dir = opendir(impl->hostPath.c_str());
+        return impl->dir ? File(impl) : File();
+    }
+    std::string hostMode = mode;
+    hostMode += 'b';
+    impl->file = fopen(impl->hostPath.c_str(), hostMode.c_str());
+    return impl->file ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat info;
+    return !_root.empty() && stat(hostPath(path).c_str(), &info) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return !_root.empty() && unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return !_root.empty() && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return !_root.empty() && ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::rmdir(const char* path) {
+    return !_root.empty() && ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+} // namespace fs
+
+bool SDFS::begin(uint8_t ssPin, SPIClass& spi, uint32_t frequency, const char* mountpoint, uint8_t maxFiles,
+                 bool formatIfEmpty) {
+    if (_removed) return false;
+    if (!_root.empty()) return true;
+    const char* root = getenv("HOST_SD_ROOT");
+    if (root != nullptr && *root) {
+        ::mkdir(root, 0755);
+        _root = root;
+    } else {
+        char temp[] = "/tmp/hostsd.XXXXXX";
+        if (mkdtemp(temp) == nullptr) return false;
+        _root = temp;
+    }
+    return true;
+}
+
+void SDFS::end() {
+    _root.clear();
+}
+
+sdcard_type_t SDFS::cardType() {
+    return _root.empty() ? CARD_NONE : CARD_SDHC;
+}
+
+static uint64_t bytesBelow(const std::string& path) {
+    uint64_t total = 0;
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) return 0;
+    while (struct dirent* entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = path + "/" + entry->d_name;
+        struct stat info;
+        if (stat(child.c_str(), &info) != 0) continue;
+        total += S_ISDIR(info.st_mode) ? bytesBelow(child) : (uint64_t)info.st_size;
+    }
+    closedir(dir);
+    return total;
+}
+
+uint64_t SDFS::usedBytes() {
+    return _root.empty() ? 0 : bytesBelow(_root);
+}
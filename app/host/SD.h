@@ -0,0 +1,41 @@
+// Host stand-in for the Arduino-ESP32 SD library (app/ host checks only).
+//
+// The card is a host directory: $HOST_SD_ROOT when set, otherwise a fresh
+// temporary directory per process, so a check starts with an empty card
+// and can inspect what the firmware wrote. totalBytes() is the modelled
+// card size (hostSetCardSize()), usedBytes() the size of the files below
+// the root, so the firmware's free-space checks see a card that fills up.
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include "FS.h"
+#include "SPI.h"
+
+typedef enum { CARD_NONE, CARD_MMC, CARD_SD, CARD_SDHC, CARD_UNKNOWN } sdcard_type_t;
+
+// Modelled card: 1 GiB unless the check changes it
+#define HOST_SD_CARD_SIZE (1024ULL * 1024 * 1024)
+
+class SDFS : public fs::FS {
+public:
+    bool begin(uint8_t ssPin = 5, SPIClass& spi = SPI, uint32_t frequency = 4000000, const char* mountpoint = "/sd",
+               uint8_t maxFiles = 5, bool formatIfEmpty = false);
+    void end();
+    sdcard_type_t cardType();
+    uint64_t cardSize() { return _cardSize; }
+    uint64_t totalBytes() { return _cardSize; }
+    uint64_t usedBytes();
+
+    // Host side
+    void hostSetCardSize(uint64_t bytes) { _cardSize = bytes; }
+    void hostRemoveCard(bool removed) { _removed = removed; }  // Next begin() fails
+
+private:
+    uint64_t _cardSize = HOST_SD_CARD_SIZE;
+    bool _removed = false;
+};
+
+extern SDFS SD;
+
+#endif // HOST_SD_H
@@ -0,0 +1,16 @@
+// Host stand-in for SPI.h (app/ host checks only): the bus is only passed to SD.begin().
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+class SPIClass {
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+    void end() {}
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
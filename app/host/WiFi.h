@@ -0,0 +1 @@
+// Host stand-in for WiFi.h (app/ host checks only): nothing the firmware calls yet.
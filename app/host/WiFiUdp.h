@@ -0,0 +1 @@
+// Host stand-in for WiFiUdp.h (app/ host checks only): nothing the firmware calls yet.
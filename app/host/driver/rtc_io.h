@@ -0,0 +1 @@
+// Host stand-in for driver/rtc_io.h (app/ host checks only): nothing the firmware calls yet.
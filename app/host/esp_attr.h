@@ -0,0 +1,12 @@
+// Host stand-in for esp_attr.h (app/ host checks only): placement attributes do nothing.
+
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+#endif // HOST_ESP_ATTR_H
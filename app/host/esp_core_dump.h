@@ -0,0 +1,46 @@
+// Host stand-in for esp_core_dump.h (app/ host checks only).
+//
+// The host has no coredump partition: it behaves like firmware built
+// without CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH, and the image calls report
+// that nothing is stored.
+
+#ifndef HOST_ESP_CORE_DUMP_H
+#define HOST_ESP_CORE_DUMP_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_system.h"
+
+#define APP_ELF_SHA256_SZ 65
+
+typedef struct {
+    uint32_t bt[16];
+    uint32_t depth;
+    bool corrupted;
+} esp_core_dump_bt_info_t;
+
+typedef struct {
+    uint32_t exc_cause;
+    uint32_t exc_vaddr;
+    uint32_t exc_a[16];
+    uint32_t epcx[8];
+    uint8_t epcx_reg_bits;
+} esp_core_dump_summary_extra_info_t;
+
+typedef struct {
+    uint32_t exc_tcb;
+    char exc_task[16];
+    uint32_t exc_pc;
+    esp_core_dump_bt_info_t exc_bt_info;
+    uint32_t core_dump_version;
+    uint8_t app_elf_sha256[APP_ELF_SHA256_SZ];
+    esp_core_dump_summary_extra_info_t ex_info;
+} esp_core_dump_summary_t;
+
+esp_err_t esp_core_dump_image_check();                           // ESP_ERR_NOT_FOUND
+esp_err_t esp_core_dump_image_get(size_t* address, size_t* size);
+esp_err_t esp_core_dump_image_erase();
+esp_err_t esp_core_dump_get_summary(esp_core_dump_summary_t* summary);
+
+#endif // HOST_ESP_CORE_DUMP_H
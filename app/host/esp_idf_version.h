@@ -0,0 +1,12 @@
+// Host stand-in for esp_idf_version.h (app/ host checks only): the IDF the firmware ships on.
+
+#ifndef HOST_ESP_IDF_VERSION_H
+#define HOST_ESP_IDF_VERSION_H
+
+#define ESP_IDF_VERSION_MAJOR  4
+#define ESP_IDF_VERSION_MINOR  4
+#define ESP_IDF_VERSION_PATCH  0
+#define ESP_IDF_VERSION_VAL(major, minor, patch)  (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION  ESP_IDF_VERSION_VAL(ESP_IDF_VERSION_MAJOR, ESP_IDF_VERSION_MINOR, ESP_IDF_VERSION_PATCH)
+
+#endif // HOST_ESP_IDF_VERSION_H
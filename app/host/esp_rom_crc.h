@@ -0,0 +1,10 @@
+// Host stand-in for esp_rom_crc.h (app/ host checks only): the same CRC-32 as the ROM.
+
+#ifndef HOST_ESP_ROM_CRC_H
+#define HOST_ESP_ROM_CRC_H
+
+#include <cstdint>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+
+#endif // HOST_ESP_ROM_CRC_H
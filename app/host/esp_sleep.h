@@ -0,0 +1,13 @@
+// Host stand-in for esp_sleep.h (app/ host checks only): deep sleep ends the process.
+
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include <cstdint>
+
+#include "esp_system.h"
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs);
+void esp_deep_sleep_start();
+
+#endif // HOST_ESP_SLEEP_H
@@ -0,0 +1,15 @@
+// Host stand-in for esp_task_wdt.h (app/ host checks only): the watchdog never fires.
+
+#ifndef HOST_ESP_TASK_WDT_H
+#define HOST_ESP_TASK_WDT_H
+
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+
+esp_err_t esp_task_wdt_init(uint32_t timeoutSeconds, bool panic);
+esp_err_t esp_task_wdt_add(TaskHandle_t task);
+esp_err_t esp_task_wdt_delete(TaskHandle_t task);
+esp_err_t esp_task_wdt_reset();
+esp_err_t esp_task_wdt_status(TaskHandle_t task);
+
+#endif // HOST_ESP_TASK_WDT_H
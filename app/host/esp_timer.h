@@ -0,0 +1,10 @@
+// Host stand-in for esp_timer.h (app/ host checks only).
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <cstdint>
+
+int64_t esp_timer_get_time();   // Microseconds of the host steady clock
+
+#endif // HOST_ESP_TIMER_H
@@ -0,0 +1,2 @@
+// Host stand-in for esp_vfs_fat.h (app/ host checks only): the contiguous
+// file calls need IDF 5.1 and the host reports 4.4 (esp_idf_version.h).
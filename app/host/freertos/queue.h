@@ -0,0 +1,2 @@
+// Host stand-in: declared with the rest in freertos/FreeRTOS.h.
+#include "FreeRTOS.h"
@@ -0,0 +1,13 @@
+// Host stand-in for mbedtls/base64.h (app/ host checks only).
+
+#ifndef HOST_MBEDTLS_BASE64_H
+#define HOST_MBEDTLS_BASE64_H
+
+#include <cstddef>
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL -0x002A
+
+// Same contract as mbedTLS: *olen is the length without the terminating NUL
+int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen);
+
+#endif // HOST_MBEDTLS_BASE64_H
@@ -0,0 +1,22 @@
+// Host stand-in for nvs.h (app/ host checks only).
+
+#ifndef HOST_NVS_H
+#define HOST_NVS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_system.h"
+
+typedef uint32_t nvs_handle_t;
+
+typedef struct {
+    size_t used_entries;
+    size_t free_entries;
+    size_t total_entries;
+    size_t namespace_count;
+} nvs_stats_t;
+
+esp_err_t nvs_get_stats(const char* partitionName, nvs_stats_t* stats);  // The Preferences model, whatever the name
+
+#endif // HOST_NVS_H
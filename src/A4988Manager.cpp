@@ -1,5 +1,9 @@
 #include "A4988Manager.h"
 #include <Arduino.h>
+#include "DeferredLog.h"
+#include "EventLogger.h"
+#include "Trace.h"
+#include "TaskHealth.h"
 
 volatile bool risingEdgeDetected = false;  // Flag to indicate a rising edge has been detected
 
@@ -26,7 +30,10 @@ A4988Manager::A4988Manager(uint8_t stepPin, uint8_t dirPin, uint8_t enablePin,
       _ms1Pin(ms1Pin), _ms2Pin(ms2Pin), _ms3Pin(ms3Pin),
       _slpPin(slpPin), _resetPin(resetPin),_Number(_Number),
       _stepping(false), _frequency(0), _interval(0), _lastStepTime(0),
-      _microSteps(1), _stepTaskHandle(nullptr) {}
+      _microSteps(1), _stepTaskHandle(nullptr), _stopRequested(false), _stepCount(0), _lastDwellUs(0),
+      _sensorIntervalUs(0), _sensorEdges(0), _lastEdgeUs(0), _capture(false),
+      _jitter(_Number ? "jitter.disc.late" : "jitter.case.late", _Number ? "jitter.disc.early" : "jitter.case.early"),
+      _healthId(-1) {}
 
 /**
  * @brief Initializes the motor driver and sets pin modes.
@@ -93,7 +100,7 @@ void A4988Manager::setStepResolution(int resolution) {
             _microSteps = resolution;
             break;
         default:
-            Serial.println("Invalid resolution.");
+            LOG_WARN(LOG_INVALID_RESOLUTION, resolution);
             break;
     }
 }
@@ -144,6 +151,10 @@ void A4988Manager::Reset() {
  */
 void A4988Manager::setFrequency(float frequency) {
     _frequency = frequency;
+    _jitter.resync();  // The next period mixes the old and the new interval
+    TRACE_INSTANT(_Number ? "disc.setpoint" : "case.setpoint", (int32_t)(frequency * 1000));
+    EventLogger::record(EVENT_SETPOINT, _Number ? EVENT_SOURCE_DISC : EVENT_SOURCE_CASE,
+                        (int32_t)(frequency * 1000), getDir());
     if (_frequency == 0.0) {
         stopMotorTask(); // Stop motor task if frequency is zero
     } else {
@@ -188,22 +199,41 @@ uint8_t A4988Manager::getStepResolution() {
  */
 void A4988Manager::startMotorTask() {
     if (_stepTaskHandle == nullptr) {
-        xTaskCreatePinnedToCore(motorStepTask, "Motor Step Task", 1024, this, 1, &_stepTaskHandle, STEP_CORE);
+        _stopRequested = false;
+        xTaskCreatePinnedToCore(motorStepTask, "Motor Step Task", MOTOR_TASK_STACK, this,
+                                STEP_TASK_PRIORITY, &_stepTaskHandle, STEP_CORE);
     }
 }
 
 /**
- * @brief Stops the motor step task.
- * 
- * This function deletes the FreeRTOS task responsible for stepping the motor.
+ * @brief Stops the motor step task and waits until it has ended.
+ *
+ * The task is not deleted from here: it may be in the middle of a
+ * lock-free EventLogger or DeferredLog write, and a record reserved but
+ * never published would wedge that ring. It is woken instead and ends
+ * itself at its next wait, between two steps.
  */
 void A4988Manager::stopMotorTask() {
-    if (_stepTaskHandle != nullptr) {
-        vTaskDelete(_stepTaskHandle);
-        _stepTaskHandle = nullptr;
+    TaskHandle_t task = _stepTaskHandle;
+    if (task == nullptr) return;
+    _stopRequested = true;
+    xTaskNotifyGive(task);  // Cuts the current wait short
+    while (_stepTaskHandle != nullptr) {
+        vTaskDelay(1);
     }
 }
 
+/**
+ * @brief Leaves TaskHealth and deletes the calling step task.
+ */
+void A4988Manager::exitTask() {
+    TaskHealth::remove(xTaskGetCurrentTaskHandle());
+    _healthId = -1;
+    LOG_INFO(LOG_MOTOR_TASK_STOPPED, _Number);
+    _stepTaskHandle = nullptr;  // Last access to this object, releases stopMotorTask()
+    vTaskDelete(nullptr);
+}
+
 /**
  * @brief Task for controlling the stepping of the motor.
  *
@@ -224,22 +254,22 @@ void A4988Manager::stopMotorTask() {
  */
 void A4988Manager::motorStepTask(void *pvParameters) {
     A4988Manager* motor = static_cast<A4988Manager*>(pvParameters);
-    Serial.println("Motor Step Task Started");
+    LOG_INFO(LOG_MOTOR_TASK_STARTED, motor->_Number);
+    motor->_healthId = TaskHealth::add(motor->_Number ? "motor.disc" : "motor.case");
     // Task loop for motor stepping
     while (true) {
 
         if (!motor->_Number) {
             // Motor false behavior: Step signal LOW -> HIGH at specified interval
             digitalWrite(motor->_stepPin, LOW);
-            vTaskDelay(motor->_interval / portTICK_PERIOD_MS);  // Wait for the next interval
-            digitalWrite(motor->_stepPin, HIGH);
-            vTaskDelay(motor->_interval / portTICK_PERIOD_MS);  // Wait for the next interval
+            motor->waitMs(motor->_interval);  // Wait for the next interval
+            motor->stepHigh();
+            motor->waitMs(motor->_interval);  // Wait for the next interval
 
         } else if (motor->_Number) {
             bool previousState = digitalRead(SENSOR_PIN);  // Initial pin state
             bool currentState;
             bool SkipFlag = false;
-            unsigned long  prevItr=motor->_interval;
             if(previousState == true) goto end;
             while(true){    
                 while(true){
@@ -247,23 +277,36 @@ void A4988Manager::motorStepTask(void *pvParameters) {
                     if(currentState  == true && previousState == false){
                         previousState = currentState;
                         risingEdgeDetected = true;
-                        Serial.println("Rising Edge Detected");
+                        uint32_t edgeUs = micros();
+                        if (motor->_sensorEdges > 0) motor->_sensorIntervalUs = edgeUs - motor->_lastEdgeUs;
+                        motor->_lastEdgeUs = edgeUs;
+                        motor->_sensorEdges++;
+                        EventLogger::record(EVENT_SENSOR_EDGE, EVENT_SOURCE_DISC, motor->_stepCount, motor->_sensorIntervalUs);
+                        TRACE_INSTANT("disc.edge", motor->_stepCount);
+                        LOG_DEBUG(LOG_RISING_EDGE, motor->_stepsToTake);
                         // Confirm we are out of the switching zone by making a few steps
                         for (int i = 0; i < motor->_stepsToTake; i++) {
                             digitalWrite(motor->_stepPin, LOW);
-                            vTaskDelay(motor->_interval / portTICK_PERIOD_MS);  // Wait for the next interval
-                            digitalWrite(motor->_stepPin, HIGH);
-                            vTaskDelay(motor->_interval / portTICK_PERIOD_MS);  // Wait for the next interval
+                            motor->waitMs(motor->_interval);  // Wait for the next interval
+                            motor->stepHigh();
+                            motor->waitMs(motor->_interval);  // Wait for the next interval
                         };
-                        prevItr = motor->_interval;// store intr
-                     motor->_interval = motor->_StopTime;// intervall equal stoptime
-                     SkipFlag = true;// skip flag false
+                        EventLogger::record(EVENT_DWELL_START, EVENT_SOURCE_DISC, motor->_stepCount, motor->_StopTime);
+                        SkipFlag = true;// the next low phase is the stop
                     };
+                    uint32_t lowStart = micros();
                     digitalWrite(motor->_stepPin, LOW);
-                    vTaskDelay(motor->_interval / portTICK_PERIOD_MS);  // Wait for the next interval
-                    motor->_interval = prevItr;//resume the previous itr
-                    digitalWrite(motor->_stepPin, HIGH);
-                    vTaskDelay(motor->_interval / portTICK_PERIOD_MS);  // Wait for the next interval
+                    // The stop time is waited here rather than stored in _interval, which
+                    // only setFrequency() writes: a setpoint set meanwhile is kept
+                    motor->waitMs(SkipFlag ? motor->_StopTime : motor->_interval);
+                    if (SkipFlag) {
+                        motor->_lastDwellUs = micros() - lowStart;  // This low phase was the stop
+                        motor->_jitter.resync();
+                        EventLogger::record(EVENT_DWELL_END, EVENT_SOURCE_DISC, motor->_stepCount, motor->_lastDwellUs);
+                        TRACE_COMPLETE("disc.dwell", esp_timer_get_time() - motor->_lastDwellUs, motor->_stepCount);
+                    }
+                    motor->stepHigh();
+                    motor->waitMs(motor->_interval);  // Wait for the next interval
                     if(SkipFlag) break;// break if the skip flag is set
                 };
                 do {
@@ -271,18 +314,17 @@ void A4988Manager::motorStepTask(void *pvParameters) {
                     // Set the step pin LOW
                     digitalWrite(motor->_stepPin, LOW);
                     // Wait for the next interval
-                    vTaskDelay(motor->_interval / portTICK_PERIOD_MS);
+                    motor->waitMs(motor->_interval);
 
                     // Set the step pin HIGH
-                    digitalWrite(motor->_stepPin, HIGH);
+                    motor->stepHigh();
                     // Wait for the next interval
-                    vTaskDelay(motor->_interval / portTICK_PERIOD_MS);
+                    motor->waitMs(motor->_interval);
 
                 } while (digitalRead(SENSOR_PIN) == true);
 
                 // Update the previous state
                 previousState = false;  
-                prevItr=motor->_interval;
                 SkipFlag = false;// reset skip flag          
             };
         }
@@ -291,6 +333,44 @@ void A4988Manager::motorStepTask(void *pvParameters) {
 
 
 
+/**
+ * @brief Waits @p ms, in slices of at most TASK_IDLE_WAKE_MS.
+ *
+ * The tick count is the same as one vTaskDelay(ms / portTICK_PERIOD_MS),
+ * but at least one tick, so a step rate above the tick rate slows down
+ * instead of starving the idle task (and tripping the watchdog); the check-ins between slices keep slow
+ * axes and long dwells within the watchdog timeout. The waits are
+ * notification waits, which stopMotorTask() ends early: the task then
+ * exits here, where no record is half written.
+ */
+void A4988Manager::waitMs(uint32_t ms) {
+    TickType_t ticks = max((TickType_t)1, (TickType_t)(ms / portTICK_PERIOD_MS));  // Never 0: idle must run
+    const TickType_t slice = pdMS_TO_TICKS(TASK_IDLE_WAKE_MS);
+    while (ticks > slice && !_stopRequested) {
+        ulTaskNotifyTake(pdTRUE, slice);
+        ticks -= slice;
+        TaskHealth::checkIn(_healthId);
+    }
+    if (!_stopRequested) ulTaskNotifyTake(pdTRUE, ticks);
+    if (_stopRequested) exitTask();
+    TaskHealth::checkIn(_healthId);
+}
+
+/**
+ * @brief Raises the step pin (the driver steps on this edge) and counts it.
+ */
+void A4988Manager::stepHigh() {
+    digitalWrite(_stepPin, HIGH);
+    _stepCount++;
+    if (_jitter.isEnabled()) {
+        // Both half periods are vTaskDelay()s of whole ticks
+        _jitter.sample(2 * max(1UL, _interval / portTICK_PERIOD_MS) * portTICK_PERIOD_MS * 1000, _stepCount);
+    }
+    if (_capture) {
+        EventLogger::record(EVENT_STEP, _Number ? EVENT_SOURCE_DISC : EVENT_SOURCE_CASE, _stepCount, _interval);
+    }
+}
+
 /**
  * @brief Generates a single step pulse for the A4988 stepper driver.
  * 
@@ -356,3 +436,65 @@ void A4988Manager::SetStopTime(int value) {
 void A4988Manager::SetStepsToTake(int value) {
     _stepsToTake = value; // Assign the number of steps
 }
+
+/**
+ * @brief Number of step pulses generated by the motor task since boot.
+ */
+uint32_t A4988Manager::getStepCount() {
+    return _stepCount;
+}
+
+/**
+ * @brief Sets the step counter, used to keep the axis position across a warm restart.
+ */
+void A4988Manager::restoreStepCount(uint32_t count) {
+    _stepCount = count;
+}
+
+/**
+ * @brief Gets the half step period the step task waits between edges.
+ *
+ * @return The interval in milliseconds, as set by the last setFrequency().
+ */
+unsigned long A4988Manager::getStepInterval() {
+    return _interval;
+}
+
+/**
+ * @brief Measured duration of the last stop after a sensor edge.
+ *
+ * @return Dwell time in microseconds, 0 before the first stop.
+ */
+uint32_t A4988Manager::getLastDwellUs() {
+    return _lastDwellUs;
+}
+
+/**
+ * @brief Time between the last two sensor rising edges.
+ *
+ * @return Interval in microseconds, 0 before the second edge.
+ */
+uint32_t A4988Manager::getSensorIntervalUs() {
+    return _sensorIntervalUs;
+}
+
+/**
+ * @brief Number of sensor rising edges seen since boot.
+ */
+uint32_t A4988Manager::getSensorEdges() {
+    return _sensorEdges;
+}
+
+/**
+ * @brief Turns per-step logging on or off.
+ *
+ * While on, every step pulse is written to the event log with its step
+ * count, so a capture can be replayed offline (app/TraceReplay.cpp).
+ */
+void A4988Manager::setCapture(bool enabled) {
+    _capture = enabled;
+}
+
+StepJitter& A4988Manager::getJitter() {
+    return _jitter;
+}
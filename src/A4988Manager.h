@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <FreeRTOS.h>
 #include "Config.h"
+#include "StepJitter.h"
 
 class A4988Manager {
 public:
@@ -32,7 +33,16 @@ public:
     uint32_t GetStepsToTake();
     void SetStopTime(int value);
     void SetStepsToTake(int value);
-    
+
+    // Live measurements for the HMI trend
+    uint32_t getStepCount();        // Step pulses generated since boot
+    void restoreStepCount(uint32_t count);  // Continue counting after a warm restart
+    uint32_t getLastDwellUs();      // Measured length of the last sensor stop
+    unsigned long getStepInterval();  // Half step period the step task waits (ms)
+    uint32_t getSensorIntervalUs(); // Time between the last two sensor edges
+    uint32_t getSensorEdges();      // Sensor rising edges since boot
+    void setCapture(bool enabled);  // Log every step to the event log (CAPTURE)
+    StepJitter& getJitter();        // Step edge timing (JITTER)
 
 
 private:
@@ -40,14 +50,26 @@ private:
     uint8_t _slpPin, _resetPin;
     bool _stepping,_Number;
     float _frequency;
-    unsigned long _interval;
+    volatile unsigned long _interval;  // Half step period (ms), written by setFrequency() only
     bool _StopFlag;
     unsigned long _lastStepTime;
     unsigned long _stepsToTake;
     unsigned long _StopTime; // Non-static, specific to the instance
 
     uint8_t _microSteps;
-    TaskHandle_t _stepTaskHandle;
+    TaskHandle_t _stepTaskHandle;   // Cleared by the step task as it ends
+    volatile bool _stopRequested;   // stopMotorTask() asks the step task to end
+    volatile uint32_t _stepCount;
+    volatile uint32_t _lastDwellUs;
+    volatile uint32_t _sensorIntervalUs;
+    volatile uint32_t _sensorEdges;
+    uint32_t _lastEdgeUs;
+    volatile bool _capture;
+    StepJitter _jitter;
+    int8_t _healthId;               // TaskHealth entry of the step task
+    void stepHigh();                // Raise the step pin and count the step
+    void waitMs(uint32_t ms);       // Step task delay that keeps checking in with TaskHealth
+    void exitTask();                // End of the step task, from its own context
     static void motorStepTask(void *pvParameters);
 };
 
@@ -0,0 +1,182 @@
+#include "BootSequence.h"
+#include "DeferredLog.h"
+#include "EventLogger.h"
+
+// Set by a stage when it starts so run() can arm its timeout
+#define BOOT_STARTED_BIT BOOT_DEP(BOOT_MAX_STAGES)
+
+static_assert(BOOT_MAX_STAGES < 24, "An event group holds 24 bits: one per stage plus BOOT_STARTED_BIT");
+
+static const char* const BOOT_STATUS_NAMES[] = { "pending", "running", "done", "timeout", "late" };
+
+/**
+ * @brief Constructor for the BootSequence class.
+ */
+BootSequence::BootSequence()
+    : stageCount(0), doneBits(nullptr), runStartUs(0), readyUs(0) {
+    statusLock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+/**
+ * @brief Registers an init step.
+ *
+ * @param name Static string, used as task name and in the report.
+ * @param dependencies BOOT_DEP() of earlier stages that must be done first.
+ * @param timeoutMs Time the stage may run before its dependents are
+ *        released without it, 0 to always wait.
+ * @return The stage number, or -1 if the table is full or a dependency
+ *         is not an earlier stage (which would allow a cycle).
+ */
+int8_t BootSequence::addStage(const char* name, BootStageFunction function, uint32_t dependencies,
+                              uint32_t timeoutMs) {
+    if (stageCount >= BOOT_MAX_STAGES || dependencies >= BOOT_DEP(stageCount)) return -1;
+
+    Stage& stage = stages[stageCount];
+    stage.owner = this;
+    stage.name = name;
+    stage.function = function;
+    stage.dependencies = dependencies;
+    stage.timeoutMs = timeoutMs;
+    stage.status = BOOT_STAGE_PENDING;
+    stage.startUs = 0;
+    stage.endUs = 0;
+    return stageCount++;
+}
+
+/**
+ * @brief Starts every stage and waits until each is done or timed out.
+ *
+ * The calling task only supervises timeouts; the stages run in their own
+ * tasks and delete themselves when their function returns.
+ */
+void BootSequence::run() {
+    runStartUs = micros();
+    doneBits = xEventGroupCreate();
+    for (uint8_t i = 0; i < stageCount; i++) {
+        xTaskCreatePinnedToCore(stageTask, stages[i].name, BOOT_TASK_STACK, &stages[i],
+                                BOOT_TASK_PRIORITY, NULL, BOOT_TASK_CORE);
+    }
+
+    const EventBits_t all = BOOT_DEP(stageCount) - 1;
+    while (true) {
+        xEventGroupClearBits(doneBits, BOOT_STARTED_BIT);
+        EventBits_t done = xEventGroupGetBits(doneBits) & all;
+        if (done == all) break;
+
+        // Expire running stages and sleep until the nearest deadline
+        TickType_t wait = portMAX_DELAY;
+        uint32_t now = micros();
+        for (uint8_t i = 0; i < stageCount; i++) {
+            Stage& stage = stages[i];
+            if ((done & BOOT_DEP(i)) || stage.timeoutMs == 0) continue;
+
+            portENTER_CRITICAL(&statusLock);
+            bool running = stage.status == BOOT_STAGE_RUNNING;
+            uint32_t elapsedMs = (now - stage.startUs) / 1000;
+            bool expired = running && elapsedMs >= stage.timeoutMs;
+            if (expired) stage.status = BOOT_STAGE_TIMEOUT;
+            portEXIT_CRITICAL(&statusLock);
+
+            if (expired) {
+                LOG_WARN(LOG_BOOT_STAGE_TIMEOUT, LOG_STR(stage.name), stage.timeoutMs);
+                EventLogger::record(EVENT_FAULT, EVENT_SOURCE_SYSTEM, FAULT_BOOT_TIMEOUT, stage.timeoutMs);
+                xEventGroupSetBits(doneBits, BOOT_DEP(i));  // Release the dependents
+                wait = 0;
+            } else if (running) {
+                TickType_t left = pdMS_TO_TICKS(stage.timeoutMs - elapsedMs) + 1;
+                if (left < wait) wait = left;
+            }
+        }
+        xEventGroupWaitBits(doneBits, (all & ~done) | BOOT_STARTED_BIT, pdFALSE, pdFALSE, wait);
+    }
+    readyUs = micros();
+}
+
+/**
+ * @brief Task body of one stage: wait for dependencies, run, report.
+ */
+void BootSequence::stageTask(void *pvParameters) {
+    Stage& stage = *static_cast<Stage*>(pvParameters);
+    BootSequence* boot = stage.owner;
+
+    if (stage.dependencies != 0) {
+        xEventGroupWaitBits(boot->doneBits, stage.dependencies, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    portENTER_CRITICAL(&boot->statusLock);
+    stage.startUs = micros();
+    stage.status = BOOT_STAGE_RUNNING;
+    portEXIT_CRITICAL(&boot->statusLock);
+    xEventGroupSetBits(boot->doneBits, BOOT_STARTED_BIT);
+
+    stage.function();
+    boot->finish(stage);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Records the end of @p stage and releases its dependents.
+ */
+void BootSequence::finish(Stage& stage) {
+    uint32_t endUs = micros();
+    portENTER_CRITICAL(&statusLock);
+    stage.endUs = endUs;
+    bool late = stage.status == BOOT_STAGE_TIMEOUT;
+    stage.status = late ? BOOT_STAGE_LATE : BOOT_STAGE_DONE;
+    portEXIT_CRITICAL(&statusLock);
+
+    if (late) {
+        LOG_WARN(LOG_BOOT_STAGE_LATE, LOG_STR(stage.name), endUs - stage.startUs);
+    } else {
+        LOG_INFO(LOG_BOOT_STAGE_DONE, LOG_STR(stage.name), endUs - stage.startUs);
+    }
+    xEventGroupSetBits(doneBits, BOOT_DEP(&stage - stages));
+}
+
+bool BootSequence::isDone(int8_t stage) {
+    if (stage < 0 || stage >= stageCount) return false;
+    BootStageStatus status = stages[stage].status;
+    return status == BOOT_STAGE_DONE || status == BOOT_STAGE_LATE;
+}
+
+uint32_t BootSequence::getReadyUs() {
+    return readyUs;
+}
+
+/**
+ * @brief Adds the boot timing to @p doc.
+ *
+ * Times are micros() since reset. "serialUs" is the sum of all stage
+ * durations, i.e. what a one-after-the-other boot would have taken.
+ */
+void BootSequence::report(JsonDocument& doc) {
+    doc["setupStartUs"] = runStartUs;
+    doc["readyUs"] = readyUs;
+    doc["bootUs"] = readyUs - runStartUs;
+
+    uint32_t serialUs = 0;
+    JsonArray list = doc["stages"].to<JsonArray>();
+    for (uint8_t i = 0; i < stageCount; i++) {
+        Stage& stage = stages[i];
+        portENTER_CRITICAL(&statusLock);
+        BootStageStatus status = stage.status;
+        uint32_t startUs = stage.startUs;
+        uint32_t endUs = stage.endUs;
+        portEXIT_CRITICAL(&statusLock);
+
+        JsonObject item = list.add<JsonObject>();
+        item["name"] = stage.name;
+        item["status"] = BOOT_STATUS_NAMES[status];
+        JsonArray after = item["after"].to<JsonArray>();
+        for (uint8_t dep = 0; dep < i; dep++) {
+            if (stage.dependencies & BOOT_DEP(dep)) after.add(stages[dep].name);
+        }
+        if (status == BOOT_STAGE_PENDING) continue;
+        item["startUs"] = startUs;
+        if (status == BOOT_STAGE_DONE || status == BOOT_STAGE_LATE) {
+            item["endUs"] = endUs;
+            item["us"] = endUs - startUs;
+            serialUs += endUs - startUs;
+        }
+    }
+    doc["serialUs"] = serialUs;
+}
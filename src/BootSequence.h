@@ -0,0 +1,73 @@
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include "Config.h"
+
+/**
+ * @file BootSequence.h
+ * @brief Dependency-aware parallel start-up with per-stage timing.
+ *
+ * setup() registers each init step as a stage with the stages it depends
+ * on. run() starts one task per stage; a stage waits until all of its
+ * dependencies are done, so independent stages (SD card, display, config)
+ * overlap. A stage with a timeout that is still running when it expires
+ * is marked timed out and its dependents are released; it keeps running
+ * in the background and is reported as late if it finishes afterwards.
+ *
+ * Start and end of every stage are recorded with micros() (time since
+ * reset) and reported by the BOOTREPORT command.
+ */
+
+// Dependency mask for addStage()
+#define BOOT_DEP(stage) (1UL << (stage))
+
+typedef void (*BootStageFunction)();
+
+enum BootStageStatus : uint8_t {
+    BOOT_STAGE_PENDING,   // Waiting for its dependencies
+    BOOT_STAGE_RUNNING,
+    BOOT_STAGE_DONE,
+    BOOT_STAGE_TIMEOUT,   // Timeout expired, still running in the background
+    BOOT_STAGE_LATE       // Finished after its timeout
+};
+
+class BootSequence {
+public:
+    BootSequence();
+
+    // Returns the stage number for BOOT_DEP(), or -1 if BOOT_MAX_STAGES is reached
+    int8_t addStage(const char* name, BootStageFunction function, uint32_t dependencies = 0,
+                    uint32_t timeoutMs = 0);
+    void run();                            // Returns when every stage is done or timed out
+    bool isDone(int8_t stage);             // Stage finished (in time or late)
+    uint32_t getReadyUs();                 // micros() when run() returned
+    void report(JsonDocument& doc);        // BOOTREPORT
+
+private:
+    struct Stage {
+        BootSequence* owner;
+        const char* name;
+        BootStageFunction function;
+        uint32_t dependencies;
+        uint32_t timeoutMs;
+        volatile BootStageStatus status;
+        uint32_t startUs;                  // Dependencies met, function called
+        uint32_t endUs;                    // Function returned
+    };
+
+    static void stageTask(void *pvParameters);
+    void finish(Stage& stage);
+
+    Stage stages[BOOT_MAX_STAGES];
+    uint8_t stageCount;
+    EventGroupHandle_t doneBits;           // One bit per stage that is done or timed out
+    portMUX_TYPE statusLock;               // Done vs. timed out decision
+    uint32_t runStartUs;
+    uint32_t readyUs;
+};
+
+#endif // BOOT_SEQUENCE_H
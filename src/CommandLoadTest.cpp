@@ -0,0 +1,179 @@
+#include "CommandLoadTest.h"
+#include "CommandReceiver.h"
+#include "Metrics.h"
+#include "TaskHealth.h"
+
+// Command templates, mirroring lib/comandFormat.json
+struct LoadTestTemplate {
+    const char* name;  // Key used in the "mix" object
+    const char* json;
+};
+
+static const LoadTestTemplate LOADTEST_TEMPLATES[] = {
+    { "STOPSYSTEM",  "{\"command\":\"STOPSYSTEM\"}" },
+    { "STARTSYSTEM", "{\"command\":\"STARTSYSTEM\"}" },
+    { "motorCase",   "{\"command\":\"motor\",\"motorType\":\"motorCase\",\"speed\":50.0,\"microsteps\":16,\"direction\":1}" },
+    { "motorDisc",   "{\"command\":\"motor\",\"motorType\":\"motorDoor\",\"speed\":30.5,\"microsteps\":8,\"direction\":-1}" },
+    { "sensor",      "{\"command\":\"sensor\",\"stoptime\":5000,\"stepstotake\":100}" },
+    { "GETSTATUS",   "{\"command\":\"GETSTATUS\"}" },
+};
+static const uint8_t LOADTEST_TEMPLATE_COUNT = sizeof(LOADTEST_TEMPLATES) / sizeof(LOADTEST_TEMPLATES[0]);
+
+/**
+ * @brief Constructor for the CommandLoadTest class.
+ *
+ * @param receiver CommandReceiver whose receiveCommand() is exercised.
+ */
+CommandLoadTest::CommandLoadTest(CommandReceiver* receiver)
+    : cmdReceiver(receiver), samples(0), maxCycles(0) {
+    memset(buckets, 0, sizeof(buckets));
+}
+
+/**
+ * @brief Runs the load test and prints a JSON report.
+ *
+ * Request fields (all optional):
+ * - count:   number of commands to send (default LOADTEST_DEFAULT_COUNT)
+ * - corrupt: percentage of commands to corrupt (0-100)
+ * - seed:    random seed, for reproducible runs
+ * - mix:     relative weight per template name, e.g. {"motorCase":4,"GETSTATUS":1},
+ *            each clamped to 0..LOADTEST_MAX_WEIGHT
+ *
+ * @param request The parsed LOADTEST command.
+ */
+void CommandLoadTest::run(JsonDocument& request) {
+    uint32_t count = request["count"] | LOADTEST_DEFAULT_COUNT;
+    int32_t corruptField = request["corrupt"] | 0;  // Clamped before narrowing
+    uint8_t corruptPercent = (uint8_t)constrain(corruptField, 0, 100);
+    uint32_t seed = request["seed"] | 1;
+
+    // Build the cumulative weight table; clamped weights keep the totals in range
+    uint32_t weights[LOADTEST_TEMPLATE_COUNT];
+    uint32_t totalWeight = 0;
+    for (uint8_t i = 0; i < LOADTEST_TEMPLATE_COUNT; i++) {
+        int32_t weightField = request["mix"].isNull() ? 1 : (request["mix"][LOADTEST_TEMPLATES[i].name] | 0);
+        totalWeight += (uint32_t)constrain(weightField, 0, LOADTEST_MAX_WEIGHT);
+        weights[i] = totalWeight;
+    }
+    if (totalWeight == 0) {
+        Serial.println("{\"loadtest\":\"error\",\"reason\":\"empty mix\"}");
+        return;
+    }
+
+    randomSeed(seed);
+    uint32_t corrupted = 0, rejectedValid = 0, rejectedCorrupt = 0, acceptedCorrupt = 0;
+    uint32_t overflowBefore = cmdReceiver->getOverflowedLines();
+    uint32_t heapStart = ESP.getFreeHeap();
+    uint32_t heapMinSampled = heapStart;
+    char line[COMMAND_LINE_SIZE];
+
+    cmdReceiver->setDryRun(true);
+    uint32_t runStart = millis();
+
+    for (uint32_t n = 0; n < count; n++) {
+        // Pick a template by weight
+        uint32_t pick = random(totalWeight);
+        uint8_t t = 0;
+        while (t < LOADTEST_TEMPLATE_COUNT - 1 && pick >= weights[t]) t++;
+
+        size_t len = strlen(LOADTEST_TEMPLATES[t].json);
+        memcpy(line, LOADTEST_TEMPLATES[t].json, len + 1);
+        bool isCorrupt = corruptPercent && (uint32_t)random(100) < corruptPercent;
+        if (isCorrupt) {
+            len = corrupt(line, len, sizeof(line));
+            corrupted++;
+        }
+
+        uint32_t start = ESP.getCycleCount();
+        bool recognized = cmdReceiver->receiveCommand(line, len);
+        recordLatency(ESP.getCycleCount() - start);
+
+        if (!recognized && !isCorrupt) rejectedValid++;
+        else if (!recognized) rejectedCorrupt++;
+        else if (isCorrupt) acceptedCorrupt++;
+
+        uint32_t freeHeap = ESP.getFreeHeap();
+        if (freeHeap < heapMinSampled) heapMinSampled = freeHeap;
+        if ((n & 0xFF) == 0) {
+            vTaskDelay(1);  // Let lower-priority tasks breathe
+            TaskHealth::feed();
+        }
+    }
+
+    uint32_t runMs = millis() - runStart;
+    cmdReceiver->setDryRun(false);
+
+    float mhz = ESP.getCpuFreqMHz();
+    JsonDocument report;
+    report["loadtest"] = "done";
+    report["commands"] = count;
+    report["corrupted"] = corrupted;
+    report["durationMs"] = runMs;
+    report["p50Us"] = percentile(0.50f) / mhz;
+    report["p99Us"] = percentile(0.99f) / mhz;
+    report["maxUs"] = maxCycles / mhz;
+    report["misparsed"] = rejectedValid;          // Valid templates that were not recognized
+    report["rejectedCorrupt"] = rejectedCorrupt;  // Corrupted input correctly refused
+    report["acceptedCorrupt"] = acceptedCorrupt;  // Corrupted input still recognized
+    report["droppedLines"] = cmdReceiver->getOverflowedLines() - overflowBefore;
+    report["heapStart"] = heapStart;
+    report["heapEnd"] = ESP.getFreeHeap();
+    report["heapMinSampled"] = heapMinSampled;
+    report["heapLowWater"] = ESP.getMinFreeHeap();  // Since boot, includes parse peaks
+    String output;
+    serializeJson(report, output);
+    Serial.println(output);
+}
+
+/**
+ * @brief Applies one random corruption: flip, delete, insert or truncate.
+ *
+ * @return New length of the line.
+ */
+size_t CommandLoadTest::corrupt(char* buf, size_t len, size_t size) {
+    if (len == 0) return 0;
+    size_t pos = random(len);
+
+    switch (random(4)) {
+        case 0:  // Flip a random bit
+            buf[pos] ^= (char)(1 << random(8));
+            break;
+        case 1:  // Delete a byte
+            memmove(buf + pos, buf + pos + 1, len - pos);
+            len--;
+            break;
+        case 2:  // Insert a random byte
+            if (len + 2 < size) {
+                memmove(buf + pos + 1, buf + pos, len - pos + 1);
+                buf[pos] = (char)random(256);
+                len++;
+            }
+            break;
+        default: // Truncate
+            len = pos;
+            buf[len] = '\0';
+            break;
+    }
+    return len;
+}
+
+void CommandLoadTest::recordLatency(uint32_t cycles) {
+    buckets[MetricHistogram::bucketIndex(cycles)]++;
+    samples++;
+    if (cycles > maxCycles) maxCycles = cycles;
+}
+
+/**
+ * @brief Returns the lower bound (cycles) of the bucket holding the given percentile.
+ */
+uint32_t CommandLoadTest::percentile(float fraction) {
+    if (samples == 0) return 0;
+    uint32_t target = (uint32_t)(fraction * samples);
+    if (target >= samples) target = samples - 1;
+    uint32_t seen = 0;
+    for (uint16_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > target) return MetricHistogram::bucketValue(i);
+    }
+    return maxCycles;
+}
@@ -0,0 +1,37 @@
+#ifndef COMMAND_LOAD_TEST_H
+#define COMMAND_LOAD_TEST_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "Config.h"
+
+class CommandReceiver;
+
+/**
+ * @brief On-device load test for the JSON command path.
+ *
+ * Feeds CommandReceiver::receiveCommand with a weighted mix of the
+ * commands documented in lib/comandFormat.json, optionally corrupting a
+ * percentage of them, while the receiver runs in dry-run mode (parse and
+ * dispatch only). Reports p50/p99/max latency, heap usage and how many
+ * commands were rejected or misparsed as a single JSON line.
+ */
+class CommandLoadTest {
+public:
+    CommandLoadTest(CommandReceiver* receiver);
+
+    // Run with the parameters of a LOADTEST request and print the report
+    void run(JsonDocument& request);
+
+private:
+    void recordLatency(uint32_t cycles);
+    uint32_t percentile(float fraction);
+    size_t corrupt(char* buf, size_t len, size_t size);
+
+    CommandReceiver* cmdReceiver;
+    uint32_t samples;
+    uint32_t maxCycles;
+    uint32_t buckets[METRICS_HISTOGRAM_BUCKETS];  // Latency (cycles), MetricHistogram bucketing
+};
+
+#endif // COMMAND_LOAD_TEST_H
@@ -1,126 +1,639 @@
 #include <ArduinoJson.h>
+#include <SD.h>
 #include "CommandReceiver.h"
 #include "Config.h"
+#include "DeferredLog.h"
+#include "NextionHMI.h"
+#include "ConfigManager.h"
+#include "RecipeManager.h"
+#include "BootSequence.h"
+#include "WarmRestart.h"
+#include "EventLogger.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "CrashReport.h"
+#include "TaskHealth.h"
+
+// Runtime metrics (GETMETRICS)
+static MetricHistogram commandLatency("command.latency", "us");  // receiveCommand() of host commands
+static MetricCounter commandsExecuted("command.executed");
+static MetricCounter commandsRejected("command.rejected");      // Unknown or invalid
+static MetricHistogram commandBusy("command.busy", "us");        // checkCommand() per command task wake-up
+
+// Commands of handleRecipeCommand(); any other RECIPE* name is unknown
+static const char* const recipeCommands[] = {
+    "RECIPESAVE", "RECIPELOAD", "RECIPEDELETE", "RECIPELIST", "RECIPEIMPORT", "RECIPEEXPORT"
+};
+
+/** Returns the recipeCommands entry equal to @p cmdType, nullptr if none. */
+static const char* findRecipeCommand(const char* cmdType) {
+    for (const char* recipeCommand : recipeCommands) {
+        if (strcmp(cmdType, recipeCommand) == 0) return recipeCommand;
+    }
+    return nullptr;
+}
 
 // Constructor implementation
 CommandReceiver::CommandReceiver(Sensor* sensor, A4988Manager& motor1, A4988Manager& motor2)
-    : commandReceived(false), // Initialize commandReceived first
+    : rxDiscarding(false),
+      commandQueue(nullptr),
+      flowControl(COMMAND_FLOW_CONTROL_DEFAULT),
+      pendingCredits(0),
+      overflowedLines(0),
+      dryRun(false),
+      commandTaskHandle(nullptr),
       sensor(sensor),
       _motor1(motor1),        // Initialize _motor1
-      _motor2(motor2) {}      // Initialize _motor2
+      _motor2(motor2),        // Initialize _motor2
+      lastCommand("NONE"),
+      telemetry(this),
+      hmi(nullptr),
+      config(nullptr),
+      recipes(nullptr), boot(nullptr), warmRestart(nullptr), crashReport(nullptr) {
+    rxSlot.length = 0;
+    controlMutex = xSemaphoreCreateMutex();
+}
 
 // Initialize the receiver
 void CommandReceiver::begin() {
+    // The RX buffer must hold a full credit window of maximum-length lines,
+    // the TX ring a telemetry frame (availableForWrite() is otherwise the
+    // 128-byte FIFO); both can only be resized while the driver is stopped.
+    Serial.end();
+    Serial.setRxBufferSize(COMMAND_RX_BUFFER_SIZE);
+    Serial.setTxBufferSize(COMMAND_TX_BUFFER_SIZE);
+#ifdef COMMAND_HW_FLOW_CONTROL
+    Serial.setPins(-1, -1, COMMAND_CTS_PIN, COMMAND_RTS_PIN);
+    Serial.setHwFlowCtrlMode(UART_HW_FLOWCTRL_CTS_RTS, COMMAND_RTS_THRESHOLD);
+#endif
     Serial.begin(BAUDE_RATE); // Start serial communication
     //while (!Serial);  // Wait for Serial to be ready (only needed for some ESP32 boards)
+
+    if (commandQueue == nullptr) {
+        commandQueue = xQueueCreate(COMMAND_QUEUE_DEPTH, sizeof(CommandSlot));
+    }
+    statusEncoder.begin();    // Render the status template once
+    advertiseCredits();
+}
+
+/**
+ * @brief Starts the command task on COMMAND_TASK_CORE.
+ *
+ * The UART driver wakes the task when bytes arrive, so a line is handled
+ * as soon as it is complete; without traffic it wakes every
+ * TASK_IDLE_WAKE_MS to check in with the task watchdog.
+ */
+void CommandReceiver::startTask() {
+    if (commandTaskHandle != nullptr) return;
+    xTaskCreatePinnedToCore(commandTask, "Command Task", COMMAND_TASK_STACK, this,
+                            COMMAND_TASK_PRIORITY, &commandTaskHandle, COMMAND_TASK_CORE);
+    TaskHandle_t task = commandTaskHandle;
+    Serial.onReceive([task]() { xTaskNotifyGive(task); }, false);
+}
+
+void CommandReceiver::commandTask(void *pvParameters) {
+    CommandReceiver* receiver = static_cast<CommandReceiver*>(pvParameters);
+    int8_t health = TaskHealth::add("command");
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TASK_IDLE_WAKE_MS));
+        TaskHealth::checkIn(health);
+        uint32_t start = micros();
+        receiver->checkCommand();
+        commandBusy.record(micros() - start);
+    }
 }
 
 // Check and process commands if data is available
 void CommandReceiver::checkCommand() {
-    // Check if data is available in the serial buffer
+    pumpRx();
+
+    // Process every queued command, then hand the freed slots back at once.
+    // The credit is counted before executing so a FLOWCONTROL re-advertise
+    // (which already includes this slot) can supersede it.
+    while (xQueueReceive(commandQueue, &workSlot, 0) == pdTRUE) {
+        pendingCredits++;
+        Serial.write((const uint8_t*)workSlot.text, workSlot.length);  // Echo the command
+        Serial.write('\n');
+        TRACE_SCOPE("cmd.execute", workSlot.length);
+        lockControl();
+        uint32_t start = micros();
+        bool executed = receiveCommand(workSlot.text, workSlot.length);
+        commandLatency.record(micros() - start);
+        unlockControl();
+        if (executed) commandsExecuted.add(); else commandsRejected.add();
+    }
+    grantCredits();
+}
+
+/**
+ * @brief Reads all pending UART bytes without blocking.
+ *
+ * Bytes are assembled into a line; each newline-terminated line is copied
+ * into a free command slot. Lines longer than COMMAND_LINE_SIZE, or lines
+ * arriving when every slot is taken (host ignored its credits), are
+ * dropped, counted and still credited back so the window stays in sync.
+ */
+void CommandReceiver::pumpRx() {
+    if (commandQueue == nullptr) return;
+
     while (Serial.available()) {
-        commandBuffer = Serial.readStringUntil('\n'); // Read command until newline
-        commandReceived = true; // Set the flag for received command
+        int c = Serial.read();
+        if (c < 0) break;
+
+        if (c == '\r') continue;
+        if (c != '\n') {
+            if (rxSlot.length < COMMAND_LINE_SIZE - 1) {
+                rxSlot.text[rxSlot.length++] = (char)c;
+            } else {
+                rxDiscarding = true;  // Keep consuming until the newline
+            }
+            continue;
+        }
+
+        // End of line
+        rxSlot.text[rxSlot.length] = '\0';
+        if (rxDiscarding || xQueueSend(commandQueue, &rxSlot, 0) != pdTRUE) {
+            overflowedLines++;
+            pendingCredits++;
+            EventLogger::record(EVENT_FAULT, EVENT_SOURCE_SYSTEM, FAULT_COMMAND_OVERFLOW, overflowedLines);
+        }
+        rxSlot.length = 0;
+        rxDiscarding = false;
     }
+}
+
+/**
+ * @brief Enables or disables credit reporting.
+ *
+ * Enabling re-advertises the window so the host can resynchronize; any
+ * credits not yet granted are folded into that advertisement.
+ */
+void CommandReceiver::setFlowControl(bool enabled) {
+    flowControl = enabled;
+    pendingCredits = 0;
+    if (flowControl) advertiseCredits();
+}
 
-    // Process command if received
-    if (commandReceived) {
-        Serial.println(commandBuffer);
-        commandReceived = false; // Reset the flag
-        receiveCommand(commandBuffer); // Call the receiveCommand function
+/**
+ * @brief Sends the full credit window, e.g. at boot or on request.
+ *
+ * The host should reset its available credits to "credits" when it sees this.
+ */
+void CommandReceiver::advertiseCredits() {
+    if (!flowControl) return;
+    Serial.printf("{\"window\":%u,\"credits\":%u,\"lineSize\":%u}\n",
+                  (unsigned)COMMAND_QUEUE_DEPTH, (unsigned)getFreeSlots(), (unsigned)COMMAND_LINE_SIZE);
+}
+
+/**
+ * @brief Replenishes host credits for every slot freed since the last grant.
+ */
+void CommandReceiver::grantCredits() {
+    if (pendingCredits == 0) return;
+    if (flowControl) {
+        Serial.printf("{\"credits\":%u}\n", (unsigned)pendingCredits);
     }
+    pendingCredits = 0;
+}
+
+uint16_t CommandReceiver::getFreeSlots() {
+    return commandQueue ? uxQueueSpacesAvailable(commandQueue) : 0;
+}
+
+uint32_t CommandReceiver::getOverflowedLines() {
+    return overflowedLines;
 }
 
 // Function to receive and handle command
-void CommandReceiver::receiveCommand(const String& command) {
+bool CommandReceiver::receiveCommand(const String& command) {
+    return receiveCommand(command.c_str(), command.length());
+}
+
+// Parse and execute one command line; returns true if it was recognized
+bool CommandReceiver::receiveCommand(const char* command, size_t length) {
     // Allocate a JSON document
     JsonDocument doc; // Adjust size as needed
 
     // Deserialize the JSON command
-    DeserializationError error = deserializeJson(doc, command);
+    DeserializationError error;
+    {
+        TRACE_SCOPE("cmd.parse");
+        error = deserializeJson(doc, command, length);
+    }
 
     if (error) {
         // Deserialization failed, return
-        Serial.print("JSON deserialization failed: ");
-        Serial.println(error.c_str());
-        return; // Exit if there is an error
+        if (!dryRun) LOG_WARN(LOG_CMD_JSON_ERROR, LOG_STR(error.c_str()));
+        return false; // Exit if there is an error
     }
 
     // Process the commands based on the JSON structure
     if (!doc["command"].is<const char*>()) {
         // Command is invalid if 'command' field is missing
-        Serial.println("Invalid command: 'command' field missing");
-        return; // Ignore if no "command" field exists
+        if (!dryRun) LOG_WARN(LOG_CMD_MISSING_FIELD);
+        return false; // Ignore if no "command" field exists
     }
 
     const char* cmdType = doc["command"];
-    bool commandRecognized = false; // Track if the command is recognized
+    const char* name = nullptr;     // Set by the branch that recognized the command
+    bool query = false;             // Polls and tools, not recorded as lastCommand
 
     // Handle system commands
     if (strcmp(cmdType, "STOPSYSTEM") == 0) {
-        _motor1.Stop();
-        _motor2.Stop();
-        _motor1.setFrequency(0.0);
-        _motor2.setFrequency(0.0);
-        commandRecognized = true;
-        Serial.println("Command received: STOPSYSTEM");
+        if (!dryRun) {
+            _motor1.Stop();
+            _motor2.Stop();
+            _motor1.setFrequency(0.0);
+            _motor2.setFrequency(0.0);
+        }
+        name = "STOPSYSTEM";
 
     } else if (strcmp(cmdType, "STARTSYSTEM") == 0) {
-        _motor1.Start();
-        _motor2.Start();
-        _motor1.setFrequency(_motor1.getSpeed());
-        _motor2.setFrequency(_motor2.getSpeed());
-        commandRecognized = true;
-        Serial.println("Command received: STARTSYSTEM");
+        if (!dryRun) {
+            _motor1.Start();
+            _motor2.Start();
+            _motor1.setFrequency(_motor1.getSpeed());
+            _motor2.setFrequency(_motor2.getSpeed());
+        }
+        name = "STARTSYSTEM";
 
     } else if (strcmp(cmdType, "motor") == 0) {
         // Ensure necessary motor parameters are present
         if (doc["motorType"].is<String>() && doc["speed"].is<float>() && doc["microsteps"].is<int>() && doc["direction"].is<int>()) {
             String motor = doc["motorType"];
-            float speed = doc["speed"];
+            float speed = clampSpeed(doc["speed"]);
             int microsteps = doc["microsteps"];
             int direction = doc["direction"];
 
-            setMotorParameters(motor == "motorCase" ? 1 : 2, speed, microsteps, direction);
-            commandRecognized = true;
-            Serial.println("Command received: MOTOR");
+            if (!dryRun) setMotorParameters(motor == "motorCase" ? 1 : 2, speed, microsteps, direction);
+            name = "motor";
         } else {
-            Serial.println("Invalid motor command: missing parameters");
+            if (!dryRun) LOG_WARN(LOG_CMD_INVALID_PARAMS, LOG_STR("motor"));
         }
 
     } else if (strcmp(cmdType, "sensor") == 0) {
         // Ensure necessary sensor parameters are present
-        if (doc["stop"].is<int>() && doc["stepstotake"].is<int>()) {
-            int stopTime = doc["stoptime"];
+        // "stoptime" is the documented field; "stop" is accepted for older hosts
+        JsonVariant stopField = doc["stoptime"].is<int>() ? doc["stoptime"] : doc["stop"];
+        if (stopField.is<int>() && doc["stepstotake"].is<int>()) {
+            int stopTime = stopField;
             int stepsToTake = doc["stepstotake"];
 
             // Set sensor parameters
-            setSensorParameters(2,stopTime, stepsToTake);
-            commandRecognized = true;
-            Serial.println("Command received: SENSOR");
+            if (!dryRun) setSensorParameters(2,stopTime, stepsToTake);
+            name = "sensor";
         } else {
-            Serial.println("Invalid sensor command: missing parameters");
+            if (!dryRun) LOG_WARN(LOG_CMD_INVALID_PARAMS, LOG_STR("sensor"));
         }
 
     } else if (strcmp(cmdType, "GETSTATUS") == 0) {
         // Handle GETSTATUS command
-        sendSystemStatus();
-        commandRecognized = true;
-        Serial.println("Command received: GETSTATUS");
+        if (dryRun) {
+            StatusSnapshot snapshot;
+            const uint8_t* line;
+            captureStatus(snapshot);
+            statusEncoder.encodeJson(snapshot, &line);  // Same work, no UART output
+        } else {
+            sendSystemStatus();
+        }
+        name = "GETSTATUS";
+        query = true;
+
+    } else if (strcmp(cmdType, "STATUSBENCH") == 0) {
+        // Measure status encoding cost: {"command":"STATUSBENCH","iterations":1000}
+        uint32_t iterations = doc["iterations"] | STATUS_BENCH_DEFAULT_ITERATIONS;
+        if (!dryRun) runStatusBenchmark(iterations);
+        name = "STATUSBENCH";
+        query = true;
+
+    } else if (strcmp(cmdType, "FLOWCONTROL") == 0) {
+        // {"command":"FLOWCONTROL","enable":true} - also re-advertises the window
+        if (!dryRun) setFlowControl(doc["enable"] | true);
+        name = "FLOWCONTROL";
+        query = true;
+
+    } else if (strcmp(cmdType, "SUBSCRIBE") == 0) {
+        // Start pushing status frames: {"command":"SUBSCRIBE","rate":50,"keyframe":25}
+        uint16_t rate = doc["rate"] | TELEMETRY_DEFAULT_RATE_HZ;
+        uint16_t keyframe = doc["keyframe"] | TELEMETRY_KEYFRAME_INTERVAL;
+        if (!dryRun) telemetry.subscribe(rate, keyframe);
+        name = "SUBSCRIBE";
+
+    } else if (strcmp(cmdType, "UNSUBSCRIBE") == 0) {
+        if (!dryRun) telemetry.unsubscribe();
+        name = "UNSUBSCRIBE";
+
+    } else if (strcmp(cmdType, "HMISTATS") == 0) {
+        if (!dryRun && hmi) hmi->reportStats();
+        name = "HMISTATS";
+        query = true;
+
+    } else if (strcmp(cmdType, "HMITREND") == 0) {
+        // {"command":"HMITREND","enable":false}
+        if (!dryRun && hmi) hmi->setTrendEnabled(doc["enable"] | true);
+        name = "HMITREND";
+
+    } else if (strcmp(cmdType, "SAVE") == 0) {
+        if (!dryRun && config) config->commit();
+        name = "SAVE";
+
+    } else if (strcmp(cmdType, "CONFIGSTATS") == 0) {
+        if (!dryRun && config) {
+            JsonDocument report;
+            report["nvsWrites"] = config->getNvsWrites();
+            report["commits"] = config->getCommitCount();
+            report["pending"] = config->getPendingCount();
+            report["rejected"] = config->getRejectedWrites();
+            report["loadedSchema"] = config->getLoadedVersion();
+            report["schema"] = CONFIG_SCHEMA_VERSION;
+            String output;
+            serializeJson(report, output);
+            Serial.println(output);
+        }
+        name = "CONFIGSTATS";
+        query = true;
+
+    } else if (strcmp(cmdType, "NVSDIAG") == 0) {
+        if (!dryRun && config) {
+            JsonDocument report;
+            config->reportDiagnostics(report);
+            String output;
+            serializeJson(report, output);
+            Serial.println(output);
+        }
+        name = "NVSDIAG";
+        query = true;
+
+    } else if (strcmp(cmdType, "EVENTSTATS") == 0) {
+        if (!dryRun) {
+            JsonDocument report;
+            EventLogger::report(report);
+            String output;
+            serializeJson(report, output);
+            Serial.println(output);
+        }
+        name = "EVENTSTATS";
+        query = true;
+
+    } else if (strcmp(cmdType, "CAPTURE") == 0) {
+        // {"command":"CAPTURE","enable":true} - without "enable" only reports the state
+        if (!dryRun && sensor) {
+            JsonDocument reply;
+            if (!doc["enable"].isNull()) reply["ok"] = setCapture(doc["enable"].as<bool>());
+            reply["capture"] = sensor->isCapturing();
+            reply["logging"] = EventLogger::isActive();
+            String output;
+            serializeJson(reply, output);
+            Serial.println(output);
+        }
+        name = "CAPTURE";
+
+    } else if (strcmp(cmdType, "GETMETRICS") == 0) {
+        // {"command":"GETMETRICS","reset":true} - reset after reporting
+        if (!dryRun) {
+            JsonDocument report;
+            Metrics::report(report);
+            String output;
+            serializeJson(report, output);
+            Serial.println(output);
+            if (doc["reset"] | false) Metrics::reset();
+        }
+        name = "GETMETRICS";
+        query = true;
+
+    } else if (strcmp(cmdType, "JITTER") == 0) {
+        // {"command":"JITTER","motor":2,"enable":true,"reset":true} - all optional, "motor" 0 = both
+        if (!dryRun) {
+            int motor = doc["motor"] | 0;
+            A4988Manager* axes[2] = { &_motor1, &_motor2 };
+            for (int i = 0; i < 2; i++) {
+                if (motor != 0 && motor != i + 1) continue;
+                StepJitter& jitter = axes[i]->getJitter();
+                if (doc["reset"] | false) jitter.reset();
+                if (!doc["enable"].isNull()) jitter.setEnabled(doc["enable"].as<bool>());
+            }
+            JsonDocument reply;
+            _motor1.getJitter().report(reply["case"].to<JsonObject>());
+            _motor2.getJitter().report(reply["disc"].to<JsonObject>());
+            String output;
+            serializeJson(reply, output);
+            Serial.println(output);
+        }
+        name = "JITTER";
+        query = true;
+
+    } else if (strcmp(cmdType, "TRACEDUMP") == 0) {
+        // {"command":"TRACEDUMP","file":"/trace.json","enable":true,"clear":true} - all optional,
+        // without "file" the trace is printed as one line before the reply
+        if (!dryRun) {
+            if (!doc["enable"].isNull()) Trace::setEnabled(doc["enable"].as<bool>());
+            JsonDocument reply;
+            const char* path = doc["file"];
+            if (path != nullptr) {
+                File file = SD.open(path, FILE_WRITE);
+                reply["ok"] = (bool)file;
+                if (file) {
+                    reply["file"] = path;
+                    reply["events"] = Trace::dump(file);
+                    file.close();
+                }
+            } else {
+                reply["events"] = Trace::dump(Serial);
+                Serial.println();
+            }
+            if (doc["clear"] | false) Trace::clear();
+            Trace::report(reply);
+            String output;
+            serializeJson(reply, output);
+            Serial.println(output);
+        }
+        name = "TRACEDUMP";
+        query = true;
+
+    } else if (strcmp(cmdType, "CRASHINFO") == 0 && crashReport) {
+        // {"command":"CRASHINFO","dump":true,"erase":true} - both optional; the dump lines
+        // come before the reply, erasing after a failed dump is skipped
+        if (!dryRun) {
+            JsonDocument reply;
+            bool ok = true;
+            if (doc["dump"] | false) {
+                ok = crashReport->streamDump(Serial);
+                reply["streamed"] = ok;
+            }
+            if ((doc["erase"] | false) && ok) reply["erased"] = crashReport->eraseDump();
+            crashReport->report(reply);
+            String output;
+            serializeJson(reply, output);
+            Serial.println(output);
+        }
+        name = "CRASHINFO";
+        query = true;
+
+    } else if (strcmp(cmdType, "TASKHEALTH") == 0) {
+        if (!dryRun) {
+            JsonDocument reply;
+            TaskHealth::report(reply);
+            String output;
+            serializeJson(reply, output);
+            Serial.println(output);
+        }
+        name = "TASKHEALTH";
+        query = true;
+
+    } else if (strcmp(cmdType, "BOOTREPORT") == 0) {
+        if (!dryRun && boot) {
+            JsonDocument report;
+            boot->report(report);
+            if (warmRestart) warmRestart->report(report);
+            String output;
+            serializeJson(report, output);
+            Serial.println(output);
+        }
+        name = "BOOTREPORT";
+        query = true;
+
+    } else if (recipes && findRecipeCommand(cmdType) != nullptr) {
+        // {"command":"RECIPELOAD","name":"PET-500"}, see lib/comandFormat.json
+        if (!dryRun) handleRecipeCommand(cmdType, doc);
+        name = findRecipeCommand(cmdType);
+
+    } else if (strcmp(cmdType, "LOADTEST") == 0) {
+        // {"command":"LOADTEST","count":5000,"corrupt":5,"seed":1,"mix":{"motorCase":4,"GETSTATUS":1}}
+        if (!dryRun) {
+            CommandLoadTest* loadTest = new CommandLoadTest(this);  // Histogram is too big for the command task stack
+            loadTest->run(doc);
+            delete loadTest;
+        }
+        name = "LOADTEST";
+        query = true;
 
     } else {
-        Serial.println("Unknown command received");
+        if (!dryRun) LOG_WARN(LOG_CMD_UNKNOWN);
     }
 
-    // Send acknowledgment if the command was recognized and processed
-    if (commandRecognized) {
-        Serial.println("Command understood and executed");
+    // Dry runs (LOADTEST) leave no trace in lastCommand or the log
+    if (!dryRun && name != nullptr) {
+        if (!query) lastCommand = name;
+        LOG_INFO(LOG_CMD_RECEIVED, LOG_STR(name));
+        LOG_INFO(LOG_CMD_EXECUTED);
+    }
+    return name != nullptr;
+}
+
+/**
+ * @brief Takes the control lock (blocks until the other side is done).
+ *
+ * The wait checks in with TaskHealth: a long command (dump, load test)
+ * keeps the lock for seconds, and if the holder hangs its own watchdog
+ * entry fires.
+ */
+void CommandReceiver::lockControl() {
+    while (xSemaphoreTake(controlMutex, pdMS_TO_TICKS(TASK_IDLE_WAKE_MS)) != pdTRUE) {
+        TaskHealth::feed();
+    }
+}
+
+void CommandReceiver::unlockControl() {
+    xSemaphoreGive(controlMutex);
+}
+
+/**
+ * @brief Parses and dispatches commands without touching motors or the UART.
+ *
+ * Used by the load test so it exercises the real receiveCommand path.
+ */
+void CommandReceiver::setDryRun(bool enabled) {
+    dryRun = enabled;
+}
+
+void CommandReceiver::setHMI(NextionHMI* hmi) {
+    this->hmi = hmi;
+}
+
+void CommandReceiver::setConfigManager(ConfigManager* config) {
+    this->config = config;
+}
+
+void CommandReceiver::setRecipes(RecipeManager* recipes) {
+    this->recipes = recipes;
+}
+
+void CommandReceiver::setBootSequence(BootSequence* boot) {
+    this->boot = boot;
+}
+
+void CommandReceiver::setWarmRestart(WarmRestart* warmRestart) {
+    this->warmRestart = warmRestart;
+}
+
+void CommandReceiver::setCrashReport(CrashReport* crashReport) {
+    this->crashReport = crashReport;
+}
+
+/**
+ * @brief Executes a RECIPE* command and prints a JSON reply.
+ *
+ * RECIPESAVE   {"recipe":{...},"slot":n}  store (missing values = current settings)
+ * RECIPELOAD   {"name":"..."} or {"slot":n}  switch to a recipe
+ * RECIPEDELETE {"name":"..."} or {"slot":n}
+ * RECIPELIST   all recipes as {"recipes":[...],"active":n}
+ * RECIPEIMPORT / RECIPEEXPORT {"file":"/recipes.json"}  SD card, same format as RECIPELIST
+ *
+ * Runs with the control lock held; RECIPELOAD releases it between ramp steps.
+ */
+void CommandReceiver::handleRecipeCommand(const char* cmdType, JsonDocument& doc) {
+    int8_t slot;
+    bool slotValid = RecipeManager::slotFromJson(doc["slot"], slot);
+    if (doc["name"].is<const char*>()) slot = config->findRecipe(doc["name"]);
+    const char* file = doc["file"] | RECIPE_SD_FILE;
+
+    JsonDocument reply;
+    reply["command"] = cmdType;
+    bool ok = false;
+
+    if (strcmp(cmdType, "RECIPESAVE") == 0) {
+        ok = slotValid && recipes->store(doc["recipe"], slot);
+    } else if (strcmp(cmdType, "RECIPELOAD") == 0) {
+        ok = slotValid && slot >= 0 && recipes->apply(slot);
+    } else if (strcmp(cmdType, "RECIPEDELETE") == 0) {
+        ok = slotValid && slot >= 0;
+        if (ok) config->deleteRecipe(slot);
+    } else if (strcmp(cmdType, "RECIPELIST") == 0) {
+        recipes->exportJson(reply);
+        ok = true;
+    } else if (strcmp(cmdType, "RECIPEIMPORT") == 0) {
+        int16_t stored = recipes->importFromSD(file);
+        reply["stored"] = stored;
+        ok = stored >= 0;
+    } else if (strcmp(cmdType, "RECIPEEXPORT") == 0) {
+        ok = recipes->exportToSD(file);
+    } else {
+        LOG_WARN(LOG_CMD_INVALID_PARAMS, LOG_STR("recipe"));
     }
+
+    reply["ok"] = ok;
+    String output;
+    serializeJson(reply, output);
+    Serial.println(output);
+}
+
+/**
+ * @brief Caps a step frequency at HMI_SPEED_MAX; 0 or less (stop) gives 0.
+ *
+ * Above 1000 Hz the step interval truncates to 0 ms and the step task
+ * would never block, starving the idle task of the step core. Slow
+ * speeds are left alone, their longer interval is harmless.
+ */
+float CommandReceiver::clampSpeed(float speed) {
+    if (!(speed > 0)) return 0;  // Also NaN
+    return min(speed, (float)HMI_SPEED_MAX);
 }
 
 // Set motor parameters based on received commands
 void CommandReceiver::setMotorParameters(int motor, float speed, int microsteps, int direction) {
     A4988Manager& selectedMotor = (motor == 1) ? _motor1 : _motor2;
+    speed = clampSpeed(speed);
 
     selectedMotor.Stop(); // Stop that motor
     selectedMotor.setStepResolution(microsteps);
@@ -136,43 +649,128 @@ void CommandReceiver::setSensorParameters(int motor,int stopTime, int stepsToTak
     A4988Manager& selectedMotor = (motor == 1) ? _motor1 : _motor2;
     selectedMotor.SetStopTime(stopTime);
     selectedMotor.SetStepsToTake(stepsToTake); // Ensure the method name matches the one in your Sensor class
+    EventLogger::record(EVENT_SENSOR_PARAMS, motor == 1 ? EVENT_SOURCE_CASE : EVENT_SOURCE_DISC, stopTime, stepsToTake);
 
 }
 
 // Send the current status of the system
 void CommandReceiver::sendSystemStatus() {
-    // Create a JSON document
-    JsonDocument doc;
-
-    // Populate system status
-    doc["status"] = "ok";
-
-    // Motor case parameters
-    JsonObject motorCase = doc["motorCase"].to<JsonObject>();
-    motorCase["speed"] = _motor1.getSpeed(); // Assuming you have a getter method in A4988Manager to get the speed
-    motorCase["microsteps"] = _motor1.getStepResolution(); // Assuming getter for microsteps
-    motorCase["direction"] = _motor1.getDir(); // Assuming getter for direction
-
-    // Motor disc parameters
-    JsonObject motorDisc = doc["motorDisc"].to<JsonObject>();
-    motorDisc["speed"] = _motor2.getSpeed(); // Same assumptions as above
-    motorDisc["microsteps"] = _motor2.getStepResolution();
-    motorDisc["direction"] = _motor2.getDir();
-
-    // Sensor parameters
-    JsonObject Sensor = doc["sensor"].to<JsonObject>();
-    Sensor["stop"] = _motor2.GetStopTime(); // Assuming GetStopTime is a method in Sensor class
-    Sensor["stepsToTake"] = _motor2.GetStepsToTake(); // Assuming GetStepsToTake is a method in Sensor class
-
-    // System status
-    JsonObject system = doc["system"].to<JsonObject>();
-    system["status"] = "active"; // Or whatever the current system status is
-    system["lastCommand"] = "STARTSYSTEM"; // The last command that was executed, could be dynamically updated
-
-    // Serialize the JSON to a string
-    String output;
-    serializeJson(doc, output);
+    StatusSnapshot snapshot;
+    captureStatus(snapshot);
+
+    // Patch the prebuilt template and hand it to the UART in one write
+    const uint8_t* line;
+    size_t len = statusEncoder.encodeJson(snapshot, &line);
+    Serial.write(line, len);
+}
 
-    // Send the JSON string over Serial
+/**
+ * @brief Starts or stops recording a replayable sensor trace.
+ *
+ * While capturing, every raw sensor transition (from the pin interrupt)
+ * and every step pulse of both axes go to the event log. The capture
+ * starts with the current setpoints and sensor parameters so the trace
+ * is self-contained for app/TraceReplay.cpp.
+ *
+ * @return False if capture was requested but the event log is not running.
+ */
+bool CommandReceiver::setCapture(bool enabled) {
+    if (sensor == nullptr) return false;
+    if (enabled == sensor->isCapturing()) return true;
+
+    if (enabled) {
+        if (!EventLogger::isActive()) return false;
+        StatusSnapshot snapshot;
+        captureStatus(snapshot);
+        EventLogger::record(EVENT_CAPTURE, EVENT_SOURCE_SYSTEM, 1);
+        EventLogger::record(EVENT_SETPOINT, EVENT_SOURCE_CASE, (int32_t)(snapshot.caseSpeed * 1000), snapshot.caseDir);
+        EventLogger::record(EVENT_SETPOINT, EVENT_SOURCE_DISC, (int32_t)(snapshot.discSpeed * 1000), snapshot.discDir);
+        EventLogger::record(EVENT_SENSOR_PARAMS, EVENT_SOURCE_DISC, snapshot.stopTime, snapshot.stepsToTake);
+        _motor1.setCapture(true);
+        _motor2.setCapture(true);
+        sensor->startCapture(&_motor2);
+        LOG_INFO(LOG_CAPTURE_STARTED, _motor2.getStepCount());
+    } else {
+        sensor->stopCapture();
+        _motor1.setCapture(false);
+        _motor2.setCapture(false);
+        EventLogger::record(EVENT_CAPTURE, EVENT_SOURCE_SYSTEM, 0);
+        LOG_INFO(LOG_CAPTURE_STOPPED, _motor2.getStepCount());
+    }
+    return true;
+}
+
+/**
+ * @brief Copies the current motor, sensor and system state into a snapshot.
+ *
+ * @param snapshot Destination snapshot.
+ */
+void CommandReceiver::captureStatus(StatusSnapshot& snapshot) {
+    snapshot.caseSpeed      = _motor1.getSpeed();
+    snapshot.caseMicrosteps = _motor1.getStepResolution();
+    snapshot.caseDir        = _motor1.getDir();
+    snapshot.discSpeed      = _motor2.getSpeed();
+    snapshot.discMicrosteps = _motor2.getStepResolution();
+    snapshot.discDir        = _motor2.getDir();
+    snapshot.stopTime       = _motor2.GetStopTime();
+    snapshot.stepsToTake    = _motor2.GetStepsToTake();
+    snapshot.running        = snapshot.caseSpeed > 0 || snapshot.discSpeed > 0;
+    snapshot.lastCommand    = lastCommand;
+}
+
+/**
+ * @brief Measures the CPU cycles needed to produce one status message.
+ *
+ * Times the template encoder for the host JSON line and, for reference, the JsonDocument + serializeJson path it
+ * replaced. Nothing is written to the UARTs during the measurement.
+ *
+ * @param iterations Number of messages encoded per variant.
+ */
+void CommandReceiver::runStatusBenchmark(uint32_t iterations) {
+    if (iterations == 0) iterations = 1;
+    StatusSnapshot snapshot;
+    captureStatus(snapshot);
+    const uint8_t* out;
+    size_t len = 0;
+
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < iterations; i++) {
+        snapshot.stopTime = i;  // Vary a field so nothing is hoisted
+        len += statusEncoder.encodeJson(snapshot, &out);
+    }
+    uint32_t jsonCycles = ESP.getCycleCount() - start;
+
+    start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < iterations; i++) {
+        JsonDocument doc;
+        doc["status"] = "ok";
+        JsonObject motorCase = doc["motorCase"].to<JsonObject>();
+        motorCase["speed"] = snapshot.caseSpeed;
+        motorCase["microsteps"] = snapshot.caseMicrosteps;
+        motorCase["direction"] = snapshot.caseDir;
+        JsonObject motorDisc = doc["motorDisc"].to<JsonObject>();
+        motorDisc["speed"] = snapshot.discSpeed;
+        motorDisc["microsteps"] = snapshot.discMicrosteps;
+        motorDisc["direction"] = snapshot.discDir;
+        JsonObject sensorObj = doc["sensor"].to<JsonObject>();
+        sensorObj["stop"] = i;
+        sensorObj["stepsToTake"] = snapshot.stepsToTake;
+        JsonObject system = doc["system"].to<JsonObject>();
+        system["status"] = snapshot.running ? "active" : "idle";
+        system["lastCommand"] = snapshot.lastCommand;
+        String output;
+        serializeJson(doc, output);
+        len += output.length();
+    }
+    uint32_t legacyCycles = ESP.getCycleCount() - start;
+
+    JsonDocument report;
+    report["bench"] = "status";
+    report["iterations"] = iterations;
+    report["jsonTemplateCycles"] = jsonCycles / iterations;
+    report["jsonDocumentCycles"] = legacyCycles / iterations;
+    report["bytes"] = len;
+    String output;
+    serializeJson(report, output);
     Serial.println(output);
-}
\ No newline at end of file
+}
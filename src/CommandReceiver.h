@@ -3,7 +3,20 @@
 
 #include "A4988Manager.h" // Make sure to include the header for A4988Manager
 #include <Arduino.h> // Include Arduino core for basic types and functions
+#include <ArduinoJson.h>
+#include <freertos/semphr.h>
 #include "Sensor.h"
+#include "StatusSnapshot.h"
+#include "TelemetryStreamer.h"
+#include "StatusEncoder.h"
+#include "CommandLoadTest.h"
+
+class NextionHMI;
+class ConfigManager;
+class RecipeManager;
+class BootSequence;
+class WarmRestart;
+class CrashReport;
 
 class CommandReceiver {
 public:
@@ -15,22 +28,75 @@ public:
 
     // Check and process commands
     void checkCommand();
+    void startTask();                        // Serve commands from the command task
+
+    // Move complete lines from the UART into free command slots
+    void pumpRx();
         // Function to handle received command
-    void receiveCommand(const String& command);
+    bool receiveCommand(const String& command);
+    bool receiveCommand(const char* command, size_t length);
+    void setDryRun(bool enabled);            // Parse/dispatch only, no side effects or log entries
+    void setHMI(NextionHMI* hmi);            // Display reported by HMISTATS
+    void setConfigManager(ConfigManager* config);  // Settings flushed by SAVE
+    void setRecipes(RecipeManager* recipes);       // Target of the RECIPE* commands
+    void setBootSequence(BootSequence* boot);      // Timing reported by BOOTREPORT
+    void setWarmRestart(WarmRestart* warmRestart); // Resume state reported by BOOTREPORT
+    void setCrashReport(CrashReport* crashReport); // Post-mortem served by CRASHINFO
+
+    // Serializes motor/sensor changes between the host link and the HMI
+    void lockControl();
+    void unlockControl();
+
+    // Credit-based flow control
+    void setFlowControl(bool enabled);
+    void advertiseCredits();                 // Send the full window to the host
+    uint16_t getFreeSlots();
+    uint32_t getOverflowedLines();
 
     // Set motor parameters based on received commands
-    void setMotorParameters(int motor, float speed, int microsteps, int direction );
+    void setMotorParameters(int motor, float speed, int microsteps, int direction );  // speed clamped
+    static float clampSpeed(float speed);    // At most HMI_SPEED_MAX, 0 stays 0 (stop)
     void setSensorParameters(int motor,int stopTime, int stepsToTake);
     void sendSystemStatus();
+    void captureStatus(StatusSnapshot& snapshot);  // Copy the current state for status/telemetry
+    void runStatusBenchmark(uint32_t iterations);   // Report CPU cycles per status message
+    bool setCapture(bool enabled);           // Sensor trace capture to the event log (CAPTURE)
 
 private:
-    // Static command buffer and received command flag
-    String commandBuffer;        // Regular String for the command buffer
-    bool commandReceived;        // Flag for received command
+    // One complete command line waiting to be processed
+    struct CommandSlot {
+        uint16_t length;
+        char text[COMMAND_LINE_SIZE];
+    };
+
+    void grantCredits();                     // Return freed slots to the host
+    static void commandTask(void *pvParameters);
+
+    // Line assembly and command slots
+    CommandSlot rxSlot;                      // Line being assembled
+    bool rxDiscarding;                       // Current line exceeded COMMAND_LINE_SIZE
+    QueueHandle_t commandQueue;              // Holds up to COMMAND_QUEUE_DEPTH slots
+    CommandSlot workSlot;                    // Slot being processed
+    bool flowControl;                        // Credits are reported to the host
+    uint16_t pendingCredits;                 // Slots freed since the last grant
+    uint32_t overflowedLines;                // Lines dropped (too long or no free slot)
+    bool dryRun;                             // Set while the load test drives receiveCommand
+    SemaphoreHandle_t controlMutex;          // Guards motor/sensor reconfiguration
+    TaskHandle_t commandTaskHandle;
     Sensor* sensor;
     // Motors managed by this receiver
     A4988Manager& _motor1;      // Declare _motor1 first
     A4988Manager& _motor2;      // Declare _motor2 second
+    const char* lastCommand;    // Last command executed, reported in status
+    TelemetryStreamer telemetry; // Push-based status stream (SUBSCRIBE)
+    StatusEncoder statusEncoder; // Preformatted GETSTATUS template
+    NextionHMI* hmi;             // Display reported by HMISTATS (may be null)
+    ConfigManager* config;       // Settings store for SAVE/CONFIGSTATS (may be null)
+    RecipeManager* recipes;      // Named recipes (may be null)
+    BootSequence* boot;          // Start-up timing for BOOTREPORT (may be null)
+    WarmRestart* warmRestart;    // Warm restart state for BOOTREPORT (may be null)
+    CrashReport* crashReport;    // Core dump summary for CRASHINFO (may be null)
+    void handleRecipeCommand(const char* cmdType, JsonDocument& doc);
 
 };
 
@@ -5,30 +5,15 @@
 // DEVICE Config Flags Name (Keys for ESP32 Preferences)
 // ==================================================
 
-// Motor Control keys
-#define DELAY_MS_KEY        "DLMSV"
-#define OFFSET_STEPS_KEY    "OFSTP"
-#define CASE_RPM_KEY        "CASRP"
-#define DISC_RPM_KEY        "DISRP"
-#define CASE_DIR_KEY        "CASDR"
-#define DISC_DIR_KEY        "DISDR"
+// Motor settings, their defaults and ranges are declared in ConfigSchema.h
 #define RESET_FLAG "RSTFL"
-
-
-// Default values
-#define DELAY_MS_DEFAULT      DEFAULT_DELAY
-#define OFFSET_STEPS_DEFAULT  DEFAULT_STEPS_TO_TAKE
-#define CASE_RPM_DEFAULT      DEFAULT_CASE_SPEED
-#define DISC_RPM_DEFAULT      DEFAULT_DISK_SPEED
-#define CASE_DIR_DEFAULT      DEFAULT_CASE_DIR
-#define DISC_DIR_DEFAULT      DEFAULT_DISK_DIR
+#define CONFIG_BLOB_KEY     "CFGBL"   // Packed settings image (ConfigBlob)
 
 
 #define DEFAULT_CASE_SPEED 250
 #define DEFAULT_CASE_DIR false
 #define DEFAULT_DISK_SPEED 750
 #define DEFAULT_DISK_DIR false
-#define DEFAULT_DELAY 2000
 #define DEFAULT_OFFSET 2000
 #define NEXTION_BAUDRATE 9600
 #define CASE_MICROSTEP 4
@@ -40,6 +25,32 @@
 #define ENABLE_SERIAL_DEBUG
 #define DEBUGMODE true
 #define CONFIG_PARTITION "config"
+#define CONFIG_CACHE_SIZE           16     // Keys held in the ConfigManager RAM cache
+#define CONFIG_KEY_SIZE             16     // NVS key length limit (15 chars + NUL)
+#define CONFIG_COMMIT_QUIET_MS      2000   // Commit once settings stopped changing this long
+#define CONFIG_COMMIT_MAX_DELAY_MS  30000  // Commit at the latest this long after a change
+#define CONFIG_COMMIT_TASK_STACK    3072
+#define CONFIG_COMMIT_TASK_PRIORITY 1
+#define CONFIG_COMMIT_TASK_CORE     CONTROL_CORE
+#define CONFIG_BLOB_MAX_SETTINGS    32     // Capacity of the settings blob (schema may grow to this)
+
+// NVS wear accounting (ConfigManager NVSDIAG)
+#define CONFIG_NVS_PARTITION        "nvs"  // Preferences::begin() without a label opens the default partition
+#define CONFIG_WEAR_KEYS            24     // Keys with their own write counter
+#define NVS_ENTRY_SIZE              32     // Bytes per NVS entry
+#define NVS_ENTRIES_PER_PAGE        126    // Entries in one 4 kB NVS page
+#define NVS_FLASH_ENDURANCE         100000 // Rated erase cycles of a flash sector
+#define CONFIG_WEAR_PERSIST_MS      3600000 // Lifetime entry counter saved at least this often (1 h)
+
+// ==================================================
+// Recipes (RecipeManager)
+// ==================================================
+#define RECIPE_MAX_COUNT     8          // Recipe slots in NVS
+#define RECIPE_NAME_SIZE     16         // Name length + NUL
+#define RECIPE_KEY_PREFIX    "RCP"      // NVS keys RCP0 .. RCP7
+#define RECIPE_RAMP_MS       1000       // Speed ramp when switching recipes on running axes
+#define RECIPE_RAMP_STEPS    20         // Frequency updates during one ramp
+#define RECIPE_SD_FILE       "/recipes.json"  // Default import/export file
 // =========================================================================
 // Pin Definitions for Case Configuration
 // =========================================================================
@@ -81,7 +92,8 @@
 #define SLP_PIN_DISC        9      // Sleep Pin for Stepper Motor (Disc)
 #define RESET_PIN_DISC      47     // Reset Pin for Stepper Motor (Disc)
 #define DEFAULT_FREQ  50
-#define STEP_CORE 0
+#define STEP_CORE 0                // Core of the motor step tasks only, see "Task Model"
+#define MOTOR_TASK_STACK 2048      // Stack size of each motor step task, see "stackFree" in GETMETRICS
 
 #define FULL_STEPS_PER_REV 200     // Constants for steps per revolution for NEMA 17 stepper motor
 // =========================================================================
@@ -95,6 +107,88 @@
 // =========================================================================
 #define SCREEN_RXD_PIN      4      // RX Pin for Display Communication
 #define SCREEN_TXD_PIN      5      // TX Pin for Display Communication
+#define NEXTION_FRAME_SIZE     64     // Max bytes of one display frame
+#define NEXTION_STRING_SIZE    32     // Max chars kept from a 0x70 string return
+#define NEXTION_IDLE_FLUSH_MS  5      // Idle gap that ends an unterminated key burst
+#define NEXTION_TASK_STACK     4096   // Stack size of the display RX task
+#define NEXTION_TASK_PRIORITY  2      // Input tier, same as the command task
+#define NEXTION_TASK_CORE      CONTROL_CORE
+#define NEXTION_MAX_COMPONENTS 8      // Numeric components tracked by NextionDisplay
+#define NEXTION_NAME_SIZE      8      // Max component name length (incl. NUL)
+#define NEXTION_TX_BUFFER_SIZE 128    // Coalesced nX.val= burst buffer
+#define NEXTION_MIN_REFRESH_MS 100    // Min time between writes to one component
+#define NEXTION_PAGE_LOAD_MS   200    // Fields are not written this long after a page reload
+#define NEXTION_TX_QUEUE_DEPTH 8      // Raw commands waiting for the writer task
+#define NEXTION_COMMAND_SIZE   48     // Max raw command length (incl. NUL)
+#define NEXTION_UART_TX_BUFFER 256    // UART driver TX ring, lets writes return early
+#define NEXTION_WRITER_TASK_STACK    3072  // Stack size of the display TX task
+#define NEXTION_WRITER_TASK_PRIORITY 1     // Below the RX task, display output can wait
+#define NEXTION_WRITER_TASK_CORE     CONTROL_CORE
+#define NEXTION_REPEAT_DELAY_MS     400   // Hold time before auto-repeat starts
+#define NEXTION_REPEAT_PERIOD_MS    100   // Auto-repeat step period
+#define NEXTION_REPEAT_ACCEL_MS     1000  // Hold time per step size increase
+#define NEXTION_REPEAT_ACCEL_FACTOR 2     // Step size growth per NEXTION_REPEAT_ACCEL_MS
+#define NEXTION_REPEAT_MAX_MULTIPLIER 8   // Largest step, in base steps
+#define NEXTION_HOLD_TIMEOUT_MS     15000 // Treat a longer hold as a lost release
+#define NEXTION_HOLD_TASK_STACK     3072  // Stack size of the auto-repeat task
+#define NEXTION_HOLD_TASK_PRIORITY  1     // Below the input tasks
+#define NEXTION_BG_QUEUE_DEPTH 16     // Background (graph) commands waiting for the writer
+#define NEXTION_BG_BURST_SIZE  64     // Max background bytes per burst
+#define NEXTION_BG_MIN_TX_FREE 100    // TX FIFO space required before background data goes out
+#define NEXTION_BG_RETRY_MS    10     // Recheck interval while the FIFO is busy
+#define NEXTION_TARGET_BAUDRATE 115200 // Rate negotiated with bauds= at startup
+#define NEXTION_PING_TIMEOUT_MS 150   // Wait for the sendme reply
+#define NEXTION_BAUD_SETTLE_MS  100   // Time the display needs to apply a new rate
+
+// Component ids of the main page buttons. These must report both press and
+// release events ("Send Component ID") in the HMI project.
+#define NEXTION_MAIN_PAGE      0
+#define NEXTION_ID_CASE_UP     1
+#define NEXTION_ID_CASE_DOWN   2
+#define NEXTION_ID_CASE_DIR    3
+#define NEXTION_ID_DISC_UP     4
+#define NEXTION_ID_DISC_DOWN   5
+#define NEXTION_ID_DISC_DIR    6
+#define NEXTION_ID_DELAY_UP    7
+#define NEXTION_ID_DELAY_DOWN  8
+#define NEXTION_ID_OFFSET_UP   9
+#define NEXTION_ID_OFFSET_DOWN 10
+#define NEXTION_ID_START       11
+#define NEXTION_ID_STOP        12
+#define NEXTION_TREND_WAVEFORM_ID 13  // Waveform component (4 channels, 255 px high)
+
+// Recipe selector page
+#define NEXTION_RECIPE_PAGE      1
+#define NEXTION_ID_RECIPE_PREV   1
+#define NEXTION_ID_RECIPE_NEXT   2
+#define NEXTION_ID_RECIPE_LOAD   3
+#define NEXTION_RECIPE_NAME_FIELD "tRcp"   // Text: selected recipe name
+#define NEXTION_RECIPE_SLOT_FIELD "nRcp"   // Number: selected slot
+
+// Trend graph
+#define NEXTION_TREND_DEFAULT_ENABLED     true
+#define NEXTION_TREND_SAMPLE_MS           50     // Counter sampling period
+#define NEXTION_TREND_DECIMATION          4      // Samples folded into one graph point
+#define NEXTION_TREND_RING_SIZE           16     // Points waiting for bandwidth
+#define NEXTION_TREND_BYTES_PER_SEC       400    // Graph bandwidth budget
+#define NEXTION_TREND_MAX_BURST           128    // Budget cap in bytes
+#define NEXTION_TREND_HEIGHT              255    // Waveform value range
+#define NEXTION_TREND_RATE_FULL_SCALE     500    // steps/s at the top of the graph
+#define NEXTION_TREND_DWELL_FULL_SCALE    10000  // ms
+#define NEXTION_TREND_INTERVAL_FULL_SCALE 20000  // ms
+#define NEXTION_TREND_TASK_STACK          3072
+#define NEXTION_TREND_TASK_PRIORITY       0      // Lowest, graph data can always wait
+#define NEXTION_TREND_TASK_CORE           CONTROL_CORE
+
+// HMI value steps and limits
+#define HMI_CASE_STEP    13
+#define HMI_DISC_STEP    26
+#define HMI_DELAY_STEP   100
+#define HMI_OFFSET_STEP  5
+#define HMI_SPEED_MIN    100
+#define HMI_SPEED_MAX    1000
+#define HMI_DELAY_MAX    60000
+#define HMI_OFFSET_MAX   60000
 
 // =========================================================================
 // SD Card Pin Definitions
@@ -110,4 +204,148 @@
 #define FLAG_LED_PIN        16     // Pin for Status LED
 #define BAUDE_RATE          115200 // Baud Rate for Serial Communication
 
+// =========================================================================
+// Command Link Flow Control
+// =========================================================================
+#define COMMAND_LINE_SIZE            256   // Max bytes of one JSON command line
+#define COMMAND_QUEUE_DEPTH          8     // Command slots = credit window
+#define COMMAND_RX_BUFFER_SIZE       (COMMAND_LINE_SIZE * (COMMAND_QUEUE_DEPTH + 1)) // Window + one line in assembly
+#define COMMAND_TX_BUFFER_SIZE       (2 * TELEMETRY_FRAME_SIZE) // TX ring: a keyframe never fits the 128 B FIFO alone
+#define COMMAND_FLOW_CONTROL_DEFAULT true  // Report credits from boot
+//#define COMMAND_HW_FLOW_CONTROL          // Uncomment to enable UART RTS/CTS
+#define COMMAND_RTS_PIN              -1    // RTS output pin when HW flow control is on
+#define COMMAND_CTS_PIN              -1    // CTS input pin when HW flow control is on
+#define COMMAND_RTS_THRESHOLD        100   // RX FIFO level that deasserts RTS
+
+// =========================================================================
+// Telemetry Streaming (SUBSCRIBE command)
+// =========================================================================
+#define TELEMETRY_MAX_RATE_HZ        100   // Upper bound for the push rate
+#define TELEMETRY_DEFAULT_RATE_HZ    10    // Rate used when SUBSCRIBE has no "rate"
+#define TELEMETRY_KEYFRAME_INTERVAL  50    // Frames between full keyframes
+#define TELEMETRY_FRAME_SIZE         320   // Max bytes of one encoded frame
+#define TELEMETRY_TASK_STACK         4096  // Stack size of the telemetry task
+#define TELEMETRY_TASK_PRIORITY      1     // Output tier
+#define TELEMETRY_TASK_CORE          CONTROL_CORE
+
+// =========================================================================
+// Status Encoder
+// =========================================================================
+#define STATUS_JSON_TEMPLATE_SIZE        256   // GETSTATUS template buffer
+#define STATUS_BENCH_DEFAULT_ITERATIONS  1000  // STATUSBENCH default loop count
+
+// =========================================================================
+// Command Load Test (LOADTEST command)
+// =========================================================================
+#define LOADTEST_DEFAULT_COUNT       1000  // Commands per run when "count" is absent
+#define LOADTEST_MAX_WEIGHT          10000 // Upper bound of one "mix" weight
+
+// =========================================================================
+// Deferred Logging
+// =========================================================================
+#define DEFERRED_LOG_LEVEL           LOG_LEVEL_INFO // Levels above this compile out
+#define DEFERRED_LOG_RING_SIZE       128   // Records per core (power of two)
+#define DEFERRED_LOG_LINE_SIZE       128   // Max formatted line length
+#define DEFERRED_LOG_DRAIN_PERIOD_MS 20    // Drain task wake-up period
+#define DEFERRED_LOG_TASK_STACK      3072  // Stack size of the drain task
+#define DEFERRED_LOG_TASK_PRIORITY   0     // Idle-level priority
+#define DEFERRED_LOG_TASK_CORE       CONTROL_CORE
+
+// =========================================================================
+// Boot Sequence (BOOTREPORT command)
+// =========================================================================
+#define BOOT_MAX_STAGES              8     // Stages one BootSequence can hold
+#define BOOT_TASK_STACK              6144  // Stack size of each stage task
+#define BOOT_TASK_PRIORITY           1     // Same as the Arduino loop task
+#define BOOT_TASK_CORE               CONTROL_CORE // Also for the motors stage, the step tasks pin themselves to STEP_CORE
+#define BOOT_SD_TIMEOUT_MS           1500  // Boot continues without the card after this
+#define BOOT_HMI_TIMEOUT_MS          3000  // Boot continues without the display after this
+
+// =========================================================================
+// Warm Restart (motion state kept in RTC memory)
+// =========================================================================
+#define WARM_SYNC_PERIOD_MS          50    // Motion state mirrored to RTC memory this often
+#define WARM_RAMP_MS                 500   // Ramp from HMI_SPEED_MIN back to the setpoints
+#define WARM_RAMP_STEPS              10    // Frequency updates during the ramp
+#define WARM_MAX_RESUMES             3     // Resumes in a row before staying stopped
+#define WARM_STABLE_MS               60000 // Uptime after which the resume count is cleared
+#define WARM_TASK_STACK              3072  // Stack size of the sync task
+#define WARM_TASK_PRIORITY           1     // Output tier
+#define WARM_TASK_CORE               CONTROL_CORE
+
+// =========================================================================
+// Event Logger (binary SD log, EVENTSTATS command)
+// =========================================================================
+#define EVENT_LOG_MOUNT              "/sd" // VFS mount point of the SD card
+#define EVENT_LOG_DIR                "/log"
+#define EVENT_LOG_FILE_SIZE          (64UL * 1024 * 1024) // Each file, allocated contiguously when created
+#define EVENT_LOG_MAX_FILES          64    // Then the oldest file is reused
+#define EVENT_LOG_SPARE_FILE         EVENT_LOG_DIR "/spare.bin" // Next file, allocated ahead of the rotation
+#define EVENT_LOG_ROTATE_MS          3600000 // Start a new file at least hourly
+#define EVENT_LOG_HEADER_SIZE        1024  // File header and schema text, start of the first block
+#define EVENT_LOG_SECTOR_SIZE        512   // SD sector
+#define EVENT_LOG_BUFFER_SIZE        8192  // Bytes per buffer (two) and per file block
+#define EVENT_LOG_RING_SIZE          1024  // Records per core (power of two)
+#define EVENT_LOG_DRAIN_PERIOD_MS    10    // Drain task wake-up period
+#define EVENT_LOG_FLUSH_MS           1000  // A partial block is written at least this often
+#define EVENT_LOG_TASK_STACK         4096  // Stack size of the drain and writer tasks
+#define EVENT_LOG_TASK_PRIORITY      1     // Output tier
+#define EVENT_LOG_TASK_CORE          CONTROL_CORE
+
+// =========================================================================
+// Runtime Metrics (GETMETRICS command)
+// =========================================================================
+#define METRICS_HISTOGRAM_SUB_BITS    3     // 8 sub-buckets per power of two (12.5% resolution)
+#define METRICS_HISTOGRAM_SUB_BUCKETS (1 << METRICS_HISTOGRAM_SUB_BITS)
+#define METRICS_HISTOGRAM_BUCKETS     ((33 - METRICS_HISTOGRAM_SUB_BITS) * METRICS_HISTOGRAM_SUB_BUCKETS)
+#define METRICS_MAX_TASKS             32    // Tasks tracked for the CPU share between reports
+
+// =========================================================================
+// Step Jitter (JITTER command)
+// =========================================================================
+#define STEP_JITTER_DEFAULT_ENABLED   false // Sampling starts with JITTER {"enable":true}
+
+// =========================================================================
+// Trace (TRACEDUMP command, Chrome trace-event JSON)
+// =========================================================================
+#define TRACE_ENABLED                 1     // 0 removes every TRACE_* call site
+#define TRACE_DEFAULT_ENABLED         true  // Recording at boot, TRACEDUMP {"enable":false} stops it
+#define TRACE_RING_SIZE               256   // Events kept per core (32 bytes each)
+#define TRACE_MAX_TASKS               32    // Tasks named in one dump
+#define TRACE_ENDED_TID               1000  // Thread ids of tasks that ended before the dump
+#define TRACE_LINE_SIZE               192   // Longest JSON entry of the dump
+
+// =========================================================================
+// Crash Report (CRASHINFO command)
+// =========================================================================
+#define CRASH_NVS_NAMESPACE           "crash" // Summary of the newest crash
+#define CRASH_NVS_KEY                 "last"
+#define CRASH_LOG_FILE                "/crash.log" // One JSON summary per crash on the SD card
+#define CRASH_BACKTRACE_DEPTH         16    // Frames kept in the summary
+#define CRASH_ELF_SHA_CHARS           16    // Hex digits of the firmware ELF hash kept
+#define CRASH_DUMP_CHUNK              768   // Dump bytes per streamed line (multiple of 3)
+
+// =========================================================================
+// Task Model (TASKHEALTH command)
+// =========================================================================
+// STEP_CORE runs only the motor step tasks, at STEP_TASK_PRIORITY (WiFi and
+// BT are never started). Every other *_TASK_CORE is CONTROL_CORE, and every
+// other *_TASK_PRIORITY is one of these tiers:
+//   input   priority 2  command task, display RX; woken by their UART
+//   output  priority 1  display TX and hold, telemetry, event log, NVS commits, RTC mirror,
+//                       boot stages (once, at boot)
+//   idle    priority 0  trend graph, deferred log text
+// Checked on the host by app/TaskModelCheck.cpp.
+#define CONTROL_CORE                  (1 - STEP_CORE)
+#define STEP_TASK_PRIORITY            20    // Above every application task, below esp_timer (22)
+#define COMMAND_TASK_STACK            8192  // Runs receiveCommand(), as large as the Arduino loop stack
+#define COMMAND_TASK_PRIORITY         2     // Input tier
+#define COMMAND_TASK_CORE             CONTROL_CORE
+#define TASK_WDT_TIMEOUT_S            5     // Task watchdog timeout
+#define TASK_WDT_PANIC                true  // Panic (core dump for CRASHINFO) instead of a warning
+#define TASK_IDLE_WAKE_MS             1000  // Longest block of a supervised task
+#define TASK_FEED_MS                  250   // Min time between watchdog resets of one task
+#define TASK_HEALTH_LATE_MS           2000  // Check-in gap reported as late
+#define TASK_HEALTH_MAX_TASKS         16    // Supervised tasks
+
 #endif
@@ -1,5 +1,8 @@
 
 #include "ConfigManager.h"
+#include <esp_rom_crc.h>
+#include "Trace.h"
+#include "TaskHealth.h"
 
 
 /************************************************************************************************/
@@ -13,7 +16,15 @@
  * 
  * @param prefs Reference to the Preferences object.
  */
-ConfigManager::ConfigManager(Preferences* preferences) : preferences(preferences),namespaceName(CONFIG_PARTITION) {}
+ConfigManager::ConfigManager(Preferences* preferences)
+    : preferences(preferences), namespaceName(CONFIG_PARTITION), cacheCount(0), commitTaskHandle(nullptr),
+      lastChangeMs(0), firstDirtyMs(0), nvsWrites(0), commitCount(0), settingsDirty(0), rejectedWrites(0),
+      loadedVersion(0), wearCount(0), entriesWritten(0), requestedBytes(0), lifetimeEntries(0),
+      unsavedEntries(0), wearSavedMs(0) {
+    for (uint8_t id = 0; id < SETTING_COUNT; id++) settings[id] = CONFIG_SCHEMA[id].defaultValue;
+    cacheMutex = xSemaphoreCreateMutex();
+    commitMutex = xSemaphoreCreateMutex();
+}
 
 /**
  * @brief Destructor for the ConfigManager class.
@@ -37,6 +48,7 @@ ConfigManager::~ConfigManager() {
  */
 void ConfigManager::RestartSysDelayDown(unsigned long delayTime) {
     unsigned long startTime = millis();  // Record the start time
+    commit();  // Pending settings must survive the restart
 
     #ifdef ENABLE_SERIAL_DEBUG 
         Serial.println("################################");
@@ -77,6 +89,7 @@ void ConfigManager::RestartSysDelayDown(unsigned long delayTime) {
  */
 void ConfigManager::RestartSysDelay(unsigned long delayTime) {
     unsigned long startTime = millis();  // Record the start time
+    commit();  // Pending settings must survive the restart
 
     #ifdef ENABLE_SERIAL_DEBUG
         Serial.println("################################");
@@ -148,6 +161,7 @@ void ConfigManager::CountdownDelay(unsigned long delayTime) {
  * It is used to simulate the power-down state of the device.
  */
 void ConfigManager::simulatePowerDown() {
+    commit();  // Pending settings must survive the power-down
     // Put the ESP32 into deep sleep for 1 second (simulate power-down)
     esp_sleep_enable_timer_wakeup(1000000); // 1 second (in microseconds)
     esp_deep_sleep_start();  // Enter deep sleep
@@ -197,6 +211,13 @@ void ConfigManager::begin() {
         Serial.println("###########################################################");
     #endif 
 
+    if (commitTaskHandle == nullptr) {
+        xTaskCreatePinnedToCore(commitTask, "Config Commit Task", CONFIG_COMMIT_TASK_STACK, this,
+                                CONFIG_COMMIT_TASK_PRIORITY, &commitTaskHandle, CONFIG_COMMIT_TASK_CORE);
+    }
+
+    loadSettings();  // One blob read, migrating older layouts if needed
+
     bool resetFlag = GetBool(RESET_FLAG, true);  // Default to true if not set
 
     if (resetFlag) {
@@ -263,87 +284,89 @@ void ConfigManager::initializeDefaults() {
  */
 void ConfigManager::initializeVariables() {
     // Assign default values to configuration variables
-
-    PutInt(DELAY_MS_KEY, DEFAULT_STOP_TIME);           // Default delay in ms
-    PutInt(OFFSET_STEPS_KEY, OFFSET_STEPS_DEFAULT);   // Default offset in steps
-    PutInt(CASE_RPM_KEY, CASE_RPM_DEFAULT);           // Default case RPM
-    PutInt(DISC_RPM_KEY, DISC_RPM_DEFAULT);           // Default disc RPM
-    PutBool(CASE_DIR_KEY, CASE_DIR_DEFAULT);          // Default case direction
-    PutBool(DISC_DIR_KEY, DISC_DIR_DEFAULT);          // Default disc direction
+    for (uint8_t id = 0; id < SETTING_COUNT; id++) {
+        setSetting((SettingId)id, CONFIG_SCHEMA[id].defaultValue);  // Defaults from ConfigSchema.h
+    }
     PutBool(RESET_FLAG, false);  // Reset flag is set to false after initialization
 
 }
 
 
 /**
- * @brief Gets a boolean value from preferences.
+ * @brief Gets a boolean value.
  * 
- * This function retrieves a boolean value associated with the given key 
- * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
- * unexpected resets.
+ * Served from the RAM cache when the key was read or written before;
+ * otherwise read once from preferences and cached. If the key does not
+ * exist, the default value is returned.
  * 
  * @param key The key associated with the boolean value.
  * @param defaultValue The default value to return if the key does not exist.
  * @return bool The retrieved boolean value or the default value.
  */
 bool ConfigManager::GetBool(const char* key, bool defaultValue) {
+    CacheValue value;
+    if (cacheGet(key, TYPE_BOOL, value)) return value.b;
     esp_task_wdt_reset();
-    bool value = preferences->getBool(key, defaultValue);
-    return value;
+    if (!preferences->isKey(key)) return defaultValue;
+    value.b = preferences->getBool(key, defaultValue);
+    cacheFill(key, TYPE_BOOL, value);
+    return value.b;
 }
 
 /**
- * @brief Gets an integer value from preferences.
+ * @brief Gets an integer value.
  * 
- * This function retrieves an integer value associated with the given key 
- * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
- * unexpected resets.
+ * Served from the RAM cache when possible, see GetBool().
  * 
  * @param key The key associated with the integer value.
  * @param defaultValue The default value to return if the key does not exist.
  * @return int The retrieved integer value or the default value.
  */
 int ConfigManager::GetInt(const char* key, int defaultValue) {
+    CacheValue value;
+    if (cacheGet(key, TYPE_INT, value)) return value.i;
     esp_task_wdt_reset();
-    int value = preferences->getInt(key, defaultValue);
-    return value;
+    if (!preferences->isKey(key)) return defaultValue;
+    value.i = preferences->getInt(key, defaultValue);
+    cacheFill(key, TYPE_INT, value);
+    return value.i;
 }
 /**
- * @brief Gets an integer value from preferences.
+ * @brief Gets an unsigned 64-bit value.
  * 
- * This function retrieves an integer value associated with the given key 
- * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
- * unexpected resets.
+ * Served from the RAM cache when possible, see GetBool().
  * 
- * @param key The key associated with the integer value.
+ * @param key The key associated with the value.
  * @param defaultValue The default value to return if the key does not exist.
- * @return int The retrieved integer value or the default value.
+ * @return uint64_t The retrieved value or the default value.
  */
 uint64_t ConfigManager::GetULong64(const char* key, int defaultValue) {
+    CacheValue value;
+    if (cacheGet(key, TYPE_ULONG64, value)) return value.u64;
     esp_task_wdt_reset();
-    uint64_t value = preferences->getULong64(key, defaultValue);
-    return value;
+    if (!preferences->isKey(key)) return defaultValue;
+    value.u64 = preferences->getULong64(key, defaultValue);
+    cacheFill(key, TYPE_ULONG64, value);
+    return value.u64;
 }
 
 /**
- * @brief Gets a float value from preferences.
+ * @brief Gets a float value.
  * 
- * This function retrieves a float value associated with the given key 
- * from the preferences. If the key does not exist, it returns the specified 
- * default value. The function also resets the watchdog timer to prevent 
- * unexpected resets.
+ * Served from the RAM cache when possible, see GetBool().
  * 
  * @param key The key associated with the float value.
  * @param defaultValue The default value to return if the key does not exist.
  * @return float The retrieved float value or the default value.
  */
 float ConfigManager::GetFloat(const char* key, float defaultValue) {
+    CacheValue value;
+    if (cacheGet(key, TYPE_FLOAT, value)) return value.f;
     esp_task_wdt_reset();
-    float value = preferences->getFloat(key, defaultValue);
-    return value;
+    if (!preferences->isKey(key)) return defaultValue;
+    value.f = preferences->getFloat(key, defaultValue);
+    cacheFill(key, TYPE_FLOAT, value);
+    return value.f;
 }
 
 /**
@@ -365,83 +388,66 @@ String ConfigManager::GetString(const char* key, const String& defaultValue) {
 }
 
 /**
- * @brief Puts a boolean value into preferences.
+ * @brief Puts a boolean value.
  * 
- * This function stores a boolean value associated with the given key 
- * in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * Only the RAM cache is updated; the value reaches NVS with the next
+ * commit. Writing the value already stored is a no-op.
  * 
  * @param key The key to associate with the boolean value.
  * @param value The boolean value to store.
  */
 void ConfigManager::PutBool(const char* key, bool value) {
-    esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putBool(key, value);  // Store the new value
+    CacheValue v;
+    v.b = value;
+    cachePut(key, TYPE_BOOL, v);
 }
 
 /**
- * @brief Puts an unsigned integer value into preferences.
- * 
- * This function stores an unsigned integer value associated with the given 
- * key in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * @brief Puts an unsigned integer value (write-behind, see PutBool()).
  * 
  * @param key The key to associate with the unsigned integer value.
  * @param value The unsigned integer value to store.
  */
 void ConfigManager::PutUInt(const char* key, int value) {
-    esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putUInt(key, value);  // Store the new value
+    CacheValue v;
+    v.u = value;
+    cachePut(key, TYPE_UINT, v);
 }
 
 /**
- * @brief Puts an unsigned integer value into preferences.
+ * @brief Puts an unsigned 64-bit value (write-behind, see PutBool()).
  * 
- * This function stores an unsigned integer value associated with the given 
- * key in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
- * 
- * @param key The key to associate with the unsigned integer value.
- * @param value The unsigned integer value to store.
+ * @param key The key to associate with the value.
+ * @param value The value to store.
  */
 void ConfigManager::PutULong64(const char* key, int value) {
-    esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putULong64(key, value);  // Store the new value
+    CacheValue v;
+    v.u64 = value;
+    cachePut(key, TYPE_ULONG64, v);
 }
 
 /**
- * @brief Puts an integer value into preferences.
- * 
- * This function stores an integer value associated with the given key 
- * in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * @brief Puts an integer value (write-behind, see PutBool()).
  * 
  * @param key The key to associate with the integer value.
  * @param value The integer value to store.
  */
 void ConfigManager::PutInt(const char* key, int value) {
-    esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putInt(key, value);  // Store the new value
+    CacheValue v;
+    v.i = value;
+    cachePut(key, TYPE_INT, v);
 }
 
 /**
- * @brief Puts a float value into preferences.
- * 
- * This function stores a float value associated with the given key 
- * in the preferences. It also resets the watchdog timer to prevent 
- * unexpected resets.
+ * @brief Puts a float value (write-behind, see PutBool()).
  * 
  * @param key The key to associate with the float value.
  * @param value The float value to store.
  */
 void ConfigManager::PutFloat(const char* key, float value) {
-    esp_task_wdt_reset();
-    RemoveKey(key);
-    preferences->putFloat(key, value);  // Store the new value
+    CacheValue v;
+    v.f = value;
+    cachePut(key, TYPE_FLOAT, v);
 }
 
 /**
@@ -458,6 +464,11 @@ void ConfigManager::PutString(const char* key, const String& value) {
     esp_task_wdt_reset();
     RemoveKey(key);
     preferences->putString(key, value);  // Store the new value
+    nvsWrites++;
+    recordWrite(key, 1 + entriesForBytes(value.length() + 1));
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    requestedBytes += value.length() + 1;
+    xSemaphoreGive(cacheMutex);
 }
 
 /**
@@ -467,6 +478,9 @@ void ConfigManager::PutString(const char* key, const String& value) {
  * storage.
  */
 void ConfigManager::ClearKey() {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    cacheCount = 0;
+    xSemaphoreGive(cacheMutex);
     preferences->clear();
 }
 
@@ -482,6 +496,12 @@ void ConfigManager::ClearKey() {
 void ConfigManager::RemoveKey(const char * key) {
     esp_task_wdt_reset();  // Reset the watchdog timer
 
+    // Drop the cached copy, including a pending write
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    CacheEntry* entry = findEntry(key);
+    if (entry) *entry = cache[--cacheCount];
+    xSemaphoreGive(cacheMutex);
+
     // Check if the key exists before removing it
     if (preferences->isKey(key)) {
         preferences->remove(key);  // Remove the key if it exists
@@ -498,3 +518,652 @@ void ConfigManager::RemoveKey(const char * key) {
 }
 
 
+
+/**
+ * @brief Writes every dirty key to NVS in one batch.
+ *
+ * The dirty set is copied and cleared under the cache lock, then written
+ * without holding it, so Get/Put callers never wait on flash. A key
+ * changed again during the write, or whose put failed, stays dirty for
+ * the next commit.
+ */
+void ConfigManager::commit() {
+    xSemaphoreTake(commitMutex, portMAX_DELAY);
+    TRACE_SCOPE("nvs.commit");
+
+    CacheEntry pending[CONFIG_CACHE_SIZE];
+    uint8_t count = 0;
+    int32_t snapshot[SETTING_COUNT];
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < cacheCount; i++) {
+        if (!cache[i].dirty) continue;
+        pending[count++] = cache[i];
+        cache[i].dirty = false;
+    }
+    xSemaphoreGive(cacheMutex);
+
+    uint8_t written = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (writeValue(pending[i].key, pending[i].type, pending[i].value)) {
+            written++;
+            continue;
+        }
+        xSemaphoreTake(cacheMutex, portMAX_DELAY);
+        CacheEntry* entry = findEntry(pending[i].key);
+        if (entry != nullptr && !entry->dirty) {  // Not stored and nothing newer, keep it for the next commit
+            markChanged();
+            entry->dirty = true;
+        }
+        xSemaphoreGive(cacheMutex);
+    }
+
+    // After the keys, so a blob written now also counts their entries
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    uint32_t dirty = settingsDirty;
+    bool saveSettings = dirty != 0;
+    memcpy(snapshot, settings, sizeof(snapshot));
+    settingsDirty = 0;
+    xSemaphoreGive(cacheMutex);
+
+    bool settingsSaved = saveSettings && writeSettings(snapshot);
+    if (saveSettings && !settingsSaved) {
+        xSemaphoreTake(cacheMutex, portMAX_DELAY);
+        settingsDirty |= dirty;  // Not stored, keep it for the next commit
+        xSemaphoreGive(cacheMutex);
+    }
+    if (written > 0 || settingsSaved) commitCount++;
+
+    xSemaphoreGive(commitMutex);
+}
+
+/**
+ * @brief Number of keys and settings changed in RAM and not yet written to NVS.
+ */
+uint16_t ConfigManager::getPendingCount() {
+    uint16_t count = 0;
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    for (uint8_t id = 0; id < SETTING_COUNT; id++) {
+        if (settingsDirty & (1UL << id)) count++;
+    }
+    for (uint8_t i = 0; i < cacheCount; i++) {
+        if (cache[i].dirty) count++;
+    }
+    xSemaphoreGive(cacheMutex);
+    return count;
+}
+
+uint32_t ConfigManager::getNvsWrites() {
+    return nvsWrites;
+}
+
+uint32_t ConfigManager::getCommitCount() {
+    return commitCount;
+}
+
+/**
+ * @brief FreeRTOS task committing dirty keys after a quiet period.
+ *
+ * Woken by the first change, it waits until no Put has changed a value for
+ * CONFIG_COMMIT_QUIET_MS, or until the oldest pending change is
+ * CONFIG_COMMIT_MAX_DELAY_MS old, then commits. While idle it saves the
+ * lifetime NVS entry counter when only keys were written for
+ * CONFIG_WEAR_PERSIST_MS.
+ *
+ * @param pvParameters Pointer to the ConfigManager instance.
+ */
+void ConfigManager::commitTask(void *pvParameters) {
+    ConfigManager* config = static_cast<ConfigManager*>(pvParameters);
+    int8_t health = TaskHealth::add("config.commit");
+
+    while (true) {
+        TaskHealth::checkIn(health);
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TASK_IDLE_WAKE_MS)) == 0) {
+            if (config->wearPersistDue()) config->commit();
+            continue;
+        }
+
+        while (config->getPendingCount() > 0) {
+            TaskHealth::checkIn(health);
+            uint32_t now = millis();
+            uint32_t quiet = now - config->lastChangeMs;
+            uint32_t age = now - config->firstDirtyMs;
+            if (quiet >= CONFIG_COMMIT_QUIET_MS || age >= CONFIG_COMMIT_MAX_DELAY_MS) {
+                config->commit();
+                break;
+            }
+            uint32_t wait = CONFIG_COMMIT_QUIET_MS - quiet;
+            if (wait > TASK_IDLE_WAKE_MS) wait = TASK_IDLE_WAKE_MS;  // Check in on the way
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+        }
+    }
+}
+
+ConfigManager::CacheEntry* ConfigManager::findEntry(const char* key) {
+    for (uint8_t i = 0; i < cacheCount; i++) {
+        if (strncmp(cache[i].key, key, CONFIG_KEY_SIZE) == 0) return &cache[i];
+    }
+    return nullptr;
+}
+
+ConfigManager::CacheEntry* ConfigManager::addEntry(const char* key, ValueType type) {
+    if (cacheCount >= CONFIG_CACHE_SIZE || strlen(key) >= CONFIG_KEY_SIZE) return nullptr;
+    CacheEntry* entry = &cache[cacheCount++];
+    strncpy(entry->key, key, CONFIG_KEY_SIZE);
+    entry->type = type;
+    entry->dirty = false;
+    return entry;
+}
+
+/**
+ * @brief Copies a cached value of the given type.
+ *
+ * @return False if the key is not cached (or cached with another type).
+ */
+bool ConfigManager::cacheGet(const char* key, ValueType type, CacheValue& value) {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    CacheEntry* entry = findEntry(key);
+    bool hit = entry != nullptr && entry->type == type;
+    if (hit) value = entry->value;
+    xSemaphoreGive(cacheMutex);
+    return hit;
+}
+
+/**
+ * @brief Caches a value just read from NVS (clean).
+ */
+void ConfigManager::cacheFill(const char* key, ValueType type, const CacheValue& value) {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    CacheEntry* entry = findEntry(key);
+    if (entry == nullptr) entry = addEntry(key, type);
+    if (entry != nullptr && !entry->dirty) {
+        entry->type = type;
+        entry->value = value;
+    }
+    xSemaphoreGive(cacheMutex);
+}
+
+/**
+ * @brief Stores a value in the cache and schedules the commit.
+ *
+ * Falls back to an immediate NVS write if the cache is full.
+ */
+void ConfigManager::cachePut(const char* key, ValueType type, const CacheValue& value) {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    CacheEntry* entry = findEntry(key);
+    if (entry != nullptr && entry->type == type && sameValue(type, entry->value, value)) {
+        xSemaphoreGive(cacheMutex);
+        return;  // Unchanged, nothing to write
+    }
+    if (entry == nullptr) entry = addEntry(key, type);
+    if (entry == nullptr) {
+        xSemaphoreGive(cacheMutex);
+        writeValue(key, type, value);
+        return;
+    }
+
+    markChanged();
+    requestedBytes += valueSize(type);
+    entry->type = type;
+    entry->value = value;
+    entry->dirty = true;
+    xSemaphoreGive(cacheMutex);
+
+    if (commitTaskHandle) xTaskNotifyGive(commitTaskHandle);
+}
+
+/**
+ * @brief Records the time of a change for the commit task (cache mutex held).
+ *
+ * Must be called before the new dirty flag is set.
+ */
+void ConfigManager::markChanged() {
+    uint32_t now = millis();
+    bool wasClean = settingsDirty == 0;
+    for (uint8_t i = 0; i < cacheCount && wasClean; i++) wasClean = !cache[i].dirty;
+    if (wasClean) firstDirtyMs = now;
+    lastChangeMs = now;
+}
+
+/**
+ * @brief Writes one value to preferences.
+ *
+ * @return False if the put failed (e.g. the partition is full).
+ */
+bool ConfigManager::writeValue(const char* key, ValueType type, const CacheValue& value) {
+    esp_task_wdt_reset();
+    size_t length = 0;
+    switch (type) {
+        case TYPE_BOOL:    length = preferences->putBool(key, value.b); break;
+        case TYPE_INT:     length = preferences->putInt(key, value.i); break;
+        case TYPE_UINT:    length = preferences->putUInt(key, value.u); break;
+        case TYPE_ULONG64: length = preferences->putULong64(key, value.u64); break;
+        case TYPE_FLOAT:   length = preferences->putFloat(key, value.f); break;
+    }
+    if (length == 0) {
+        #ifdef ENABLE_SERIAL_DEBUG
+            Serial.printf("ConfigManager: write of %s failed ⚠️\n", key);
+        #endif
+        return false;
+    }
+    nvsWrites++;
+    recordWrite(key, 1);  // Primitive types take a single entry
+    return true;
+}
+
+bool ConfigManager::sameValue(ValueType type, const CacheValue& a, const CacheValue& b) {
+    switch (type) {
+        case TYPE_BOOL:    return a.b == b.b;
+        case TYPE_INT:     return a.i == b.i;
+        case TYPE_UINT:    return a.u == b.u;
+        case TYPE_ULONG64: return a.u64 == b.u64;
+        case TYPE_FLOAT:   return a.f == b.f;
+    }
+    return false;
+}
+
+/**
+ * @brief Returns a schema setting from RAM.
+ */
+int32_t ConfigManager::getSetting(SettingId id) {
+    if (id >= SETTING_COUNT) return 0;
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    int32_t value = settings[id];
+    xSemaphoreGive(cacheMutex);
+    return value;
+}
+
+/**
+ * @brief Changes a schema setting (write-behind, committed with the blob).
+ *
+ * Values outside the schema range are refused and counted.
+ *
+ * @return False if the value was out of range.
+ */
+bool ConfigManager::setSetting(SettingId id, int32_t value) {
+    if (id >= SETTING_COUNT || !settingInRange(id, value)) {
+        rejectedWrites++;
+        #ifdef ENABLE_SERIAL_DEBUG
+            Serial.printf("ConfigManager: %s=%ld out of range, ignored\n",
+                          id < SETTING_COUNT ? CONFIG_SCHEMA[id].key : "?", (long)value);
+        #endif
+        return false;
+    }
+
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    if (settings[id] == value) {
+        xSemaphoreGive(cacheMutex);
+        return true;  // Unchanged, nothing to write
+    }
+    markChanged();
+    requestedBytes += sizeof(int32_t);
+    settings[id] = value;
+    settingsDirty |= 1UL << id;
+    xSemaphoreGive(cacheMutex);
+
+    if (commitTaskHandle) xTaskNotifyGive(commitTaskHandle);
+    return true;
+}
+
+/**
+ * @brief Changes settings 0..count-1 together.
+ *
+ * Every value is validated first; if one is out of range nothing is
+ * changed. The commit task sees either none or all of the new values.
+ *
+ * @return False if a value was out of range.
+ */
+bool ConfigManager::setSettings(const int32_t* values, uint8_t count) {
+    if (count > SETTING_COUNT) return false;
+    for (uint8_t id = 0; id < count; id++) {
+        if (!settingInRange((SettingId)id, values[id])) {
+            rejectedWrites++;
+            return false;
+        }
+    }
+
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    uint32_t changed = 0;
+    for (uint8_t id = 0; id < count; id++) {
+        if (settings[id] != values[id]) changed |= 1UL << id;
+    }
+    if (changed) {
+        markChanged();
+        for (uint8_t id = 0; id < count; id++) {
+            if (changed & (1UL << id)) requestedBytes += sizeof(int32_t);
+        }
+        memcpy(settings, values, count * sizeof(int32_t));
+        settingsDirty |= changed;
+    }
+    xSemaphoreGive(cacheMutex);
+
+    if (changed && commitTaskHandle) xTaskNotifyGive(commitTaskHandle);
+    return true;
+}
+
+uint32_t ConfigManager::getRejectedWrites() {
+    return rejectedWrites;
+}
+
+/**
+ * @brief Schema version the settings were loaded from (0 = legacy keys).
+ */
+uint16_t ConfigManager::getLoadedVersion() {
+    return loadedVersion;
+}
+
+bool ConfigManager::settingInRange(SettingId id, int32_t value) {
+    return value >= CONFIG_SCHEMA[id].minValue && value <= CONFIG_SCHEMA[id].maxValue;
+}
+
+/**
+ * @brief Loads all settings with a single blob read.
+ *
+ * - Current blob: used as is.
+ * - Blob from an older schema: settings it predates get their defaults
+ *   and the blob is rewritten in the current layout.
+ * - Blob from a newer schema (downgrade): the settings known here are used.
+ * - No blob or bad CRC: the legacy per-key values are migrated (defaults
+ *   where missing), saved as a blob and the old keys are removed.
+ *
+ * Stored values outside the schema range fall back to their default.
+ */
+void ConfigManager::loadSettings() {
+    esp_task_wdt_reset();
+    ConfigBlob blob;
+    size_t length = preferences->getBytesLength(CONFIG_BLOB_KEY);
+    bool valid = length >= CONFIG_BLOB_HEADER_SIZE && length <= sizeof(blob)
+              && preferences->getBytes(CONFIG_BLOB_KEY, &blob, length) == length
+              && length == CONFIG_BLOB_HEADER_SIZE + blob.count * sizeof(int32_t)
+              && blob.crc == blobCrc(blob.values, blob.count);
+
+    if (valid) {
+        loadedVersion = blob.version;
+        for (uint8_t id = 0; id < SETTING_COUNT; id++) {
+            bool stored = id < blob.count && CONFIG_SCHEMA[id].since <= blob.version;
+            int32_t value = stored ? blob.values[id] : CONFIG_SCHEMA[id].defaultValue;
+            settings[id] = settingInRange((SettingId)id, value) ? value : CONFIG_SCHEMA[id].defaultValue;
+        }
+        lifetimeEntries = settings[SETTING_NVS_ENTRIES];
+        if ((blob.version < CONFIG_SCHEMA_VERSION || blob.count < SETTING_COUNT) && writeSettings(settings)) {
+            #ifdef ENABLE_SERIAL_DEBUG
+                Serial.printf("ConfigManager: settings migrated v%u -> v%u\n", blob.version, CONFIG_SCHEMA_VERSION);
+            #endif
+        }
+        return;
+    }
+
+    #ifdef ENABLE_SERIAL_DEBUG
+        if (length > 0) Serial.println("ConfigManager: settings blob corrupt, rebuilding ⚠️");
+    #endif
+    loadedVersion = 0;
+    for (uint8_t id = 0; id < SETTING_COUNT; id++) {
+        const SettingDef& def = CONFIG_SCHEMA[id];
+        int32_t value = def.defaultValue;
+        if (preferences->isKey(def.key)) {
+            value = def.type == SETTING_BOOL ? preferences->getBool(def.key, def.defaultValue)
+                                             : preferences->getInt(def.key, def.defaultValue);
+        }
+        settings[id] = settingInRange((SettingId)id, value) ? value : def.defaultValue;
+    }
+    lifetimeEntries = settings[SETTING_NVS_ENTRIES];
+    if (!writeSettings(settings)) return;  // Keep the legacy keys, retried at the next boot
+    for (uint8_t id = 0; id < SETTING_COUNT; id++) {
+        if (preferences->isKey(CONFIG_SCHEMA[id].key)) preferences->remove(CONFIG_SCHEMA[id].key);
+    }
+}
+
+/**
+ * @brief Writes the settings blob in the current layout (one NVS put).
+ *
+ * @return False if NVS did not store the whole blob (full or failing
+ *         partition); nothing is counted then.
+ */
+bool ConfigManager::writeSettings(const int32_t* values) {
+    const size_t length = CONFIG_BLOB_HEADER_SIZE + SETTING_COUNT * sizeof(int32_t);
+    const uint16_t entries = entriesForBytes(length);
+
+    ConfigBlob blob;
+    blob.version = CONFIG_SCHEMA_VERSION;
+    blob.count = SETTING_COUNT;
+    blob.reserved = 0;
+    memcpy(blob.values, values, SETTING_COUNT * sizeof(int32_t));
+    // The wear counter rides along with every blob write, including this one
+    uint32_t lifetime = lifetimeEntries + entries;
+    blob.values[SETTING_NVS_ENTRIES] = lifetime > INT32_MAX ? INT32_MAX : (int32_t)lifetime;
+    blob.crc = blobCrc(blob.values, blob.count);
+
+    esp_task_wdt_reset();
+    if (preferences->putBytes(CONFIG_BLOB_KEY, &blob, length) != length) {
+        #ifdef ENABLE_SERIAL_DEBUG
+            Serial.println("ConfigManager: settings blob write failed ⚠️");
+        #endif
+        return false;
+    }
+    nvsWrites++;
+    recordWrite(CONFIG_BLOB_KEY, entries);
+    return true;
+}
+
+uint32_t ConfigManager::blobCrc(const int32_t* values, uint8_t count) {
+    return esp_rom_crc32_le(0, (const uint8_t*)values, count * sizeof(int32_t));
+}
+
+/**
+ * @brief True if the recipe has a printable name and every value is in range.
+ */
+bool ConfigManager::validateRecipe(const Recipe& recipe) {
+    if (recipe.name[0] == '\0' || memchr(recipe.name, '\0', sizeof(recipe.name)) == nullptr) return false;
+    for (const char* c = recipe.name; *c; c++) {
+        if (*c < ' ' || *c > '~' || *c == '"') return false;  // Shown on the display as a quoted string
+    }
+    for (uint8_t id = 0; id < RECIPE_SETTINGS; id++) {
+        if (!settingInRange((SettingId)id, recipe.values[id])) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Validates and stores a recipe in @p slot (immediate NVS write).
+ *
+ * Recipes change rarely, so they bypass the write-behind cache.
+ *
+ * @return False if the slot or the recipe is invalid.
+ */
+bool ConfigManager::saveRecipe(uint8_t slot, const Recipe& recipe) {
+    if (slot >= RECIPE_MAX_COUNT || !validateRecipe(recipe)) {
+        rejectedWrites++;
+        return false;
+    }
+
+    RecipeRecord record;
+    record.recipe = recipe;
+    record.crc = esp_rom_crc32_le(0, (const uint8_t*)&record.recipe, sizeof(record.recipe));
+
+    char key[CONFIG_KEY_SIZE];
+    recipeKey(slot, key);
+    esp_task_wdt_reset();
+    preferences->putBytes(key, &record, sizeof(record));
+    nvsWrites++;
+    recordWrite(key, entriesForBytes(sizeof(record)));
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    requestedBytes += sizeof(Recipe);
+    xSemaphoreGive(cacheMutex);
+    return true;
+}
+
+/**
+ * @brief Reads the recipe in @p slot.
+ *
+ * @return False if the slot is empty, fails its CRC or holds values
+ *         outside the current schema ranges.
+ */
+bool ConfigManager::loadRecipe(uint8_t slot, Recipe& recipe) {
+    if (slot >= RECIPE_MAX_COUNT) return false;
+
+    char key[CONFIG_KEY_SIZE];
+    recipeKey(slot, key);
+    esp_task_wdt_reset();
+    RecipeRecord record;
+    if (preferences->getBytesLength(key) != sizeof(record)) return false;
+    if (preferences->getBytes(key, &record, sizeof(record)) != sizeof(record)) return false;
+    if (record.crc != esp_rom_crc32_le(0, (const uint8_t*)&record.recipe, sizeof(record.recipe))) return false;
+    if (!validateRecipe(record.recipe)) return false;
+
+    recipe = record.recipe;
+    return true;
+}
+
+void ConfigManager::deleteRecipe(uint8_t slot) {
+    if (slot >= RECIPE_MAX_COUNT) return;
+    char key[CONFIG_KEY_SIZE];
+    recipeKey(slot, key);
+    esp_task_wdt_reset();
+    if (preferences->isKey(key)) preferences->remove(key);
+    if (getSetting(SETTING_ACTIVE_RECIPE) == slot) setSetting(SETTING_ACTIVE_RECIPE, -1);
+}
+
+int8_t ConfigManager::findRecipe(const char* name) {
+    Recipe recipe;
+    for (uint8_t slot = 0; slot < RECIPE_MAX_COUNT; slot++) {
+        if (loadRecipe(slot, recipe) && strncmp(recipe.name, name, RECIPE_NAME_SIZE) == 0) return slot;
+    }
+    return -1;
+}
+
+int8_t ConfigManager::findFreeRecipeSlot() {
+    char key[CONFIG_KEY_SIZE];
+    for (uint8_t slot = 0; slot < RECIPE_MAX_COUNT; slot++) {
+        recipeKey(slot, key);
+        if (!preferences->isKey(key)) return slot;
+    }
+    return -1;
+}
+
+void ConfigManager::recipeKey(uint8_t slot, char* key) {
+    snprintf(key, CONFIG_KEY_SIZE, RECIPE_KEY_PREFIX "%u", slot);
+}
+
+/**
+ * @brief Counts one NVS put of @p entries entries against @p key.
+ *
+ * Keys beyond CONFIG_WEAR_KEYS are only included in the totals. The
+ * lifetime counter is kept in RAM: each blob write saves it (the blob
+ * already carries its own entries), and the commit task writes the blob
+ * for it alone only once CONFIG_WEAR_PERSIST_MS have passed. Dirtying
+ * the blob on every key or recipe put would double their flash wear.
+ */
+void ConfigManager::recordWrite(const char* key, uint16_t entries) {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    entriesWritten += entries;
+    lifetimeEntries += entries;
+    settings[SETTING_NVS_ENTRIES] = lifetimeEntries > INT32_MAX ? INT32_MAX : (int32_t)lifetimeEntries;
+    if (strcmp(key, CONFIG_BLOB_KEY) == 0) {
+        unsavedEntries = 0;  // The blob just written carries the counter
+        wearSavedMs = millis();
+    } else {
+        unsavedEntries += entries;
+    }
+
+    WearEntry* slot = nullptr;
+    for (uint8_t i = 0; i < wearCount && slot == nullptr; i++) {
+        if (strncmp(wear[i].key, key, CONFIG_KEY_SIZE) == 0) slot = &wear[i];
+    }
+    if (slot == nullptr && wearCount < CONFIG_WEAR_KEYS) {
+        slot = &wear[wearCount++];
+        strncpy(slot->key, key, CONFIG_KEY_SIZE - 1);
+        slot->key[CONFIG_KEY_SIZE - 1] = '\0';
+        slot->writes = 0;
+        slot->entries = 0;
+    }
+    if (slot) {
+        slot->writes++;
+        slot->entries += entries;
+    }
+    xSemaphoreGive(cacheMutex);
+}
+
+/**
+ * @brief Marks the lifetime counter for a commit if entries written since
+ *        the last blob have waited CONFIG_WEAR_PERSIST_MS.
+ *
+ * @return True if the counter was marked and a commit is needed.
+ */
+bool ConfigManager::wearPersistDue() {
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    bool due = unsavedEntries > 0 && millis() - wearSavedMs >= CONFIG_WEAR_PERSIST_MS
+            && !(settingsDirty & (1UL << SETTING_NVS_ENTRIES));
+    if (due) {
+        markChanged();
+        settingsDirty |= 1UL << SETTING_NVS_ENTRIES;
+    }
+    xSemaphoreGive(cacheMutex);
+    return due;
+}
+
+/**
+ * @brief NVS entries taken by a blob or string of @p length bytes.
+ *
+ * NVS stores variable-length data as a header entry plus 32-byte data
+ * entries, and blobs (format v2) add an index entry. The string case is
+ * one less, which the caller accounts for.
+ */
+uint16_t ConfigManager::entriesForBytes(size_t length) {
+    return 2 + (length + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE;
+}
+
+uint16_t ConfigManager::valueSize(ValueType type) {
+    switch (type) {
+        case TYPE_BOOL:    return sizeof(uint8_t);
+        case TYPE_ULONG64: return sizeof(uint64_t);
+        default:           return sizeof(uint32_t);
+    }
+}
+
+/**
+ * @brief Adds the flash wear diagnostics to @p doc.
+ *
+ * NVS writes append entries to the active page and erase a page only when
+ * it is reclaimed, so each NVS_ENTRIES_PER_PAGE entries written cost about
+ * one page erase. Spread over the partition's pages by NVS wear levelling,
+ * this gives the erase cycles per page used so far.
+ */
+void ConfigManager::reportDiagnostics(JsonDocument& doc) {
+    nvs_stats_t stats;
+    esp_err_t err = nvs_get_stats(CONFIG_NVS_PARTITION, &stats);
+
+    xSemaphoreTake(cacheMutex, portMAX_DELAY);
+    doc["partition"] = CONFIG_NVS_PARTITION;
+    if (err == ESP_OK) {
+        uint32_t pages = stats.total_entries / NVS_ENTRIES_PER_PAGE;
+        doc["usedEntries"] = stats.used_entries;
+        doc["freeEntries"] = stats.free_entries;
+        doc["totalEntries"] = stats.total_entries;
+        doc["namespaces"] = stats.namespace_count;
+        doc["pages"] = pages;
+        doc["freePages"] = stats.free_entries / NVS_ENTRIES_PER_PAGE;
+        if (pages > 0) {
+            float erasesPerPage = (float)lifetimeEntries / NVS_ENTRIES_PER_PAGE / pages;
+            doc["erasesPerPage"] = erasesPerPage;
+            doc["wearPercent"] = erasesPerPage * 100.0f / NVS_FLASH_ENDURANCE;
+        }
+    } else {
+        doc["statsError"] = err;
+    }
+
+    doc["nvsWrites"] = nvsWrites;
+    doc["entriesWritten"] = entriesWritten;
+    doc["lifetimeEntries"] = lifetimeEntries;
+    doc["requestedBytes"] = requestedBytes;
+    if (requestedBytes > 0) {
+        doc["writeAmplification"] = (float)entriesWritten * NVS_ENTRY_SIZE / requestedBytes;
+    }
+
+    JsonArray keys = doc["keys"].to<JsonArray>();
+    for (uint8_t i = 0; i < wearCount; i++) {
+        JsonObject item = keys.add<JsonObject>();
+        item["key"] = String(wear[i].key);
+        item["writes"] = wear[i].writes;
+        item["entries"] = wear[i].entries;
+    }
+    xSemaphoreGive(cacheMutex);
+}
@@ -20,6 +20,23 @@
  * This class is especially useful in applications where persistent configuration 
  * data is necessary, such as in IoT devices that require configuration 
  * management across power cycles.
+ *
+ * Scalar values are cached in RAM (write-behind). Get* reads from the cache,
+ * Put* only updates it and marks the key dirty. Dirty keys are written to
+ * NVS in one batch once no change happened for CONFIG_COMMIT_QUIET_MS, on
+ * commit() (SAVE command), and before a restart or simulated power-down.
+ * Strings are not cached and still go straight to NVS.
+ *
+ * The motor and HMI settings declared in ConfigSchema.h are accessed with
+ * getSetting()/setSetting(). They are kept together and stored as one
+ * CRC-checked blob, so boot loading is a single NVS read. Every write is
+ * checked against the schema range.
+ *
+ * Every NVS write is also accounted for wear: writes and 32-byte entries
+ * per key, the bytes callers asked to store, and a lifetime entry count
+ * kept in the settings blob. reportDiagnostics() turns these and
+ * nvs_get_stats() into page usage, write amplification and an estimate of
+ * erase cycles per page.
  */
 
  #include <Arduino.h>
@@ -28,6 +45,9 @@
  #include <WiFiUdp.h>
  #include <ArduinoJson.h>
  #include <Preferences.h>
+ #include <nvs.h>
+ #include <FreeRTOS.h>
+ #include <freertos/semphr.h>
 
  
  // ESP32-specific includes
@@ -37,6 +57,7 @@
  
  // Custom includes
  #include "Config.h"  // Include Config.h for default values
+ #include "ConfigSchema.h"
  
 
 class ConfigManager {
@@ -65,6 +86,32 @@ public:
     void RemoveKey(const char* key);  // Remove a specific key
     void ClearKey(); 
 
+    // Schema settings (ConfigSchema.h)
+    int32_t getSetting(SettingId id);
+    bool setSetting(SettingId id, int32_t value);  // False if outside the schema range
+    uint32_t getRejectedWrites();  // setSetting() calls refused by range validation
+    uint16_t getLoadedVersion();   // Schema version found at boot (0 = legacy keys)
+    bool setSettings(const int32_t* values, uint8_t count);  // Ids 0..count-1, all or nothing
+    static bool settingInRange(SettingId id, int32_t value);
+
+    // Recipe slots (written through, one NVS entry per slot)
+    bool validateRecipe(const Recipe& recipe);
+    bool saveRecipe(uint8_t slot, const Recipe& recipe);
+    bool loadRecipe(uint8_t slot, Recipe& recipe);  // False if empty, corrupt or invalid
+    void deleteRecipe(uint8_t slot);
+    int8_t findRecipe(const char* name);            // Slot holding @p name, or -1
+    int8_t findFreeRecipeSlot();                    // First empty slot, or -1
+
+    // Write-behind cache
+    void commit();                 // Write all dirty keys to NVS now
+    uint16_t getPendingCount();    // Keys changed in RAM but not yet in NVS
+    uint32_t getNvsWrites();       // NVS put operations since boot
+    uint32_t getCommitCount();     // Batches written since boot
+
+    // Flash wear diagnostics (NVSDIAG)
+    void reportDiagnostics(JsonDocument& doc);
+    static uint16_t entriesForBytes(size_t length);  // NVS entries used by a blob of @p length
+
 
     // System control methods
     void RestartSysDelay(unsigned long delayTime);  // Restart system with delay
@@ -84,6 +131,70 @@ private:
 
     Preferences* preferences;     // Preferences object to store configuration
     const char* namespaceName;   // Namespace for the preferences storage
+
+    enum ValueType : uint8_t { TYPE_BOOL, TYPE_INT, TYPE_UINT, TYPE_ULONG64, TYPE_FLOAT };
+
+    union CacheValue {
+        bool b;
+        int32_t i;
+        uint32_t u;
+        uint64_t u64;
+        float f;
+    };
+
+    struct CacheEntry {
+        char key[CONFIG_KEY_SIZE];
+        ValueType type;
+        bool dirty;               // Changed since the last commit
+        CacheValue value;
+    };
+
+    CacheEntry* findEntry(const char* key);                 // Cache mutex held
+    CacheEntry* addEntry(const char* key, ValueType type);  // Cache mutex held
+    bool cacheGet(const char* key, ValueType type, CacheValue& value);
+    void cacheFill(const char* key, ValueType type, const CacheValue& value);
+    void cachePut(const char* key, ValueType type, const CacheValue& value);
+    bool writeValue(const char* key, ValueType type, const CacheValue& value);
+    void markChanged();                                     // Cache mutex held
+    void recordWrite(const char* key, uint16_t entries);     // Wear accounting of one NVS put
+    bool wearPersistDue();                                   // Lifetime counter unsaved for CONFIG_WEAR_PERSIST_MS
+    static uint16_t valueSize(ValueType type);
+    static bool sameValue(ValueType type, const CacheValue& a, const CacheValue& b);
+    static void commitTask(void *pvParameters);
+
+    void loadSettings();
+    bool writeSettings(const int32_t* values);
+    static uint32_t blobCrc(const int32_t* values, uint8_t count);
+    static void recipeKey(uint8_t slot, char* key);
+
+    CacheEntry cache[CONFIG_CACHE_SIZE];
+    uint8_t cacheCount;
+    SemaphoreHandle_t cacheMutex;   // Guards the cache table
+    SemaphoreHandle_t commitMutex;  // Serializes commits
+    TaskHandle_t commitTaskHandle;
+    uint32_t lastChangeMs;          // millis() of the last Put that changed a value
+    uint32_t firstDirtyMs;          // millis() when the oldest pending change was made
+    uint32_t nvsWrites;
+    uint32_t commitCount;
+
+    int32_t settings[SETTING_COUNT];  // Indexed by SettingId, guarded by cacheMutex
+    uint32_t settingsDirty;           // One bit per SettingId changed since the last commit
+    uint32_t rejectedWrites;
+    uint16_t loadedVersion;
+
+    // Wear accounting (guarded by cacheMutex)
+    struct WearEntry {
+        char key[CONFIG_KEY_SIZE];
+        uint32_t writes;
+        uint32_t entries;
+    };
+    WearEntry wear[CONFIG_WEAR_KEYS];
+    uint8_t wearCount;
+    uint32_t entriesWritten;     // NVS entries written since boot
+    uint32_t requestedBytes;     // Payload bytes of the changes callers made
+    uint32_t lifetimeEntries;    // From the blob at boot, plus entriesWritten
+    uint32_t unsavedEntries;     // Counted in lifetimeEntries but not in a stored blob yet
+    uint32_t wearSavedMs;        // millis() of the last blob write (which saves the counter)
 };
 
 #endif // CONFIG_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef CONFIG_SCHEMA_H
+#define CONFIG_SCHEMA_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * @file ConfigSchema.h
+ * @brief Single definition of every persistent setting.
+ *
+ * Each setting has one row: its legacy NVS key, type, default and valid
+ * range, and the schema version that introduced it. ConfigManager keeps
+ * all values in one ConfigBlob that is loaded and saved as a single NVS
+ * entry.
+ *
+ * Rules for changing the schema:
+ * - Append new settings at the end of SettingId, never reorder or remove
+ *   one (the blob is indexed by id).
+ * - Give the new row `since` = the new CONFIG_SCHEMA_VERSION and bump it.
+ *   Older blobs then load with the new settings at their defaults.
+ */
+
+// Schema version written into the blob (0 = loose per-key layout)
+constexpr uint16_t CONFIG_SCHEMA_VERSION = 3;
+
+enum SettingId : uint8_t {
+    SETTING_DELAY_MS = 0,   // Sensor stop time (ms)
+    SETTING_OFFSET_STEPS,   // Steps taken after a sensor edge
+    SETTING_CASE_RPM,       // Case axis step frequency
+    SETTING_DISC_RPM,       // Disc axis step frequency
+    SETTING_CASE_DIR,       // Case axis direction
+    SETTING_DISC_DIR,       // Disc axis direction
+    SETTING_HMI_BAUD,       // Last display baud rate that answered a ping
+    SETTING_ACTIVE_RECIPE,  // Recipe slot last applied, -1 if none
+    SETTING_NVS_ENTRIES,    // Lifetime NVS entries written (wear estimate), updated on each blob write
+    SETTING_COUNT
+};
+
+enum SettingType : uint8_t { SETTING_INT, SETTING_BOOL };
+
+struct SettingDef {
+    const char* key;     // Legacy NVS key, read once during migration
+    SettingType type;
+    int32_t defaultValue;
+    int32_t minValue;
+    int32_t maxValue;
+    uint16_t since;      // Schema version that introduced the setting
+};
+
+constexpr SettingDef CONFIG_SCHEMA[SETTING_COUNT] = {
+    // key      type          default               min             max              since
+    { "DLMSV", SETTING_INT,  DEFAULT_STOP_TIME,     0,              HMI_DELAY_MAX,   1 },
+    { "OFSTP", SETTING_INT,  DEFAULT_STEPS_TO_TAKE, 0,              HMI_OFFSET_MAX,  1 },
+    { "CASRP", SETTING_INT,  DEFAULT_CASE_SPEED,    HMI_SPEED_MIN,  HMI_SPEED_MAX,   1 },
+    { "DISRP", SETTING_INT,  DEFAULT_DISK_SPEED,    HMI_SPEED_MIN,  HMI_SPEED_MAX,   1 },
+    { "CASDR", SETTING_BOOL, DEFAULT_CASE_DIR,      0,              1,               1 },
+    { "DISDR", SETTING_BOOL, DEFAULT_DISK_DIR,      0,              1,               1 },
+    { "HMIBD", SETTING_INT,  NEXTION_BAUDRATE,      2400,           921600,          1 },
+    { "RCPAC", SETTING_INT,  -1,                    -1,             RECIPE_MAX_COUNT - 1, 2 },
+    { "NVSEN", SETTING_INT,  0,                     0,              INT32_MAX,       3 },
+};
+
+/**
+ * @brief Compile-time check of one schema row.
+ */
+constexpr bool settingValid(const SettingDef& def, uint8_t id) {
+    return def.minValue <= def.maxValue
+        && def.defaultValue >= def.minValue && def.defaultValue <= def.maxValue
+        && def.since >= 1 && def.since <= CONFIG_SCHEMA_VERSION
+        && (def.type != SETTING_BOOL || (def.minValue == 0 && def.maxValue == 1))
+        && (id == 0 || CONFIG_SCHEMA[id - 1].since <= def.since);
+}
+
+constexpr bool schemaValid(uint8_t id = 0) {
+    return id >= SETTING_COUNT || (settingValid(CONFIG_SCHEMA[id], id) && schemaValid(id + 1));
+}
+
+static_assert(schemaValid(), "CONFIG_SCHEMA: default outside range, bad type range or bad version order");
+static_assert(SETTING_COUNT <= CONFIG_BLOB_MAX_SETTINGS, "Raise CONFIG_BLOB_MAX_SETTINGS");
+
+/**
+ * @brief Settings image stored under CONFIG_BLOB_KEY.
+ *
+ * Only the first `count` values are written, so a blob from an older
+ * schema is shorter. The CRC covers the values actually stored.
+ */
+struct ConfigBlob {
+    uint16_t version;      // CONFIG_SCHEMA_VERSION of the writer
+    uint8_t count;         // Number of values stored
+    uint8_t reserved;
+    uint32_t crc;          // CRC32 of values[0..count)
+    int32_t values[CONFIG_BLOB_MAX_SETTINGS];
+};
+
+constexpr size_t CONFIG_BLOB_HEADER_SIZE = offsetof(ConfigBlob, values);
+static_assert(CONFIG_BLOB_HEADER_SIZE == 8, "ConfigBlob header must not contain padding");
+
+// A recipe holds the motion settings SETTING_DELAY_MS .. SETTING_DISC_DIR
+constexpr uint8_t RECIPE_SETTINGS = SETTING_DISC_DIR + 1;
+
+/**
+ * @brief Named, complete motion parameter set (see RecipeManager).
+ */
+struct Recipe {
+    char name[RECIPE_NAME_SIZE];        // NUL-terminated
+    int32_t values[RECIPE_SETTINGS];    // Indexed by SettingId
+};
+
+/**
+ * @brief NVS image of one recipe slot (RECIPE_KEY_PREFIX + slot).
+ */
+struct RecipeRecord {
+    uint32_t crc;                       // CRC32 of recipe
+    Recipe recipe;
+};
+
+// Both are stored byte for byte, so their layout must not contain padding
+static_assert(sizeof(Recipe) == RECIPE_NAME_SIZE + RECIPE_SETTINGS * sizeof(int32_t), "Recipe has padding");
+static_assert(sizeof(RecipeRecord) == sizeof(uint32_t) + sizeof(Recipe), "RecipeRecord has padding");
+
+#endif // CONFIG_SCHEMA_H
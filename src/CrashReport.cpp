@@ -0,0 +1,222 @@
+#include "CrashReport.h"
+#include <SD.h>
+#include <esp_partition.h>
+#include <mbedtls/base64.h>
+#include "DeferredLog.h"
+#include "TaskHealth.h"
+
+#define CRASH_SUMMARY_MAGIC  0x48535243  // "CRSH"
+
+static const char* const RESET_REASONS[] = {
+    "unknown", "powerOn", "external", "software", "panic", "intWdt", "taskWdt", "wdt",
+    "deepSleep", "brownout", "sdio"
+};
+
+/**
+ * @brief Copies at most @p size - 1 characters of @p src (which may lack a
+ *        terminator within @p srcSize) and always terminates @p dst.
+ */
+static void copyText(char* dst, size_t size, const char* src, size_t srcSize) {
+    size_t len = strnlen(src, min(size - 1, srcSize));
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+/**
+ * @brief Name of the common Xtensa exception causes, nullptr for others.
+ */
+static const char* exceptionName(uint32_t cause) {
+    switch (cause) {
+        case 0:  return "IllegalInstruction";
+        case 2:  return "InstructionFetchError";
+        case 3:  return "LoadStoreError";
+        case 6:  return "IntegerDivideByZero";
+        case 9:  return "LoadStoreAlignment";
+        case 20: return "InstFetchProhibited";
+        case 28: return "LoadProhibited";
+        case 29: return "StoreProhibited";
+        default: return nullptr;
+    }
+}
+
+CrashReport::CrashReport()
+    : supported(false), dumpPresent(false), newCrash(false), dumpAddress(0), dumpSize(0) {
+    memset(&last, 0, sizeof(last));
+}
+
+/**
+ * @brief Loads the previous summary from NVS and checks the partition.
+ *
+ * A valid image whose summary differs from the stored one is a new crash:
+ * it is counted and replaces the stored summary. The image checksum is
+ * verified, which reads the whole dump once.
+ */
+void CrashReport::begin() {
+    prefs.begin(CRASH_NVS_NAMESPACE, false);
+    if (prefs.getBytesLength(CRASH_NVS_KEY) != sizeof(last)
+        || prefs.getBytes(CRASH_NVS_KEY, &last, sizeof(last)) != sizeof(last)
+        || last.magic != CRASH_SUMMARY_MAGIC) {
+        memset(&last, 0, sizeof(last));
+    }
+    prefs.end();
+
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH && CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+    supported = true;
+    dumpPresent = esp_core_dump_image_check() == ESP_OK
+               && esp_core_dump_image_get(&dumpAddress, &dumpSize) == ESP_OK;
+    if (!dumpPresent) return;
+
+    CrashSummary found;
+    if (!readSummary(found)) return;
+    found.dumpSize = dumpSize;
+    bool same = last.magic == CRASH_SUMMARY_MAGIC && last.dumpSize == found.dumpSize
+             && last.tcb == found.tcb && last.pc == found.pc
+             && memcmp(last.backtrace, found.backtrace, sizeof(found.backtrace)) == 0;
+    if (same) return;
+
+    found.count = last.count + 1;
+    last = found;
+    newCrash = true;
+    store();
+    LOG_WARN(LOG_CRASH_FOUND, LOG_STR(last.task), last.pc);
+#endif
+}
+
+/**
+ * @brief Fills @p summary from the dump in flash.
+ */
+bool CrashReport::readSummary(CrashSummary& summary) {
+    esp_core_dump_summary_t* dump = (esp_core_dump_summary_t*)malloc(sizeof(esp_core_dump_summary_t));
+    if (dump == nullptr) return false;
+    bool ok = esp_core_dump_get_summary(dump) == ESP_OK;
+    if (ok) {
+        memset(&summary, 0, sizeof(summary));
+        summary.magic = CRASH_SUMMARY_MAGIC;
+        summary.tcb = dump->exc_tcb;
+        summary.pc = dump->exc_pc;
+        summary.excCause = dump->ex_info.exc_cause;
+        summary.excVaddr = dump->ex_info.exc_vaddr;
+        summary.depth = min((uint32_t)CRASH_BACKTRACE_DEPTH, (uint32_t)dump->exc_bt_info.depth);
+        memcpy(summary.backtrace, dump->exc_bt_info.bt, summary.depth * sizeof(uint32_t));
+        summary.corrupted = dump->exc_bt_info.corrupted;
+        summary.resetReason = (uint8_t)esp_reset_reason();
+        copyText(summary.task, sizeof(summary.task), dump->exc_task, sizeof(dump->exc_task));
+        copyText(summary.elfSha, sizeof(summary.elfSha), (const char*)dump->app_elf_sha256,
+                 sizeof(dump->app_elf_sha256));
+    }
+    free(dump);
+    return ok;
+}
+
+void CrashReport::store() {
+    prefs.begin(CRASH_NVS_NAMESPACE, false);
+    prefs.putBytes(CRASH_NVS_KEY, &last, sizeof(last));
+    prefs.end();
+}
+
+/**
+ * @brief Appends the crash found at this boot to CRASH_LOG_FILE, once.
+ */
+void CrashReport::saveToSD() {
+    if (last.magic != CRASH_SUMMARY_MAGIC || last.savedToSd) return;
+    File file = SD.open(CRASH_LOG_FILE, FILE_APPEND);
+    if (!file) return;
+    JsonDocument doc;
+    writeSummary(doc.to<JsonObject>());
+    serializeJson(doc, file);
+    file.print('\n');
+    file.close();
+    last.savedToSd = 1;
+    store();
+}
+
+bool CrashReport::hasDump() {
+    return dumpPresent;
+}
+
+/**
+ * @brief Summary of the newest crash as JSON; the backtrace is hex addresses
+ *        for addr2line / xtensa-esp32s3-elf-addr2line.
+ */
+void CrashReport::writeSummary(JsonObject out) {
+    char hex[11];
+    out["count"] = last.count;
+    out["task"] = last.task;
+    snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)last.pc);
+    out["pc"] = hex;
+    uint8_t reason = last.resetReason;
+    out["reason"] = RESET_REASONS[reason < sizeof(RESET_REASONS) / sizeof(RESET_REASONS[0]) ? reason : 0];
+    out["excCause"] = last.excCause;
+    const char* name = exceptionName(last.excCause);
+    if (name != nullptr) out["exception"] = name;
+    snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)last.excVaddr);
+    out["excVaddr"] = hex;
+    JsonArray trace = out["backtrace"].to<JsonArray>();
+    for (uint8_t i = 0; i < last.depth; i++) {
+        snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)last.backtrace[i]);
+        trace.add(hex);
+    }
+    if (last.corrupted) out["corrupted"] = true;
+    out["dumpSize"] = last.dumpSize;
+    out["elfSha"] = last.elfSha;
+}
+
+/**
+ * @brief CRASHINFO reply: whether a dump is stored and the newest summary.
+ */
+void CrashReport::report(JsonDocument& doc) {
+    doc["supported"] = supported;
+    doc["dump"] = dumpPresent;
+    if (dumpPresent) doc["dumpSize"] = dumpSize;
+    doc["newCrash"] = newCrash;
+    if (last.magic == CRASH_SUMMARY_MAGIC) writeSummary(doc["last"].to<JsonObject>());
+}
+
+/**
+ * @brief Writes the image in CRASH_DUMP_CHUNK pieces, one JSON line each.
+ *
+ * Blocks until everything is written: at 115200 baud a 64 KB image takes
+ * about 8 s.
+ */
+bool CrashReport::streamDump(Print& out) {
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, nullptr);
+    if (!dumpPresent || partition == nullptr) return false;
+
+    static_assert(CRASH_DUMP_CHUNK % 3 == 0, "Chunks must encode without base64 padding");
+    uint8_t chunk[CRASH_DUMP_CHUNK];
+    unsigned char encoded[CRASH_DUMP_CHUNK / 3 * 4 + 1];
+    for (size_t offset = 0; offset < dumpSize; offset += CRASH_DUMP_CHUNK) {
+        size_t n = min((size_t)CRASH_DUMP_CHUNK, dumpSize - offset);
+        size_t length = 0;
+        if (esp_partition_read(partition, dumpAddress - partition->address + offset, chunk, n) != ESP_OK
+            || mbedtls_base64_encode(encoded, sizeof(encoded), &length, chunk, n) != 0) {
+            return false;
+        }
+        encoded[length] = '\0';
+        out.print("{\"crashdump\":");
+        out.print((unsigned long)offset);
+        out.print(",\"data\":\"");
+        out.print((const char*)encoded);
+        out.print("\"}\n");
+        TaskHealth::feed();
+    }
+    return true;
+}
+
+/**
+ * @brief Clears the partition; the summary stays in NVS.
+ *
+ * Its dump size is cleared, so the same fault happening again is counted
+ * as a new crash.
+ */
+bool CrashReport::eraseDump() {
+    if (!supported || esp_core_dump_image_erase() != ESP_OK) return false;
+    dumpPresent = false;
+    dumpSize = 0;
+    if (last.magic == CRASH_SUMMARY_MAGIC) {
+        last.dumpSize = 0;
+        store();
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef CRASH_REPORT_H
+#define CRASH_REPORT_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <esp_core_dump.h>
+#include <esp_system.h>
+#include "Config.h"
+
+/**
+ * @file CrashReport.h
+ * @brief Post-mortem summary of the core dump left by a crash (CRASHINFO command).
+ *
+ * After a panic or watchdog reset, ESP-IDF leaves an ELF core dump in the
+ * coredump partition. At boot, begin() checks it and extracts the crashed
+ * task, PC, backtrace and exception cause. A dump not seen before is
+ * counted and its summary kept in NVS (CRASH_NVS_NAMESPACE), so it
+ * outlives the dump being erased; once the SD card is up, saveToSD()
+ * appends it as one JSON line to CRASH_LOG_FILE.
+ *
+ * CRASHINFO {"dump":true} streams the whole image as JSON lines
+ *
+ *   {"crashdump":<offset>,"data":"<base64>"}
+ *
+ * Each data field decodes to CRASH_DUMP_CHUNK bytes (the last may be
+ * shorter). Written one per line to a file, they are what
+ * `esp-coredump info_corefile -t b64 -c dump.b64 firmware.elf` reads.
+ * CRASHINFO {"erase":true} clears the partition for the next crash.
+ */
+
+struct CrashSummary {
+    uint32_t magic;          // CRASH_SUMMARY_MAGIC
+    uint32_t count;          // Different dumps seen since NVS was cleared
+    uint32_t dumpSize;       // Bytes of the image in the partition
+    uint32_t tcb;            // Crashed task control block
+    uint32_t pc;
+    uint32_t excCause;       // Xtensa EXCCAUSE
+    uint32_t excVaddr;       // Faulting address of a load/store
+    uint32_t backtrace[CRASH_BACKTRACE_DEPTH];
+    uint8_t depth;           // Valid backtrace entries
+    uint8_t corrupted;       // Backtrace stopped at a corrupt frame
+    uint8_t resetReason;     // esp_reset_reason() of the boot that found it
+    uint8_t savedToSd;       // Appended to CRASH_LOG_FILE
+    char task[16];
+    char elfSha[CRASH_ELF_SHA_CHARS + 1];  // Start of the firmware's ELF SHA-256
+};
+
+class CrashReport {
+public:
+    CrashReport();
+
+    void begin();                      // Read the dump summary (boot, before the motors start)
+    void saveToSD();                   // Append a new summary to the SD log (SD card ready)
+    bool hasDump();                    // An image is in the partition
+    void report(JsonDocument& doc);    // CRASHINFO
+    bool streamDump(Print& out);       // Full image as base64 lines
+    bool eraseDump();
+
+private:
+    bool readSummary(CrashSummary& summary);
+    void store();                      // Write `last` to NVS
+    void writeSummary(JsonObject out);
+
+    Preferences prefs;
+    CrashSummary last;       // Newest crash, from NVS or found at this boot
+    bool supported;          // Firmware built with core dumps to flash
+    bool dumpPresent;
+    bool newCrash;           // The dump was first seen at this boot
+    size_t dumpAddress;      // Flash address of the image
+    size_t dumpSize;
+};
+
+#endif // CRASH_REPORT_H
@@ -0,0 +1,169 @@
+#include "DeferredLog.h"
+#include "TaskHealth.h"
+
+// Format strings indexed by LogId; two %ld/%s/%c conversions at most
+static const char* const LOG_FORMATS[LOG_ID_COUNT] = {
+    "Motor Step Task Started (axis %ld)",      // LOG_MOTOR_TASK_STARTED
+    "Motor Step Task Stopped (axis %ld)",      // LOG_MOTOR_TASK_STOPPED
+    "Rising Edge Detected (offset %ld steps)", // LOG_RISING_EDGE
+    "Invalid resolution: %ld",                 // LOG_INVALID_RESOLUTION
+    "Command received: %s",                    // LOG_CMD_RECEIVED
+    "Command understood and executed",         // LOG_CMD_EXECUTED
+    "Unknown command received",                // LOG_CMD_UNKNOWN
+    "JSON deserialization failed: %s",         // LOG_CMD_JSON_ERROR
+    "Invalid command: 'command' field missing",// LOG_CMD_MISSING_FIELD
+    "Invalid %s command: missing parameters",  // LOG_CMD_INVALID_PARAMS
+    "%s button pressed",                       // LOG_HMI_BUTTON
+    "Nextion key '%c' (rx %lu us)",            // LOG_HMI_KEY
+    "Nextion event 0x%02lx (rx %lu us)",       // LOG_HMI_EVENT
+    "Nextion error 0x%02lx (rx %lu us)",       // LOG_HMI_ERROR
+    "Nextion link at %ld baud",                // LOG_HMI_BAUD
+    "Nextion silent at %ld baud, back to %ld", // LOG_HMI_BAUD_FALLBACK
+    "Nextion not answering, staying at %ld baud", // LOG_HMI_NOT_FOUND
+    "Hold '%c' released after %ld steps",      // LOG_HMI_HOLD_COMMIT
+    "Recipe %ld applied (%ld ms)",             // LOG_RECIPE_APPLIED
+    "Recipe %ld rejected: empty or invalid",   // LOG_RECIPE_REJECTED
+    "Boot stage %s ready (%ld us)",            // LOG_BOOT_STAGE_DONE
+    "Boot stage %s timed out after %ld ms",    // LOG_BOOT_STAGE_TIMEOUT
+    "Boot stage %s finished late (%ld us)",    // LOG_BOOT_STAGE_LATE
+    "Warm restart: motion resumed %ld us after reset (%ld in a row)", // LOG_WARM_RESUMED
+    "Warm restart: %ld resumes in a row, staying stopped (reset reason %ld)", // LOG_WARM_REFUSED
+    "Trace capture started at disc step %ld",  // LOG_CAPTURE_STARTED
+    "Trace capture stopped at disc step %ld",  // LOG_CAPTURE_STOPPED
+    "Core dump found: task %s, pc 0x%08lx",    // LOG_CRASH_FOUND
+};
+
+static const char LOG_LEVEL_TAGS[] = { '-', 'E', 'W', 'I', 'D' };
+
+DeferredLog::Ring DeferredLog::rings[portNUM_PROCESSORS];
+TaskHandle_t DeferredLog::drainTaskHandle = nullptr;
+
+/*
+ * Slot sequence numbers are stored relative to the slot index so that the
+ * zero-initialized ring is already in its valid empty state: slot i is free
+ * for position p when (stored + i) == p. Records can therefore be written
+ * before begin() runs, e.g. from constructors or early setup().
+ */
+#define SLOT_SEQ(ring, i)         ((ring).slots[i].sequence.load(std::memory_order_acquire) + (i))
+#define SLOT_SET_SEQ(ring, i, v)  (ring).slots[i].sequence.store((v) - (i), std::memory_order_release)
+
+/**
+ * @brief Starts the low-priority task that formats and prints records.
+ */
+void DeferredLog::begin() {
+    if (drainTaskHandle == nullptr) {
+        xTaskCreatePinnedToCore(drainTask, "Log Drain Task", DEFERRED_LOG_TASK_STACK, nullptr,
+                                DEFERRED_LOG_TASK_PRIORITY, &drainTaskHandle, DEFERRED_LOG_TASK_CORE);
+    }
+}
+
+/**
+ * @brief Appends a record to the current core's ring without blocking.
+ *
+ * Safe from any task and from ISRs. If the ring is full the record is
+ * discarded and the ring's dropped counter is incremented.
+ *
+ * @param level Record level (LOG_LEVEL_*).
+ * @param id Message id (LogId).
+ * @param arg0 First format argument.
+ * @param arg1 Second format argument.
+ */
+void DeferredLog::write(uint8_t level, uint16_t id, intptr_t arg0, intptr_t arg1) {
+    Ring& ring = rings[xPortGetCoreID()];
+    uint32_t pos = ring.head.load(std::memory_order_relaxed);
+    uint32_t index;
+
+    while (true) {
+        index = pos & (DEFERRED_LOG_RING_SIZE - 1);
+        int32_t diff = (int32_t)(SLOT_SEQ(ring, index) - pos);
+        if (diff == 0) {
+            if (ring.head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);  // Ring full
+            return;
+        } else {
+            pos = ring.head.load(std::memory_order_relaxed);
+        }
+    }
+
+    LogRecord& record = ring.slots[index].record;
+    record.timestamp = micros();
+    record.id = id;
+    record.level = level;
+    record.core = (uint8_t)xPortGetCoreID();
+    record.args[0] = arg0;
+    record.args[1] = arg1;
+    SLOT_SET_SEQ(ring, index, pos + 1);  // Publish to the drain task
+}
+
+/**
+ * @brief Total number of records dropped because a ring was full.
+ */
+uint32_t DeferredLog::getDropped() {
+    uint32_t total = 0;
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        total += rings[i].dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+/**
+ * @brief Removes the oldest published record from a ring (drain task only).
+ *
+ * @return True if a record was copied into @p record.
+ */
+bool DeferredLog::pop(Ring& ring, LogRecord& record) {
+    uint32_t index = ring.tail & (DEFERRED_LOG_RING_SIZE - 1);
+    if (SLOT_SEQ(ring, index) != ring.tail + 1) return false;  // Empty or still being written
+
+    record = ring.slots[index].record;
+    SLOT_SET_SEQ(ring, index, ring.tail + DEFERRED_LOG_RING_SIZE);  // Hand the slot back
+    ring.tail++;
+    return true;
+}
+
+/**
+ * @brief Formats one record and writes it to Serial.
+ */
+void DeferredLog::print(const LogRecord& record) {
+    char line[DEFERRED_LOG_LINE_SIZE];
+    const char* format = record.id < LOG_ID_COUNT ? LOG_FORMATS[record.id] : "Unknown log id";
+    char level = record.level < sizeof(LOG_LEVEL_TAGS) ? LOG_LEVEL_TAGS[record.level] : '?';
+
+    int len = snprintf(line, sizeof(line), "[%10lu][C%u][%c] ",
+                       (unsigned long)record.timestamp, record.core, level);
+    if (len < 0 || len >= (int)sizeof(line)) return;
+    int body = snprintf(line + len, sizeof(line) - len, format, record.args[0], record.args[1]);
+    if (body > 0) len += body;
+    if (len > (int)sizeof(line) - 2) len = sizeof(line) - 2;
+    line[len++] = '\n';
+    Serial.write((const uint8_t*)line, len);
+}
+
+/**
+ * @brief FreeRTOS task draining every core's ring.
+ *
+ * Prints a notice whenever the dropped counter has moved since the last pass.
+ */
+void DeferredLog::drainTask(void *pvParameters) {
+    uint32_t reportedDropped = 0;
+    LogRecord record;
+    int8_t health = TaskHealth::add("log.drain");
+
+    while (true) {
+        TaskHealth::checkIn(health);
+        for (int i = 0; i < portNUM_PROCESSORS; i++) {
+            while (pop(rings[i], record)) {
+                print(record);
+            }
+        }
+
+        uint32_t dropped = getDropped();
+        if (dropped != reportedDropped) {
+            Serial.printf("[log] %lu records dropped (ring full)\n", (unsigned long)(dropped - reportedDropped));
+            reportedDropped = dropped;
+        }
+
+        vTaskDelay(DEFERRED_LOG_DRAIN_PERIOD_MS / portTICK_PERIOD_MS);
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <Arduino.h>
+#include <FreeRTOS.h>
+#include <atomic>
+#include "Config.h"
+
+/**
+ * @file DeferredLog.h
+ * @brief Deferred binary logging for real-time paths.
+ *
+ * Call sites only copy a small fixed-size record (message id, timestamp,
+ * two pointer-sized arguments) into a lock-free ring owned by the current
+ * core. A low-priority task formats the records and prints them to Serial, so
+ * the motor and command paths never wait on the UART.
+ *
+ * Levels above DEFERRED_LOG_LEVEL compile to nothing. String arguments
+ * must be static strings (literals) and are passed with LOG_STR().
+ */
+
+// Log levels
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+// Message ids, one per format string in DeferredLog.cpp
+enum LogId : uint16_t {
+    LOG_MOTOR_TASK_STARTED = 0,
+    LOG_MOTOR_TASK_STOPPED,
+    LOG_RISING_EDGE,
+    LOG_INVALID_RESOLUTION,
+    LOG_CMD_RECEIVED,
+    LOG_CMD_EXECUTED,
+    LOG_CMD_UNKNOWN,
+    LOG_CMD_JSON_ERROR,
+    LOG_CMD_MISSING_FIELD,
+    LOG_CMD_INVALID_PARAMS,
+    LOG_HMI_BUTTON,
+    LOG_HMI_KEY,
+    LOG_HMI_EVENT,
+    LOG_HMI_ERROR,
+    LOG_HMI_BAUD,
+    LOG_HMI_BAUD_FALLBACK,
+    LOG_HMI_NOT_FOUND,
+    LOG_HMI_HOLD_COMMIT,
+    LOG_RECIPE_APPLIED,
+    LOG_RECIPE_REJECTED,
+    LOG_BOOT_STAGE_DONE,
+    LOG_BOOT_STAGE_TIMEOUT,
+    LOG_BOOT_STAGE_LATE,
+    LOG_WARM_RESUMED,
+    LOG_WARM_REFUSED,
+    LOG_CAPTURE_STARTED,
+    LOG_CAPTURE_STOPPED,
+    LOG_CRASH_FOUND,
+    LOG_ID_COUNT
+};
+
+// Pass a static string as a record argument
+#define LOG_STR(s) ((intptr_t)(s))
+
+#if DEFERRED_LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) DeferredLog::write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if DEFERRED_LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) DeferredLog::write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if DEFERRED_LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) DeferredLog::write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if DEFERRED_LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) DeferredLog::write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+struct LogRecord {
+    uint32_t timestamp;  // micros() at the call site
+    uint16_t id;         // LogId
+    uint8_t  level;      // LOG_LEVEL_*
+    uint8_t  core;       // Core that wrote the record
+    intptr_t args[2];    // Format arguments, wide enough for a LOG_STR() pointer
+};
+
+class DeferredLog {
+public:
+    static void begin();  // Start the drain task
+    static void write(uint8_t level, uint16_t id, intptr_t arg0 = 0, intptr_t arg1 = 0);
+    static uint32_t getDropped();  // Records lost to a full ring (all cores)
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        LogRecord record;
+    };
+
+    // Bounded multi-producer / single-consumer ring (one per core)
+    struct Ring {
+        Slot slots[DEFERRED_LOG_RING_SIZE];
+        std::atomic<uint32_t> head;
+        uint32_t tail;
+        std::atomic<uint32_t> dropped;
+    };
+
+    static bool pop(Ring& ring, LogRecord& record);
+    static void print(const LogRecord& record);
+    static void drainTask(void *pvParameters);
+
+    static Ring rings[portNUM_PROCESSORS];
+    static TaskHandle_t drainTaskHandle;
+};
+
+#endif // DEFERRED_LOG_H
@@ -0,0 +1,515 @@
+#include "EventLogger.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include <esp_vfs_fat.h>
+#include <freertos/queue.h>
+#include "Trace.h"
+#include "TaskHealth.h"
+
+// Names written into the schema text of every file, indexed by EventType
+struct EventTypeInfo {
+    const char* name;
+    const char* value0;
+    const char* value1;
+};
+
+static const EventTypeInfo EVENT_TYPES[EVENT_TYPE_COUNT] = {
+    { "NONE",          "value0",   "value1" },
+    { "SENSOR_EDGE",   "steps",    "intervalUs" },
+    { "DWELL_START",   "steps",    "stopTimeMs" },
+    { "DWELL_END",     "steps",    "dwellUs" },
+    { "SETPOINT",      "freqMilliHz", "direction" },
+    { "SENSOR_PARAMS", "stopTimeMs", "offsetSteps" },
+    { "FAULT",         "fault",    "detail" },
+    { "STEP",          "steps",    "intervalMs" },
+    { "SENSOR_RAW",    "steps",    "level" },
+    { "CAPTURE",       "enabled",  "value1" },
+};
+
+static const char* const EVENT_FAULTS[] = { "", "COMMAND_OVERFLOW", "HMI_ERROR", "BOOT_TIMEOUT", "WARM_REFUSED" };
+
+EventLogger::Ring EventLogger::rings[portNUM_PROCESSORS];
+std::atomic<bool> EventLogger::active(false);
+EventBlock* EventLogger::buffers[2] = { nullptr, nullptr };
+volatile bool EventLogger::bufferBusy[2] = { false, false };
+QueueHandle_t EventLogger::writeQueue = nullptr;
+TaskHandle_t EventLogger::drainTaskHandle = nullptr;
+TaskHandle_t EventLogger::writeTaskHandle = nullptr;
+uint32_t EventLogger::fileNumber = 0;
+uint32_t EventLogger::fileFirstSequence = 0;
+uint32_t EventLogger::fileOpenedMs = 0;
+bool EventLogger::fileContiguous = false;
+bool EventLogger::spareReady = false;
+bool EventLogger::spareNeeded = false;
+bool EventLogger::spareContiguous = false;
+uint32_t EventLogger::recordsLogged = 0;
+uint32_t EventLogger::blocksUsed = 0;
+uint32_t EventLogger::blocksWritten = 0;
+uint32_t EventLogger::writeErrors = 0;
+uint32_t EventLogger::bufferStalls = 0;
+uint32_t EventLogger::maxWriteUs = 0;
+uint32_t EventLogger::maxRotateUs = 0;
+uint32_t EventLogger::filesOpened = 0;
+uint32_t EventLogger::filesReused = 0;
+uint32_t EventLogger::fragmentedFiles = 0;
+
+static File logFile;  // Used by the writer task only (and begin())
+static char fileHeader[EVENT_LOG_HEADER_SIZE];
+
+// Data blocks per file, the first block holds the file header
+#define EVENT_FILE_BLOCKS (EVENT_LOG_FILE_SIZE / EVENT_LOG_BUFFER_SIZE - 1)
+
+// Slot sequence numbers relative to the slot index, see DeferredLog.cpp
+#define SLOT_SEQ(ring, i)         ((ring).slots[i].sequence.load(std::memory_order_acquire) + (i))
+#define SLOT_SET_SEQ(ring, i, v)  (ring).slots[i].sequence.store((v) - (i), std::memory_order_release)
+
+/**
+ * @brief Opens the first log file and starts the drain and writer tasks.
+ *
+ * Every boot starts a new file. Blocks while the file and the spare for
+ * the next rotation are allocated; call from the SD boot stage.
+ *
+ * @return False if the file or the buffers cannot be set up.
+ */
+bool EventLogger::begin() {
+    if (drainTaskHandle != nullptr) return true;
+
+    if (!SD.exists(EVENT_LOG_DIR)) SD.mkdir(EVENT_LOG_DIR);
+    uint32_t oldest, newest;
+    uint16_t count;
+    scanFiles(oldest, newest, count);
+    fileNumber = count ? newest : 0;
+    if (!openFile(0)) return false;
+    prepareSpare();  // For the first rotation
+
+    for (uint8_t i = 0; i < 2; i++) {
+        buffers[i] = (EventBlock*)heap_caps_malloc(sizeof(EventBlock), MALLOC_CAP_DMA);
+        if (buffers[i] == nullptr) {
+            heap_caps_free(buffers[0]);
+            buffers[0] = nullptr;
+            logFile.close();
+            return false;
+        }
+    }
+
+    writeQueue = xQueueCreate(2, sizeof(uint8_t));
+    xTaskCreatePinnedToCore(writeTask, "Event Write Task", EVENT_LOG_TASK_STACK, nullptr,
+                            EVENT_LOG_TASK_PRIORITY, &writeTaskHandle, EVENT_LOG_TASK_CORE);
+    xTaskCreatePinnedToCore(drainTask, "Event Drain Task", EVENT_LOG_TASK_STACK, nullptr,
+                            EVENT_LOG_TASK_PRIORITY, &drainTaskHandle, EVENT_LOG_TASK_CORE);
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Appends an event to the current core's ring without blocking.
+ *
+ * Safe from any task and from ISRs. Does nothing until begin() succeeded;
+ * a full ring drops the record and counts it.
+ */
+void EventLogger::record(EventType type, uint8_t source, int32_t value0, int32_t value1) {
+    if (!active.load(std::memory_order_relaxed)) return;
+
+    Ring& ring = rings[xPortGetCoreID()];
+    uint32_t pos = ring.head.load(std::memory_order_relaxed);
+    uint32_t index;
+
+    while (true) {
+        index = pos & (EVENT_LOG_RING_SIZE - 1);
+        int32_t diff = (int32_t)(SLOT_SEQ(ring, index) - pos);
+        if (diff == 0) {
+            if (ring.head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);  // Ring full
+            return;
+        } else {
+            pos = ring.head.load(std::memory_order_relaxed);
+        }
+    }
+
+    EventRecord& event = ring.slots[index].record;
+    event.timestamp = micros();
+    event.type = type;
+    event.source = source;
+    event.reserved = 0;
+    event.values[0] = value0;
+    event.values[1] = value1;
+    SLOT_SET_SEQ(ring, index, pos + 1);  // Publish to the drain task
+}
+
+/**
+ * @brief True once begin() succeeded, i.e. records reach the card.
+ */
+bool EventLogger::isActive() {
+    return active.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Removes the oldest published record from a ring (drain task only).
+ */
+bool EventLogger::pop(Ring& ring, EventRecord& record) {
+    uint32_t index = ring.tail & (EVENT_LOG_RING_SIZE - 1);
+    if (SLOT_SEQ(ring, index) != ring.tail + 1) return false;  // Empty or still being written
+
+    record = ring.slots[index].record;
+    SLOT_SET_SEQ(ring, index, ring.tail + EVENT_LOG_RING_SIZE);  // Hand the slot back
+    ring.tail++;
+    return true;
+}
+
+uint32_t EventLogger::getDropped() {
+    uint32_t total = 0;
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        total += rings[i].dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void EventLogger::startBlock(EventBlock* block, uint32_t sequence) {
+    block->header.magic = EVENT_BLOCK_MAGIC;
+    block->header.sequence = sequence;
+    block->header.count = 0;
+    block->header.recordSize = sizeof(EventRecord);
+    block->header.dropped = 0;
+    block->header.uptimeMs = 0;
+    block->header.fileNumber = 0;
+    memset(block->header.reserved, 0, sizeof(block->header.reserved));
+}
+
+/**
+ * @brief Moves records from the rings into the fill buffer and hands
+ *        buffers to the writer task.
+ *
+ * A full block goes to the writer and the next block starts in the other
+ * buffer. A partial block older than EVENT_LOG_FLUSH_MS is also written;
+ * its records are first copied to the other buffer, which keeps filling
+ * the same block, so the block is simply rewritten once it has grown.
+ */
+void EventLogger::drainTask(void *pvParameters) {
+    uint8_t fill = 0;
+    startBlock(buffers[fill], blocksUsed++);
+    uint32_t lastSubmitMs = millis();
+    uint16_t submittedCount = 0;  // Records of the current block already handed over
+    EventRecord record;
+    int8_t health = TaskHealth::add("event.drain");
+
+    while (true) {
+        TaskHealth::checkIn(health);
+        EventBlock* block = buffers[fill];
+        bool moved = true;
+        while (moved && block->header.count < EVENT_BLOCK_RECORDS) {
+            moved = false;
+            for (int i = 0; i < portNUM_PROCESSORS && block->header.count < EVENT_BLOCK_RECORDS; i++) {
+                if (pop(rings[i], record)) {
+                    block->records[block->header.count++] = record;
+                    recordsLogged++;
+                    moved = true;
+                }
+            }
+        }
+
+        bool full = block->header.count == EVENT_BLOCK_RECORDS;
+        bool flush = block->header.count > submittedCount && millis() - lastSubmitMs >= EVENT_LOG_FLUSH_MS;
+        if (full || flush) {
+            uint8_t other = fill ^ 1;
+            if (bufferBusy[other]) {
+                if (full) bufferStalls++;  // Producers now only have the rings
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(EVENT_LOG_DRAIN_PERIOD_MS));
+                continue;
+            }
+
+            if (full) {
+                startBlock(buffers[other], blocksUsed++);
+            } else {
+                memcpy(buffers[other], block, sizeof(EventBlockHeader) + block->header.count * sizeof(EventRecord));
+            }
+
+            block->header.dropped = getDropped();
+            block->header.uptimeMs = millis();
+            bufferBusy[fill] = true;
+            xQueueSend(writeQueue, &fill, portMAX_DELAY);
+            submittedCount = full ? 0 : block->header.count;
+            fill = other;
+            lastSubmitMs = millis();
+
+            if (full) continue;  // More records may be waiting
+        }
+        vTaskDelay(pdMS_TO_TICKS(EVENT_LOG_DRAIN_PERIOD_MS));
+    }
+}
+
+/**
+ * @brief Writes each handed-over buffer at its block offset.
+ *
+ * Before the first write of a new block, the writer moves to the next
+ * file if the current one is full or older than EVENT_LOG_ROTATE_MS.
+ * Rewrites of a partial block always go to the file that holds it. After
+ * a rotation the spare for the next one is allocated once the queue is
+ * empty.
+ */
+void EventLogger::writeTask(void *pvParameters) {
+    uint32_t lastSequence = UINT32_MAX;
+    uint8_t index;
+    int8_t health = TaskHealth::add("event.write");
+    while (true) {
+        TaskHealth::checkIn(health);
+        if (xQueueReceive(writeQueue, &index, pdMS_TO_TICKS(TASK_IDLE_WAKE_MS)) != pdTRUE) continue;
+        EventBlock* block = buffers[index];
+        uint32_t sequence = block->header.sequence;
+        bool ok = true;
+
+        if (sequence != lastSequence) {
+            bool full = sequence - fileFirstSequence >= EVENT_FILE_BLOCKS;
+            bool old = millis() - fileOpenedMs >= EVENT_LOG_ROTATE_MS;
+            if (!logFile || full || old) {
+                TRACE_SCOPE("sd.rotate", sequence);
+                uint32_t start = micros();
+                ok = openFile(sequence);
+                uint32_t elapsed = micros() - start;
+                if (elapsed > maxRotateUs) maxRotateUs = elapsed;
+            }
+            lastSequence = sequence;
+        }
+
+        TRACE_SCOPE("sd.block", block->header.count);
+        uint32_t start = micros();
+        if (ok) {
+            block->header.fileNumber = fileNumber;
+            ok = logFile.seek((sequence - fileFirstSequence + 1) * EVENT_LOG_BUFFER_SIZE)
+              && logFile.write((const uint8_t*)block, EVENT_LOG_BUFFER_SIZE) == EVENT_LOG_BUFFER_SIZE;
+            logFile.flush();
+        }
+        uint32_t elapsed = micros() - start;
+
+        if (ok) blocksWritten++; else writeErrors++;
+        if (elapsed > maxWriteUs) maxWriteUs = elapsed;
+        bufferBusy[index] = false;
+        if (drainTaskHandle != nullptr) xTaskNotifyGive(drainTaskHandle);
+
+        // Allocate the next file while no buffer is waiting, not at rotation
+        if (spareNeeded && uxQueueMessagesWaiting(writeQueue) == 0) prepareSpare();
+    }
+}
+
+/**
+ * @brief Closes the current file and starts the next one at @p firstSequence.
+ *
+ * The next file is the spare allocated ahead by prepareSpare(), so this
+ * is only a rename and an open. If no spare is ready (its preparation
+ * failed), one is prepared here first.
+ */
+bool EventLogger::openFile(uint32_t firstSequence) {
+    if (logFile) logFile.close();
+    if (!spareReady && !prepareSpare()) return false;
+
+    uint32_t number = fileNumber + 1;
+    char path[32];
+    filePath(number, path);
+    spareReady = false;
+    spareNeeded = true;
+    if (!SD.rename(EVENT_LOG_SPARE_FILE, path)) {
+        SD.remove(EVENT_LOG_SPARE_FILE);
+        return false;
+    }
+    logFile = SD.open(path, "r+");  // Keep the clusters, "w" would free them
+    if (!logFile) return false;
+
+    fileNumber = number;
+    fileContiguous = spareContiguous;
+    fileFirstSequence = firstSequence;
+    fileOpenedMs = millis();
+    filesOpened++;
+
+    // Header and schema; the rest of the first block is unused
+    memset(fileHeader, 0, sizeof(fileHeader));
+    EventFileHeader* header = (EventFileHeader*)fileHeader;
+    memcpy(header->magic, EVENT_FILE_MAGIC, sizeof(header->magic));
+    header->version = EVENT_FILE_VERSION;
+    header->blockSize = EVENT_LOG_BUFFER_SIZE;
+    header->fileSize = EVENT_LOG_FILE_SIZE;
+    header->fileNumber = fileNumber;
+    header->firstSequence = firstSequence;
+    header->openedMs = fileOpenedMs;
+    header->contiguous = fileContiguous;
+    header->schemaLength = buildSchema(fileHeader + sizeof(EventFileHeader),
+                                       sizeof(fileHeader) - sizeof(EventFileHeader));
+
+    bool ok = logFile.seek(0) && logFile.write((const uint8_t*)fileHeader, sizeof(fileHeader)) == sizeof(fileHeader);
+    logFile.flush();
+    return ok;
+}
+
+/**
+ * @brief Allocates the file the next rotation switches to (EVENT_LOG_SPARE_FILE).
+ *
+ * A spare left by the previous run is kept. With EVENT_LOG_MAX_FILES files
+ * present, or less than EVENT_LOG_FILE_SIZE free on the card, the oldest
+ * file becomes the spare and is later overwritten in place, which keeps
+ * its clusters. Otherwise a new file is created as one contiguous run; if
+ * the card has no run that long, it is extended by seeking (fragmented)
+ * instead. A file that could not be fully allocated is removed again.
+ *
+ * @return False if no spare could be prepared.
+ */
+bool EventLogger::prepareSpare() {
+    TRACE_SCOPE("sd.spare");
+    spareNeeded = false;
+    if (spareReady) return true;
+    if (SD.exists(EVENT_LOG_SPARE_FILE) && checkSpare()) return spareReady = true;
+
+    uint32_t oldest, newest;
+    uint16_t count;
+    scanFiles(oldest, newest, count);
+    bool lowSpace = SD.totalBytes() - SD.usedBytes() < EVENT_LOG_FILE_SIZE;
+    if ((count >= EVENT_LOG_MAX_FILES || lowSpace) && count > 0 && oldest != fileNumber) {
+        char oldPath[32];
+        filePath(oldest, oldPath);
+        if (SD.rename(oldPath, EVENT_LOG_SPARE_FILE) && checkSpare()) {
+            filesReused++;
+            return spareReady = true;
+        }
+    }
+    if (lowSpace) return false;
+
+    // The contiguous file API needs IDF 5.1 (Arduino-ESP32 3.x); before
+    // that files are only preallocated by seeking and not reported contiguous
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    char fullPath[40];
+    snprintf(fullPath, sizeof(fullPath), EVENT_LOG_MOUNT "%s", EVENT_LOG_SPARE_FILE);
+    if (esp_vfs_fat_create_contiguous_file(EVENT_LOG_MOUNT, fullPath, EVENT_LOG_FILE_SIZE, true) == ESP_OK) {
+        spareContiguous = true;
+        return spareReady = true;
+    }
+    SD.remove(EVENT_LOG_SPARE_FILE);  // No contiguous run, drop what was allocated
+#endif
+    File spare = SD.open(EVENT_LOG_SPARE_FILE, FILE_WRITE);
+    bool whole = spare && spare.seek(EVENT_LOG_FILE_SIZE - 1) && spare.write((uint8_t)0) == 1;
+    if (spare) spare.close();
+    if (!whole) {
+        SD.remove(EVENT_LOG_SPARE_FILE);  // Card full: no stub left per attempt
+        return false;
+    }
+    fragmentedFiles++;
+    spareContiguous = false;
+    return spareReady = true;
+}
+
+/**
+ * @brief Checks that the spare has the full size and whether it is contiguous.
+ *
+ * A spare of another size (old build, interrupted allocation) is removed.
+ */
+bool EventLogger::checkSpare() {
+    File spare = SD.open(EVENT_LOG_SPARE_FILE, FILE_READ);
+    bool whole = spare && spare.size() == EVENT_LOG_FILE_SIZE;
+    if (spare) spare.close();
+    if (!whole) {
+        SD.remove(EVENT_LOG_SPARE_FILE);
+        return false;
+    }
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    char fullPath[40];
+    snprintf(fullPath, sizeof(fullPath), EVENT_LOG_MOUNT "%s", EVENT_LOG_SPARE_FILE);
+    bool contiguous = false;
+    spareContiguous = esp_vfs_fat_test_contiguous_file(EVENT_LOG_MOUNT, fullPath, &contiguous) == ESP_OK
+                      && contiguous;
+#else
+    spareContiguous = false;
+#endif
+    return true;
+}
+
+/**
+ * @brief Finds the log files in EVENT_LOG_DIR.
+ *
+ * @return False if the directory cannot be read.
+ */
+bool EventLogger::scanFiles(uint32_t& oldest, uint32_t& newest, uint16_t& count) {
+    oldest = UINT32_MAX;
+    newest = 0;
+    count = 0;
+
+    File dir = SD.open(EVENT_LOG_DIR);
+    if (!dir) return false;
+    while (true) {
+        File entry = dir.openNextFile();
+        if (!entry) break;
+        const char* name = strrchr(entry.name(), '/');
+        name = name ? name + 1 : entry.name();
+        unsigned long number;
+        char extension[4];
+        if (!entry.isDirectory() && sscanf(name, "ev%6lu.%3s", &number, extension) == 2
+            && strcmp(extension, "bin") == 0) {
+            if (number < oldest) oldest = number;
+            if (number > newest) newest = number;
+            count++;
+        }
+        entry.close();
+    }
+    dir.close();
+    return true;
+}
+
+void EventLogger::filePath(uint32_t number, char* path) {
+    sprintf(path, EVENT_LOG_DIR "/ev%06lu.bin", (unsigned long)number);
+}
+
+/**
+ * @brief Writes the record schema as text, one item per line:
+ *
+ *   record <size>
+ *   field <name> <u8|u16|u32|i32> <offset>
+ *   type <id> <NAME> <value0 name> <value1 name>
+ *   source <id> <name>
+ *   fault <id> <NAME>
+ *
+ * @return Length of the text.
+ */
+size_t EventLogger::buildSchema(char* text, size_t size) {
+    size_t len = 0;
+    auto add = [&](const char* format, auto... args) {
+        int n = snprintf(text + len, size - len, format, args...);
+        if (n > 0) len = min(len + n, size - 1);
+    };
+
+    add("record %u\n", (unsigned)sizeof(EventRecord));
+    add("field timestamp u32 %u\n", (unsigned)offsetof(EventRecord, timestamp));
+    add("field type u8 %u\n", (unsigned)offsetof(EventRecord, type));
+    add("field source u8 %u\n", (unsigned)offsetof(EventRecord, source));
+    add("field value0 i32 %u\n", (unsigned)offsetof(EventRecord, values));
+    add("field value1 i32 %u\n", (unsigned)(offsetof(EventRecord, values) + sizeof(int32_t)));
+    for (uint8_t id = 1; id < EVENT_TYPE_COUNT; id++) {
+        add("type %u %s %s %s\n", id, EVENT_TYPES[id].name, EVENT_TYPES[id].value0, EVENT_TYPES[id].value1);
+    }
+    add("source %u case\n", EVENT_SOURCE_CASE);
+    add("source %u disc\n", EVENT_SOURCE_DISC);
+    add("source %u system\n", EVENT_SOURCE_SYSTEM);
+    for (uint8_t id = 1; id < sizeof(EVENT_FAULTS) / sizeof(EVENT_FAULTS[0]); id++) {
+        add("fault %u %s\n", id, EVENT_FAULTS[id]);
+    }
+    return len;
+}
+
+/**
+ * @brief Adds the logger state and counters to @p doc.
+ */
+void EventLogger::report(JsonDocument& doc) {
+    doc["active"] = active.load(std::memory_order_relaxed);
+    doc["file"] = fileNumber;
+    doc["fileSize"] = EVENT_LOG_FILE_SIZE;
+    doc["contiguous"] = fileContiguous;
+    doc["fileBlocksUsed"] = blocksUsed - fileFirstSequence;
+    doc["filesOpened"] = filesOpened;
+    doc["filesReused"] = filesReused;
+    doc["fragmentedFiles"] = fragmentedFiles;
+    doc["spareReady"] = spareReady;
+    doc["blocksUsed"] = blocksUsed;
+    doc["blocksWritten"] = blocksWritten;
+    doc["records"] = recordsLogged;
+    doc["dropped"] = getDropped();
+    doc["stalls"] = bufferStalls;
+    doc["writeErrors"] = writeErrors;
+    doc["maxWriteUs"] = maxWriteUs;
+    doc["maxRotateUs"] = maxRotateUs;
+}
@@ -0,0 +1,186 @@
+#ifndef EVENT_LOGGER_H
+#define EVENT_LOGGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FreeRTOS.h>
+#include <atomic>
+#include "Config.h"
+
+/**
+ * @file EventLogger.h
+ * @brief High-rate binary event log on the SD card.
+ *
+ * Producers (motor task, command and HMI paths, ISRs) call record(), which
+ * copies a 16-byte timestamped record into a lock-free ring of the current
+ * core and never blocks; a full ring drops the record and counts it.
+ *
+ * A drain task on the non-motor core moves records into one of two
+ * sector-multiple buffers. A full buffer (or a partial one every
+ * EVENT_LOG_FLUSH_MS) is handed to the writer task, which writes it as one
+ * block while the drain task fills the other buffer.
+ *
+ * Files: EVENT_LOG_DIR/evNNNNNN.bin, all EVENT_LOG_FILE_SIZE and allocated
+ * as one contiguous cluster run when created. The writer moves to a new
+ * file when the current one is full or older than EVENT_LOG_ROTATE_MS.
+ * The next file is allocated ahead as EVENT_LOG_SPARE_FILE (at boot, then
+ * after each rotation while the writer is idle), so a rotation is only a
+ * rename. Once EVENT_LOG_MAX_FILES exist, or the card has less than a
+ * file free, the oldest becomes the spare and is overwritten, so FAT
+ * never allocates clusters while logging.
+ *
+ * File layout (decoded by app/EventLogDecode.cpp):
+ * - Offset 0: EventFileHeader followed by `schemaLength` bytes of text
+ *   describing the record fields, event types and sources.
+ * - Offset n * EVENT_LOG_BUFFER_SIZE (n >= 1): data block with sequence
+ *   firstSequence + n - 1, an EventBlockHeader followed by `count`
+ *   EventRecords. A partial block is rewritten in place as it fills. The
+ *   data ends at the first block whose magic, file number or sequence does
+ *   not match (a reused file still holds older blocks after that point).
+ */
+
+enum EventType : uint8_t {
+    EVENT_NONE = 0,
+    EVENT_SENSOR_EDGE,    // value0 = step count, value1 = time since the previous edge (us)
+    EVENT_DWELL_START,    // value0 = step count, value1 = stop time (ms)
+    EVENT_DWELL_END,      // value0 = step count, value1 = measured dwell (us)
+    EVENT_SETPOINT,       // value0 = step frequency (mHz), value1 = direction
+    EVENT_SENSOR_PARAMS,  // value0 = stop time (ms), value1 = steps taken after an edge
+    EVENT_FAULT,          // value0 = EventFault, value1 = detail
+    EVENT_STEP,           // Capture only: value0 = step count, value1 = step interval (ms)
+    EVENT_SENSOR_RAW,     // Capture only, from the sensor ISR: value0 = disc step count, value1 = level
+    EVENT_CAPTURE,        // value0 = 1 capture started, 0 stopped
+    EVENT_TYPE_COUNT
+};
+
+enum EventFault : int32_t {
+    FAULT_COMMAND_OVERFLOW = 1,  // Command line too long or no free slot; detail = lines dropped
+    FAULT_HMI_ERROR,             // Display returned an error code; detail = code
+    FAULT_BOOT_TIMEOUT,          // Boot stage timed out; detail = timeout (ms)
+    FAULT_WARM_REFUSED,          // Too many warm resumes in a row; detail = reset reason
+};
+
+// EventRecord::source
+#define EVENT_SOURCE_CASE    0
+#define EVENT_SOURCE_DISC    1
+#define EVENT_SOURCE_SYSTEM  0xFF
+
+struct EventRecord {
+    uint32_t timestamp;   // micros() at the call site
+    uint8_t type;         // EventType
+    uint8_t source;       // EVENT_SOURCE_*
+    uint16_t reserved;
+    int32_t values[2];
+};
+
+struct EventBlockHeader {
+    uint32_t magic;       // EVENT_BLOCK_MAGIC
+    uint32_t sequence;    // Block number since start, continues across files
+    uint16_t count;       // Valid records in this block
+    uint16_t recordSize;  // sizeof(EventRecord)
+    uint32_t dropped;     // Records dropped since start, as of this block
+    uint32_t uptimeMs;    // millis() when the block was handed over, extends the 32-bit timestamps
+    uint32_t fileNumber;  // File the block was written to; stale blocks of a reused file differ
+    uint32_t reserved[2];
+};
+
+struct EventFileHeader {
+    char magic[8];        // EVENT_FILE_MAGIC
+    uint16_t version;     // EVENT_FILE_VERSION
+    uint16_t schemaLength;  // Bytes of schema text following this header
+    uint32_t blockSize;   // EVENT_LOG_BUFFER_SIZE
+    uint32_t fileSize;    // EVENT_LOG_FILE_SIZE
+    uint32_t fileNumber;  // NNNNNN of the file name
+    uint32_t firstSequence;  // Sequence of the block at offset blockSize
+    uint32_t openedMs;    // millis() when the file was started
+    uint8_t contiguous;   // Clusters form one run
+    uint8_t reserved[15];
+};
+
+#define EVENT_FILE_MAGIC     "EVTLOG\r\n"
+#define EVENT_FILE_VERSION   1
+#define EVENT_BLOCK_MAGIC    0x4B4C5645  // "EVLK"
+#define EVENT_BLOCK_RECORDS  ((EVENT_LOG_BUFFER_SIZE - sizeof(EventBlockHeader)) / sizeof(EventRecord))
+
+struct EventBlock {
+    EventBlockHeader header;
+    EventRecord records[EVENT_BLOCK_RECORDS];
+};
+
+static_assert(sizeof(EventRecord) == 16, "Log records must stay 16 bytes");
+static_assert(sizeof(EventBlockHeader) % sizeof(EventRecord) == 0, "Block header must be whole records");
+static_assert(sizeof(EventFileHeader) == 48, "EventFileHeader layout is part of the file format");
+static_assert(sizeof(EventBlock) == EVENT_LOG_BUFFER_SIZE, "EventBlock must fill the buffer exactly");
+static_assert(EVENT_LOG_BUFFER_SIZE % EVENT_LOG_SECTOR_SIZE == 0, "Buffers must be whole sectors");
+static_assert(EVENT_LOG_FILE_SIZE % EVENT_LOG_BUFFER_SIZE == 0, "Files must be whole blocks");
+static_assert(EVENT_LOG_HEADER_SIZE % EVENT_LOG_SECTOR_SIZE == 0 && EVENT_LOG_HEADER_SIZE <= EVENT_LOG_BUFFER_SIZE,
+              "File header area must be whole sectors within the first block");
+
+class EventLogger {
+public:
+    static bool begin();   // Open the first file and start the tasks (SD card ready)
+    static void record(EventType type, uint8_t source, int32_t value0 = 0, int32_t value1 = 0);
+    static void report(JsonDocument& doc);  // EVENTSTATS
+    static bool isActive();
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        EventRecord record;
+    };
+
+    // Bounded multi-producer / single-consumer ring (one per core), as in DeferredLog
+    struct Ring {
+        Slot slots[EVENT_LOG_RING_SIZE];
+        std::atomic<uint32_t> head;
+        uint32_t tail;
+        std::atomic<uint32_t> dropped;
+    };
+
+    static bool pop(Ring& ring, EventRecord& record);
+    static uint32_t getDropped();
+    static void drainTask(void *pvParameters);
+    static void writeTask(void *pvParameters);
+    static void startBlock(EventBlock* block, uint32_t sequence);
+
+    // Files (writer task)
+    static bool openFile(uint32_t firstSequence);   // Switch to the spare
+    static bool prepareSpare();                     // Allocate the next file ahead
+    static bool checkSpare();                       // Full size; sets spareContiguous
+    static bool scanFiles(uint32_t& oldest, uint32_t& newest, uint16_t& count);
+    static void filePath(uint32_t number, char* path);
+    static size_t buildSchema(char* text, size_t size);
+
+    static Ring rings[portNUM_PROCESSORS];
+    static std::atomic<bool> active;      // Records are accepted
+    static EventBlock* buffers[2];
+    static volatile bool bufferBusy[2];   // Owned by the writer task
+    static QueueHandle_t writeQueue;      // Buffer indexes to write
+    static TaskHandle_t drainTaskHandle;
+    static TaskHandle_t writeTaskHandle;
+
+    // Current file (writer task)
+    static uint32_t fileNumber;
+    static uint32_t fileFirstSequence;
+    static uint32_t fileOpenedMs;
+    static bool fileContiguous;
+
+    // Next file, allocated ahead (writer task)
+    static bool spareReady;
+    static bool spareNeeded;              // Rotation used the spare, prepare another
+    static bool spareContiguous;
+
+    // Statistics
+    static uint32_t recordsLogged;        // Copied into a buffer
+    static uint32_t blocksUsed;           // Blocks started so far
+    static uint32_t blocksWritten;        // Block writes, including partial rewrites
+    static uint32_t writeErrors;
+    static uint32_t bufferStalls;         // Drain found both buffers busy
+    static uint32_t maxWriteUs;
+    static uint32_t maxRotateUs;          // Longest switch to the next file
+    static uint32_t filesOpened;
+    static uint32_t filesReused;
+    static uint32_t fragmentedFiles;      // Created without a contiguous run
+};
+
+#endif // EVENT_LOGGER_H
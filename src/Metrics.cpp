@@ -0,0 +1,193 @@
+#include "Metrics.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+static_assert(METRICS_HISTOGRAM_SUB_BUCKETS == (1 << METRICS_HISTOGRAM_SUB_BITS),
+              "Sub-buckets must be a power of two");
+
+static const char* const METRIC_TYPE_GROUPS[] = { "counters", "gauges", "histograms" };
+
+Metric* Metrics::head = nullptr;
+portMUX_TYPE Metrics::lock = portMUX_INITIALIZER_UNLOCKED;
+Metrics::TaskTime Metrics::lastTaskTimes[METRICS_MAX_TASKS];
+uint8_t Metrics::lastTaskCount = 0;
+int64_t Metrics::lastReportUs = 0;
+
+/**
+ * @brief Registers the metric; runs during static initialization or boot.
+ */
+Metric::Metric(const char* name, const char* unit, MetricType type)
+    : name(name), unit(unit), type(type), next(nullptr) {
+    Metrics::add(this);
+}
+
+MetricCounter::MetricCounter(const char* name, const char* unit)
+    : Metric(name, unit, METRIC_COUNTER), value(0) {}
+
+MetricGauge::MetricGauge(const char* name, const char* unit, Reader reader)
+    : Metric(name, unit, METRIC_GAUGE), value(0), reader(reader) {}
+
+MetricHistogram::MetricHistogram(const char* name, const char* unit)
+    : Metric(name, unit, METRIC_HISTOGRAM), max(0) {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+}
+
+uint32_t MetricHistogram::bucketValue(uint16_t index) {
+    if (index < 2 * METRICS_HISTOGRAM_SUB_BUCKETS) return index;
+    uint8_t shift = index / METRICS_HISTOGRAM_SUB_BUCKETS - 1;
+    return (uint32_t)(index % METRICS_HISTOGRAM_SUB_BUCKETS + METRICS_HISTOGRAM_SUB_BUCKETS) << shift;
+}
+
+/**
+ * @brief Writes count, max, mean and percentiles to @p out.
+ *
+ * Percentiles and the mean come from the buckets (lower bound and
+ * midpoint), so they are as precise as the bucket width. Records that
+ * arrive while the buckets are read may be counted or not.
+ */
+void MetricHistogram::report(JsonObject out) {
+    static const float PERCENTILES[] = { 0.5f, 0.9f, 0.99f, 0.999f };
+    static const char* const PERCENTILE_NAMES[] = { "p50", "p90", "p99", "p999" };
+
+    uint32_t snapshot[METRICS_HISTOGRAM_BUCKETS];
+    uint32_t total = 0;
+    uint64_t sum = 0;
+    for (uint16_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+        total += snapshot[i];
+        uint32_t low = bucketValue(i);
+        uint32_t high = i + 1 < METRICS_HISTOGRAM_BUCKETS ? bucketValue(i + 1) : UINT32_MAX;
+        sum += (uint64_t)snapshot[i] * (low + (high - low) / 2);
+    }
+
+    out["count"] = total;
+    out["max"] = max.load(std::memory_order_relaxed);
+    if (total == 0) return;
+    out["mean"] = (uint32_t)(sum / total);
+
+    uint8_t next = 0;
+    uint32_t seen = 0;
+    for (uint16_t i = 0; i < METRICS_HISTOGRAM_BUCKETS && next < 4; i++) {
+        if (snapshot[i] == 0) continue;
+        if (seen == 0) out["min"] = bucketValue(i);
+        seen += snapshot[i];
+        while (next < 4 && seen > (uint32_t)(PERCENTILES[next] * total)) {
+            out[PERCENTILE_NAMES[next++]] = bucketValue(i);
+        }
+    }
+}
+
+void MetricHistogram::reset() {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+void Metrics::add(Metric* metric) {
+    portENTER_CRITICAL(&lock);
+    metric->next = head;
+    head = metric;
+    portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @brief Adds every registered metric plus the heap and task collectors to @p doc.
+ */
+void Metrics::report(JsonDocument& doc) {
+    doc["uptimeMs"] = millis();
+
+    for (Metric* metric = head; metric != nullptr; metric = metric->next) {
+        JsonObject item = doc[METRIC_TYPE_GROUPS[metric->type]][metric->name].to<JsonObject>();
+        item["unit"] = metric->unit;
+        switch (metric->type) {
+            case METRIC_COUNTER:
+                item["value"] = static_cast<MetricCounter*>(metric)->get();
+                break;
+            case METRIC_GAUGE:
+                item["value"] = static_cast<MetricGauge*>(metric)->get();
+                break;
+            case METRIC_HISTOGRAM:
+                static_cast<MetricHistogram*>(metric)->report(item);
+                break;
+        }
+    }
+
+    reportHeap(doc);
+    reportTasks(doc);
+}
+
+void Metrics::reset() {
+    for (Metric* metric = head; metric != nullptr; metric = metric->next) {
+        if (metric->type == METRIC_COUNTER) static_cast<MetricCounter*>(metric)->reset();
+        else if (metric->type == METRIC_HISTOGRAM) static_cast<MetricHistogram*>(metric)->reset();
+    }
+}
+
+/**
+ * @brief Free memory and how fragmented it is.
+ *
+ * "fragmentation" is the share of free memory not in the largest block,
+ * i.e. 0 when any free byte could be part of one allocation.
+ */
+void Metrics::reportHeap(JsonDocument& doc) {
+    JsonObject heap = doc["heap"].to<JsonObject>();
+    size_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    heap["free"] = freeBytes;
+    heap["largestFreeBlock"] = largest;
+    heap["minFree"] = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    heap["fragmentation"] = freeBytes ? 100 - (uint32_t)((uint64_t)largest * 100 / freeBytes) : 0;
+    heap["internalFree"] = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    heap["internalLargestFreeBlock"] = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+}
+
+/**
+ * @brief One entry per FreeRTOS task.
+ *
+ * "stackFree" is the least free stack the task ever had (bytes on
+ * ESP-IDF); a task close to 0 is about to overflow. "cpu" is the share of
+ * one core the task used since the previous report (run-time counter in
+ * esp_timer microseconds), absent on the first report.
+ */
+void Metrics::reportTasks(JsonDocument& doc) {
+#if configUSE_TRACE_FACILITY
+    static const char* const TASK_STATES[] = { "running", "ready", "blocked", "suspended", "deleted", "invalid" };
+
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 2;  // Room for tasks created meanwhile
+    TaskStatus_t* tasks = (TaskStatus_t*)malloc(capacity * sizeof(TaskStatus_t));
+    if (tasks == nullptr) return;
+    uint32_t totalRunTime = 0;
+    UBaseType_t count = uxTaskGetSystemState(tasks, capacity, &totalRunTime);
+    int64_t nowUs = esp_timer_get_time();
+    int64_t elapsedUs = lastReportUs ? nowUs - lastReportUs : 0;
+
+    JsonArray list = doc["tasks"].to<JsonArray>();
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t& task = tasks[i];
+        JsonObject item = list.add<JsonObject>();
+        item["name"] = (char*)task.pcTaskName;   // Copied: the task may be gone before serialization
+        item["state"] = TASK_STATES[task.eCurrentState <= eInvalid ? task.eCurrentState : eInvalid];
+        item["priority"] = task.uxCurrentPriority;
+        item["stackFree"] = task.usStackHighWaterMark;
+#if configTASKLIST_INCLUDE_COREID
+        if (task.xCoreID != tskNO_AFFINITY) item["core"] = task.xCoreID;
+#endif
+#if configGENERATE_RUN_TIME_STATS
+        for (uint8_t j = 0; j < lastTaskCount && elapsedUs > 0; j++) {
+            if (lastTaskTimes[j].number != task.xTaskNumber) continue;
+            uint32_t used = task.ulRunTimeCounter - lastTaskTimes[j].runTime;
+            item["cpu"] = (uint32_t)((uint64_t)used * 1000 / elapsedUs) / 10.0f;  // One decimal
+            break;
+        }
+#endif
+    }
+
+#if configGENERATE_RUN_TIME_STATS
+    lastTaskCount = 0;
+    for (UBaseType_t i = 0; i < count && lastTaskCount < METRICS_MAX_TASKS; i++) {
+        lastTaskTimes[lastTaskCount++] = { tasks[i].xTaskNumber, tasks[i].ulRunTimeCounter };
+    }
+    lastReportUs = nowUs;
+#endif
+    free(tasks);
+#endif
+}
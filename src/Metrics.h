@@ -0,0 +1,133 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FreeRTOS.h>
+#include <atomic>
+#include "Config.h"
+
+/**
+ * @file Metrics.h
+ * @brief Runtime metrics registry reported by GETMETRICS.
+ *
+ * Metrics are declared as static objects next to the code they measure
+ * and add themselves to the registry when constructed:
+ *
+ *   static MetricHistogram commandLatency("command.latency", "us");
+ *   ...
+ *   commandLatency.record(micros() - start);
+ *
+ * Recording is a relaxed atomic update with no lock, so it is safe from
+ * any task or ISR on either core. Metric objects must live for the whole
+ * run (static or in objects that are never deleted).
+ *
+ * The report adds built-in collectors: heap (free, largest free block,
+ * fragmentation) and every FreeRTOS task (state, priority, stack
+ * high-water mark, CPU share since the previous report).
+ */
+
+enum MetricType : uint8_t {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+};
+
+class Metric {
+public:
+    const char* getName() { return name; }
+
+protected:
+    Metric(const char* name, const char* unit, MetricType type);
+
+private:
+    const char* name;   // Static string, dotted ("command.busy")
+    const char* unit;   // Static string, may be empty
+    MetricType type;
+    Metric* next;       // Registry list
+    friend class Metrics;
+};
+
+/** @brief Monotonic event count. */
+class MetricCounter : public Metric {
+public:
+    MetricCounter(const char* name, const char* unit = "");
+    void add(uint32_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t get() { return value.load(std::memory_order_relaxed); }
+    void reset() { value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> value;
+};
+
+/**
+ * @brief Current level of something, set by its owner or read on report
+ *        through @p reader (for values another module already keeps).
+ */
+class MetricGauge : public Metric {
+public:
+    typedef int32_t (*Reader)();
+    MetricGauge(const char* name, const char* unit = "", Reader reader = nullptr);
+    void set(int32_t v) { value.store(v, std::memory_order_relaxed); }
+    int32_t get() { return reader ? reader() : value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int32_t> value;
+    Reader reader;
+};
+
+/**
+ * @brief HdrHistogram-style log-linear histogram of 32-bit values.
+ *
+ * Values below 2 * METRICS_HISTOGRAM_SUB_BUCKETS are exact; above that each
+ * power of two is split into METRICS_HISTOGRAM_SUB_BUCKETS buckets, so
+ * percentiles are within 1 / METRICS_HISTOGRAM_SUB_BUCKETS of the value.
+ */
+class MetricHistogram : public Metric {
+public:
+    MetricHistogram(const char* name, const char* unit);
+
+    void record(uint32_t value) {
+        buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        uint32_t seen = max.load(std::memory_order_relaxed);
+        while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+    void report(JsonObject out);
+    void reset();
+
+    static uint16_t bucketIndex(uint32_t value) {
+        if (value < 2 * METRICS_HISTOGRAM_SUB_BUCKETS) return value;
+        uint8_t shift = 31 - __builtin_clz(value) - METRICS_HISTOGRAM_SUB_BITS;
+        return shift * METRICS_HISTOGRAM_SUB_BUCKETS + (value >> shift);
+    }
+    static uint32_t bucketValue(uint16_t index);   // Lowest value of a bucket
+
+private:
+    std::atomic<uint32_t> buckets[METRICS_HISTOGRAM_BUCKETS];
+    std::atomic<uint32_t> max;
+};
+
+class Metrics {
+public:
+    static void add(Metric* metric);         // Called by the Metric constructor
+    static void report(JsonDocument& doc);   // GETMETRICS
+    static void reset();                     // Counters and histograms back to zero
+
+private:
+    static void reportHeap(JsonDocument& doc);
+    static void reportTasks(JsonDocument& doc);
+
+    static Metric* head;
+    static portMUX_TYPE lock;
+
+    // Run-time counters at the previous report, for the CPU share
+    struct TaskTime {
+        UBaseType_t number;     // FreeRTOS task number, unique per task
+        uint32_t runTime;
+    };
+    static TaskTime lastTaskTimes[METRICS_MAX_TASKS];
+    static uint8_t lastTaskCount;
+    static int64_t lastReportUs;
+};
+
+#endif // METRICS_H
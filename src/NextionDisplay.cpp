@@ -0,0 +1,330 @@
+#include "NextionDisplay.h"
+#include "Trace.h"
+#include "TaskHealth.h"
+
+/**
+ * @brief Constructor for the NextionDisplay class.
+ */
+NextionDisplay::NextionDisplay()
+    : _out(nullptr), _writerHandle(nullptr), _count(0), _holdUntil(0), _bytesWritten(0), _writes(0),
+      _lastWriteBytes(0), _suppressed(0), _droppedCommands(0), _backgroundBytes(0),
+      _press(PRESS_IDLE), _pressStart(0), _lastPressBytes(0) {
+    _mutex = xSemaphoreCreateMutex();
+    _commands = xQueueCreate(NEXTION_TX_QUEUE_DEPTH, sizeof(TxCommand));
+    _background = xQueueCreate(NEXTION_BG_QUEUE_DEPTH, sizeof(TxCommand));
+}
+
+/**
+ * @brief Sets the output and starts the writer task.
+ *
+ * @param out Stream the commands are written to (normally Serial1).
+ */
+void NextionDisplay::begin(Print* out) {
+    _out = out;
+    if (_writerHandle == nullptr) {
+        xTaskCreatePinnedToCore(writerTask, "Nextion TX Task", NEXTION_WRITER_TASK_STACK, this,
+                                NEXTION_WRITER_TASK_PRIORITY, &_writerHandle, NEXTION_WRITER_TASK_CORE);
+    }
+}
+
+/**
+ * @brief Registers a numeric component.
+ *
+ * The component starts unknown, so its first value is always sent.
+ *
+ * @param name Component name on the display, e.g. "n1".
+ * @param minIntervalMs Minimum time between two writes to this component.
+ * @return Component id for setNumber(), or -1 if the table is full.
+ */
+int8_t NextionDisplay::addNumber(const char* name, uint16_t minIntervalMs) {
+    if (_count >= NEXTION_MAX_COMPONENTS) return -1;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+
+    Component& c = _components[_count];
+    strncpy(c.name, name, sizeof(c.name) - 1);
+    c.name[sizeof(c.name) - 1] = '\0';
+    c.value = 0;
+    c.shown = 0;
+    c.known = false;
+    c.dirty = false;
+    c.minIntervalMs = minIntervalMs;
+    c.lastSent = millis() - minIntervalMs;  // First write is never held back
+    int8_t id = _count++;
+
+    xSemaphoreGive(_mutex);
+    return id;
+}
+
+/**
+ * @brief Requests a new value for a component.
+ *
+ * Nothing is written here; the change goes out with the next flush().
+ * Setting a value back to what the display already shows cancels a
+ * pending update.
+ */
+void NextionDisplay::setNumber(uint8_t id, int32_t value) {
+    if (id >= _count) return;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    Component& c = _components[id];
+    c.value = value;
+    bool dirty = !c.known || value != c.shown;
+    if (!dirty && !c.dirty) _suppressed++;
+    c.dirty = dirty;
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * @brief Queues a raw instruction (without terminator) for the writer task.
+ *
+ * Never blocks. Commands longer than NEXTION_COMMAND_SIZE - 1 are refused.
+ *
+ * @return False if the command was dropped.
+ */
+bool NextionDisplay::sendCommand(const char* command) {
+    if (!enqueue(_commands, command)) {
+        _droppedCommands++;
+        return false;
+    }
+    flush();
+    return true;
+}
+
+/**
+ * @brief Queues a low-priority instruction, e.g. a waveform `add`.
+ *
+ * Never blocks. The caller is expected to check getBackgroundSpace() and
+ * keep its own backlog; a full queue simply refuses the command.
+ *
+ * @return False if the command was not queued.
+ */
+bool NextionDisplay::sendBackground(const char* command) {
+    if (!enqueue(_background, command)) return false;
+    flush();
+    return true;
+}
+
+uint16_t NextionDisplay::getBackgroundSpace() {
+    return uxQueueSpacesAvailable(_background);
+}
+
+bool NextionDisplay::enqueue(QueueHandle_t queue, const char* command) {
+    TxCommand cmd;
+    size_t len = strlen(command);
+    if (len >= sizeof(cmd.text)) return false;
+    memcpy(cmd.text, command, len);
+    cmd.length = (uint8_t)len;
+    return xQueueSend(queue, &cmd, 0) == pdTRUE;
+}
+
+/**
+ * @brief Forgets what the display shows so every component is resent.
+ *
+ * @param holdMs Time the display needs before it takes field writes
+ *        again (a page that is still loading drops them); the writer task
+ *        waits it out, the caller does not.
+ */
+void NextionDisplay::invalidate(uint16_t holdMs) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _holdUntil = millis() + holdMs;
+    for (uint8_t i = 0; i < _count; i++) {
+        _components[i].known = false;
+        _components[i].dirty = true;
+    }
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * @brief Wakes the writer task; returns immediately.
+ */
+void NextionDisplay::flush() {
+    if (_writerHandle) xTaskNotifyGive(_writerHandle);
+}
+
+/**
+ * @brief True if a command or component is waiting to be written.
+ */
+bool NextionDisplay::hasPending() {
+    bool pending = uxQueueMessagesWaiting(_commands) > 0;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < _count && !pending; i++) {
+        pending = _components[i].dirty;
+    }
+    xSemaphoreGive(_mutex);
+    return pending;
+}
+
+/**
+ * @brief Starts attributing foreground output to a key press.
+ *
+ * Background data is not counted. A press still open is replaced.
+ */
+void NextionDisplay::beginPress() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _press = PRESS_OPEN;
+    _pressStart = _bytesWritten - _backgroundBytes;
+    xSemaphoreGive(_mutex);
+}
+
+/**
+ * @brief Marks the press complete and wakes the writer.
+ *
+ * The byte count is taken once the writer has sent everything queued so
+ * far, including components held back by their minimum interval.
+ */
+void NextionDisplay::endPress() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_press == PRESS_OPEN) _press = PRESS_ENDED;
+    xSemaphoreGive(_mutex);
+    flush();
+}
+
+/**
+ * @brief FreeRTOS task writing queued commands and dirty components.
+ *
+ * Sleeps until flush() wakes it or until the next rate-limited component
+ * becomes due. It is the only code that writes to the display UART, so a
+ * slow link only ever delays this task.
+ *
+ * @param pvParameters Pointer to the NextionDisplay instance.
+ */
+void NextionDisplay::writerTask(void *pvParameters) {
+    NextionDisplay* display = static_cast<NextionDisplay*>(pvParameters);
+    const TickType_t idleWait = pdMS_TO_TICKS(TASK_IDLE_WAKE_MS);
+    TickType_t wait = idleWait;
+    int8_t health = TaskHealth::add("hmi.tx");
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, wait);
+        TaskHealth::checkIn(health);
+
+        uint32_t nextDueMs;
+        size_t len;
+        while ((len = display->collect(nextDueMs)) > 0) {
+            display->write(len);
+        }
+        display->settlePress();
+        wait = (nextDueMs == UINT32_MAX) ? idleWait : min(idleWait, pdMS_TO_TICKS(nextDueMs) + 1);
+    }
+}
+
+/**
+ * @brief Moves queued commands, then due components, into the burst buffer.
+ *
+ * Whatever does not fit stays pending for the next call. Background
+ * commands are only taken when the burst would otherwise be empty.
+ *
+ * @param nextDueMs Receives the time until the next held-back component or
+ *        background retry is due, or UINT32_MAX if none is waiting.
+ * @return Burst length in bytes.
+ */
+size_t NextionDisplay::collect(uint32_t& nextDueMs) {
+    size_t len = 0;
+    nextDueMs = UINT32_MAX;
+
+    TxCommand cmd;
+    while (xQueuePeek(_commands, &cmd, 0) == pdTRUE) {
+        if (len + cmd.length + 3 > sizeof(_tx)) return len;
+        xQueueReceive(_commands, &cmd, 0);
+        memcpy(_tx + len, cmd.text, cmd.length);
+        len += cmd.length;
+        memset(_tx + len, 0xFF, 3);
+        len += 3;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    uint32_t now = millis();
+    int32_t held = (int32_t)(_holdUntil - now);
+    if (held > 0) nextDueMs = min(nextDueMs, (uint32_t)held);
+    for (uint8_t i = 0; i < _count && held <= 0; i++) {
+        Component& c = _components[i];
+        if (!c.dirty) continue;
+
+        uint32_t elapsed = now - c.lastSent;
+        if (elapsed < c.minIntervalMs) {
+            nextDueMs = min(nextDueMs, (uint32_t)(c.minIntervalMs - elapsed));
+            continue;
+        }
+
+        int n = snprintf(_tx + len, sizeof(_tx) - len, "%s.val=%ld\xFF\xFF\xFF", c.name, (long)c.value);
+        if (n < 0 || len + n >= sizeof(_tx)) break;  // Rest goes out with the next burst
+        len += n;
+
+        c.shown = c.value;
+        c.known = true;
+        c.dirty = false;
+        c.lastSent = now;
+    }
+    xSemaphoreGive(_mutex);
+
+    // Background data only when nothing else is going out and the FIFO has drained
+    if (len == 0 && uxQueueMessagesWaiting(_background) > 0) {
+        if (_out->availableForWrite() < NEXTION_BG_MIN_TX_FREE) {
+            nextDueMs = min(nextDueMs, (uint32_t)NEXTION_BG_RETRY_MS);
+            return 0;
+        }
+        while (xQueuePeek(_background, &cmd, 0) == pdTRUE && len + cmd.length + 3 <= NEXTION_BG_BURST_SIZE) {
+            xQueueReceive(_background, &cmd, 0);
+            memcpy(_tx + len, cmd.text, cmd.length);
+            len += cmd.length;
+            memset(_tx + len, 0xFF, 3);
+            len += 3;
+        }
+        _backgroundBytes += len;
+    }
+    return len;
+}
+
+/**
+ * @brief Writes the burst to the UART (writer task only).
+ */
+void NextionDisplay::write(size_t len) {
+    TRACE_SCOPE("hmi.write", len);
+    _out->write((const uint8_t*)_tx, len);
+    _bytesWritten += len;
+    _lastWriteBytes = len;
+    _writes++;
+}
+
+/**
+ * @brief Records the size of an ended press once its output is all sent (writer task only).
+ */
+void NextionDisplay::settlePress() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_press == PRESS_ENDED && uxQueueMessagesWaiting(_commands) == 0) {
+        bool pending = false;
+        for (uint8_t i = 0; i < _count && !pending; i++) pending = _components[i].dirty;
+        if (!pending) {
+            _lastPressBytes = _bytesWritten - _backgroundBytes - _pressStart;
+            _press = PRESS_IDLE;
+        }
+    }
+    xSemaphoreGive(_mutex);
+}
+
+uint32_t NextionDisplay::getBytesWritten() {
+    return _bytesWritten;
+}
+
+uint32_t NextionDisplay::getWrites() {
+    return _writes;
+}
+
+uint32_t NextionDisplay::getLastWriteBytes() {
+    return _lastWriteBytes;
+}
+
+uint32_t NextionDisplay::getSuppressed() {
+    return _suppressed;
+}
+
+uint32_t NextionDisplay::getDroppedCommands() {
+    return _droppedCommands;
+}
+
+uint32_t NextionDisplay::getBackgroundBytes() {
+    return _backgroundBytes;
+}
+
+uint32_t NextionDisplay::getLastPressBytes() {
+    return _lastPressBytes;
+}
@@ -0,0 +1,96 @@
+#ifndef NEXTION_DISPLAY_H
+#define NEXTION_DISPLAY_H
+
+#include <Arduino.h>
+#include <FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/queue.h>
+#include "Config.h"
+
+/**
+ * @brief Cached model of the Nextion display with a non-blocking writer.
+ *
+ * Remembers the last value written to every registered numeric component
+ * and only sends components whose value changed. Callers never touch the
+ * UART: setNumber() and sendCommand() only update the model or a bounded
+ * queue and wake a writer task, which coalesces everything pending into
+ * one burst. Repeated updates to a component collapse into its latest
+ * value, so rapid input cannot grow the backlog. A component refreshed
+ * less than its minimum interval ago is sent once the interval elapses.
+ * Background commands (e.g. graph data) only go out when nothing else is
+ * pending and the UART TX FIFO is nearly empty, so they never hold up
+ * control updates by more than one small burst.
+ *
+ * The output is any Print, so the wire traffic can be redirected to a
+ * counting sink. Safe to use from several tasks.
+ */
+class NextionDisplay {
+public:
+    NextionDisplay();
+
+    void begin(Print* out);                     // Start the writer task
+    int8_t addNumber(const char* name, uint16_t minIntervalMs = NEXTION_MIN_REFRESH_MS);
+    void setNumber(uint8_t id, int32_t value);  // Marks the component dirty if the value changed
+    bool sendCommand(const char* command);      // Queue a raw command; false if the queue is full
+    bool sendBackground(const char* command);   // Lowest priority, only sent while the link is idle
+    uint16_t getBackgroundSpace();              // Free background queue entries
+    void invalidate(uint16_t holdMs = 0);       // Resend everything (e.g. after a page reload), not before holdMs
+    void flush();                               // Wake the writer for pending updates
+    bool hasPending();
+    void beginPress();                          // Output from here to endPress() is one key press
+    void endPress();                            // Counted once the writer has sent it all
+
+    uint32_t getBytesWritten();
+    uint32_t getWrites();
+    uint32_t getLastWriteBytes();               // Size of the most recent burst
+    uint32_t getSuppressed();                   // Updates skipped because the value was unchanged
+    uint32_t getDroppedCommands();              // sendCommand() calls refused by a full queue
+    uint32_t getBackgroundBytes();
+    uint32_t getLastPressBytes();               // Wire bytes of the last completed key press
+
+private:
+    struct Component {
+        char name[NEXTION_NAME_SIZE];
+        int32_t value;        // Latest requested value
+        int32_t shown;        // Value last written to the display
+        bool known;           // shown reflects the display
+        bool dirty;           // value != shown
+        uint16_t minIntervalMs;
+        uint32_t lastSent;    // millis() of the last write
+    };
+
+    struct TxCommand {
+        uint8_t length;
+        char text[NEXTION_COMMAND_SIZE];
+    };
+
+    static bool enqueue(QueueHandle_t queue, const char* command);
+    static void writerTask(void *pvParameters);
+    size_t collect(uint32_t& nextDueMs);        // Build the next burst in _tx
+    void write(size_t len);
+    void settlePress();                         // Close an ended press once nothing is pending
+
+    Print* _out;
+    SemaphoreHandle_t _mutex;
+    QueueHandle_t _commands;
+    QueueHandle_t _background;
+    TaskHandle_t _writerHandle;
+    Component _components[NEXTION_MAX_COMPONENTS];
+    uint8_t _count;
+    uint32_t _holdUntil;                        // millis() before which no component is written
+    char _tx[NEXTION_TX_BUFFER_SIZE];           // Writer task only
+
+    uint32_t _bytesWritten;
+    uint32_t _writes;
+    uint32_t _lastWriteBytes;
+    uint32_t _suppressed;
+    uint32_t _droppedCommands;
+    uint32_t _backgroundBytes;
+
+    enum PressState : uint8_t { PRESS_IDLE, PRESS_OPEN, PRESS_ENDED };
+    PressState _press;                          // Mutex held
+    uint32_t _pressStart;                       // Foreground bytes at beginPress()
+    uint32_t _lastPressBytes;
+};
+
+#endif // NEXTION_DISPLAY_H
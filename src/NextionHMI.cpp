@@ -1,5 +1,11 @@
+#include <ArduinoJson.h>
 #include "NextionHMI.h"
 #include"Arduino.h"
+#include "DeferredLog.h"
+#include "EventLogger.h"
+#include "RecipeManager.h"
+#include "Trace.h"
+#include "TaskHealth.h"
 
 
 /**
@@ -9,44 +15,231 @@
  * @param motor2 Reference to the A4988Manager for motor 2 control.
  */
 NextionHMI::NextionHMI(CommandReceiver* commandReceiver, A4988Manager& motor1, A4988Manager& motor2,ConfigManager*Conf)
-    : cmdReceiver(commandReceiver), _motor1(motor1), _motor2(motor2), commandReceived(false),Conf(Conf) {
-        CaseSpeed = Conf->GetInt(CASE_RPM_KEY, CASE_RPM_DEFAULT);
-        DiscSpeed = Conf->GetInt(DISC_RPM_KEY, DISC_RPM_DEFAULT);
-        Delay     = Conf->GetInt(DELAY_MS_KEY, DELAY_MS_DEFAULT);
-        offset    = Conf->GetInt(OFFSET_STEPS_KEY, OFFSET_STEPS_DEFAULT);
-        CaseDir   = Conf->GetBool(CASE_DIR_KEY, CASE_DIR_DEFAULT);
-        DiscDir   = Conf->GetBool(DISC_DIR_KEY, DISC_DIR_DEFAULT);
+    : cmdReceiver(commandReceiver), _motor1(motor1), _motor2(motor2), commandReceived(false),Conf(Conf),
+      trend(motor1, motor2) {
+        CaseSpeed = Conf->getSetting(SETTING_CASE_RPM);
+        DiscSpeed = Conf->getSetting(SETTING_DISC_RPM);
+        Delay     = Conf->getSetting(SETTING_DELAY_MS);
+        offset    = Conf->getSetting(SETTING_OFFSET_STEPS);
+        CaseDir   = Conf->getSetting(SETTING_CASE_DIR);
+        DiscDir   = Conf->getSetting(SETTING_DISC_DIR);
 
-    _motor1.setFrequency(CaseSpeed);
-    _motor2.setFrequency(DiscSpeed);
-    cmdReceiver->setMotorParameters(2,DiscSpeed,DISC_MICROSTEP,DiscDir);// Disc Motor
-    cmdReceiver->setMotorParameters(1,CaseSpeed,CASE_MICROSTEP,CaseDir);// Case Motor
-    cmdReceiver->setSensorParameters(2,Delay, offset);
-    _motor1.Stop();
-    _motor2.Stop();
-    _motor1.setFrequency(0.0);
-    _motor2.setFrequency(0.0);
+    // Load the stored setup into the idle drivers; the motors start with the START key.
+    // Axes already running were resumed after a warm restart and keep their setup.
+    if (_motor1.getSpeed() == 0) {
+        _motor1.setStepResolution(CASE_MICROSTEP);
+        _motor1.setDirPin(CaseDir);
+    }
+    if (_motor2.getSpeed() == 0) {
+        _motor2.setStepResolution(DISC_MICROSTEP);
+        _motor2.setDirPin(DiscDir);
+        cmdReceiver->setSensorParameters(2,Delay, offset);
+    }
 
-    SYSTEM_ON = false;  // Initialize system as OFF
+    SYSTEM_ON = _motor1.getSpeed() > 0 || _motor2.getSpeed() > 0;  // OFF unless resumed
+    keyPresses = 0;
+    linkBaud = NEXTION_BAUDRATE;
+    pageReply = xSemaphoreCreateBinary();
+    holdKey = 0;
+    holdStart = 0;
+    holdSteps = 0;
+    holdTaskHandle = nullptr;
+    recipes = nullptr;
+    recipeCursor = Conf->getSetting(SETTING_ACTIVE_RECIPE);
 }
 
 /**
  * @brief Initializes the UART communication with the Nextion HMI display.
+ *
+ * Connects at the rate stored in NVS and negotiates a faster link if the
+ * display is still at its factory rate.
  */
 void NextionHMI::begin() {
-    Serial1.begin(NEXTION_BAUDRATE, SERIAL_8N1, SCREEN_RXD_PIN, SCREEN_TXD_PIN);
-    while (!Serial1);  // Wait for Serial to be ready (only needed for some ESP32 boards)
+    linkBaud = Conf->getSetting(SETTING_HMI_BAUD);
+    Serial1.setTxBufferSize(NEXTION_UART_TX_BUFFER);  // Driver ring, writes return once copied
+    Serial1.begin(linkBaud, SERIAL_8N1, SCREEN_RXD_PIN, SCREEN_TXD_PIN);
+    if (holdTaskHandle == nullptr) {
+        xTaskCreatePinnedToCore(holdTask, "Nextion Hold Task", NEXTION_HOLD_TASK_STACK, this,
+                                NEXTION_HOLD_TASK_PRIORITY, &holdTaskHandle, NEXTION_TASK_CORE);
+    }
+    protocol.begin(&Serial1, onProtocolEvent, this);  // Decode display data as it arrives
+    negotiateBaudRate();
+
+    display.begin(&Serial1);
+    caseRpmField = display.addNumber("n1");
+    discRpmField = display.addNumber("n2");
+    delayField   = display.addNumber("n0");
+    offsetField  = display.addNumber("n3");
+    trend.begin(&display);
+}
+
+/**
+ * @brief Finds the display's current rate and moves it to NEXTION_TARGET_BAUDRATE.
+ *
+ * Tries the stored rate first, then the factory rate. The switch uses
+ * `bauds=`, which the display also keeps as its power-on rate, so the next
+ * boot connects at full speed on the first ping. If the display does not
+ * answer at the new rate it may still have switched, so it is asked back
+ * to the last working rate at the new one, and both rates are probed
+ * again. Only a rate the display answered at is written to NVS, and only
+ * when it changes.
+ */
+void NextionHMI::negotiateBaudRate() {
+    uint32_t stored = linkBaud;
+
+    bool found = ping();
+    if (!found && stored != NEXTION_BAUDRATE) found = connectAt(NEXTION_BAUDRATE);
+    if (!found && stored != NEXTION_TARGET_BAUDRATE) found = connectAt(NEXTION_TARGET_BAUDRATE);
+
+    if (found && linkBaud != NEXTION_TARGET_BAUDRATE) {
+        uint32_t working = linkBaud;
+        sendBaudRate(NEXTION_TARGET_BAUDRATE);
+        if (!connectAt(NEXTION_TARGET_BAUDRATE)) {
+            LOG_WARN(LOG_HMI_BAUD_FALLBACK, NEXTION_TARGET_BAUDRATE, working);
+            sendBaudRate(working);  // Sent at the target rate, in case only the reply was lost
+            found = connectAt(working) || connectAt(NEXTION_TARGET_BAUDRATE);
+        }
+    }
+
+    if (!found) {
+        Serial1.updateBaudRate(stored);  // No display answering; keep the stored rate
+        linkBaud = stored;
+        LOG_WARN(LOG_HMI_NOT_FOUND, stored);
+        return;
+    }
+
+    LOG_INFO(LOG_HMI_BAUD, linkBaud);
+    if (linkBaud != stored) Conf->setSetting(SETTING_HMI_BAUD, linkBaud);
 }
 
 /**
- * @brief Sends a command to the Nextion HMI display.
+ * @brief Sends `bauds=` at the current rate and waits for the display to switch.
+ */
+void NextionHMI::sendBaudRate(uint32_t baud) {
+    writeDirect(("bauds=" + String(baud)).c_str());
+    Serial1.flush();  // Let the command leave at the current rate
+    delay(NEXTION_BAUD_SETTLE_MS);
+}
+
+/**
+ * @brief Switches Serial1 to @p baud and checks that the display answers.
+ */
+bool NextionHMI::connectAt(uint32_t baud) {
+    Serial1.updateBaudRate(baud);
+    linkBaud = baud;
+    return ping();
+}
+
+/**
+ * @brief Sends `sendme` and waits for the current-page reply.
+ *
+ * @return True if the display answered within NEXTION_PING_TIMEOUT_MS.
+ */
+bool NextionHMI::ping() {
+    xSemaphoreTake(pageReply, 0);  // Drop a stale reply
+    writeDirect("sendme");
+    return xSemaphoreTake(pageReply, pdMS_TO_TICKS(NEXTION_PING_TIMEOUT_MS)) == pdTRUE;
+}
+
+uint32_t NextionHMI::getBaudRate() {
+    return linkBaud;
+}
+
+void NextionHMI::setTrendEnabled(bool enabled) {
+    trend.setEnabled(enabled);
+}
+
+void NextionHMI::setRecipes(RecipeManager* recipes) {
+    this->recipes = recipes;
+}
+
+/**
+ * @brief Takes over the motion settings after a recipe switch and shows them.
+ *
+ * The motors were already retuned by the caller; this only refreshes the
+ * working values behind the adjust keys and the display.
+ */
+void NextionHMI::reloadSettings() {
+    CaseSpeed = Conf->getSetting(SETTING_CASE_RPM);
+    DiscSpeed = Conf->getSetting(SETTING_DISC_RPM);
+    Delay     = Conf->getSetting(SETTING_DELAY_MS);
+    offset    = Conf->getSetting(SETTING_OFFSET_STEPS);
+    CaseDir   = Conf->getSetting(SETTING_CASE_DIR);
+    DiscDir   = Conf->getSetting(SETTING_DISC_DIR);
+    recipeCursor = Conf->getSetting(SETTING_ACTIVE_RECIPE);
+    showRecipe();
+    sendSystemStatus();
+}
+
+/**
+ * @brief Trampoline from the protocol task to the HMI instance.
+ */
+void NextionHMI::onProtocolEvent(const NextionEvent& event, void* context) {
+    static_cast<NextionHMI*>(context)->handleEvent(event);
+}
+
+/**
+ * @brief Handles one decoded event from the display.
+ *
+ * Runs in the Nextion protocol task. Key and touch events are handled
+ * while holding the control lock shared with CommandReceiver, so host
+ * and HMI changes never interleave.
+ *
+ * @param event The decoded event, stamped with its receive time.
+ */
+void NextionHMI::handleEvent(const NextionEvent& event) {
+    TRACE_SCOPE("hmi.event", event.type);
+    switch (event.type) {
+        case NEXTION_EVENT_KEY:
+            LOG_DEBUG(LOG_HMI_KEY, event.key, event.timestamp);
+            cmdReceiver->lockControl();
+            display.beginPress();
+            handleButtonPress(String(event.key));
+            display.endPress();
+            cmdReceiver->unlockControl();
+            keyPresses++;
+            break;
+        case NEXTION_EVENT_TOUCH:
+            cmdReceiver->lockControl();
+            handleTouch(event);
+            cmdReceiver->unlockControl();
+            break;
+        case NEXTION_EVENT_PAGE:
+            LOG_DEBUG(LOG_HMI_EVENT, event.code, event.timestamp);
+            xSemaphoreGive(pageReply);  // Answer to ping()
+            break;
+        case NEXTION_EVENT_ERROR:
+            LOG_WARN(LOG_HMI_ERROR, event.code, event.timestamp);
+            EventLogger::record(EVENT_FAULT, EVENT_SOURCE_SYSTEM, FAULT_HMI_ERROR, event.code);
+            break;
+        default:
+            LOG_DEBUG(LOG_HMI_EVENT, event.code, event.timestamp);
+            break;
+    }
+}
+
+/**
+ * @brief Queues a command for the Nextion HMI display.
+ *
+ * Returns immediately; the display writer task sends it. The command is
+ * dropped (and counted) if the TX queue is full.
+ *
  * @param command The command string to send.
  */
 void NextionHMI::sendCommand(const String& command) {
-    Serial1.print(command);
-    Serial1.write(0xFF);
-    Serial1.write(0xFF);
-    Serial1.write(0xFF);
+    display.sendCommand(command.c_str());
+}
+
+/**
+ * @brief Writes a command straight to the UART.
+ *
+ * Only used by the link negotiation in begin(), which has to control
+ * exactly when bytes leave relative to baud rate changes, before the
+ * display writer task is started.
+ */
+void NextionHMI::writeDirect(const char* command) {
+    Serial1.write((const uint8_t*)command, strlen(command));
+    Serial1.write((const uint8_t*)"\xFF\xFF\xFF", 3);
 }
 
 
@@ -67,54 +260,325 @@ String NextionHMI::exportToLineByLineString(String input) {
     return result;
 }
 
+// Buttons reporting press/release (0x65) events, and the key letter they act as
+static const struct {
+    uint8_t component;
+    char key;
+} HOLD_BUTTONS[] = {
+    { NEXTION_ID_CASE_UP,    'A' },
+    { NEXTION_ID_CASE_DOWN,  'C' },
+    { NEXTION_ID_CASE_DIR,   'B' },
+    { NEXTION_ID_DISC_UP,    'G' },
+    { NEXTION_ID_DISC_DOWN,  'E' },
+    { NEXTION_ID_DISC_DIR,   'F' },
+    { NEXTION_ID_DELAY_UP,   'H' },
+    { NEXTION_ID_DELAY_DOWN, 'I' },
+    { NEXTION_ID_OFFSET_UP,  'J' },
+    { NEXTION_ID_OFFSET_DOWN,'K' },
+    { NEXTION_ID_START,      'S' },
+    { NEXTION_ID_STOP,       'P' },
+};
+
+/**
+ * @brief Key letter of a touch component on the main page, or 0.
+ */
+char NextionHMI::keyForComponent(uint8_t page, uint8_t component) {
+    if (page != NEXTION_MAIN_PAGE) return 0;
+    for (size_t i = 0; i < sizeof(HOLD_BUTTONS) / sizeof(HOLD_BUTTONS[0]); i++) {
+        if (HOLD_BUTTONS[i].component == component) return HOLD_BUTTONS[i].key;
+    }
+    return 0;
+}
+
+/**
+ * @brief True for the keys that step a value up or down.
+ */
+bool NextionHMI::isAdjustKey(char key) {
+    return key == 'A' || key == 'C' || key == 'G' || key == 'E' ||
+           key == 'H' || key == 'I' || key == 'J' || key == 'K';
+}
+
+/**
+ * @brief Handles a press or release reported with the component id.
+ *
+ * Adjust buttons step once on press and keep stepping from the hold task
+ * while held; only the display follows the intermediate values. The
+ * final value is persisted and applied once, on release. Other buttons
+ * act on press.
+ *
+ * @param event TOUCH event from the protocol task.
+ */
+void NextionHMI::handleTouch(const NextionEvent& event) {
+    if (event.page == NEXTION_RECIPE_PAGE) {
+        if (event.pressed) handleRecipeTouch(event.component);
+        return;
+    }
+
+    char key = keyForComponent(event.page, event.component);
+    if (key == 0) {
+        LOG_DEBUG(LOG_HMI_EVENT, event.code, event.timestamp);
+        return;
+    }
+
+    if (!isAdjustKey(key)) {
+        if (event.pressed) handleButtonPress(String(key));
+        return;
+    }
+
+    if (event.pressed) {
+        if (holdKey != 0) releaseHold();  // Missed release of another button
+        LOG_INFO(LOG_HMI_BUTTON, LOG_STR(keyLabel(key)));
+        holdKey = key;
+        holdStart = millis();
+        holdSteps = 1;
+        stepValue(key, 1);
+        previewValue(key);
+        xTaskNotifyGive(holdTaskHandle);
+    } else if (key == holdKey) {
+        releaseHold();
+    }
+}
+
+/**
+ * @brief Recipe page: browse the stored recipes and load the selected one.
+ */
+void NextionHMI::handleRecipeTouch(uint8_t component) {
+    if (recipes == nullptr) return;
+    switch (component) {
+        case NEXTION_ID_RECIPE_PREV:
+            recipeCursor = recipes->nextSlot(recipeCursor, -1);
+            showRecipe();
+            break;
+        case NEXTION_ID_RECIPE_NEXT:
+            recipeCursor = recipes->nextSlot(recipeCursor, 1);
+            showRecipe();
+            break;
+        case NEXTION_ID_RECIPE_LOAD:
+            LOG_INFO(LOG_HMI_BUTTON, LOG_STR("Recipe load"));
+            if (recipeCursor >= 0) recipes->apply(recipeCursor);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Shows the recipe under the cursor on the recipe page.
+ */
+void NextionHMI::showRecipe() {
+    Recipe recipe;
+    if (recipeCursor < 0 || !Conf->loadRecipe(recipeCursor, recipe)) {
+        strcpy(recipe.name, "-");
+    }
+    char line[NEXTION_COMMAND_SIZE];
+    snprintf(line, sizeof(line), NEXTION_RECIPE_NAME_FIELD ".txt=\"%s\"", recipe.name);
+    display.sendCommand(line);
+    snprintf(line, sizeof(line), NEXTION_RECIPE_SLOT_FIELD ".val=%d", recipeCursor);
+    display.sendCommand(line);
+}
+
+/**
+ * @brief Ends the current hold: persists and applies the final value.
+ */
+void NextionHMI::releaseHold() {
+    char key = holdKey;
+    holdKey = 0;
+    LOG_INFO(LOG_HMI_HOLD_COMMIT, key, holdSteps);
+    commitValue(key);
+    sendSystemStatus();
+}
+
+/**
+ * @brief One auto-repeat step of the held button (hold task, control lock held).
+ *
+ * The step grows by NEXTION_REPEAT_ACCEL_FACTOR every NEXTION_REPEAT_ACCEL_MS
+ * of holding, up to NEXTION_REPEAT_MAX_MULTIPLIER times the base step. A
+ * hold longer than NEXTION_HOLD_TIMEOUT_MS is treated as a lost release.
+ *
+ * @return False once no button is held.
+ */
+bool NextionHMI::repeatHold() {
+    if (holdKey == 0) return false;
+
+    uint32_t held = millis() - holdStart;
+    if (held >= NEXTION_HOLD_TIMEOUT_MS) {
+        releaseHold();
+        return false;
+    }
+    if (held < NEXTION_REPEAT_DELAY_MS) return true;
+
+    uint16_t multiplier = 1;
+    for (uint32_t t = NEXTION_REPEAT_ACCEL_MS; t <= held && multiplier < NEXTION_REPEAT_MAX_MULTIPLIER; t += NEXTION_REPEAT_ACCEL_MS) {
+        multiplier *= NEXTION_REPEAT_ACCEL_FACTOR;
+    }
+    if (multiplier > NEXTION_REPEAT_MAX_MULTIPLIER) multiplier = NEXTION_REPEAT_MAX_MULTIPLIER;
+
+    stepValue(holdKey, multiplier);
+    previewValue(holdKey);
+    holdSteps++;
+    return true;
+}
+
+/**
+ * @brief FreeRTOS task generating auto-repeat steps while a button is held.
+ *
+ * Sleeps until a press notifies it, then ticks every
+ * NEXTION_REPEAT_PERIOD_MS until the button is released.
+ *
+ * @param pvParameters Pointer to the NextionHMI instance.
+ */
+void NextionHMI::holdTask(void *pvParameters) {
+    NextionHMI* hmi = static_cast<NextionHMI*>(pvParameters);
+    int8_t health = TaskHealth::add("hmi.hold");
+
+    while (true) {
+        TaskHealth::checkIn(health);
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TASK_IDLE_WAKE_MS)) == 0) continue;
+
+        bool held = true;
+        while (held) {
+            vTaskDelay(pdMS_TO_TICKS(NEXTION_REPEAT_PERIOD_MS));
+            TaskHealth::checkIn(health);
+            hmi->cmdReceiver->lockControl();
+            held = hmi->repeatHold();
+            hmi->cmdReceiver->unlockControl();
+        }
+    }
+}
+
+/**
+ * @brief Moves @p value by @p delta, clamped to [min, max].
+ */
+static uint16_t stepClamped(uint16_t value, int32_t delta, int32_t min, int32_t max) {
+    int32_t next = (int32_t)value + delta;
+    if (next < min) next = min;
+    if (next > max) next = max;
+    return (uint16_t)next;
+}
+
+/**
+ * @brief Changes the working value behind an adjust key, without applying it.
+ *
+ * @param key Adjust key letter.
+ * @param multiplier Number of base steps to move.
+ */
+void NextionHMI::stepValue(char key, uint16_t multiplier) {
+    int32_t n = multiplier;
+    switch (key) {
+        case 'A': CaseSpeed = stepClamped(CaseSpeed,  HMI_CASE_STEP * n,   HMI_SPEED_MIN, HMI_SPEED_MAX); break;
+        case 'C': CaseSpeed = stepClamped(CaseSpeed, -HMI_CASE_STEP * n,   HMI_SPEED_MIN, HMI_SPEED_MAX); break;
+        case 'G': DiscSpeed = stepClamped(DiscSpeed,  HMI_DISC_STEP * n,   HMI_SPEED_MIN, HMI_SPEED_MAX); break;
+        case 'E': DiscSpeed = stepClamped(DiscSpeed, -HMI_DISC_STEP * n,   HMI_SPEED_MIN, HMI_SPEED_MAX); break;
+        case 'H': Delay     = stepClamped(Delay,      HMI_DELAY_STEP * n,  0, HMI_DELAY_MAX); break;
+        case 'I': Delay     = stepClamped(Delay,     -HMI_DELAY_STEP * n,  0, HMI_DELAY_MAX); break;
+        case 'J': offset    = stepClamped(offset,     HMI_OFFSET_STEP * n, 0, HMI_OFFSET_MAX); break;
+        case 'K': offset    = stepClamped(offset,    -HMI_OFFSET_STEP * n, 0, HMI_OFFSET_MAX); break;
+    }
+}
+
+/**
+ * @brief Shows the working value behind an adjust key on the display only.
+ */
+void NextionHMI::previewValue(char key) {
+    switch (key) {
+        case 'A': case 'C':
+            display.setNumber(caseRpmField, calculateRPM(CaseSpeed, CASE_MICROSTEP, FULL_STEPS_PER_REV));
+            break;
+        case 'G': case 'E':
+            display.setNumber(discRpmField, calculateRPM(DiscSpeed, DISC_MICROSTEP, FULL_STEPS_PER_REV));
+            break;
+        case 'H': case 'I':
+            display.setNumber(delayField, Delay);
+            break;
+        case 'J': case 'K':
+            display.setNumber(offsetField, offset);
+            break;
+    }
+    display.flush();
+}
+
+/**
+ * @brief Persists the working value behind an adjust key and applies it.
+ */
+void NextionHMI::commitValue(char key) {
+    switch (key) {
+        case 'A': case 'C':
+            Conf->setSetting(SETTING_CASE_RPM, CaseSpeed);
+            cmdReceiver->setMotorParameters(1, CaseSpeed, CASE_MICROSTEP, CaseDir);
+            break;
+        case 'G': case 'E':
+            Conf->setSetting(SETTING_DISC_RPM, DiscSpeed);
+            cmdReceiver->setMotorParameters(2, DiscSpeed, DISC_MICROSTEP, DiscDir);
+            break;
+        case 'H': case 'I':
+            Conf->setSetting(SETTING_DELAY_MS, Delay);
+            cmdReceiver->setSensorParameters(2, Delay, offset);
+            break;
+        case 'J': case 'K':
+            Conf->setSetting(SETTING_OFFSET_STEPS, offset);
+            cmdReceiver->setSensorParameters(2, Delay, offset);
+            break;
+    }
+}
+
+/**
+ * @brief Log label of a key letter.
+ */
+const char* NextionHMI::keyLabel(char key) {
+    switch (key) {
+        case 'A': return "Case up";
+        case 'C': return "Case down";
+        case 'G': return "Disk up";
+        case 'E': return "Disk down";
+        case 'H': return "Delay up";
+        case 'I': return "Delay down";
+        case 'J': return "Offset up";
+        case 'K': return "Offset down";
+        default:  return "Unknown";
+    }
+}
+
 /**
  * @brief Handles button press events received from the Nextion HMI display.
+ *
+ * Letter keys carry no release, so an adjust key is a press immediately
+ * followed by a release: one step, persisted and applied at once.
+ *
  * @param response The response string identifying the button pressed.
  */
 void NextionHMI::handleButtonPress(const String& response) {
-    if (response == "A") {
-        Serial.println("Case up button pressed");
-        CaseSpeed+=13;
-        if(CaseSpeed>1000)CaseSpeed =1000;
-        Conf->PutInt(CASE_RPM_KEY, CaseSpeed); 
-        cmdReceiver->setMotorParameters(1, CaseSpeed, CASE_MICROSTEP, CaseDir);
+    char key = response.length() > 0 ? response[0] : 0;
+
+    if (isAdjustKey(key)) {
+        LOG_INFO(LOG_HMI_BUTTON, LOG_STR(keyLabel(key)));
+        stepValue(key, 1);
+        commitValue(key);
         sendSystemStatus();
-    } 
+    }
     else if (response == "B") {
-        Serial.println("Case direction button pressed");
+        LOG_INFO(LOG_HMI_BUTTON, LOG_STR("Case direction"));
         CaseDir = !CaseDir;
-        Conf->PutBool(CASE_DIR_KEY, CaseDir); 
+        Conf->setSetting(SETTING_CASE_DIR, CaseDir);
         cmdReceiver->setMotorParameters(1, CaseSpeed, CASE_MICROSTEP, CaseDir);
         sendSystemStatus();
     }
     else if (response == "W") {
-        Serial.println("first time param update");
-        delay(200);
-        sendSystemStatus();
-    }
-    else if (response == "C") {
-        Serial.println("Case down button pressed");
-        CaseSpeed-=13;
-        if(CaseSpeed<100)CaseSpeed =100;
-        Conf->PutInt(CASE_RPM_KEY, CaseSpeed); 
-        cmdReceiver->setMotorParameters(1, CaseSpeed, CASE_MICROSTEP, CaseDir);
+        LOG_INFO(LOG_HMI_BUTTON, LOG_STR("Param refresh (W)"));
+        display.invalidate(NEXTION_PAGE_LOAD_MS);  // Page was reloaded, its fields show the defaults
         sendSystemStatus();
     }
     else if (response == "S") {
-        Serial.println("Start button pressed");
+        LOG_INFO(LOG_HMI_BUTTON, LOG_STR("Start"));
         SYSTEM_ON = true;  // Set system status to ON
-        _motor1.Start();
-        _motor2.Start();
-        CaseSpeed = Conf->GetInt(CASE_RPM_KEY, CASE_RPM_DEFAULT);;
-        DiscSpeed = Conf->GetInt(DISC_RPM_KEY, DISC_RPM_DEFAULT);;
-        _motor1.setFrequency(CaseSpeed);
-        _motor2.setFrequency(DiscSpeed);
-        cmdReceiver->setMotorParameters(2,DEFAULT_DISK_SPEED,DISC_MICROSTEP,DiscDir);// Disc Motor
-        cmdReceiver->setMotorParameters(1,DEFAULT_CASE_SPEED,CASE_MICROSTEP,CaseDir);// Case Motor
+        // Current settings, which an applied recipe has replaced
+        CaseSpeed = Conf->getSetting(SETTING_CASE_RPM);
+        DiscSpeed = Conf->getSetting(SETTING_DISC_RPM);
+        cmdReceiver->setMotorParameters(2, DiscSpeed, DISC_MICROSTEP, DiscDir);// Disc Motor
+        cmdReceiver->setMotorParameters(1, CaseSpeed, CASE_MICROSTEP, CaseDir);// Case Motor
         sendSystemStatus();
     }
     else if (response == "P") {
-        Serial.println("Stop button pressed");
+        LOG_INFO(LOG_HMI_BUTTON, LOG_STR("Stop"));
         SYSTEM_ON = false;  // Set system status to OFF
         _motor1.Stop();
         _motor2.Stop();
@@ -122,60 +586,13 @@ void NextionHMI::handleButtonPress(const String& response) {
         _motor2.setFrequency(0.0);
         sendSystemStatus();
     }
-    else if (response == "G") {
-        Serial.println("Disk up button pressed");
-        DiscSpeed+=26;
-        if(DiscSpeed>1000)DiscSpeed =1000;
-        Conf->PutInt(DISC_RPM_KEY, DiscSpeed);
-        cmdReceiver->setMotorParameters(2, DiscSpeed, DISC_MICROSTEP, DiscDir);
-        sendSystemStatus();
-    }
     else if (response == "F") {
-        Serial.println("Disk direction button pressed");
+        LOG_INFO(LOG_HMI_BUTTON, LOG_STR("Disk direction"));
         DiscDir = !DiscDir;
-        Conf->PutBool(DISC_DIR_KEY, DiscDir);
+        Conf->setSetting(SETTING_DISC_DIR, DiscDir);
         cmdReceiver->setMotorParameters(2, DiscSpeed, DISC_MICROSTEP, DiscDir);
         sendSystemStatus();
     }
-    else if (response == "E") {
-        Serial.println("Disk down button pressed");
-        DiscSpeed-=26;
-        if(DiscSpeed<100)DiscSpeed =100;
-        Conf->PutInt(DISC_RPM_KEY, DiscSpeed);
-        cmdReceiver->setMotorParameters(2, DiscSpeed, DISC_MICROSTEP, DiscDir);
-        sendSystemStatus();
-    }
-    else if (response == "H") {
-        Serial.println("Delay up button pressed");
-        Delay += 100;
-        Conf->PutInt(DELAY_MS_KEY, Delay);
-        cmdReceiver->setSensorParameters(2, Delay, offset);
-        sendSystemStatus();
-    }
-    else if (response == "I") {
-        Serial.println("Delay down button pressed");
-        Delay -= 100;
-         if(Delay<0)Delay =100;
-        Conf->PutInt(DELAY_MS_KEY, Delay);
-        cmdReceiver->setSensorParameters(2, Delay, offset);
-        sendSystemStatus();
-    }
-    else if (response == "J") {
-        Serial.println("Offset down button pressed");
-        offset += 5;
-         if(offset<0)offset = 0;
-        Conf->PutInt(OFFSET_STEPS_KEY, offset);
-        cmdReceiver->setSensorParameters(2, Delay, offset);
-        sendSystemStatus();
-    }
-    else if (response == "K") {
-        Serial.println("Offset down button pressed");
-        offset -= 5;
-        Conf->PutInt(OFFSET_STEPS_KEY, offset);
-         if(offset<0)offset =0;
-        cmdReceiver->setSensorParameters(2, Delay, offset);
-        sendSystemStatus();
-    }
 }
 
 /**
@@ -198,28 +615,54 @@ int NextionHMI::calculateRPM(float pulseFrequency, int microsteps, int stepsPerR
 }
 /**
  * @brief Sends the current system status to the Nextion HMI display.
+ *
+ * Values come from the same snapshot as the host GETSTATUS reply. Only
+ * fields that differ from what the display already shows are written,
+ * coalesced into a single burst by the display writer task.
  */
 void NextionHMI::sendSystemStatus() {
+    uint32_t caseRPM = 0, discRPM = 0, delayMs = 0, steps = 0;
+
     if (SYSTEM_ON) {
+        StatusSnapshot snapshot;
+        cmdReceiver->captureStatus(snapshot);
 
         // Calculate RPMs
-        int caseRPM =calculateRPM(CaseSpeed,CASE_MICROSTEP,FULL_STEPS_PER_REV);
-        int discRPM = calculateRPM(DiscSpeed,DISC_MICROSTEP,FULL_STEPS_PER_REV);
-
-        // Update Nextion display with calculated RPM values
-        sendCommand("n1.val=" + String(caseRPM));  // Update case RPM
-        sendCommand("n2.val=" + String(discRPM));  // Update disc RPM
-        sendCommand("n0.val=" + String(Delay));    // Update delay
-        sendCommand("n3.val=" + String(offset));    // Update delay
-    }
-    else {
-        sendCommand("n1.val=0");  // Case speed off
-        sendCommand("n2.val=0");  // Disc speed off
-        sendCommand("n0.val=0");  // Delay off
-        sendCommand("n3.val=0"); // offset off
+        caseRPM = calculateRPM(snapshot.caseSpeed, snapshot.caseMicrosteps, FULL_STEPS_PER_REV);
+        discRPM = calculateRPM(snapshot.discSpeed, snapshot.discMicrosteps, FULL_STEPS_PER_REV);
+        delayMs = snapshot.stopTime;
+        steps   = snapshot.stepsToTake;
     }
+
+    display.setNumber(caseRpmField, caseRPM);
+    display.setNumber(discRpmField, discRPM);
+    display.setNumber(delayField, delayMs);
+    display.setNumber(offsetField, steps);
+    display.flush();
 }
 
+/**
+ * @brief Prints the display traffic counters as one JSON line.
+ */
+void NextionHMI::reportStats() {
+    JsonDocument report;
+    report["hmiBytes"] = display.getBytesWritten();
+    report["hmiWrites"] = display.getWrites();
+    report["hmiSuppressed"] = display.getSuppressed();
+    report["keyPresses"] = keyPresses;
+    report["lastWriteBytes"] = display.getLastWriteBytes();
+    report["lastPressBytes"] = display.getLastPressBytes();
+    report["droppedCommands"] = display.getDroppedCommands();
+    report["pending"] = display.hasPending();
+    report["hmiBaud"] = linkBaud;
+    report["trendEnabled"] = trend.isEnabled();
+    report["trendPoints"] = trend.getPointsSent();
+    report["trendDropped"] = trend.getPointsDropped();
+    report["trendBytes"] = display.getBackgroundBytes();
+    String output;
+    serializeJson(report, output);
+    Serial.println(output);
+}
 
 void NextionHMI::InitMotorsParameters(){
     cmdReceiver->setMotorParameters(1, 0, CASE_MICROSTEP, CaseDir);
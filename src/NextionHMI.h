@@ -6,6 +6,11 @@
 #include "A4988Manager.h" // Make sure to include the header for A4988Manager
 #include "CommandReceiver.h"
 #include "ConfigManager.h"
+#include "NextionDisplay.h"
+#include "NextionProtocol.h"
+#include "NextionTrend.h"
+
+class RecipeManager;
 
 class NextionHMI {
 public:
@@ -13,10 +18,17 @@ public:
     NextionHMI(CommandReceiver* commandReceiver, A4988Manager& motor1, A4988Manager& motor2,ConfigManager*Conf);
 
     void begin();                             // Initialize UART for Nextion HMI
-    void sendCommand(const String &command);  // Send a command to the Nextion HMI
+    void sendCommand(const String &command);  // Queue a command for the Nextion HMI (never blocks)
 
     void handleButtonPress(const String &response);  // Handle button press responses
+    void handleEvent(const NextionEvent& event);     // Handle a decoded display event
+    void handleTouch(const NextionEvent& event);     // Press/release of a button with its component id
     void sendSystemStatus();
+    void reportStats();                       // Print display traffic counters as JSON
+    uint32_t getBaudRate();                   // Negotiated display link rate
+    void setTrendEnabled(bool enabled);       // Start/stop the waveform stream
+    void setRecipes(RecipeManager* recipes);  // Recipe selector page (may be null)
+    void reloadSettings();                    // Re-read settings changed elsewhere (control lock held)
     void InitMotorsParameters();
     int calculateRPM(float pulseFrequency, int microsteps, int stepsPerRevolution);
     String exportToLineByLineString(String input);
@@ -27,6 +39,49 @@ private:
     A4988Manager& _motor1;     // Reference to motor 1
     A4988Manager& _motor2;     // Reference to motor 2
     ConfigManager*Conf;
+    NextionDisplay display;       // Cached component values and TX writer task
+    NextionProtocol protocol;     // UART frame decoder task
+    NextionTrend trend;           // Waveform stream of live measurements
+
+    static void onProtocolEvent(const NextionEvent& event, void* context);
+
+    // Link speed negotiation
+    void writeDirect(const char* command);    // Synchronous write, negotiation only
+    bool ping();                              // sendme, wait for the 0x66 page reply
+    bool connectAt(uint32_t baud);            // Retune Serial1 and ping
+    void sendBaudRate(uint32_t baud);         // bauds= at the current rate, then settle
+    void negotiateBaudRate();
+    SemaphoreHandle_t pageReply;              // Given by handleEvent on a 0x66 frame
+    uint32_t linkBaud;
+
+    // Display component ids
+    int8_t caseRpmField;     // n1
+    int8_t discRpmField;     // n2
+    int8_t delayField;       // n0
+    int8_t offsetField;      // n3
+
+    uint32_t keyPresses;     // Key events handled
+
+    // Recipe selector page
+    void handleRecipeTouch(uint8_t component);
+    void showRecipe();
+    RecipeManager* recipes;
+    int8_t recipeCursor;     // Slot shown on the recipe page, -1 if none
+
+    // Press-and-hold auto-repeat (state guarded by the control lock)
+    static void holdTask(void *pvParameters);
+    static char keyForComponent(uint8_t page, uint8_t component);
+    static bool isAdjustKey(char key);
+    static const char* keyLabel(char key);
+    bool repeatHold();
+    void releaseHold();
+    void stepValue(char key, uint16_t multiplier);  // Working value only
+    void previewValue(char key);                    // Display only
+    void commitValue(char key);                     // NVS + motor/sensor
+    TaskHandle_t holdTaskHandle;
+    char holdKey;            // Adjust key being held, 0 if none
+    uint32_t holdStart;      // millis() of the press
+    uint32_t holdSteps;      // Steps applied during the current hold
 
     uint16_t CaseSpeed;
     uint16_t DiscSpeed;
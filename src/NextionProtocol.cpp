@@ -0,0 +1,233 @@
+#include "NextionProtocol.h"
+#include "Trace.h"
+#include "TaskHealth.h"
+
+/**
+ * @brief Constructor for the NextionProtocol class.
+ */
+NextionProtocol::NextionProtocol()
+    : _serial(nullptr), _handler(nullptr), _context(nullptr), _taskHandle(nullptr),
+      _frameLen(0), _ffCount(0), _frameStart(0), _frameCount(0), _discardedBytes(0) {}
+
+/**
+ * @brief Starts the protocol task and hooks it to the UART receive event.
+ *
+ * @param serial UART connected to the display (already started).
+ * @param handler Function called for every decoded event, from the protocol task.
+ * @param context Opaque pointer passed back to the handler.
+ */
+void NextionProtocol::begin(HardwareSerial* serial, NextionEventHandler handler, void* context) {
+    _serial = serial;
+    _handler = handler;
+    _context = context;
+
+    if (_taskHandle == nullptr) {
+        xTaskCreatePinnedToCore(protocolTask, "Nextion RX Task", NEXTION_TASK_STACK, this,
+                                NEXTION_TASK_PRIORITY, &_taskHandle, NEXTION_TASK_CORE);
+    }
+
+    // Wake the protocol task from the UART driver's event task
+    TaskHandle_t task = _taskHandle;
+    _serial->onReceive([task]() { xTaskNotifyGive(task); }, false);
+}
+
+uint32_t NextionProtocol::getFrameCount() {
+    return _frameCount;
+}
+
+uint32_t NextionProtocol::getDiscardedBytes() {
+    return _discardedBytes;
+}
+
+/**
+ * @brief FreeRTOS task decoding the display's UART stream.
+ *
+ * Blocks until the UART receive callback notifies it. If no data arrives
+ * for NEXTION_IDLE_FLUSH_MS while an unterminated burst is pending, the
+ * burst is decoded as legacy key data.
+ *
+ * @param pvParameters Pointer to the NextionProtocol instance.
+ */
+void NextionProtocol::protocolTask(void *pvParameters) {
+    NextionProtocol* protocol = static_cast<NextionProtocol*>(pvParameters);
+    int8_t health = TaskHealth::add("hmi.rx");
+
+    while (true) {
+        uint32_t notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NEXTION_IDLE_FLUSH_MS));
+        TaskHealth::checkIn(health);
+        if (protocol->_serial == nullptr) continue;
+
+        bool received = false;
+        while (protocol->_serial->available()) {
+            int c = protocol->_serial->read();
+            if (c < 0) break;
+            protocol->feed((uint8_t)c, micros());
+            received = true;
+        }
+
+        if (!notified && !received && protocol->_frameLen > 0) {
+            protocol->flushBurst();
+        }
+    }
+}
+
+/**
+ * @brief Adds one byte to the pending frame, decoding it on 0xFF 0xFF 0xFF.
+ */
+void NextionProtocol::feed(uint8_t byte, uint32_t timestamp) {
+    if (_frameLen == 0) _frameStart = timestamp;
+
+    if (_frameLen >= NEXTION_FRAME_SIZE) {
+        _discardedBytes += _frameLen;  // Runaway frame without terminator
+        _frameLen = 0;
+        _ffCount = 0;
+        _frameStart = timestamp;
+    }
+
+    _frame[_frameLen++] = byte;
+    _ffCount = (byte == 0xFF) ? _ffCount + 1 : 0;
+
+    // A numeric return carries 4 raw bytes that may themselves be 0xFF
+    bool numericIncomplete = _frame[0] == NEXTION_RET_NUMERIC_DATA && _frameLen < 8;
+
+    if (_ffCount >= 3 && !numericIncomplete) {
+        decodeFrame(_frame, _frameLen - 3, _frameStart);
+        _frameLen = 0;
+        _ffCount = 0;
+    }
+}
+
+/**
+ * @brief Decodes one terminated frame into an event.
+ *
+ * @param data Frame payload without the terminator.
+ * @param len Payload length.
+ * @param timestamp Receive time of the first byte.
+ */
+void NextionProtocol::decodeFrame(const uint8_t* data, uint16_t len, uint32_t timestamp) {
+    if (len == 0) return;
+    TRACE_SCOPE("hmi.frame", data[0]);
+    _frameCount++;
+
+    NextionEvent event;
+    memset(&event, 0, sizeof(event));
+    event.code = data[0];
+    event.timestamp = timestamp;
+
+    switch (data[0]) {
+        case NEXTION_RET_TOUCH_EVENT:
+            if (len < 4) break;
+            event.type = NEXTION_EVENT_TOUCH;
+            event.page = data[1];
+            event.component = data[2];
+            event.pressed = data[3];
+            dispatch(event);
+            if (len > 4 && isKeyCode(data[4])) emitKey((char)data[4], timestamp);
+            return;
+
+        case NEXTION_RET_CURRENT_PAGE:
+            if (len < 2) break;
+            event.type = NEXTION_EVENT_PAGE;
+            event.page = data[1];
+            dispatch(event);
+            return;
+
+        case NEXTION_RET_NUMERIC_DATA:
+            if (len < 5) break;
+            event.type = NEXTION_EVENT_NUMBER;
+            event.number = (int32_t)((uint32_t)data[1] | ((uint32_t)data[2] << 8) |
+                                     ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 24));
+            dispatch(event);
+            return;
+
+        case NEXTION_RET_STRING_DATA: {
+            event.type = NEXTION_EVENT_STRING;
+            uint16_t n = len - 1;
+            if (n > NEXTION_STRING_SIZE - 1) n = NEXTION_STRING_SIZE - 1;
+            memcpy(event.text, data + 1, n);
+            event.text[n] = '\0';
+            dispatch(event);
+            return;
+        }
+
+        case NEXTION_RET_TOUCH_COORDINATE:
+        case NEXTION_RET_TOUCH_IN_SLEEP:
+        case NEXTION_RET_AUTO_SLEEP:
+        case NEXTION_RET_AUTO_WAKE:
+        case NEXTION_RET_READY:
+        case NEXTION_RET_SUCCESS:
+            event.type = NEXTION_EVENT_SYSTEM;
+            dispatch(event);
+            return;
+
+        default:
+            if (data[0] <= NEXTION_RET_BUFFER_OVERFLOW) {
+                // Error code, or the 00 00 00 start-up frame
+                event.type = (len == 1) ? NEXTION_EVENT_ERROR : NEXTION_EVENT_SYSTEM;
+                dispatch(event);
+                return;
+            }
+            // Custom frame from the HMI project: key letter at the fifth byte or alone
+            if (len > 4 && isKeyCode(data[4])) {
+                emitKey((char)data[4], timestamp);
+                return;
+            }
+            if (len == 1 && isKeyCode(data[0])) {
+                emitKey((char)data[0], timestamp);
+                return;
+            }
+            break;
+    }
+
+    _discardedBytes += len;  // Malformed or unknown frame
+}
+
+/**
+ * @brief Decodes bytes left unterminated after an idle gap.
+ *
+ * Keeps the historical readResponse() rule (key letter at the fifth byte)
+ * and additionally accepts bursts made only of key letters, so back-to-back
+ * presses are not merged.
+ */
+void NextionProtocol::flushBurst() {
+    uint16_t len = _frameLen;
+    _frameLen = 0;
+    _ffCount = 0;
+
+    if (len > 4) {
+        if (isKeyCode(_frame[4])) {
+            emitKey((char)_frame[4], _frameStart);
+        } else {
+            _discardedBytes += len;
+        }
+        return;
+    }
+
+    for (uint16_t i = 0; i < len; i++) {
+        if (isKeyCode(_frame[i])) {
+            emitKey((char)_frame[i], _frameStart);
+        } else {
+            _discardedBytes++;
+        }
+    }
+}
+
+void NextionProtocol::emitKey(char key, uint32_t timestamp) {
+    NextionEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = NEXTION_EVENT_KEY;
+    event.key = key;
+    event.timestamp = timestamp;
+    dispatch(event);
+}
+
+void NextionProtocol::dispatch(NextionEvent& event) {
+    if (_handler) _handler(event, _context);
+}
+
+/**
+ * @brief True for the button letters sent by the HMI project.
+ */
+bool NextionProtocol::isKeyCode(uint8_t c) {
+    return (c >= 'A' && c <= 'K') || c == 'P' || c == 'S' || c == 'W';
+}
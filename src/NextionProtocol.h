@@ -0,0 +1,87 @@
+#ifndef NEXTION_PROTOCOL_H
+#define NEXTION_PROTOCOL_H
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <FreeRTOS.h>
+#include "Config.h"
+
+// Nextion return codes (first byte of a 0xFF 0xFF 0xFF terminated frame)
+#define NEXTION_RET_INVALID_INSTRUCTION  0x00
+#define NEXTION_RET_SUCCESS              0x01
+#define NEXTION_RET_BUFFER_OVERFLOW      0x24
+#define NEXTION_RET_TOUCH_EVENT          0x65
+#define NEXTION_RET_CURRENT_PAGE         0x66
+#define NEXTION_RET_TOUCH_COORDINATE     0x67
+#define NEXTION_RET_TOUCH_IN_SLEEP       0x68
+#define NEXTION_RET_STRING_DATA          0x70
+#define NEXTION_RET_NUMERIC_DATA         0x71
+#define NEXTION_RET_AUTO_SLEEP           0x86
+#define NEXTION_RET_AUTO_WAKE            0x87
+#define NEXTION_RET_READY                0x88
+
+enum NextionEventType : uint8_t {
+    NEXTION_EVENT_TOUCH,    // 0x65 component press/release
+    NEXTION_EVENT_KEY,      // Single-letter button code sent by the HMI project
+    NEXTION_EVENT_NUMBER,   // 0x71 numeric return
+    NEXTION_EVENT_STRING,   // 0x70 string return
+    NEXTION_EVENT_PAGE,     // 0x66 current page
+    NEXTION_EVENT_ERROR,    // 0x00-0x24 instruction error codes
+    NEXTION_EVENT_SYSTEM,   // Success, sleep/wake, ready and other status codes
+};
+
+struct NextionEvent {
+    NextionEventType type;
+    uint8_t  code;          // Raw return code (first frame byte)
+    uint8_t  page;          // TOUCH / PAGE
+    uint8_t  component;     // TOUCH
+    uint8_t  pressed;       // TOUCH: 1 = press, 0 = release
+    char     key;           // KEY
+    int32_t  number;        // NUMBER
+    char     text[NEXTION_STRING_SIZE];  // STRING (NUL terminated, truncated)
+    uint32_t timestamp;     // micros() when the bytes were read from the UART
+};
+
+typedef void (*NextionEventHandler)(const NextionEvent& event, void* context);
+
+/**
+ * @brief Event-driven decoder for data coming back from the Nextion display.
+ *
+ * A dedicated task sleeps until the UART driver reports received bytes,
+ * splits the stream into 0xFF 0xFF 0xFF terminated frames and hands each
+ * decoded event to the registered handler. Unterminated bursts (the HMI
+ * project's `print` key codes) are flushed after a short idle gap and
+ * decoded the same way readResponse() used to: the fifth byte, or a lone
+ * byte, is taken as the key letter.
+ */
+class NextionProtocol {
+public:
+    NextionProtocol();
+
+    void begin(HardwareSerial* serial, NextionEventHandler handler, void* context);
+    uint32_t getFrameCount();
+    uint32_t getDiscardedBytes();
+
+private:
+    static void protocolTask(void *pvParameters);
+    void feed(uint8_t byte, uint32_t timestamp);
+    void decodeFrame(const uint8_t* data, uint16_t len, uint32_t timestamp);
+    void flushBurst();
+    void emitKey(char key, uint32_t timestamp);
+    void dispatch(NextionEvent& event);
+    static bool isKeyCode(uint8_t c);
+
+    HardwareSerial* _serial;
+    NextionEventHandler _handler;
+    void* _context;
+    TaskHandle_t _taskHandle;
+
+    uint8_t _frame[NEXTION_FRAME_SIZE];
+    uint16_t _frameLen;
+    uint8_t _ffCount;
+    uint32_t _frameStart;   // Timestamp of the first byte of the pending frame
+    uint32_t _frameCount;
+    uint32_t _discardedBytes;
+};
+
+#endif // NEXTION_PROTOCOL_H
@@ -0,0 +1,190 @@
+#include "NextionTrend.h"
+#include "TaskHealth.h"
+
+// Full-scale value of each channel (maps to the top of the waveform)
+static const uint32_t TREND_FULL_SCALE[TREND_CHANNELS] = {
+    NEXTION_TREND_RATE_FULL_SCALE,
+    NEXTION_TREND_RATE_FULL_SCALE,
+    NEXTION_TREND_DWELL_FULL_SCALE,
+    NEXTION_TREND_INTERVAL_FULL_SCALE,
+};
+
+// Channels whose bucket keeps the maximum instead of the mean
+static const bool TREND_KEEP_MAX[TREND_CHANNELS] = { false, false, true, true };
+
+/**
+ * @brief Constructor for the NextionTrend class.
+ */
+NextionTrend::NextionTrend(A4988Manager& caseMotor, A4988Manager& discMotor)
+    : _caseMotor(caseMotor), _discMotor(discMotor), _display(nullptr), _taskHandle(nullptr),
+      _enabled(NEXTION_TREND_DEFAULT_ENABLED), _bucketSamples(0), _lastSampleUs(0),
+      _lastCaseSteps(0), _lastDiscSteps(0), _lastEdges(0), _lastEdgeSeenUs(0),
+      _ringHead(0), _ringCount(0), _budget(0), _pointsSent(0), _pointsDropped(0) {
+    memset(_bucket, 0, sizeof(_bucket));
+}
+
+/**
+ * @brief Starts the sampling task.
+ *
+ * @param display Display whose background queue carries the graph data.
+ */
+void NextionTrend::begin(NextionDisplay* display) {
+    _display = display;
+    resetBaseline(micros());
+
+    if (_taskHandle == nullptr) {
+        xTaskCreatePinnedToCore(trendTask, "Nextion Trend Task", NEXTION_TREND_TASK_STACK, this,
+                                NEXTION_TREND_TASK_PRIORITY, &_taskHandle, NEXTION_TREND_TASK_CORE);
+    }
+}
+
+/**
+ * @brief Starts or stops streaming. Pending points are discarded on stop.
+ */
+void NextionTrend::setEnabled(bool enabled) {
+    _enabled = enabled;
+}
+
+bool NextionTrend::isEnabled() {
+    return _enabled;
+}
+
+uint32_t NextionTrend::getPointsSent() {
+    return _pointsSent;
+}
+
+uint32_t NextionTrend::getPointsDropped() {
+    return _pointsDropped;
+}
+
+/**
+ * @brief FreeRTOS task sampling, downsampling and sending trend points.
+ *
+ * @param pvParameters Pointer to the NextionTrend instance.
+ */
+void NextionTrend::trendTask(void *pvParameters) {
+    NextionTrend* trend = static_cast<NextionTrend*>(pvParameters);
+    TickType_t lastWake = xTaskGetTickCount();
+    int8_t health = TaskHealth::add("hmi.trend");
+
+    while (true) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(NEXTION_TREND_SAMPLE_MS));
+        TaskHealth::checkIn(health);
+        if (!trend->_enabled) {
+            trend->_ringCount = 0;
+            trend->_bucketSamples = 0;
+            memset(trend->_bucket, 0, sizeof(trend->_bucket));
+            trend->resetBaseline(micros());  // The first point after enabling covers one sample period
+            continue;
+        }
+
+        trend->sample(micros());
+        if (trend->_bucketSamples >= NEXTION_TREND_DECIMATION) trend->closeBucket();
+
+        trend->_budget += NEXTION_TREND_BYTES_PER_SEC * NEXTION_TREND_SAMPLE_MS / 1000;
+        if (trend->_budget > NEXTION_TREND_MAX_BURST) trend->_budget = NEXTION_TREND_MAX_BURST;
+        trend->sendPoints();
+    }
+}
+
+/**
+ * @brief Reads the motor counters and adds one sample to the current bucket.
+ */
+void NextionTrend::sample(uint32_t nowUs) {
+    uint32_t elapsedUs = nowUs - _lastSampleUs;
+    if (elapsedUs == 0) return;
+
+    uint32_t caseSteps = _caseMotor.getStepCount();
+    uint32_t discSteps = _discMotor.getStepCount();
+    uint32_t edges = _discMotor.getSensorEdges();
+
+    uint32_t value[TREND_CHANNELS];
+    value[TREND_CASE_RATE] = (uint64_t)(caseSteps - _lastCaseSteps) * 1000000 / elapsedUs;
+    value[TREND_DISC_RATE] = (uint64_t)(discSteps - _lastDiscSteps) * 1000000 / elapsedUs;
+    value[TREND_DWELL] = _discMotor.getLastDwellUs() / 1000;
+
+    // Without new edges, show the time since the last one so a missed edge stands out
+    if (edges != _lastEdges) _lastEdgeSeenUs = nowUs;
+    uint32_t intervalMs = _discMotor.getSensorIntervalUs() / 1000;
+    uint32_t silentMs = (nowUs - _lastEdgeSeenUs) / 1000;
+    value[TREND_SENSOR_INTERVAL] = max(intervalMs, silentMs);
+
+    for (uint8_t ch = 0; ch < TREND_CHANNELS; ch++) {
+        if (TREND_KEEP_MAX[ch]) {
+            _bucket[ch] = max(_bucket[ch], value[ch]);
+        } else {
+            _bucket[ch] += value[ch];
+        }
+    }
+    _bucketSamples++;
+
+    _lastSampleUs = nowUs;
+    _lastCaseSteps = caseSteps;
+    _lastDiscSteps = discSteps;
+    _lastEdges = edges;
+}
+
+/**
+ * @brief Takes the motor counters as they are now as the base of the next sample.
+ */
+void NextionTrend::resetBaseline(uint32_t nowUs) {
+    _lastSampleUs = nowUs;
+    _lastEdgeSeenUs = nowUs;
+    _lastCaseSteps = _caseMotor.getStepCount();
+    _lastDiscSteps = _discMotor.getStepCount();
+    _lastEdges = _discMotor.getSensorEdges();
+}
+
+/**
+ * @brief Turns the current bucket into a point, dropping the oldest if full.
+ */
+void NextionTrend::closeBucket() {
+    if (_ringCount == NEXTION_TREND_RING_SIZE) {
+        _ringHead = (_ringHead + 1) % NEXTION_TREND_RING_SIZE;
+        _ringCount--;
+        _pointsDropped++;
+    }
+
+    Point& point = _ring[(_ringHead + _ringCount) % NEXTION_TREND_RING_SIZE];
+    for (uint8_t ch = 0; ch < TREND_CHANNELS; ch++) {
+        uint32_t v = TREND_KEEP_MAX[ch] ? _bucket[ch] : _bucket[ch] / _bucketSamples;
+        point.value[ch] = scale(v, TREND_FULL_SCALE[ch]);
+    }
+    _ringCount++;
+
+    memset(_bucket, 0, sizeof(_bucket));
+    _bucketSamples = 0;
+}
+
+/**
+ * @brief Sends queued points while the byte budget and display queue allow.
+ */
+void NextionTrend::sendPoints() {
+    char line[NEXTION_COMMAND_SIZE];
+
+    while (_ringCount > 0 && _display->getBackgroundSpace() >= TREND_CHANNELS) {
+        Point& point = _ring[_ringHead];
+        int cost = 0;
+        for (uint8_t ch = 0; ch < TREND_CHANNELS; ch++) {
+            cost += snprintf(nullptr, 0, "add %u,%u,%u", NEXTION_TREND_WAVEFORM_ID, ch, point.value[ch]) + 3;
+        }
+        if (cost > _budget) return;
+
+        for (uint8_t ch = 0; ch < TREND_CHANNELS; ch++) {
+            snprintf(line, sizeof(line), "add %u,%u,%u", NEXTION_TREND_WAVEFORM_ID, ch, point.value[ch]);
+            _display->sendBackground(line);
+        }
+        _budget -= cost;
+        _ringHead = (_ringHead + 1) % NEXTION_TREND_RING_SIZE;
+        _ringCount--;
+        _pointsSent++;
+    }
+}
+
+/**
+ * @brief Maps a value onto the waveform height, saturating at full scale.
+ */
+uint8_t NextionTrend::scale(uint32_t value, uint32_t fullScale) {
+    if (value >= fullScale) return NEXTION_TREND_HEIGHT;
+    return (uint8_t)((uint64_t)value * NEXTION_TREND_HEIGHT / fullScale);
+}
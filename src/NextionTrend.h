@@ -0,0 +1,79 @@
+#ifndef NEXTION_TREND_H
+#define NEXTION_TREND_H
+
+#include <Arduino.h>
+#include <FreeRTOS.h>
+#include "Config.h"
+#include "A4988Manager.h"
+#include "NextionDisplay.h"
+
+// Waveform channels
+enum NextionTrendChannel : uint8_t {
+    TREND_CASE_RATE = 0,    // Case axis step rate (steps/s)
+    TREND_DISC_RATE,        // Disc axis step rate (steps/s)
+    TREND_DWELL,            // Measured stop time after a sensor edge (ms)
+    TREND_SENSOR_INTERVAL,  // Time between sensor edges, grows while edges are missing (ms)
+    TREND_CHANNELS
+};
+
+/**
+ * @brief Streams live axis and sensor measurements to a Nextion waveform.
+ *
+ * A low-priority task samples the motor counters every
+ * NEXTION_TREND_SAMPLE_MS and folds NEXTION_TREND_DECIMATION samples into
+ * one point (rates averaged, dwell and interval kept at their maximum so
+ * spikes survive). Points wait in a small ring and are sent as `add`
+ * commands through the display's background queue, limited by a byte
+ * budget, so the graph never competes with control updates. When the
+ * link cannot keep up the oldest points are dropped.
+ */
+class NextionTrend {
+public:
+    NextionTrend(A4988Manager& caseMotor, A4988Manager& discMotor);
+
+    void begin(NextionDisplay* display);
+    void setEnabled(bool enabled);
+    bool isEnabled();
+    uint32_t getPointsSent();
+    uint32_t getPointsDropped();
+
+private:
+    struct Point {
+        uint8_t value[TREND_CHANNELS];  // Scaled to the waveform height
+    };
+
+    static void trendTask(void *pvParameters);
+    void sample(uint32_t nowUs);
+    void resetBaseline(uint32_t nowUs);
+    void closeBucket();
+    void sendPoints();
+    static uint8_t scale(uint32_t value, uint32_t fullScale);
+
+    A4988Manager& _caseMotor;
+    A4988Manager& _discMotor;
+    NextionDisplay* _display;
+    TaskHandle_t _taskHandle;
+    bool _enabled;
+
+    // Current downsampling bucket
+    uint32_t _bucket[TREND_CHANNELS];
+    uint8_t _bucketSamples;
+
+    // Counter state from the previous sample
+    uint32_t _lastSampleUs;
+    uint32_t _lastCaseSteps;
+    uint32_t _lastDiscSteps;
+    uint32_t _lastEdges;
+    uint32_t _lastEdgeSeenUs;
+
+    // Points waiting for bandwidth
+    Point _ring[NEXTION_TREND_RING_SIZE];
+    uint8_t _ringHead;
+    uint8_t _ringCount;
+    int32_t _budget;  // Bytes that may be sent now
+
+    uint32_t _pointsSent;
+    uint32_t _pointsDropped;
+};
+
+#endif // NEXTION_TREND_H
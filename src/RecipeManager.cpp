@@ -0,0 +1,282 @@
+#include "RecipeManager.h"
+#include "CommandReceiver.h"
+#include "DeferredLog.h"
+#include "NextionHMI.h"
+
+// JSON field of each recipe value, indexed by SettingId
+static const char* const RECIPE_FIELDS[RECIPE_SETTINGS] = {
+    "delay",       // SETTING_DELAY_MS
+    "offset",      // SETTING_OFFSET_STEPS
+    "caseSpeed",   // SETTING_CASE_RPM
+    "discSpeed",   // SETTING_DISC_RPM
+    "caseDir",     // SETTING_CASE_DIR
+    "discDir",     // SETTING_DISC_DIR
+};
+
+/**
+ * @brief Constructor for the RecipeManager class.
+ */
+RecipeManager::RecipeManager(ConfigManager* config, CommandReceiver* commandReceiver, SDCardManager* sdCard,
+                             A4988Manager& caseMotor, A4988Manager& discMotor)
+    : config(config), cmdReceiver(commandReceiver), sdCard(sdCard), _caseMotor(caseMotor),
+      _discMotor(discMotor), hmi(nullptr), switches(0) {}
+
+void RecipeManager::setHMI(NextionHMI* hmi) {
+    this->hmi = hmi;
+}
+
+/**
+ * @brief Switches to the recipe in @p slot.
+ *
+ * The recipe is read and fully validated before anything moves. Running
+ * axes are ramped to the new speeds; an axis that changes direction is
+ * ramped down to HMI_SPEED_MIN, reversed, then ramped up. Stopped axes
+ * stay stopped and only take the new direction. The sensor parameters
+ * are set once at the end and all values are committed together.
+ *
+ * Called with the control lock held; the lock is released while waiting
+ * between ramp steps, so the host and the panel are not locked out for
+ * the RECIPE_RAMP_MS of a ramp.
+ *
+ * @return False if the slot is empty or the recipe is invalid.
+ */
+bool RecipeManager::apply(uint8_t slot) {
+    Recipe recipe;
+    if (!config->loadRecipe(slot, recipe)) {
+        LOG_WARN(LOG_RECIPE_REJECTED, slot);
+        return false;
+    }
+
+    A4988Manager* axes[2] = { &_caseMotor, &_discMotor };
+    const SettingId speedIds[2] = { SETTING_CASE_RPM, SETTING_DISC_RPM };
+    const SettingId dirIds[2] = { SETTING_CASE_DIR, SETTING_DISC_DIR };
+
+    float from[2], mid[2], to[2];
+    bool running[2], reverse[2];
+    bool anyReverse = false;
+    for (uint8_t i = 0; i < 2; i++) {
+        bool dir = recipe.values[dirIds[i]] != 0;
+        from[i] = axes[i]->getSpeed();
+        to[i] = recipe.values[speedIds[i]];
+        running[i] = from[i] > 0;
+        reverse[i] = running[i] && (axes[i]->getDir() != 0) != dir;
+        mid[i] = reverse[i] ? HMI_SPEED_MIN : to[i];
+        anyReverse |= reverse[i];
+        if (!running[i]) axes[i]->setDirPin(dir);
+    }
+
+    uint32_t start = millis();
+    bool takenOver[2] = { false, false };
+    ramp(from, mid, running, takenOver);
+    if (anyReverse) {
+        for (uint8_t i = 0; i < 2; i++) {
+            if (reverse[i] && !takenOver[i]) axes[i]->setDirPin(recipe.values[dirIds[i]] != 0);
+        }
+        ramp(mid, to, running, takenOver);
+    }
+
+    // A taken-over axis keeps what it was set to, the settings follow it
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!takenOver[i]) continue;
+        int32_t speed = (int32_t)axes[i]->getSpeed();
+        recipe.values[speedIds[i]] = ConfigManager::settingInRange(speedIds[i], speed) ? speed
+                                                                                        : config->getSetting(speedIds[i]);
+        recipe.values[dirIds[i]] = axes[i]->getDir() != 0;
+    }
+
+    cmdReceiver->setSensorParameters(2, recipe.values[SETTING_DELAY_MS], recipe.values[SETTING_OFFSET_STEPS]);
+    config->setSettings(recipe.values, RECIPE_SETTINGS);
+    config->setSetting(SETTING_ACTIVE_RECIPE, slot);
+    if (hmi) hmi->reloadSettings();
+
+    switches++;
+    LOG_INFO(LOG_RECIPE_APPLIED, slot, millis() - start);
+    return true;
+}
+
+/**
+ * @brief Moves the running axes from @p from to @p to in RECIPE_RAMP_STEPS.
+ *
+ * Each step is applied under the control lock, which is released during
+ * the wait before it. An axis whose speed was changed by someone else in
+ * the meantime is left alone for the rest of the ramp and flagged in
+ * @p takenOver; axes already flagged are skipped.
+ */
+void RecipeManager::ramp(const float* from, const float* to, const bool* running, bool* takenOver) {
+    A4988Manager* axes[2] = { &_caseMotor, &_discMotor };
+    bool moving[2];
+    float set[2];
+    bool any = false;
+    for (uint8_t i = 0; i < 2; i++) {
+        moving[i] = running[i] && !takenOver[i] && from[i] != to[i];
+        set[i] = from[i];
+        any |= moving[i];
+    }
+    if (!any) return;
+
+    for (uint8_t step = 1; step <= RECIPE_RAMP_STEPS; step++) {
+        cmdReceiver->unlockControl();
+        vTaskDelay(pdMS_TO_TICKS(RECIPE_RAMP_MS / RECIPE_RAMP_STEPS));
+        cmdReceiver->lockControl();
+        for (uint8_t i = 0; i < 2; i++) {
+            if (!moving[i]) continue;
+            if (axes[i]->getSpeed() != set[i]) {
+                moving[i] = false;  // Taken over by a host or panel change
+                takenOver[i] = true;
+                continue;
+            }
+            set[i] = from[i] + (to[i] - from[i]) * step / RECIPE_RAMP_STEPS;
+            axes[i]->setFrequency(set[i]);
+        }
+    }
+}
+
+/**
+ * @brief Stores a recipe given as JSON.
+ *
+ * Values missing from @p json are taken from the current settings, so
+ * `{"name":"X"}` captures the running setup.
+ *
+ * @param slot Target slot, or -1 to replace the recipe of the same name
+ *        or use the first free slot.
+ * @return False if the JSON, the values or the slot are invalid.
+ */
+bool RecipeManager::store(JsonVariantConst json, int8_t slot) {
+    Recipe recipe;
+    for (uint8_t id = 0; id < RECIPE_SETTINGS; id++) recipe.values[id] = config->getSetting((SettingId)id);
+    if (!fromJson(json, recipe)) return false;
+
+    if (slot < 0) slot = config->findRecipe(recipe.name);
+    if (slot < 0) slot = config->findFreeRecipeSlot();
+    if (slot < 0) return false;
+    return config->saveRecipe(slot, recipe);
+}
+
+/**
+ * @brief Adds every stored recipe and the active slot to @p doc.
+ */
+void RecipeManager::exportJson(JsonDocument& doc) {
+    JsonArray list = doc["recipes"].to<JsonArray>();
+    Recipe recipe;
+    for (uint8_t slot = 0; slot < RECIPE_MAX_COUNT; slot++) {
+        if (!config->loadRecipe(slot, recipe)) continue;
+        JsonObject item = list.add<JsonObject>();
+        item["slot"] = slot;
+        toJson(recipe, item);
+    }
+    doc["active"] = config->getSetting(SETTING_ACTIVE_RECIPE);
+}
+
+/**
+ * @brief Imports the recipes of a file written by exportToSD().
+ *
+ * Each entry is stored like store() with its "slot" if present. Invalid
+ * entries, including those with a slot out of range, are skipped.
+ *
+ * @return Number of recipes stored, or -1 if the card or file is unusable.
+ */
+int16_t RecipeManager::importFromSD(const char* path) {
+    if (sdCard == nullptr || !sdCard->isInitialized()) return -1;
+    File file = SD.open(path, FILE_READ);
+    if (!file) return -1;
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error) return -1;
+
+    int16_t stored = 0;
+    for (JsonVariantConst item : doc["recipes"].as<JsonArrayConst>()) {
+        int8_t slot;
+        if (slotFromJson(item["slot"], slot) && store(item, slot)) stored++;
+    }
+    return stored;
+}
+
+/**
+ * @brief Reads a "slot" value without narrowing it first.
+ *
+ * @param slot Set to the slot, or -1 if @p value is missing.
+ * @return False if @p value is present but not 0..RECIPE_MAX_COUNT-1.
+ */
+bool RecipeManager::slotFromJson(JsonVariantConst value, int8_t& slot) {
+    slot = -1;
+    if (value.isNull()) return true;
+    if (!value.is<int>()) return false;
+    int number = value.as<int>();
+    if (number < 0 || number >= RECIPE_MAX_COUNT) return false;
+    slot = (int8_t)number;
+    return true;
+}
+
+/**
+ * @brief Writes all recipes to @p path in the exportJson() format.
+ */
+bool RecipeManager::exportToSD(const char* path) {
+    if (sdCard == nullptr || !sdCard->isInitialized()) return false;
+    File file = SD.open(path, FILE_WRITE);
+    if (!file) return false;
+
+    JsonDocument doc;
+    exportJson(doc);
+    bool ok = serializeJson(doc, file) > 0;
+    file.close();
+    return ok;
+}
+
+/**
+ * @brief Next used slot after @p from in @p direction (+1/-1), wrapping.
+ *
+ * @param from Starting slot, or -1 to start from the beginning.
+ * @return The slot, or -1 if no recipe is stored.
+ */
+int8_t RecipeManager::nextSlot(int8_t from, int8_t direction) {
+    Recipe recipe;
+    int8_t slot = from < 0 ? (direction > 0 ? -1 : 0) : from;
+    for (uint8_t tried = 0; tried < RECIPE_MAX_COUNT; tried++) {
+        slot = (slot + direction + RECIPE_MAX_COUNT) % RECIPE_MAX_COUNT;
+        if (config->loadRecipe(slot, recipe)) return slot;
+    }
+    return -1;
+}
+
+uint32_t RecipeManager::getSwitches() {
+    return switches;
+}
+
+/**
+ * @brief Fills @p recipe from JSON; fields not present are left unchanged.
+ *
+ * @return False if the name is missing or too long, or a field has the
+ *         wrong type. Ranges are checked when the recipe is saved.
+ */
+bool RecipeManager::fromJson(JsonVariantConst json, Recipe& recipe) {
+    const char* name = json["name"] | (const char*)nullptr;
+    if (name == nullptr || name[0] == '\0' || strlen(name) >= sizeof(recipe.name)) return false;
+    memset(recipe.name, 0, sizeof(recipe.name));
+    strncpy(recipe.name, name, sizeof(recipe.name) - 1);
+
+    for (uint8_t id = 0; id < RECIPE_SETTINGS; id++) {
+        JsonVariantConst field = json[RECIPE_FIELDS[id]];
+        if (field.isNull()) continue;
+        if (CONFIG_SCHEMA[id].type == SETTING_BOOL) {
+            if (!field.is<bool>()) return false;
+            recipe.values[id] = field.as<bool>() ? 1 : 0;
+        } else {
+            if (!field.is<int32_t>()) return false;
+            recipe.values[id] = field.as<int32_t>();
+        }
+    }
+    return true;
+}
+
+void RecipeManager::toJson(const Recipe& recipe, JsonObject json) {
+    json["name"] = String(recipe.name);  // Copied; the recipe is usually a local
+    for (uint8_t id = 0; id < RECIPE_SETTINGS; id++) {
+        if (CONFIG_SCHEMA[id].type == SETTING_BOOL) {
+            json[RECIPE_FIELDS[id]] = recipe.values[id] != 0;
+        } else {
+            json[RECIPE_FIELDS[id]] = recipe.values[id];
+        }
+    }
+}
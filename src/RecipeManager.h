@@ -0,0 +1,63 @@
+#ifndef RECIPE_MANAGER_H
+#define RECIPE_MANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "Config.h"
+#include "A4988Manager.h"
+#include "ConfigManager.h"
+#include "SDCardManager.h"
+
+class CommandReceiver;
+class NextionHMI;
+
+/**
+ * @brief Named production recipes: storage, JSON import/export and switching.
+ *
+ * A recipe is a complete motion parameter set (speeds, directions, sensor
+ * delay and offset) kept in a ConfigManager slot. Applying one validates
+ * the whole set first, then ramps the running axes from their current to
+ * the new speeds (through the minimum speed when an axis reverses), sets
+ * the sensor parameters once and stores all values as the current
+ * settings in a single commit. The caller must hold the control lock;
+ * it is only released between ramp steps, and an axis changed from
+ * elsewhere during the ramp keeps that change, which is also what gets
+ * stored for it.
+ *
+ * JSON form of a recipe:
+ *   {"name":"PET-500","caseSpeed":250,"discSpeed":750,"delay":1000,
+ *    "offset":100,"caseDir":false,"discDir":false}
+ */
+class RecipeManager {
+public:
+    RecipeManager(ConfigManager* config, CommandReceiver* commandReceiver, SDCardManager* sdCard,
+                  A4988Manager& caseMotor, A4988Manager& discMotor);
+
+    void setHMI(NextionHMI* hmi);          // Refreshed after a switch (may be null)
+
+    bool apply(uint8_t slot);              // Control lock held by the caller, released between ramp steps
+    bool store(JsonVariantConst json, int8_t slot = -1);  // Same name replaces, else first free slot
+    void exportJson(JsonDocument& doc);    // {"recipes":[...],"active":n}
+    int16_t importFromSD(const char* path);    // Recipes stored, -1 if the file is unusable
+    bool exportToSD(const char* path);
+    int8_t nextSlot(int8_t from, int8_t direction);  // Next used slot, wrapping; -1 if none
+
+    uint32_t getSwitches();
+
+    static bool fromJson(JsonVariantConst json, Recipe& recipe);
+    static bool slotFromJson(JsonVariantConst value, int8_t& slot);  // Missing = -1, false if out of range
+    static void toJson(const Recipe& recipe, JsonObject json);
+
+private:
+    void ramp(const float* from, const float* to, const bool* running, bool* takenOver);
+
+    ConfigManager* config;
+    CommandReceiver* cmdReceiver;
+    SDCardManager* sdCard;
+    A4988Manager& _caseMotor;
+    A4988Manager& _discMotor;
+    NextionHMI* hmi;
+    uint32_t switches;       // Recipes applied since boot
+};
+
+#endif // RECIPE_MANAGER_H
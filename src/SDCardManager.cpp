@@ -1,4 +1,5 @@
 #include "SDCardManager.h"
+#include "Trace.h"
 
 // Constructor: No parameters needed since pins are defined in Config.h
 SDCardManager::SDCardManager() {
@@ -8,6 +9,7 @@ SDCardManager::SDCardManager() {
 
 // Method to initialize the SD card
 bool SDCardManager::begin() {
+  TRACE_SCOPE("sd.begin");
   // Set up the SPI interface with custom pins
   SPI.begin(SD_CLK_PIN, SD_MISO_PIN, SD_MOSI_PIN, SD_NCS_PIN);
   
@@ -35,6 +37,7 @@ String SDCardManager::getError() {
 
 // List files in the root directory (for debugging purposes)
 void SDCardManager::listFiles() {
+  TRACE_SCOPE("sd.list");
   if (!_initialized) {
     Serial.println("SD Card not initialized.");
     return;
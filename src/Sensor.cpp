@@ -1,5 +1,6 @@
 #include "Sensor.h"
 #include "Config.h"
+#include "EventLogger.h"
 
 // Initialize static members
 Sensor* Sensor::currentSensor = nullptr; ///< Pointer to the current instance of the sensor
@@ -11,7 +12,7 @@ Sensor* Sensor::currentSensor = nullptr; ///< Pointer to the current instance of
  * @param motor The motor that will be controlled by this sensor.
  */
 Sensor::Sensor(int pin)
-    : _pin(pin) {
+    : _pin(pin), captureMotor(nullptr) {
     currentSensor = this; // Set current instance of the sensor
 }
 
@@ -24,3 +25,41 @@ void Sensor::begin() {
     pinMode(_pin, INPUT); // Configure the sensor pin as input 
 }
 
+/**
+ * @brief Starts logging every sensor transition from a pin interrupt.
+ *
+ * The motor task only polls the sensor once per step and only while it
+ * waits for an edge; the interrupt sees every transition, including
+ * bounces and products passing during a stop, each logged with the step
+ * count of @p motor at that moment.
+ */
+void Sensor::startCapture(A4988Manager* motor) {
+    captureMotor = motor;
+    attachInterrupt(digitalPinToInterrupt(_pin), onEdge, CHANGE);
+    EventLogger::record(EVENT_SENSOR_RAW, EVENT_SOURCE_DISC, motor->getStepCount(), digitalRead(_pin));
+}
+
+void Sensor::stopCapture() {
+    if (captureMotor == nullptr) return;
+    detachInterrupt(digitalPinToInterrupt(_pin));
+    captureMotor = nullptr;
+}
+
+bool Sensor::isCapturing() {
+    return captureMotor != nullptr;
+}
+
+/**
+ * @brief Pin change interrupt of the capture.
+ *
+ * Not IRAM: EventLogger::record(), getStepCount() and digitalRead() are in
+ * flash. The build must keep CONFIG_ARDUINO_ISR_IRAM off, so the GPIO
+ * interrupt is held off while the flash cache is disabled (NVS commits)
+ * rather than run into flash code.
+ */
+void Sensor::onEdge() {
+    Sensor* sensor = currentSensor;
+    if (sensor == nullptr || sensor->captureMotor == nullptr) return;
+    EventLogger::record(EVENT_SENSOR_RAW, EVENT_SOURCE_DISC, sensor->captureMotor->getStepCount(),
+                        digitalRead(sensor->_pin));
+}
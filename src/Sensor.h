@@ -11,9 +11,16 @@ public:
     
     void begin();
 
+    // Trace capture: log every raw sensor edge with the position of @p motor
+    void startCapture(A4988Manager* motor);
+    void stopCapture();
+    bool isCapturing();
+
 private:
     int _pin;
+    A4988Manager* captureMotor;   // Axis whose step count is logged with each edge
     static Sensor *currentSensor; // To store the current sensor instance for interrupt
+    static void onEdge();         // Sensor pin change interrupt, runs from flash (see Sensor.cpp)
 
 };
 
@@ -0,0 +1,139 @@
+#include "StatusEncoder.h"
+
+/**
+ * @brief Constructor for the StatusEncoder class.
+ */
+StatusEncoder::StatusEncoder() : _jsonLen(0), _ready(false) {}
+
+/**
+ * @brief Renders the JSON template with empty value slots.
+ *
+ * The JSON layout matches the historical GETSTATUS reply so existing host
+ * tools keep parsing it unchanged.
+ */
+void StatusEncoder::begin() {
+    if (_ready) return;
+    _jsonLen = 0;
+
+    appendJson("{\"status\":\"ok\",\"motorCase\":{\"speed\":");
+    _caseSpeed = addJsonSlot(9);
+    appendJson(",\"microsteps\":");
+    _caseMicro = addJsonSlot(2);
+    appendJson(",\"direction\":");
+    _caseDir = addJsonSlot(1);
+    appendJson("},\"motorDisc\":{\"speed\":");
+    _discSpeed = addJsonSlot(9);
+    appendJson(",\"microsteps\":");
+    _discMicro = addJsonSlot(2);
+    appendJson(",\"direction\":");
+    _discDir = addJsonSlot(1);
+    appendJson("},\"sensor\":{\"stop\":");
+    _stop = addJsonSlot(10);
+    appendJson(",\"stepsToTake\":");
+    _steps = addJsonSlot(10);
+    appendJson("},\"system\":{\"status\":");
+    _sysStatus = addJsonSlot(8);       // "active" / "idle" incl. quotes
+    appendJson(",\"lastCommand\":");
+    _lastCommand = addJsonSlot(14);    // Quoted command name
+    appendJson("}}\n");
+
+    _ready = true;
+}
+
+/**
+ * @brief Patches a snapshot into the JSON template.
+ *
+ * @param s Snapshot to encode.
+ * @param out Receives a pointer to the encoded line (valid until the next call).
+ * @return Length of the encoded line in bytes, newline included.
+ */
+size_t StatusEncoder::encodeJson(const StatusSnapshot& s, const uint8_t** out) {
+    if (!_ready) begin();
+
+    patchFixed2(_json, _caseSpeed, s.caseSpeed);
+    patchUInt(_json, _caseMicro, s.caseMicrosteps, ' ');
+    patchUInt(_json, _caseDir, s.caseDir, ' ');
+    patchFixed2(_json, _discSpeed, s.discSpeed);
+    patchUInt(_json, _discMicro, s.discMicrosteps, ' ');
+    patchUInt(_json, _discDir, s.discDir, ' ');
+    patchUInt(_json, _stop, s.stopTime, ' ');
+    patchUInt(_json, _steps, s.stepsToTake, ' ');
+    patchString(_json, _sysStatus, s.running ? "active" : "idle");
+    patchString(_json, _lastCommand, s.lastCommand);
+
+    *out = (const uint8_t*)_json;
+    return _jsonLen;
+}
+
+void StatusEncoder::appendJson(const char* text) {
+    size_t len = strlen(text);
+    if (_jsonLen + len > sizeof(_json)) return;
+    memcpy(_json + _jsonLen, text, len);
+    _jsonLen += len;
+}
+
+StatusEncoder::Slot StatusEncoder::addJsonSlot(uint8_t width) {
+    Slot slot = { _jsonLen, width };
+    if (_jsonLen + width > sizeof(_json)) return slot;
+    memset(_json + _jsonLen, ' ', width);
+    _jsonLen += width;
+    return slot;
+}
+
+/**
+ * @brief Writes an unsigned value right-aligned into a slot.
+ *
+ * Values wider than the slot saturate to all nines.
+ */
+void StatusEncoder::patchUInt(char* buf, const Slot& slot, uint32_t value, char pad) {
+    char* p = buf + slot.offset + slot.width;
+    uint8_t i = 0;
+    do {
+        *--p = '0' + (value % 10);
+        value /= 10;
+        i++;
+    } while (value && i < slot.width);
+
+    if (value) {
+        memset(buf + slot.offset, '9', slot.width);
+        return;
+    }
+    while (i++ < slot.width) *--p = pad;
+}
+
+/**
+ * @brief Writes a non-negative float with two decimals right-aligned into a slot.
+ *
+ * Values too wide for the slot saturate to all nines.
+ */
+void StatusEncoder::patchFixed2(char* buf, const Slot& slot, float value) {
+    Slot whole = { slot.offset, (uint8_t)(slot.width - 3) };
+    float limit = 1.0f;
+    for (uint8_t i = 0; i < whole.width; i++) limit *= 10.0f;
+    if (value < 0) value = 0;
+    if (value >= limit) value = limit - 0.01f;  // Saturate to 99...9.99
+    uint32_t scaled = (uint32_t)(value * 100.0f + 0.5f);
+    patchUInt(buf, whole, scaled / 100, ' ');
+    char* frac = buf + slot.offset + slot.width - 3;
+    frac[0] = '.';
+    frac[1] = '0' + (scaled / 10) % 10;
+    frac[2] = '0' + scaled % 10;
+}
+
+/**
+ * @brief Writes a quoted string left-aligned into a slot, padding with spaces.
+ *
+ * Strings longer than the slot are truncated.
+ */
+void StatusEncoder::patchString(char* buf, const Slot& slot, const char* value) {
+    char* p = buf + slot.offset;
+    uint8_t room = slot.width - 2;
+    uint8_t n = 0;
+    *p++ = '"';
+    while (value && value[n] && n < room) {
+        *p++ = value[n];
+        n++;
+    }
+    *p++ = '"';
+    while (n++ < room) *p++ = ' ';
+}
@@ -0,0 +1,50 @@
+#ifndef STATUS_ENCODER_H
+#define STATUS_ENCODER_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "StatusSnapshot.h"
+
+/**
+ * @brief Formats status messages by patching a prebuilt template.
+ *
+ * The fixed parts of the GETSTATUS JSON line are rendered once in
+ * begin(). Each encode call only overwrites the fixed-width value slots,
+ * so no heap allocation or full re-serialization happens per message.
+ * Numbers are padded with leading spaces (valid JSON whitespace).
+ */
+class StatusEncoder {
+public:
+    StatusEncoder();
+
+    void begin();  // Build the template (called once)
+
+    // Patch the snapshot into the JSON template; returns its length
+    size_t encodeJson(const StatusSnapshot& s, const uint8_t** out);
+
+private:
+    struct Slot {
+        uint16_t offset;
+        uint8_t width;
+    };
+
+    // Template building helpers
+    void appendJson(const char* text);
+    Slot addJsonSlot(uint8_t width);
+
+    // Slot patchers
+    static void patchUInt(char* buf, const Slot& slot, uint32_t value, char pad);
+    static void patchFixed2(char* buf, const Slot& slot, float value);
+    static void patchString(char* buf, const Slot& slot, const char* value);
+
+    char _json[STATUS_JSON_TEMPLATE_SIZE];
+    uint16_t _jsonLen;
+    bool _ready;
+
+    Slot _caseSpeed, _caseMicro, _caseDir;
+    Slot _discSpeed, _discMicro, _discDir;
+    Slot _stop, _steps;
+    Slot _sysStatus, _lastCommand;
+};
+
+#endif // STATUS_ENCODER_H
@@ -0,0 +1,25 @@
+#ifndef STATUS_SNAPSHOT_H
+#define STATUS_SNAPSHOT_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Plain copy of the machine state reported to the host and the HMI.
+ *
+ * Captured in one go by CommandReceiver::captureStatus() so every consumer
+ * (GETSTATUS replies, telemetry frames) formats the same values.
+ */
+struct StatusSnapshot {
+    float    caseSpeed;        // Case motor step frequency (Hz)
+    uint8_t  caseMicrosteps;   // Case motor microstep resolution
+    uint8_t  caseDir;          // Case motor direction pin level
+    float    discSpeed;        // Disc motor step frequency (Hz)
+    uint8_t  discMicrosteps;   // Disc motor microstep resolution
+    uint8_t  discDir;          // Disc motor direction pin level
+    uint32_t stopTime;         // Sensor stop time (ms)
+    uint32_t stepsToTake;      // Steps taken after a sensor edge
+    bool     running;          // True while at least one axis is stepping
+    const char* lastCommand;   // Last command executed (static string)
+};
+
+#endif // STATUS_SNAPSHOT_H
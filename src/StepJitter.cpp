@@ -0,0 +1,98 @@
+#include "StepJitter.h"
+
+/**
+ * @brief Constructor for the StepJitter class.
+ *
+ * @param lateName, earlyName Static metric names of the two histograms.
+ */
+StepJitter::StepJitter(const char* lateName, const char* earlyName)
+    : enabled(STEP_JITTER_DEFAULT_ENABLED), synced(false), lastEdge(0), cyclesPerUs(0),
+      lastDeviationNs(0), samples(0), resyncs(0), late(lateName, "ns"), early(earlyName, "ns") {
+    worstLock = portMUX_INITIALIZER_UNLOCKED;
+    memset(&worst, 0, sizeof(worst));
+}
+
+/**
+ * @brief Turns sampling on or off; turning it on starts a new period.
+ */
+void StepJitter::setEnabled(bool on) {
+    if (on && !enabled) {
+        cyclesPerUs = ESP.getCpuFreqMHz();
+        synced = false;
+    }
+    enabled = on;
+}
+
+void StepJitter::resync() {
+    synced = false;
+}
+
+/**
+ * @brief Compares this edge with the previous one plus @p periodUs.
+ *
+ * Runs in the step task; only the rare update of the worst case takes a
+ * lock.
+ */
+void StepJitter::sample(uint32_t periodUs, uint32_t stepCount) {
+    uint32_t now = ESP.getCycleCount();
+    uint32_t elapsed = now - lastEdge;
+    bool regular = synced && cyclesPerUs != 0;
+    lastEdge = now;
+    synced = true;
+    if (!regular) {
+        resyncs++;
+        return;
+    }
+
+    int64_t deviationCycles = (int64_t)elapsed - (int64_t)periodUs * cyclesPerUs;
+    int64_t ns = deviationCycles * 1000 / (int32_t)cyclesPerUs;
+    int32_t deviationNs = (int32_t)constrain(ns, (int64_t)-INT32_MAX, (int64_t)INT32_MAX);
+    if (deviationNs >= 0) late.record(deviationNs); else early.record(-deviationNs);
+    samples++;
+
+    if (abs(deviationNs) > abs(worst.deviationNs)) {
+        portENTER_CRITICAL(&worstLock);
+        worst.deviationNs = deviationNs;
+        worst.periodUs = periodUs;
+        worst.actualUs = elapsed / cyclesPerUs;
+        worst.stepCount = stepCount;
+        worst.atMs = millis();
+        worst.previousNs = lastDeviationNs;
+        portEXIT_CRITICAL(&worstLock);
+    }
+    lastDeviationNs = deviationNs;
+}
+
+void StepJitter::reset() {
+    late.reset();
+    early.reset();
+    portENTER_CRITICAL(&worstLock);
+    memset(&worst, 0, sizeof(worst));
+    portEXIT_CRITICAL(&worstLock);
+    samples = 0;
+    resyncs = 0;
+    synced = false;
+}
+
+/**
+ * @brief Adds the state, both histograms and the worst edge to @p out.
+ */
+void StepJitter::report(JsonObject out) {
+    out["enabled"] = (bool)enabled;
+    out["samples"] = samples;
+    out["resyncs"] = resyncs;
+    late.report(out["lateNs"].to<JsonObject>());
+    early.report(out["earlyNs"].to<JsonObject>());
+
+    portENTER_CRITICAL(&worstLock);
+    Worst copy = worst;
+    portEXIT_CRITICAL(&worstLock);
+    if (copy.deviationNs == 0) return;
+    JsonObject item = out["worst"].to<JsonObject>();
+    item["deviationNs"] = copy.deviationNs;
+    item["periodUs"] = copy.periodUs;
+    item["actualUs"] = copy.actualUs;
+    item["step"] = copy.stepCount;
+    item["atMs"] = copy.atMs;
+    item["previousNs"] = copy.previousNs;
+}
@@ -0,0 +1,58 @@
+#ifndef STEP_JITTER_H
+#define STEP_JITTER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FreeRTOS.h>
+#include "Config.h"
+#include "Metrics.h"
+
+/**
+ * @file StepJitter.h
+ * @brief Timing check of the step pulses of one axis (JITTER command).
+ *
+ * When enabled, every rising step edge is timestamped with the CPU cycle
+ * counter and compared with the schedule: the previous edge plus one step
+ * period. Late and early deviations go into two histograms (ns, also
+ * listed by GETMETRICS) and the largest one is kept with its context.
+ *
+ * Edges that do not follow a regular period (first step after a start,
+ * a frequency change or a sensor stop) only restart the measurement.
+ * Disabled, the cost in the step path is one flag test.
+ */
+class StepJitter {
+public:
+    StepJitter(const char* lateName, const char* earlyName);
+
+    bool isEnabled() { return enabled; }
+    void setEnabled(bool on);
+    void resync();                                   // Next edge starts a new period
+    void sample(uint32_t periodUs, uint32_t stepCount);  // Step task, at the rising edge
+    void reset();
+    void report(JsonObject out);
+
+private:
+    // Largest deviation seen, with what the axis was doing
+    struct Worst {
+        int32_t deviationNs;  // Actual - scheduled, negative when early
+        uint32_t periodUs;    // Scheduled period
+        uint32_t actualUs;    // Measured period
+        uint32_t stepCount;   // Step that was off
+        uint32_t atMs;        // millis() of the edge
+        int32_t previousNs;   // Deviation of the edge before
+    };
+
+    volatile bool enabled;
+    bool synced;              // lastEdge belongs to the current period
+    uint32_t lastEdge;        // Cycle count of the previous edge
+    uint32_t cyclesPerUs;
+    int32_t lastDeviationNs;
+    uint32_t samples;
+    uint32_t resyncs;
+    Worst worst;
+    portMUX_TYPE worstLock;
+    MetricHistogram late;     // ns behind the schedule
+    MetricHistogram early;    // ns ahead of the schedule
+};
+
+#endif // STEP_JITTER_H
@@ -0,0 +1,137 @@
+#include "TaskHealth.h"
+#include <esp_idf_version.h>
+#include <esp_task_wdt.h>
+
+TaskHealth::Entry TaskHealth::entries[TASK_HEALTH_MAX_TASKS];
+uint8_t TaskHealth::count = 0;
+portMUX_TYPE TaskHealth::lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Sets the watchdog timeout and whether it panics.
+ *
+ * The framework starts the watchdog before setup(); this only changes its
+ * configuration. The idle task of the step core stays watched, so step
+ * tasks that never block are caught too.
+ */
+void TaskHealth::begin() {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_task_wdt_config_t config = {
+        .timeout_ms = TASK_WDT_TIMEOUT_S * 1000,
+        .idle_core_mask = 1 << STEP_CORE,
+        .trigger_panic = TASK_WDT_PANIC,
+    };
+    if (esp_task_wdt_init(&config) == ESP_ERR_INVALID_STATE) esp_task_wdt_reconfigure(&config);
+#else
+    esp_task_wdt_init(TASK_WDT_TIMEOUT_S, TASK_WDT_PANIC);
+#endif
+}
+
+/**
+ * @brief Supervises the calling task under @p name (a static string).
+ *
+ * A task that ended and starts again under the same name gets its old
+ * entry back, with its history.
+ */
+int8_t TaskHealth::add(const char* name) {
+    int8_t id = -1;
+    portENTER_CRITICAL(&lock);
+    for (uint8_t i = 0; i < count; i++) {
+        if (entries[i].task == nullptr && strcmp(entries[i].name, name) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0 && count < TASK_HEALTH_MAX_TASKS) {
+        id = count++;
+        memset(&entries[id], 0, sizeof(Entry));
+        entries[id].name = name;
+    }
+    if (id >= 0) {
+        Entry& entry = entries[id];
+        entry.task = xTaskGetCurrentTaskHandle();
+        entry.core = xPortGetCoreID();
+        entry.priority = uxTaskPriorityGet(nullptr);
+        entry.starts++;
+        entry.lastMs = millis();
+        entry.lastFeedMs = entry.lastMs;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (id >= 0) esp_task_wdt_add(nullptr);
+    return id;
+}
+
+/**
+ * @brief Stops supervising @p task; no-op for a task that was never added.
+ */
+void TaskHealth::remove(TaskHandle_t task) {
+    bool found = false;
+    portENTER_CRITICAL(&lock);
+    for (uint8_t i = 0; i < count && !found; i++) {
+        if (entries[i].task != task) continue;
+        entries[i].task = nullptr;
+        found = true;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (found) esp_task_wdt_delete(task);
+}
+
+void TaskHealth::feed() {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 0; i < count; i++) {
+        if (entries[i].task == task) {
+            checkIn(i);
+            return;
+        }
+    }
+}
+
+void TaskHealth::feedWatchdog(Entry& entry, uint32_t now) {
+    entry.lastFeedMs = now;
+    esp_task_wdt_reset();
+}
+
+bool TaskHealth::isHealthy() {
+    for (uint8_t i = 0; i < count; i++) {
+        if (entries[i].task == nullptr) continue;
+        uint32_t last = entries[i].lastMs;
+        if (millis() - last > TASK_HEALTH_LATE_MS) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Watchdog settings and one entry per supervised task.
+ *
+ * "ageMs" is the time since the last check-in of a running task, "ok"
+ * false when it is above TASK_HEALTH_LATE_MS. "late" counts the check-ins
+ * that came later than that, i.e. stalls the task recovered from.
+ */
+void TaskHealth::report(JsonDocument& doc) {
+    doc["healthy"] = isHealthy();
+    JsonObject watchdog = doc["watchdog"].to<JsonObject>();
+    watchdog["timeoutS"] = TASK_WDT_TIMEOUT_S;
+    watchdog["panic"] = TASK_WDT_PANIC;
+    watchdog["lateMs"] = TASK_HEALTH_LATE_MS;
+
+    JsonArray list = doc["tasks"].to<JsonArray>();
+    for (uint8_t i = 0; i < count; i++) {
+        const Entry& entry = entries[i];
+        JsonObject item = list.add<JsonObject>();
+        item["name"] = entry.name;
+        bool running = entry.task != nullptr;
+        item["running"] = running;
+        item["core"] = entry.core;
+        item["priority"] = entry.priority;
+        item["starts"] = entry.starts;
+        item["checkIns"] = entry.checkIns;
+        item["maxGapMs"] = entry.maxGapMs;
+        item["late"] = entry.lateCount;
+        if (running) {
+            uint32_t last = entry.lastMs;
+            uint32_t age = millis() - last;
+            item["ageMs"] = age;
+            item["ok"] = age <= TASK_HEALTH_LATE_MS;
+        }
+    }
+}
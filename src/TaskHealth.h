@@ -0,0 +1,67 @@
+#ifndef TASK_HEALTH_H
+#define TASK_HEALTH_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FreeRTOS.h>
+#include "Config.h"
+
+/**
+ * @file TaskHealth.h
+ * @brief Task watchdog supervision of the firmware tasks (TASKHEALTH command).
+ *
+ * Every long-lived task calls add() once at its start, which subscribes it
+ * to the ESP-IDF task watchdog, then checkIn() on each pass of its loop.
+ * A check-in feeds the watchdog (at most every TASK_FEED_MS) and records
+ * the time since the previous one. Supervised tasks never block longer
+ * than TASK_IDLE_WAKE_MS, so a task that stops checking in is stuck: it is
+ * reported late after TASK_HEALTH_LATE_MS and the watchdog fires after
+ * TASK_WDT_TIMEOUT_S (a panic and a core dump with TASK_WDT_PANIC).
+ *
+ * A task that ends removes itself before vTaskDelete(nullptr); tasks are
+ * never deleted from outside (see A4988Manager::stopMotorTask()).
+ * Code that legitimately runs for seconds in a supervised task (long
+ * serial dumps) calls feed() as it goes.
+ */
+class TaskHealth {
+public:
+    static void begin();                        // Configure the watchdog (setup, before the tasks)
+    static int8_t add(const char* name);        // Calling task; returns its id, -1 if the table is full
+    static void remove(TaskHandle_t task);      // By a supervised task about to delete itself
+    static void checkIn(int8_t id) {
+        if (id < 0) return;
+        Entry& entry = entries[id];
+        uint32_t now = millis();
+        uint32_t gap = now - entry.lastMs;
+        if (gap > entry.maxGapMs) entry.maxGapMs = gap;
+        if (gap > TASK_HEALTH_LATE_MS) entry.lateCount++;
+        entry.lastMs = now;
+        entry.checkIns++;
+        if (now - entry.lastFeedMs >= TASK_FEED_MS) feedWatchdog(entry, now);
+    }
+    static void feed();                         // checkIn() of the calling task, looked up by handle
+    static bool isHealthy();                    // No supervised task is late
+    static void report(JsonDocument& doc);      // TASKHEALTH
+
+private:
+    struct Entry {
+        const char* name;       // Static string, stays when the task ends
+        TaskHandle_t task;      // nullptr while not running
+        uint8_t core;
+        uint8_t priority;
+        uint16_t starts;        // add() calls, motor tasks restart with each start
+        uint32_t lastMs;        // Last check-in
+        uint32_t lastFeedMs;
+        uint32_t maxGapMs;      // Longest time between two check-ins
+        uint32_t lateCount;     // Gaps longer than TASK_HEALTH_LATE_MS
+        uint32_t checkIns;
+    };
+
+    static void feedWatchdog(Entry& entry, uint32_t now);
+
+    static Entry entries[TASK_HEALTH_MAX_TASKS];
+    static uint8_t count;
+    static portMUX_TYPE lock;
+};
+
+#endif // TASK_HEALTH_H
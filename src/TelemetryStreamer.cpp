@@ -0,0 +1,180 @@
+#include "TelemetryStreamer.h"
+#include "CommandReceiver.h"
+#include <esp_timer.h>
+#include "TaskHealth.h"
+
+/**
+ * @brief Constructor for the TelemetryStreamer class.
+ *
+ * @param receiver CommandReceiver used as the snapshot source.
+ */
+TelemetryStreamer::TelemetryStreamer(CommandReceiver* receiver)
+    : cmdReceiver(receiver), _taskHandle(nullptr), _running(false), _rateHz(0),
+      _keyframeInterval(TELEMETRY_KEYFRAME_INTERVAL), _forceKeyframe(true),
+      _sequence(0), _framesSinceKeyframe(0), _sentFrames(0), _droppedFrames(0) {
+    memset(&_lastSent, 0, sizeof(_lastSent));
+}
+
+/**
+ * @brief Starts the telemetry stream, or changes its rate if already running.
+ *
+ * The first frame after a (re)subscribe is always a keyframe.
+ *
+ * @param rateHz Frames per second, clamped to TELEMETRY_MAX_RATE_HZ. 0 stops the stream.
+ * @param keyframeInterval Number of frames between full keyframes (0 = default).
+ */
+void TelemetryStreamer::subscribe(uint16_t rateHz, uint16_t keyframeInterval) {
+    if (rateHz == 0) {
+        unsubscribe();
+        return;
+    }
+    if (rateHz > TELEMETRY_MAX_RATE_HZ) rateHz = TELEMETRY_MAX_RATE_HZ;
+    _keyframeInterval = keyframeInterval ? keyframeInterval : TELEMETRY_KEYFRAME_INTERVAL;
+    _rateHz = rateHz;
+    _forceKeyframe = true;
+
+    if (_taskHandle == nullptr) {
+        _running = true;
+        xTaskCreatePinnedToCore(streamTask, "Telemetry Task", TELEMETRY_TASK_STACK, this,
+                                TELEMETRY_TASK_PRIORITY, &_taskHandle, TELEMETRY_TASK_CORE);
+    }
+}
+
+/**
+ * @brief Stops the telemetry stream and waits for the task to end.
+ *
+ * The task is asked to stop rather than deleted: it may be inside
+ * Serial.write() holding the UART locks. It leaves its loop after the
+ * current frame, so the wait is one frame encode at most.
+ */
+void TelemetryStreamer::unsubscribe() {
+    _rateHz = 0;
+    if (_taskHandle != nullptr) {
+        xTaskNotifyGive(_taskHandle);
+        while (_running) {
+            vTaskDelay(1);
+        }
+        _taskHandle = nullptr;
+    }
+}
+
+bool TelemetryStreamer::isSubscribed() {
+    return _taskHandle != nullptr;
+}
+
+uint16_t TelemetryStreamer::getRate() {
+    return _rateHz;
+}
+
+uint32_t TelemetryStreamer::getSentFrames() {
+    return _sentFrames;
+}
+
+uint32_t TelemetryStreamer::getDroppedFrames() {
+    return _droppedFrames;
+}
+
+/**
+ * @brief FreeRTOS task publishing one frame per period.
+ *
+ * Frames are due at fixed ticks from the start, so the frame rate does not
+ * drift with encode time. The wait between frames is a notification wait,
+ * which unsubscribe() cuts short; a rate of 0 ends the task.
+ *
+ * @param pvParameters Pointer to the TelemetryStreamer instance.
+ */
+void TelemetryStreamer::streamTask(void *pvParameters) {
+    TelemetryStreamer* streamer = static_cast<TelemetryStreamer*>(pvParameters);
+    TickType_t nextWake = xTaskGetTickCount();
+    int8_t health = TaskHealth::add("telemetry");
+
+    while (true) {
+        uint16_t rateHz = streamer->_rateHz;  // Read once, unsubscribe() may clear it
+        if (rateHz == 0) break;
+        TaskHealth::checkIn(health);  // At least 1 Hz
+        streamer->publishFrame();
+
+        TickType_t period = pdMS_TO_TICKS(1000 / rateHz);
+        if (period == 0) period = 1;
+        nextWake += period;
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(nextWake - now) > 0) {
+            ulTaskNotifyTake(pdTRUE, nextWake - now);
+        } else {
+            nextWake = now;  // Behind schedule, do not burst to catch up
+        }
+    }
+
+    TaskHealth::remove(xTaskGetCurrentTaskHandle());
+    streamer->_running = false;
+    vTaskDelete(nullptr);
+}
+
+/**
+ * @brief Captures a snapshot, encodes it and writes it if the link has room.
+ *
+ * When the TX buffer cannot take the whole frame it is dropped and the
+ * last-sent snapshot is left untouched, so the next delta still carries
+ * every change the host has not seen yet.
+ */
+void TelemetryStreamer::publishFrame() {
+    StatusSnapshot snapshot;
+    cmdReceiver->captureStatus(snapshot);
+
+    bool keyframe = _forceKeyframe || _framesSinceKeyframe >= _keyframeInterval;
+    size_t len = encodeFrame(snapshot, keyframe, _frame, sizeof(_frame));
+    _sequence++;
+
+    if (len == 0 || Serial.availableForWrite() < (int)len) {
+        _droppedFrames++;  // Backpressure: skip this frame, never block the caller
+        return;
+    }
+
+    Serial.write((const uint8_t*)_frame, len);
+    _sentFrames++;
+    _lastSent = snapshot;
+    if (keyframe) {
+        _forceKeyframe = false;
+        _framesSinceKeyframe = 0;
+    } else {
+        _framesSinceKeyframe++;
+    }
+}
+
+/**
+ * @brief Encodes a telemetry frame as a single JSON line.
+ *
+ * @param s Snapshot to encode.
+ * @param keyframe True to include every field, false for changed fields only.
+ * @param buf Output buffer.
+ * @param size Size of the output buffer.
+ * @return Number of bytes written, or 0 if the frame did not fit.
+ */
+size_t TelemetryStreamer::encodeFrame(const StatusSnapshot& s, bool keyframe, char* buf, size_t size) {
+    const StatusSnapshot& p = _lastSent;
+    int len = snprintf(buf, size, "{\"tlm\":%lu,\"ts\":%llu,\"key\":%d",
+                       (unsigned long)_sequence, (unsigned long long)esp_timer_get_time(), keyframe ? 1 : 0);
+
+    #define TLM_FIELD(cond, fmt, value)                                          \
+        if (len > 0 && (size_t)len < size && (keyframe || (cond))) {             \
+            len += snprintf(buf + len, size - len, fmt, value);                  \
+        }
+    TLM_FIELD(s.caseSpeed != p.caseSpeed,           ",\"caseSpeed\":%.2f",   s.caseSpeed);
+    TLM_FIELD(s.caseMicrosteps != p.caseMicrosteps, ",\"caseMicro\":%u",     s.caseMicrosteps);
+    TLM_FIELD(s.caseDir != p.caseDir,               ",\"caseDir\":%u",       s.caseDir);
+    TLM_FIELD(s.discSpeed != p.discSpeed,           ",\"discSpeed\":%.2f",   s.discSpeed);
+    TLM_FIELD(s.discMicrosteps != p.discMicrosteps, ",\"discMicro\":%u",     s.discMicrosteps);
+    TLM_FIELD(s.discDir != p.discDir,               ",\"discDir\":%u",       s.discDir);
+    TLM_FIELD(s.stopTime != p.stopTime,             ",\"stop\":%lu",         (unsigned long)s.stopTime);
+    TLM_FIELD(s.stepsToTake != p.stepsToTake,       ",\"stepsToTake\":%lu",  (unsigned long)s.stepsToTake);
+    TLM_FIELD(s.running != p.running,               ",\"running\":%d",       s.running ? 1 : 0);
+    TLM_FIELD(s.lastCommand != p.lastCommand,       ",\"lastCommand\":\"%s\"", s.lastCommand);
+    #undef TLM_FIELD
+
+    if (len > 0 && (size_t)len + 2 < size) {
+        buf[len++] = '}';
+        buf[len++] = '\n';
+        return len;
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef TELEMETRY_STREAMER_H
+#define TELEMETRY_STREAMER_H
+
+#include <Arduino.h>
+#include <FreeRTOS.h>
+#include "Config.h"
+#include "StatusSnapshot.h"
+
+class CommandReceiver;
+
+/**
+ * @brief Pushes status frames to the host at a fixed rate.
+ *
+ * Each frame is one JSON line carrying a sequence number and a device
+ * timestamp (µs). Only fields that changed since the last frame that went
+ * out are included, except every Nth frame which is a full keyframe.
+ * Frames that do not fit in the UART TX buffer are dropped instead of
+ * blocking; the sequence number still advances so the host can see gaps.
+ */
+class TelemetryStreamer {
+public:
+    TelemetryStreamer(CommandReceiver* receiver);
+
+    void subscribe(uint16_t rateHz, uint16_t keyframeInterval);  // Start or retune the stream
+    void unsubscribe();                                          // Stop the stream
+    bool isSubscribed();
+    uint16_t getRate();
+    uint32_t getSentFrames();
+    uint32_t getDroppedFrames();
+
+private:
+    static void streamTask(void *pvParameters);
+    void publishFrame();
+    size_t encodeFrame(const StatusSnapshot& s, bool keyframe, char* buf, size_t size);
+
+    CommandReceiver* cmdReceiver;
+    TaskHandle_t _taskHandle;
+    volatile bool _running;       // Cleared by the task as its last access to this object
+    volatile uint16_t _rateHz;    // 0 asks the task to stop
+    volatile uint16_t _keyframeInterval;
+    volatile bool _forceKeyframe;
+    uint32_t _sequence;
+    uint16_t _framesSinceKeyframe;
+    uint32_t _sentFrames;
+    uint32_t _droppedFrames;
+    StatusSnapshot _lastSent;     // Last snapshot the host actually received
+    char _frame[TELEMETRY_FRAME_SIZE];
+};
+
+#endif // TELEMETRY_STREAMER_H
@@ -0,0 +1,167 @@
+#include "Trace.h"
+#include "TaskHealth.h"
+
+Trace::Ring Trace::rings[portNUM_PROCESSORS];
+std::atomic<bool> Trace::enabled(TRACE_DEFAULT_ENABLED);
+
+// A task seen in the dump, with its Chrome thread id
+struct TraceThread {
+    TaskHandle_t task;
+    uint32_t tid;
+    char name[configMAX_TASK_NAME_LEN];  // Copied: the task may end while the dump is written
+    uint8_t namedCores;   // Cores whose thread_name entry was written
+};
+
+/**
+ * @brief Records a span that started at @p startUs (esp_timer time) and ends now.
+ */
+void Trace::complete(const char* name, int64_t startUs, int32_t value) {
+    int64_t now = esp_timer_get_time();
+    TraceEvent event = { startUs, (uint32_t)(now - startUs), name, xTaskGetCurrentTaskHandle(), value, 'X' };
+    add(event);
+}
+
+void Trace::instant(const char* name, int32_t value) {
+    TraceEvent event = { esp_timer_get_time(), 0, name, xTaskGetCurrentTaskHandle(), value, 'i' };
+    add(event);
+}
+
+/**
+ * @brief Stores @p event in the ring of the current core, over the oldest one.
+ */
+void Trace::add(const TraceEvent& event) {
+    Ring& ring = rings[xPortGetCoreID()];
+    portENTER_CRITICAL(&ring.lock);
+    ring.events[ring.written % TRACE_RING_SIZE] = event;
+    ring.written++;
+    portEXIT_CRITICAL(&ring.lock);
+}
+
+void Trace::clear() {
+    for (Ring& ring : rings) {
+        portENTER_CRITICAL(&ring.lock);
+        ring.written = 0;
+        portEXIT_CRITICAL(&ring.lock);
+    }
+}
+
+/**
+ * @brief Writes the recorded events as Chrome trace-event JSON.
+ *
+ * The rings are copied under their locks first, so recording goes on
+ * while the (slow) output is written. Tasks still running are named from
+ * the scheduler; events of tasks that ended since are kept under
+ * "ended task". Spans are listed in the order they ended, which the
+ * viewers accept.
+ *
+ * @return Number of events written, 0 if the copy could not be allocated.
+ */
+uint32_t Trace::dump(Print& out) {
+    const size_t ringBytes = TRACE_RING_SIZE * sizeof(TraceEvent);
+    TraceEvent* copy = (TraceEvent*)malloc(portNUM_PROCESSORS * ringBytes);
+    if (copy == nullptr) return 0;
+    uint32_t counts[portNUM_PROCESSORS];
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        Ring& ring = rings[core];
+        TraceEvent* events = copy + core * TRACE_RING_SIZE;
+        portENTER_CRITICAL(&ring.lock);
+        uint32_t written = ring.written;
+        counts[core] = written < TRACE_RING_SIZE ? written : TRACE_RING_SIZE;
+        uint32_t first = written - counts[core];
+        for (uint32_t i = 0; i < counts[core]; i++) {
+            events[i] = ring.events[(first + i) % TRACE_RING_SIZE];   // Oldest first
+        }
+        portEXIT_CRITICAL(&ring.lock);
+    }
+
+    // Chrome thread ids: the FreeRTOS task number of live tasks
+    TraceThread threads[TRACE_MAX_TASKS + 1];
+    uint8_t threadCount = 0;
+    threads[TRACE_MAX_TASKS] = { nullptr, TRACE_ENDED_TID + TRACE_MAX_TASKS, "other tasks", 0 };
+#if configUSE_TRACE_FACILITY
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t* tasks = (TaskStatus_t*)malloc(capacity * sizeof(TaskStatus_t));
+    UBaseType_t taskCount = tasks ? uxTaskGetSystemState(tasks, capacity, nullptr) : 0;
+#endif
+
+    char line[TRACE_LINE_SIZE];
+    uint32_t total = 0;
+    out.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        snprintf(line, sizeof(line), "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"Core %u\"}}",
+                 core ? "," : "", core, core);
+        out.print(line);
+    }
+
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        const TraceEvent* events = copy + core * TRACE_RING_SIZE;
+        for (uint32_t i = 0; i < counts[core]; i++) {
+            const TraceEvent& event = events[i];
+
+            uint8_t t = 0;
+            while (t < threadCount && threads[t].task != event.task) t++;
+            if (t == threadCount) {
+                if (threadCount < TRACE_MAX_TASKS) {
+                    threads[t] = { event.task, (uint32_t)(TRACE_ENDED_TID + t), "ended task", 0 };
+#if configUSE_TRACE_FACILITY
+                    for (UBaseType_t j = 0; j < taskCount; j++) {
+                        if (tasks[j].xHandle != event.task) continue;
+                        threads[t].tid = tasks[j].xTaskNumber;
+                        strncpy(threads[t].name, tasks[j].pcTaskName, sizeof(threads[t].name) - 1);
+                        break;
+                    }
+#endif
+                    threadCount++;
+                } else {
+                    t = TRACE_MAX_TASKS;
+                }
+            }
+            TraceThread& thread = threads[t];
+            if (!(thread.namedCores & (1 << core))) {
+                thread.namedCores |= 1 << core;
+                snprintf(line, sizeof(line),
+                         ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                         core, (unsigned long)thread.tid, thread.name);
+                out.print(line);
+            }
+
+            int n = snprintf(line, sizeof(line), ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%u,\"tid\":%lu",
+                             event.name, event.phase, (long long)event.startUs, core, (unsigned long)thread.tid);
+            if (event.phase == 'X') {
+                n += snprintf(line + n, sizeof(line) - n, ",\"dur\":%lu", (unsigned long)event.durationUs);
+            } else {
+                n += snprintf(line + n, sizeof(line) - n, ",\"s\":\"t\"");   // Thread-scoped instant
+            }
+            if (event.value != 0) {
+                snprintf(line + n, sizeof(line) - n, ",\"args\":{\"value\":%ld}", (long)event.value);
+            }
+            out.print(line);
+            out.print('}');
+            if ((++total & 0x3F) == 0) TaskHealth::feed();  // Serial output takes seconds
+        }
+    }
+    out.print("]}");
+
+#if configUSE_TRACE_FACILITY
+    free(tasks);
+#endif
+    free(copy);
+    return total;
+}
+
+/**
+ * @brief Recording state and how much of each ring is filled.
+ */
+void Trace::report(JsonDocument& doc) {
+    doc["enabled"] = isEnabled();
+    doc["ringSize"] = TRACE_RING_SIZE;
+    JsonArray cores = doc["cores"].to<JsonArray>();
+    for (Ring& ring : rings) {
+        portENTER_CRITICAL(&ring.lock);
+        uint32_t written = ring.written;
+        portEXIT_CRITICAL(&ring.lock);
+        JsonObject item = cores.add<JsonObject>();
+        item["events"] = written < TRACE_RING_SIZE ? written : TRACE_RING_SIZE;
+        item["overwritten"] = written < TRACE_RING_SIZE ? 0 : written - TRACE_RING_SIZE;
+    }
+}
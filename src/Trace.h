@@ -0,0 +1,94 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FreeRTOS.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "Config.h"
+
+/**
+ * @file Trace.h
+ * @brief Flight recorder of timed spans and instants (TRACEDUMP command).
+ *
+ * Code marks what it is doing with
+ *
+ *   TRACE_SCOPE("nvs.commit");          // Span until the end of the block
+ *   TRACE_INSTANT("disc.edge", steps);  // Single point in time
+ *   TRACE_COMPLETE("disc.dwell", startUs);  // Span that did not fit a block
+ *
+ * Each event is written, when it ends, into a ring of TRACE_RING_SIZE
+ * events per core; the oldest events are overwritten, so the rings always
+ * hold the most recent activity. Writing takes the ring lock of the
+ * current core for a few stores and never allocates. Not for ISRs.
+ *
+ * TRACEDUMP copies both rings and writes them as Chrome trace-event JSON
+ * (to Serial or a file on the SD card), one process per core and one
+ * thread per task, which chrome://tracing and ui.perfetto.dev open as a
+ * timeline. Names must be string literals: only the pointer is stored.
+ *
+ * With TRACE_ENABLED 0 the macros compile to nothing.
+ */
+
+struct TraceEvent {
+    int64_t startUs;      // esp_timer time
+    uint32_t durationUs;  // 0 for instants
+    const char* name;     // Static string
+    TaskHandle_t task;    // Task that recorded the event
+    int32_t value;        // Shown as args.value when not 0
+    char phase;           // 'X' span, 'i' instant
+};
+
+class Trace {
+public:
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+    static void complete(const char* name, int64_t startUs, int32_t value = 0);  // Span from startUs to now
+    static void instant(const char* name, int32_t value = 0);
+    static void clear();
+    static uint32_t dump(Print& out);       // Chrome trace JSON, returns the events written
+    static void report(JsonDocument& doc);  // Ring usage
+
+private:
+    struct Ring {
+        TraceEvent events[TRACE_RING_SIZE];
+        uint32_t written;     // Events since the last clear, the newest is at (written - 1) % size
+        portMUX_TYPE lock;
+        Ring() : written(0) { lock = portMUX_INITIALIZER_UNLOCKED; }
+    };
+
+    static void add(const TraceEvent& event);
+
+    static Ring rings[portNUM_PROCESSORS];
+    static std::atomic<bool> enabled;
+};
+
+/** @brief Records a span from construction to destruction (TRACE_SCOPE). */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, int32_t value = 0)
+        : name(name), value(value), startUs(Trace::isEnabled() ? esp_timer_get_time() : 0) {}
+    ~TraceSpan() { if (startUs != 0) Trace::complete(name, startUs, value); }
+    void setValue(int32_t v) { value = v; }
+
+private:
+    const char* name;
+    int32_t value;
+    int64_t startUs;      // 0 when tracing was off at the start
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+
+#if TRACE_ENABLED
+#define TRACE_SCOPE(...)    TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(__VA_ARGS__)
+#define TRACE_INSTANT(...)  do { if (Trace::isEnabled()) Trace::instant(__VA_ARGS__); } while (0)
+#define TRACE_COMPLETE(...) do { if (Trace::isEnabled()) Trace::complete(__VA_ARGS__); } while (0)
+#else
+#define TRACE_SCOPE(...)    do {} while (0)
+#define TRACE_INSTANT(...)  do {} while (0)
+#define TRACE_COMPLETE(...) do {} while (0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,233 @@
+#include "WarmRestart.h"
+#include "CommandReceiver.h"
+#include "ConfigManager.h"
+#include "DeferredLog.h"
+#include "EventLogger.h"
+#include "TaskHealth.h"
+#include <esp_rom_crc.h>
+#include <math.h>
+
+#define WARM_STATE_MAGIC 0x57524D31  // "WRM1", change when WarmState changes
+
+// Not cleared by the startup code, so it survives software and watchdog resets
+static RTC_NOINIT_ATTR WarmState rtcState[2];
+
+/**
+ * @brief Constructor for the WarmRestart class.
+ */
+WarmRestart::WarmRestart(A4988Manager& caseMotor, A4988Manager& discMotor)
+    : _caseMotor(caseMotor), _discMotor(discMotor), cmdReceiver(nullptr), config(nullptr),
+      syncTaskHandle(nullptr), resetReason(ESP_RST_UNKNOWN), warm(false), stateValid(false),
+      resumed(false), resumes(0), nextSlot(0), sequence(0), resumeUs(0), rampUs(0) {
+    memset(&saved, 0, sizeof(saved));
+}
+
+/**
+ * @brief Reads the reset reason and the newest valid saved state.
+ *
+ * Only reads RTC memory, so it can run first thing in setup().
+ */
+void WarmRestart::begin() {
+    resetReason = esp_reset_reason();
+    warm = isWarmReason(resetReason);
+    stateValid = warm && loadState();
+    if (stateValid) {
+        sequence = saved.sequence;
+        resumes = saved.resumes;
+    }
+}
+
+/**
+ * @brief Restarts the saved motion on a warm reset, then starts mirroring.
+ *
+ * Blocks for the ramp (WARM_RAMP_MS) when motion is resumed; returns at
+ * once otherwise. Needs the motors initialized and the command receiver
+ * created.
+ *
+ * @return True if motion was resumed.
+ */
+bool WarmRestart::resume(CommandReceiver* commandReceiver) {
+    cmdReceiver = commandReceiver;
+
+    if (stateValid) {
+        // Positions carry over on every warm reset, running or not
+        _caseMotor.restoreStepCount(saved.axes[0].steps);
+        _discMotor.restoreStepCount(saved.axes[1].steps);
+    }
+
+    if (stateValid && saved.running) {
+        if (resumes >= WARM_MAX_RESUMES) {
+            LOG_WARN(LOG_WARM_REFUSED, resumes, resetReason);
+            EventLogger::record(EVENT_FAULT, EVENT_SOURCE_SYSTEM, FAULT_WARM_REFUSED, resetReason);
+            resumes = 0;
+        } else {
+            resumes++;
+            restore();
+            resumed = true;
+            LOG_INFO(LOG_WARM_RESUMED, resumeUs, resumes);
+        }
+    } else {
+        resumes = 0;
+    }
+
+    if (syncTaskHandle == nullptr) {
+        xTaskCreatePinnedToCore(syncTask, "Warm Sync Task", WARM_TASK_STACK, this,
+                                WARM_TASK_PRIORITY, &syncTaskHandle, WARM_TASK_CORE);
+    }
+    return resumed;
+}
+
+void WarmRestart::setConfigManager(ConfigManager* config) {
+    this->config = config;
+}
+
+bool WarmRestart::isWarm() {
+    return warm;
+}
+
+bool WarmRestart::isResumed() {
+    return resumed;
+}
+
+/**
+ * @brief Puts the saved setup back and ramps the running axes to speed.
+ *
+ * Runs under the control lock so no command or HMI key can interleave.
+ */
+void WarmRestart::restore() {
+    A4988Manager* axes[2] = { &_caseMotor, &_discMotor };
+    float start[2];
+
+    cmdReceiver->lockControl();
+    cmdReceiver->setSensorParameters(2, saved.stopTime, saved.stepsToTake);
+    for (uint8_t i = 0; i < 2; i++) {
+        const WarmAxis& axis = saved.axes[i];
+        if (axis.speed > 0) {
+            start[i] = min(axis.speed, (float)HMI_SPEED_MIN);
+            cmdReceiver->setMotorParameters(i + 1, start[i], axis.microsteps, axis.dir);
+        } else {
+            start[i] = 0;
+            axes[i]->setStepResolution(axis.microsteps);
+            axes[i]->setDirPin(axis.dir);
+        }
+    }
+    resumeUs = micros();
+
+    for (uint8_t step = 1; step <= WARM_RAMP_STEPS; step++) {
+        vTaskDelay(pdMS_TO_TICKS(WARM_RAMP_MS / WARM_RAMP_STEPS));
+        for (uint8_t i = 0; i < 2; i++) {
+            float target = CommandReceiver::clampSpeed(saved.axes[i].speed);  // Saved before the limit existed
+            if (target <= start[i]) continue;
+            // The last step lands on the target itself, not a rounded interpolation of it
+            axes[i]->setFrequency(step == WARM_RAMP_STEPS ? target
+                                                          : start[i] + (target - start[i]) * step / WARM_RAMP_STEPS);
+        }
+    }
+    rampUs = micros() - resumeUs;
+    cmdReceiver->unlockControl();
+}
+
+void WarmRestart::syncTask(void *pvParameters) {
+    WarmRestart* warmRestart = static_cast<WarmRestart*>(pvParameters);
+    TickType_t lastWake = xTaskGetTickCount();
+    int8_t health = TaskHealth::add("warm.sync");
+    while (true) {
+        TaskHealth::checkIn(health);
+        warmRestart->sync();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(WARM_SYNC_PERIOD_MS));
+    }
+}
+
+/**
+ * @brief Writes the current motion state into the older RTC copy.
+ */
+void WarmRestart::sync() {
+    StatusSnapshot snapshot;
+    cmdReceiver->captureStatus(snapshot);
+
+    if (resumes != 0 && millis() >= WARM_STABLE_MS) resumes = 0;
+
+    WarmState state;
+    memset(&state, 0, sizeof(state));
+    state.magic = WARM_STATE_MAGIC;
+    state.sequence = ++sequence;
+    state.axes[0] = { snapshot.caseSpeed, _caseMotor.getStepCount(), snapshot.caseMicrosteps, snapshot.caseDir, {0, 0} };
+    state.axes[1] = { snapshot.discSpeed, _discMotor.getStepCount(), snapshot.discMicrosteps, snapshot.discDir, {0, 0} };
+    state.stopTime = snapshot.stopTime;
+    state.stepsToTake = snapshot.stepsToTake;
+    state.recipe = config ? config->getSetting(SETTING_ACTIVE_RECIPE) : (stateValid ? saved.recipe : -1);
+    state.running = snapshot.running;
+    state.resumes = resumes;
+    state.crc = stateCrc(state);
+
+    rtcState[nextSlot] = state;
+    nextSlot ^= 1;
+}
+
+/**
+ * @brief Copies the newest copy that passes the checks into @p saved.
+ */
+bool WarmRestart::loadState() {
+    int8_t best = -1;
+    for (uint8_t slot = 0; slot < 2; slot++) {
+        const WarmState& state = rtcState[slot];
+        if (state.magic != WARM_STATE_MAGIC || state.crc != stateCrc(state)) continue;
+
+        bool sane = true;
+        for (uint8_t i = 0; i < 2; i++) {
+            const WarmAxis& axis = state.axes[i];
+            sane &= isfinite(axis.speed) && axis.speed >= 0 && axis.microsteps >= 1 && axis.microsteps <= 16;
+        }
+        if (!sane) continue;
+        if (best < 0 || state.sequence > rtcState[best].sequence) best = slot;
+    }
+    if (best < 0) return false;
+
+    saved = rtcState[best];
+    nextSlot = best ^ 1;  // Keep the copy just read until a newer one exists
+    return true;
+}
+
+/**
+ * @brief Software, panic and watchdog resets keep RTC memory and the
+ *        machine was powered throughout; everything else is a cold boot.
+ */
+bool WarmRestart::isWarmReason(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_SW:
+        case ESP_RST_PANIC:
+        case ESP_RST_INT_WDT:
+        case ESP_RST_TASK_WDT:
+        case ESP_RST_WDT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t WarmRestart::stateCrc(const WarmState& state) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&state, offsetof(WarmState, crc));
+}
+
+/**
+ * @brief Adds the restart classification and resume timing to @p doc.
+ */
+void WarmRestart::report(JsonDocument& doc) {
+    JsonObject restart = doc["restart"].to<JsonObject>();
+    restart["resetReason"] = (int)resetReason;
+    restart["warm"] = warm;
+    restart["stateValid"] = stateValid;
+    restart["resumed"] = resumed;
+    restart["resumes"] = resumes;
+    if (resumed) {
+        restart["resumeUs"] = resumeUs;   // Since reset
+        restart["rampUs"] = rampUs;
+        restart["recipe"] = saved.recipe;
+        restart["caseSpeed"] = saved.axes[0].speed;
+        restart["discSpeed"] = saved.axes[1].speed;
+    }
+    if (stateValid) {
+        restart["caseSteps"] = saved.axes[0].steps;
+        restart["discSteps"] = saved.axes[1].steps;
+    }
+}
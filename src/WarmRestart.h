@@ -0,0 +1,91 @@
+#ifndef WARM_RESTART_H
+#define WARM_RESTART_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include "Config.h"
+#include "A4988Manager.h"
+
+class CommandReceiver;
+class ConfigManager;
+
+/**
+ * @file WarmRestart.h
+ * @brief Resumes motion after a watchdog or software reset.
+ *
+ * A low-priority task mirrors the live motion state (setpoints,
+ * directions, microstepping, sensor parameters, step counters, active
+ * recipe) into RTC memory that survives a reset but not a power cycle.
+ * Two copies are written alternately, each with a sequence number and a
+ * CRC, so a reset in the middle of a write leaves the other copy valid.
+ *
+ * At boot, a software, panic or watchdog reset with a valid state that
+ * was running restarts the axes at HMI_SPEED_MIN and ramps them back to
+ * their setpoints. Power-on, brown-out and deep-sleep wake-ups are cold
+ * boots and keep the machine stopped. After WARM_MAX_RESUMES resumes
+ * without WARM_STABLE_MS of uptime in between, the machine stays stopped
+ * so a fault that resets the chip cannot restart the motors forever.
+ */
+
+struct WarmAxis {
+    float speed;             // Step frequency, 0 = stopped
+    uint32_t steps;          // Step counter (axis position)
+    uint8_t microsteps;
+    uint8_t dir;
+    uint8_t reserved[2];
+};
+
+struct WarmState {
+    uint32_t magic;          // WARM_STATE_MAGIC
+    uint32_t sequence;       // Higher is newer
+    WarmAxis axes[2];        // Case, disc
+    uint32_t stopTime;       // Sensor parameters of the disc axis
+    uint32_t stepsToTake;
+    int32_t recipe;          // Active recipe slot, -1 if none
+    uint8_t running;         // At least one axis was stepping
+    uint8_t resumes;         // Warm resumes in a row
+    uint8_t reserved[2];
+    uint32_t crc;            // CRC32 of everything above
+};
+
+class WarmRestart {
+public:
+    WarmRestart(A4988Manager& caseMotor, A4988Manager& discMotor);
+
+    void begin();                                   // Classify the reset, read the saved state
+    bool resume(CommandReceiver* commandReceiver);  // Restart motion if warm, then start mirroring
+    void setConfigManager(ConfigManager* config);   // Source of the active recipe
+
+    bool isWarm();        // Reset kept RTC memory
+    bool isResumed();     // Motion was restarted from the saved state
+    void report(JsonDocument& doc);  // BOOTREPORT "restart" section
+
+private:
+    static void syncTask(void *pvParameters);
+    void sync();
+    void restore();
+    bool loadState();
+    static bool isWarmReason(esp_reset_reason_t reason);
+    static uint32_t stateCrc(const WarmState& state);
+
+    A4988Manager& _caseMotor;
+    A4988Manager& _discMotor;
+    CommandReceiver* cmdReceiver;
+    ConfigManager* config;
+    TaskHandle_t syncTaskHandle;
+
+    esp_reset_reason_t resetReason;
+    bool warm;
+    bool stateValid;      // A copy passed the CRC check
+    bool resumed;
+    WarmState saved;      // Newest valid copy found at boot
+    uint8_t resumes;      // Written back with every copy
+    uint8_t nextSlot;     // Copy overwritten by the next sync
+    uint32_t sequence;
+    uint32_t resumeUs;    // micros() when the axes were restarted
+    uint32_t rampUs;      // Time to reach the setpoints again
+};
+
+#endif // WARM_RESTART_H
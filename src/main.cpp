@@ -5,10 +5,16 @@
 #include "config.h"                 // Include configuration header for pin definitions and settings
 #include "SDCardManager.h"          // Include SD card manager for handling SD card operations
 #include "NextionHMI.h"             // Include Nextion HMI library for display interactions
+#include "RecipeManager.h"          // Named production recipes
+#include "DeferredLog.h"            // Deferred logging for real-time paths
+#include "BootSequence.h"           // Parallel, timed start-up stages
+#include "WarmRestart.h"            // Motion resume after a watchdog/software reset
+#include "EventLogger.h"            // Binary production event log on SD
+#include "Metrics.h"                // Runtime metrics served by GETMETRICS
+#include "CrashReport.h"            // Core dump post-mortem served by CRASHINFO
+#include "TaskHealth.h"             // Task watchdog supervision served by TASKHEALTH
 #include <Preferences.h>            // ESP32 Preferences library for non-volatile storage (settings persistence)
 
-void readResponse();               // Declare function to handle serial responses from Nextion HMI
-
 // ==================================================
 // Motor Instances
 // ==================================================
@@ -27,6 +33,7 @@ A4988Manager caseMotor(
 
 HardwareSerial nextionSerial(1);  // Declare HardwareSerial object for Nextion display (UART1)
 Preferences prefs;               // Declare Preferences object for non-volatile storage
+BootSequence boot;               // Start-up stages, timing reported by BOOTREPORT
 
 // ==================================================
 // Object Pointers
@@ -37,30 +44,98 @@ SDCardManager* SDcard = nullptr;      // Pointer to SD card manager instance
 CommandReceiver* commandReceiver = nullptr; // Pointer to command receiver instance
 NextionHMI* nextionHMI = nullptr;     // Pointer to Nextion HMI instance
 ConfigManager* Config = nullptr;      // Pointer to configuration manager instance
+RecipeManager* recipes = nullptr;     // Pointer to recipe manager instance
+WarmRestart* warmRestart = nullptr;   // Pointer to warm restart state
+CrashReport* crashReport = nullptr;   // Pointer to the core dump summary
+
+// ==================================================
+// Runtime Metrics
+// ==================================================
+static MetricGauge caseSteps("motor.case.steps", "steps", []() { return (int32_t)caseMotor.getStepCount(); });
+static MetricGauge discSteps("motor.disc.steps", "steps", []() { return (int32_t)discMotor.getStepCount(); });
+static MetricGauge sensorEdges("sensor.edges", "", []() { return (int32_t)discMotor.getSensorEdges(); });
+static MetricGauge dwellUs("sensor.dwell", "us", []() { return (int32_t)discMotor.getLastDwellUs(); });
+
+// ==================================================
+// Boot Stages
+// ==================================================
+// Each stage runs in its own task once the stages it depends on are done
+// (see setup()). Stages other than "config" must not print directly to
+// Serial while others may still run; they report through BOOTREPORT and
+// the deferred log.
+
+// Sensor input and the host command link. Restarts the console UART with
+// the command RX and TX buffers, so every stage that prints waits for it.
+// The deferred log drain starts only after the restart: records queued
+// before (e.g. LOG_CRASH_FOUND) wait in the ring, none is written while
+// the driver is stopped.
+static void bootConsole() {
+  sensor = new Sensor(SENSOR_PIN);         // Create instance of Sensor with the defined pin
+  sensor->begin();                         // Initialize the sensor
+  commandReceiver = new CommandReceiver(sensor, caseMotor, discMotor); // Create instance of CommandReceiver
+  commandReceiver->begin();                // Initialize the command receiver
+  DeferredLog::begin();                    // Start draining deferred log records
+  commandReceiver->setBootSequence(&boot); // BOOTREPORT
+  commandReceiver->setWarmRestart(warmRestart);
+  commandReceiver->setCrashReport(crashReport); // CRASHINFO
+}
+
+// Preferences and the settings blob
+static void bootConfig() {
+  prefs.begin(CONFIG_PARTITION, false);    // Start Preferences with the specified partition (non-read-only)
+  Config = new ConfigManager(&prefs);      // Create instance of ConfigManager with Preferences object
+  Config->begin();                         // Begin configuration process
+  commandReceiver->setConfigManager(Config); // SAVE and CONFIGSTATS act on the settings cache
+  warmRestart->setConfigManager(Config);   // Active recipe is mirrored to RTC memory
+}
+
+// Driver pins; both motors stay disabled
+static void bootMotors() {
+  discMotor.begin();                       // Initialize disc motor
+  caseMotor.begin();                       // Initialize case motor
+}
+
+// SD.begin() blocks for a long time when no card is inserted. The stage has
+// a timeout and finishes in the background; until then isInitialized() is false.
+// The event log is preallocated here, off the critical path of the boot.
+// A crash found at this boot is added to the crash log on the card.
+static void bootSDCard() {
+  if (!SDcard->begin()) return;
+  EventLogger::begin();
+  crashReport->saveToSD();
+}
+
+// Restarts the motion saved in RTC memory after a warm reset (no-op on a
+// cold boot). Needs no settings from NVS, so it runs as soon as the
+// drivers and the receiver exist.
+static void bootResume() {
+  warmRestart->resume(commandReceiver);
+}
+
+static void bootRecipes() {
+  recipes = new RecipeManager(Config, commandReceiver, SDcard, caseMotor, discMotor); // Recipe slots in NVS
+  commandReceiver->setRecipes(recipes);    // RECIPE* commands
+}
+
+// Display link. The HMI is attached to the receiver and the recipes only
+// after begin(), so a display that is slow to answer (stage timeout) is
+// simply picked up later.
+static void bootDisplay() {
+  nextionHMI = new NextionHMI(commandReceiver, caseMotor, discMotor, Config); // Loads the stored setup into the drivers
+  nextionHMI->begin();                     // Initialize the HMI manager
+  nextionHMI->setRecipes(recipes);         // Recipe selector page
+  recipes->setHMI(nextionHMI);             // Display follows recipe switches
+  commandReceiver->setHMI(nextionHMI);     // Expose display counters through HMISTATS
+  nextionHMI->sendSystemStatus();
+}
 
 void setup() {
   // ==================================================
   // Serial Communication Setup
   // ==================================================
-  Serial.begin(BAUDE_RATE);         // Initialize serial communication with the specified baud rate
-  while (!Serial) { ; }             // Wait for serial connection to establish
+  Serial.begin(BAUDE_RATE);         // No wait: boot must not depend on a host being attached
   Serial.println("Serial console initialized 🖥️");  // Print message to indicate successful serial connection
-
-  // ==================================================
-  // Preferences & Config Manager Initialization
-  // ==================================================
-  Serial.println("Opening Preferences storage ⚙️"); // Print message for Preferences setup
-  prefs.begin(CONFIG_PARTITION, false); // Start Preferences with the specified partition (non-read-only)
-  Serial.println("Initializing Config Manager 🛠️");  // Print message for Config manager setup
-  Config = new ConfigManager(&prefs); // Create instance of ConfigManager with Preferences object
-  Config->begin();                   // Begin configuration process
-  Serial.println("Config Manager ready ✅");  // Print confirmation message after config initialization
-
-  // ==================================================
-  // Nextion HMI Serial Communication Setup
-  // ==================================================
-  Serial1.begin(NEXTION_BAUDRATE, SERIAL_8N1, SCREEN_RXD_PIN, SCREEN_TXD_PIN); // Start Nextion serial communication
-  Serial.println("Nextion HMI serial initialized 📺"); // Print message to indicate Nextion communication setup
+  TaskHealth::begin();              // Task watchdog, before any supervised task starts
 
   // ==================================================
   // Flag LED Indicator Setup
@@ -70,86 +145,39 @@ void setup() {
   Serial.println("LED Flag ON 🔴");      // Print message indicating that the LED flag is on
 
   // ==================================================
-  // Motor Initialization
-  // ==================================================
-  Serial.println("Initializing motors ⚙️");   // Print message to indicate motor initialization
-  discMotor.begin();                        // Initialize disc motor
-  caseMotor.begin();                        // Initialize case motor
-  Serial.println("Motors ready ✅");         // Print message indicating motors are ready
-
-  // ==================================================
-  // SD Card Initialization
-  // ==================================================
-  Serial.println("Initializing SD card 💾");  // Print message for SD card setup
-  SDcard = new SDCardManager();             // Create instance of SDCardManager
-  if (SDcard->begin()) {                    // Try to initialize SD card
+  // Staged Initialization
+  // ==================================================
+  // console ──┬─ config ─┬─ recipes ─┐
+  //           │          └───────────┼─ display
+  // motors ───┴─ resume ─────────────┘
+  // sd (independent, timeout)
+  warmRestart = new WarmRestart(caseMotor, discMotor);
+  warmRestart->begin();                     // Reset reason and RTC state, no I/O
+  crashReport = new CrashReport();
+  crashReport->begin();                     // Core dump left by a crash, summary kept in NVS
+  SDcard = new SDCardManager();             // Created up front, recipes hold the pointer
+  int8_t console = boot.addStage("console", bootConsole);
+  int8_t motors  = boot.addStage("motors", bootMotors);
+  int8_t sd      = boot.addStage("sd", bootSDCard, 0, BOOT_SD_TIMEOUT_MS);
+  int8_t resume  = boot.addStage("resume", bootResume, BOOT_DEP(console) | BOOT_DEP(motors));
+  int8_t config  = boot.addStage("config", bootConfig, BOOT_DEP(console));
+  int8_t recipe  = boot.addStage("recipes", bootRecipes, BOOT_DEP(console) | BOOT_DEP(config));
+  boot.addStage("display", bootDisplay,
+                BOOT_DEP(console) | BOOT_DEP(config) | BOOT_DEP(resume) | BOOT_DEP(recipe),
+                BOOT_HMI_TIMEOUT_MS);
+  boot.run();
+
+  if (!boot.isDone(sd)) {
+    Serial.println("SD card not ready yet, continuing without it ⏳");
+  } else if (SDcard->isInitialized()) {
     Serial.println("SD card initialized successfully 📂"); // Print message for successful SD card initialization
   } else {
     Serial.println("❌ SD card initialization failed");  // Print error message if SD card initialization fails
   }
-
-  // ==================================================
-  // Sensor & Command Receiver Initialization
-  // ==================================================
-  Serial.println("Initializing sensor 📡"); // Print message for sensor initialization
-  sensor = new Sensor(SENSOR_PIN);         // Create instance of Sensor with the defined pin
-  sensor->begin();                         // Initialize the sensor
-  Serial.println("Sensor initialized ✅");  // Print message confirming the sensor is initialized
-  Serial.println("Setting up Command Receiver 🎛️");  // Print message for command receiver setup
-  commandReceiver = new CommandReceiver(sensor, caseMotor, discMotor); // Create instance of CommandReceiver
-  commandReceiver->begin();                        // Initialize the command receiver
-  Serial.println("Command Receiver initialized ✅"); // Print message confirming command receiver is initialized
-
-  // ==================================================
-  // Nextion HMI Setup
-  // ==================================================
-  Serial.println("Starting Nextion HMI Manager 🖥️"); // Print message for HMI manager setup
-  nextionHMI = new NextionHMI(commandReceiver, caseMotor, discMotor, Config); // Create instance of Nextion HMI manager
-  nextionHMI->begin();                             // Initialize the HMI manager
-  Serial.println("System initialization complete ✅");  // Print message confirming all system components initialized
-  nextionHMI->sendSystemStatus();
+  Serial.printf("System initialization complete in %lu us ✅\n", (unsigned long)(boot.getReadyUs())); // Time since reset
+  commandReceiver->startTask();     // JSON commands from the host, woken by the UART
 }
 
 void loop() {
-  readResponse();  // Call function to read response from Nextion display
-}
-
-// ==================================================
-// Read Response: Handle Incoming Data from Nextion HMI
-// ==================================================
-void readResponse() {
-  while (Serial1.available()) {      // While data is available from Nextion via UART1
-    String receivedData = "";         // Initialize empty string to hold incoming data
-
-    // Read all available data from serial
-    while (Serial1.available()) {
-      char c = Serial1.read();        // Read each character
-      receivedData += c;              // Append character to the receivedData string
-    }
-
-    // Process the data if its length is greater than 4 characters
-    if (receivedData.length() > 4) {
-      char processedData = receivedData.charAt(4);  // Extract the 5th character from the received data string
-
-      // Check if the extracted character is a valid command (A-K)
-      if (processedData == 'A' || processedData == 'B' || processedData == 'C' ||
-          processedData == 'D' || processedData == 'H' || processedData == 'I' ||
-          processedData == 'E' || processedData == 'F' || processedData == 'G' ||
-          processedData == 'S' || processedData == 'P' || processedData == 'J' ||
-          processedData == 'K'|| processedData == 'W') {
-
-        Serial.print("📨 Received from Nextion: ");   // Print received command for debugging
-        Serial.println(processedData);
-
-        // Forward the valid command to the Nextion HMI handler
-        nextionHMI->handleButtonPress(String(processedData));
-      } else {
-        // If the command is invalid, print a warning and return
-        Serial.print("⚠️ Unsupported character received: ");
-        Serial.println(processedData);
-        return;  // Exit the function since the data is not supported
-      }
-    }
-  }
-  delay(100);  // Add a small delay to prevent overwhelming the loop
+  vTaskDelete(nullptr);  // All work runs in tasks (see TaskHealth.h); the Arduino loop task is not needed
 }